@@ -57,6 +57,13 @@ foreach (build ${DRB_BUILD_TYPES})
 	set(LAZYTEN_DEPENDENCIES_${build} ${LAZYTEN_DEPENDENCIES_${build}} ${krims_${build}_TARGET})
 endforeach()
 
+###############
+#-- Threads --#
+###############
+# Needed for solving independent (block) problems concurrently
+find_package(Threads REQUIRED)
+set(LAZYTEN_DEPENDENCIES ${LAZYTEN_DEPENDENCIES} ${CMAKE_THREAD_LIBS_INIT})
+
 #########################
 #--  LAPACK and BLAS  --#
 #########################
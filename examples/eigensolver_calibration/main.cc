@@ -0,0 +1,144 @@
+//
+// Copyright (C) 2017 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+// Calibrate the parameters of the EigensolverCostModel for this machine.
+//
+// The program times dense diagonalisations, matrix-vector applies, vector
+// orthogonalisations and an iterative solve and fits the model parameters
+// to the measured times.
+// The printed values can be passed to the EigensystemSolver (or the
+// eigensystem functions) via the parameter map to improve the
+// automatic method selection.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <lazyten/EigensystemSolver.hh>
+#include <lazyten/SmallMatrix.hh>
+#include <lazyten/random.hh>
+
+using namespace lazyten;
+
+typedef double scalar_type;
+typedef SmallMatrix<scalar_type> matrix_type;
+typedef typename matrix_type::vector_type vector_type;
+typedef Eigenproblem<true, matrix_type> problem_type;
+
+/** Return a random symmetric matrix with a well-separated lower spectrum */
+matrix_type random_symmetric(size_t size) {
+  matrix_type mat(size, size, false);
+  for (size_t i = 0; i < size; ++i) {
+    for (size_t j = 0; j <= i; ++j) mat(i, j) = mat(j, i) = random<scalar_type>();
+    mat(i, i) += 100. * static_cast<scalar_type>(i);
+  }
+  return mat;
+}
+
+/** Run a functor a few times and return the best time in seconds */
+template <typename Functor>
+double best_time(Functor&& f, size_t repeat = 3) {
+  double best = std::numeric_limits<double>::max();
+  for (size_t r = 0; r < repeat; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(end - start).count());
+  }
+  return best;
+}
+
+int main() {
+  const std::vector<size_t> sizes{200, 400, 800, 1200};
+
+  // Least-squares fits through the origin: t = c * flops
+  //   => c = sum(t * flops) / sum(flops^2)
+  double dense_tf = 0, dense_ff = 0;
+  double apply_tf = 0, apply_ff = 0;
+
+  for (const size_t size : sizes) {
+    const matrix_type mat = random_symmetric(size);
+    problem_type problem{mat};
+
+    // Dense solve for all eigenpairs
+    EigensystemSolver<problem_type> dense_solver{{{"method", "lapack"}}};
+    const double t_dense = best_time([&] { dense_solver.solve(problem); });
+    const double f_dense = EigensolverCostModel::dense_flops(size, size, false);
+    dense_tf += t_dense * f_dense;
+    dense_ff += f_dense * f_dense;
+
+    // Matrix-vector applies
+    constexpr size_t n_applies = 20;
+    MultiVector<vector_type> x(size, 1, false);
+    MultiVector<vector_type> y(size, 1, false);
+    x[0] = random<vector_type>(size);
+    const double t_apply = best_time([&] {
+                             for (size_t i = 0; i < n_applies; ++i) mat.apply(x, y);
+                           }) /
+                           n_applies;
+    const double f_apply = EigensolverCostModel::stored_apply_flops(size);
+    apply_tf += t_apply * f_apply;
+    apply_ff += f_apply * f_apply;
+
+    std::cout << "size " << size << ":  dense solve " << t_dense << " s,  apply "
+              << t_apply << " s" << std::endl;
+  }
+
+  // Orthogonalisation of a vector against another (dot product and update)
+  const size_t size = sizes.back();
+  constexpr size_t n_projections = 100;
+  const vector_type u = random<vector_type>(size);
+  vector_type v = random<vector_type>(size);
+  const double t_ortho = best_time([&] {
+    for (size_t i = 0; i < n_projections; ++i) v -= dot(u, v) * u;
+  });
+  const double f_ortho = 4. * static_cast<double>(size * n_projections);
+
+  // Applies per eigenpair of the preferred iterative method
+  const size_t n_ep = 10;
+  const matrix_type mat = random_symmetric(size);
+  problem_type problem{mat, n_ep};
+#ifdef LAZYTEN_HAVE_ARPACK
+  const std::string iterative = "arpack";
+#else
+  const std::string iterative = "lanczos";
+#endif
+  EigensystemSolver<problem_type> iterative_solver{{{"method", iterative}}};
+  const auto state = iterative_solver.solve(problem);
+
+  EigensolverCostModel model;
+  model.seconds_per_dense_flop = dense_tf / dense_ff;
+  model.seconds_per_apply_flop = apply_tf / apply_ff;
+  model.seconds_per_ortho_flop = t_ortho / f_ortho;
+  model.applies_per_eigenpair =
+        static_cast<double>(state.n_mtx_applies()) / static_cast<double>(n_ep);
+
+  std::cout << std::endl
+            << "Calibrated cost model parameters (" << iterative
+            << " used for the iterative method):" << std::endl
+            << "  " << EigensolverCostModelKeys::seconds_per_dense_flop << " = "
+            << model.seconds_per_dense_flop << std::endl
+            << "  " << EigensolverCostModelKeys::seconds_per_apply_flop << " = "
+            << model.seconds_per_apply_flop << std::endl
+            << "  " << EigensolverCostModelKeys::seconds_per_ortho_flop << " = "
+            << model.seconds_per_ortho_flop << std::endl
+            << "  " << EigensolverCostModelKeys::applies_per_eigenpair << " = "
+            << model.applies_per_eigenpair << std::endl;
+  return 0;
+}
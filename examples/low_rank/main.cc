@@ -0,0 +1,98 @@
+//
+// Copyright (C) 2017 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+// Compare the randomised low-rank SVD to a full dense diagonalisation.
+//
+// The test matrix is a Gaussian kernel matrix on points in the unit
+// interval, which is symmetric positive semi-definite and has rapidly
+// decaying eigenvalues, such that its dominant part is well described
+// by a low-rank approximation. For such matrices the singular values
+// are the eigenvalues, which makes the two methods directly comparable.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <lazyten/LazyMatrixWrapper.hh>
+#include <lazyten/SmallMatrix.hh>
+#include <lazyten/eigensystem.hh>
+#include <lazyten/randomised_svd.hh>
+#include <limits>
+
+using namespace lazyten;
+
+typedef double scalar_type;
+typedef SmallMatrix<scalar_type> matrix_type;
+
+/** Return the Gaussian kernel matrix exp(-(x_i - x_j)^2 / (2 l^2))
+ *  for equidistant points x_i in [0,1] */
+matrix_type kernel_matrix(size_t size, scalar_type length = 0.1) {
+  matrix_type mat(size, size, false);
+  for (size_t i = 0; i < size; ++i) {
+    for (size_t j = 0; j <= i; ++j) {
+      const scalar_type dx = static_cast<scalar_type>(i - j) / (size - 1);
+      mat(i, j) = mat(j, i) = std::exp(-dx * dx / (2. * length * length));
+    }
+  }
+  return mat;
+}
+
+/** Run a functor a few times and return the best time in seconds */
+template <typename Functor>
+double best_time(Functor&& f, size_t repeat = 3) {
+  double best = std::numeric_limits<double>::max();
+  for (size_t r = 0; r < repeat; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(end - start).count());
+  }
+  return best;
+}
+
+int main() {
+  const std::vector<size_t> sizes{500, 1000, 2000};
+  const size_t rank = 20;
+  const krims::GenMap params{{RandomisedSvdKeys::seed, size_t(42)}};
+
+  for (const size_t size : sizes) {
+    const matrix_type mat = kernel_matrix(size);
+    const LazyMatrixWrapper<matrix_type> lazy_mat(mat);
+
+    // Full dense diagonalisation (eigenvalues in ascending order)
+    const double t_full = best_time([&] { eigensystem_hermitian(mat); });
+    const auto full = eigensystem_hermitian(mat);
+
+    // Randomised SVD of the requested rank
+    const double t_rsvd = best_time([&] { randomised_svd(lazy_mat, rank, params); });
+    const auto approx = randomised_svd(lazy_mat, rank, params);
+
+    // Largest relative error in the singular values
+    scalar_type max_error = 0;
+    for (size_t i = 0; i < rank; ++i) {
+      const scalar_type ref = full.evalues()[size - 1 - i];
+      max_error = std::max(max_error, std::abs(approx.weights()[i] - ref) / ref);
+    }
+
+    std::cout << "size " << size << ":  full diagonalisation " << t_full
+              << " s,  randomised SVD (rank " << rank << ") " << t_rsvd
+              << " s,  max. rel. error in singular values " << max_error << std::endl;
+  }
+  return 0;
+}
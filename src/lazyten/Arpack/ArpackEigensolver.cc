@@ -25,6 +25,7 @@ namespace lazyten {
 const std::string ArpackEigensolverKeys::max_iter = "max_iter";
 const std::string ArpackEigensolverKeys::n_arnoldi_vectors = "n_arnoldi_vectors";
 const std::string ArpackEigensolverKeys::mode = "mode";
+const std::string ArpackEigensolverKeys::sigma = "sigma";
 
 }  // namespace lazyten
 #endif  // LAZYTEN_HAVE_ARPACK
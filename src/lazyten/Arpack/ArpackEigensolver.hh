@@ -25,6 +25,8 @@
 #include "lazyten/Base/Solvers.hh"
 #include "lazyten/Exceptions.hh"
 #include "lazyten/PtrVector.hh"
+#include <chrono>
+#include <numeric>
 
 namespace lazyten {
 
@@ -62,6 +64,34 @@ struct ArpackEigensolverState : public EigensolverStateBase<Eigenproblem> {
   /** The pointer to the reverse communication workbench */
   std::shared_ptr<std::vector<scalar_type>> workd_ptr;
 
+  /** Scratch vector of problem dimension used in the shift-invert modes */
+  std::shared_ptr<std::vector<scalar_type>> scratch_ptr;
+
+  /** Views into the three sections of the workd array, such that serving
+   *  the reverse communication requests does not allocate. */
+  std::array<MultiVector<PtrVector<scalar_type>>, 3> workd_views;
+
+  /** View into the scratch vector */
+  MultiVector<PtrVector<scalar_type>> scratch_view;
+
+  /** The number of reverse communication steps performed in the last solve */
+  size_t n_ido_steps;
+
+  /** Wall time spent inside the ARPACK iteration routine in the last solve */
+  std::chrono::duration<double> time_in_arpack;
+
+  /** Wall time spent serving the reverse communication requests
+   *  (i.e. mostly matrix applies) in the last solve */
+  std::chrono::duration<double> time_in_applies;
+
+#ifdef LAZYTEN_HAVE_LAPACK
+  /** The factorisation of A - sigma B used to apply the shifted inverse
+   *  in modes 3 to 5 (only set if it has been computed by the solver) */
+  std::shared_ptr<const detail::ShiftedSymmetricFactorisation<
+        typename base_type::stored_matrix_type>>
+        shift_factorisation_ptr;
+#endif  // LAZYTEN_HAVE_LAPACK
+
   /** Get the number of Arnoldi iterations performed.
    *
    * \note
@@ -78,6 +108,15 @@ struct ArpackEigensolverState : public EigensolverStateBase<Eigenproblem> {
    */
   size_t n_mtx_applies() const override { return static_cast<size_t>(iparam[8]); }
 
+  /** Return the view into the section of the workd array, which
+   *  starts at the (1-based) index ipntr_value as returned by ARPACK. */
+  MultiVector<PtrVector<scalar_type>>& workd_view(int ipntr_value) {
+    const size_type dim = base_type::eigenproblem().dim();
+    const size_type offset = static_cast<size_type>(ipntr_value - 1);
+    assert_internal(offset % dim == 0 && offset / dim < 3);
+    return workd_views[offset / dim];
+  }
+
   /** Setup the initial state from an eigenproblem to solve */
   ArpackEigensolverState(const eproblem_type problem)
         : base_type(std::move(problem)),
@@ -89,7 +128,19 @@ struct ArpackEigensolverState : public EigensolverStateBase<Eigenproblem> {
           resid_ptr{new std::vector<scalar_type>(base_type::eigenproblem().dim(), 0.0)},
           have_old_residual(false),
           workd_ptr{
-                new std::vector<scalar_type>(3 * base_type::eigenproblem().dim(), 0.0)} {}
+                new std::vector<scalar_type>(3 * base_type::eigenproblem().dim(), 0.0)},
+          scratch_ptr{
+                new std::vector<scalar_type>(base_type::eigenproblem().dim(), 0.0)},
+          n_ido_steps(0),
+          time_in_arpack(0),
+          time_in_applies(0) {
+    const size_type dim = base_type::eigenproblem().dim();
+    for (size_type i = 0; i < workd_views.size(); ++i) {
+      workd_views[i] =
+            make_as_multivector<PtrVector<scalar_type>>(workd_ptr->data() + i * dim, dim);
+    }
+    scratch_view = make_as_multivector<PtrVector<scalar_type>>(scratch_ptr->data(), dim);
+  }
 };
 
 DefException1(ExcArpackInvalidIdo, int,
@@ -112,6 +163,11 @@ DefSolverException1(ExcArpackCouldNotApplyShifts, size_t, n_arnoldi_vectors,
                     << "vectors beyond the current value ( " << n_arnoldi_vectors
                     << " ) using the key 'n_arnoldi_vectors' in a GenMap.");
 
+DefSolverException2(ExcArpackShiftedFactorisationFailed, double, sigma, int, info,
+                    << "Factorising the shifted matrix A - sigma*B for sigma == " << sigma
+                    << " failed with Lapack info value " << info
+                    << ". Most likely sigma is an eigenvalue of the problem.");
+
 /** Class which contains all GenMap keys which are understood
  *  by the ArpackSolver update_control_params as static string
  *  members.
@@ -125,6 +181,9 @@ struct ArpackEigensolverKeys : public EigensolverBaseKeys {
 
   /** Arpack mode to use, Type: int */
   static const std::string mode;
+
+  /** Shift for the shift-invert modes 3 to 5, Type: double */
+  static const std::string sigma;
 };
 
 /** \brief Arpack eigensolver class
@@ -147,6 +206,7 @@ struct ArpackEigensolverKeys : public EigensolverBaseKeys {
  *   - mode:      Arpack mode to use. We use mode 1 for normal
  *                eigenproblems and mode 2 for generalised
  *                eigenproblems by default (see below)
+ *   - sigma:     The shift used in modes 3 to 5. Default: 0
  *   - n_arnoldi_vectors: The number of Arnoldi vectors to use.
  *                Has to be larger than twice the number of eigenpairs
  *                to be obtained.
@@ -162,13 +222,27 @@ struct ArpackEigensolverKeys : public EigensolverBaseKeys {
  * apply_inverse function, for details how to get this see the
  * inverse() method
  *
+ * ### modes 3 to 5
+ * In all these modes the inverse of the shifted matrix $A - \sigma B$
+ * is needed. Either Diag is a different object than A, in which case
+ * Diag == $(A - \sigma B)^{-1}$ is expected, or A and Diag are the same
+ * object and the solver factorises $A - \sigma B$ once per solve
+ * (requires Lapack) and uses this factorisation for all applications
+ * of the inverse. Note that which refers to the eigenvalues $\nu$ of
+ * the shifted and inverted operator, e.g. which == "LM" yields the
+ * eigenvalues $\lambda$ closest to $\sigma$. The returned eigenvalues
+ * are those of the original problem.
+ *
  * ### mode 3
- * Shift-and-invert mode. Diag == $(A - \sigma B)^{-1}$
+ * Shift-and-invert mode: $\nu = 1 / (\lambda - \sigma)$.
  * May be a generalised or a non-generalised problem.
  *
- * ### modes > 3
- * Not supported. Check Arpack documentation for dnaupd,
- * dsaupd or znaupd on your own.
+ * ### mode 4
+ * Buckling mode: $\nu = \lambda / (\lambda - \sigma)$.
+ * A needs to be positive semi-definite.
+ *
+ * ### mode 5
+ * Cayley transform mode: $\nu = (\lambda + \sigma) / (\lambda - \sigma)$.
  *
  *
  * ## Handlers and events
@@ -178,8 +252,19 @@ struct ArpackEigensolverKeys : public EigensolverBaseKeys {
  * before_iteration_step() and after_iteration_step() are never
  * triggered.
  *
+ * Depending on the eigenproblem different ARPACK drivers are used:
+ * dsaupd for real Hermitian, dnaupd for real non-Hermitian and
+ * znaupd for complex problems. For the latter two only the modes
+ * 1 to 3 are available and in mode 3 the shifted inverse needs to be
+ * provided in Diag. Their eigenpairs are returned in the order given
+ * by which applied to the transformed eigenvalues $\nu$.
+ *
  * \note Currently only double precision scalar types can be used.
  *
+ * \note ARPACK keeps its state in Fortran SAVE variables and is hence not
+ *       reentrant. All solves of this class therefore hold a global mutex
+ *       while ARPACK is running, i.e. concurrent solves are serialised.
+ *
  * \tparam Eigenproblem  The eigenproblem to solve.
  * \tparam State         The state type of the solver.
  */
@@ -189,14 +274,8 @@ class ArpackEigensolver : public EigensolverBase<State> {
                 "The type Eigenproblem and the implicit eigenproblem type in the SCF "
                 "state have to agree");
 
-  // TODO remove assertion and generalise
-  static_assert(std::is_same<typename Eigenproblem::scalar_type, double>::value,
-                "Arpack can only solve real problems at double precision at "
-                "the moment");
-
-  // TODO remove assertion and generalise
-  static_assert(Eigenproblem::hermitian,
-                "Can only solve Hermitian eigenproblems at the moment.");
+  static_assert(std::is_same<typename Eigenproblem::real_type, double>::value,
+                "Arpack can only solve problems at double precision.");
 
  public:
   //@{
@@ -244,6 +323,9 @@ class ArpackEigensolver : public EigensolverBase<State> {
   /** Maximum number of iterations */
   size_t max_iter = 100;
 
+  /** The shift for the shift-invert modes 3 to 5 */
+  double sigma = 0.;
+
   /** Update control parameters from Parameter map */
   void update_control_params(const krims::GenMap& map) {
     base_type::update_control_params(map);
@@ -251,6 +333,7 @@ class ArpackEigensolver : public EigensolverBase<State> {
     n_arnoldi_vectors =
           map.at(ArpackEigensolverKeys::n_arnoldi_vectors, n_arnoldi_vectors);
     mode = map.at(ArpackEigensolverKeys::mode, mode);
+    sigma = map.at(ArpackEigensolverKeys::sigma, sigma);
   }
 
   /** Get the current settings of all internal control parameters and
@@ -261,6 +344,7 @@ class ArpackEigensolver : public EigensolverBase<State> {
     map.update(ArpackEigensolverKeys::max_iter, max_iter);
     map.update(ArpackEigensolverKeys::n_arnoldi_vectors, n_arnoldi_vectors);
     map.update(ArpackEigensolverKeys::mode, mode);
+    map.update(ArpackEigensolverKeys::sigma, sigma);
   }
   ///@}
 
@@ -268,6 +352,17 @@ class ArpackEigensolver : public EigensolverBase<State> {
   void solve_state(state_type& state) const override;
 
  private:
+  /** The ARPACK routines used for this kind of problem:
+   *  dsaupd for real Hermitian, dnaupd for real non-Hermitian
+   *  and znaupd for complex problems */
+  typedef typename detail::ArpackDriver<scalar_type, Eigenproblem::hermitian>::type
+        driver_type;
+
+  /** Are we dealing with a real symmetric problem, i.e. is the
+   *  dsaupd driver used? */
+  typedef std::integral_constant<bool, Eigenproblem::hermitian && Eigenproblem::real>
+        real_symmetric_type;
+
   /** Assert that the state of the control parameters is sensible.
    *  In case its not, raise an ExcInvalidEigensolverParameters
    *  exception */
@@ -280,6 +375,30 @@ class ArpackEigensolver : public EigensolverBase<State> {
 
   /** Deal with the ido parameter we got */
   void arpack_ido_step(state_type& s, std::array<int, 14> ipntr) const;
+
+  /** Compute y = (A - sigma B)^{-1} x in the shift-invert modes */
+  void apply_shifted_inverse(state_type& s, const MultiVector<PtrVector<scalar_type>>& x,
+                             MultiVector<PtrVector<scalar_type>>& y) const;
+
+  /** Factorise A - sigma B and store the factorisation in the state
+   *  (only available for real symmetric problems) */
+  void factorise_shifted_matrix(state_type& s, std::true_type) const;
+  void factorise_shifted_matrix(state_type&, std::false_type) const {
+    assert_internal(false);
+  }
+
+  /** Apply the inverse using the factorisation stored in the state
+   *  (only available for real symmetric problems) */
+  void solve_shifted_factorisation(state_type& s,
+                                   const MultiVector<PtrVector<scalar_type>>& x,
+                                   MultiVector<PtrVector<scalar_type>>& y,
+                                   std::true_type) const;
+  void solve_shifted_factorisation(state_type&,
+                                   const MultiVector<PtrVector<scalar_type>>&,
+                                   MultiVector<PtrVector<scalar_type>>&,
+                                   std::false_type) const {
+    assert_internal(false);
+  }
 };
 
 //
@@ -332,12 +451,15 @@ void ArpackEigensolver<Eigenproblem, State>::assert_valid_control_params(
                         "For normal eigenproblems mode 2 is not allowed."));
   }
   // dsaupd accepts modes between 1 and 5.
-  // dnaupd accepts modes between 1 and 4.
+  // dnaupd accepts modes between 1 and 4, but mode 4 is only sensible
+  //        for complex shifts, which we do not support.
   // znaupd accepts modes between 1 and 3.
-  solver_assert(mode >= 1 && mode <= 5, state,
+  const int max_mode = real_symmetric_type::value ? 5 : 3;
+  solver_assert(mode >= 1 && mode <= max_mode, state,
                 ExcInvalidSolverParametersEncountered(
                       "The value " + std::to_string(mode) +
-                      " for mode is not allowed. Only values within [1,5] are ok."));
+                      " for mode is not allowed. Only values within [1," +
+                      std::to_string(max_mode) + "] are ok."));
 
   if (mode == 1 || mode == 2) {
     // note: We compare memory addresses
@@ -346,11 +468,20 @@ void ArpackEigensolver<Eigenproblem, State>::assert_valid_control_params(
                         "For mode 1 or 2 the matrices A and Diag need "
                         "to be the same objects."));
   } else {
+#ifdef LAZYTEN_HAVE_LAPACK
+    const bool can_factorise = real_symmetric_type::value;
+#else
+    const bool can_factorise = false;
+#endif  // LAZYTEN_HAVE_LAPACK
+    // If we cannot factorise A - sigma B ourselves (no Lapack or not
+    // a real symmetric problem), the user has to provide the inverse.
     // note: We compare memory addresses
-    solver_assert(&problem.A() != &problem.Diag(), state,
+    solver_assert(can_factorise || &problem.A() != &problem.Diag(), state,
                   ExcInvalidSolverParametersEncountered(
                         "For modes > 2 the matrices A and Diag have to be different "
-                        "objects, e.g. for mode 3 we need Diag = (A-sigma*S)^{-1}"));
+                        "objects, e.g. for mode 3 we need Diag = (A-sigma*S)^{-1}, "
+                        "since lazyten can only factorise real symmetric shifted "
+                        "matrices and only if compiled with Lapack."));
   }
 
   if (mode == 2) {
@@ -391,6 +522,56 @@ void ArpackEigensolver<Eigenproblem, State>::assert_valid_control_params(
               std::to_string(problem.dim()) + ")"));
 }
 
+template <typename Eigenproblem, typename State>
+void ArpackEigensolver<Eigenproblem, State>::apply_shifted_inverse(
+      state_type& state, const MultiVector<PtrVector<scalar_type>>& x,
+      MultiVector<PtrVector<scalar_type>>& y) const {
+  const Eigenproblem& problem = state.eigenproblem();
+
+  // note: We compare memory addresses
+  if (&problem.A() != &problem.Diag()) {
+    // Diag is the user-provided (A - \sigma B)^{-1}
+    problem.Diag().apply(x, y);
+    return;
+  }
+
+  // Use the factorisation computed in solve_state
+  solve_shifted_factorisation(state, x, y, real_symmetric_type{});
+}
+
+template <typename Eigenproblem, typename State>
+void ArpackEigensolver<Eigenproblem, State>::solve_shifted_factorisation(
+      state_type& state, const MultiVector<PtrVector<scalar_type>>& x,
+      MultiVector<PtrVector<scalar_type>>& y, std::true_type) const {
+#ifdef LAZYTEN_HAVE_LAPACK
+  assert_internal(state.shift_factorisation_ptr != nullptr);
+  const int info = state.shift_factorisation_ptr->solve(x[0].memptr(), y[0].memptr());
+  assert_internal(info == 0);
+#else
+  (void)state;
+  (void)x;
+  (void)y;
+  assert_internal(false);
+#endif  // LAZYTEN_HAVE_LAPACK
+}
+
+template <typename Eigenproblem, typename State>
+void ArpackEigensolver<Eigenproblem, State>::factorise_shifted_matrix(
+      state_type& state, std::true_type) const {
+#ifdef LAZYTEN_HAVE_LAPACK
+  const Eigenproblem& problem = state.eigenproblem();
+  typedef detail::ShiftedSymmetricFactorisation<stored_matrix_type> factorisation_type;
+  state.shift_factorisation_ptr = std::make_shared<const factorisation_type>(
+        problem.A(), Eigenproblem::generalised ? &problem.B() : nullptr, sigma);
+  solver_assert(state.shift_factorisation_ptr->info == 0, state,
+                ExcArpackShiftedFactorisationFailed(sigma,
+                                                    state.shift_factorisation_ptr->info));
+#else
+  (void)state;
+  assert_internal(false);
+#endif  // LAZYTEN_HAVE_LAPACK
+}
+
 template <typename Eigenproblem, typename State>
 void ArpackEigensolver<Eigenproblem, State>::arpack_ido_step(
       state_type& state, std::array<int, 14> ipntr) const {
@@ -400,59 +581,73 @@ void ArpackEigensolver<Eigenproblem, State>::arpack_ido_step(
   // Nothing to do if we are converged.
   if (state.ido == 99) return;
 
-  typedef PtrVector<scalar_type> ptrvec_t;
-  // Build MultiVector<PtrVector>s for the important vectors, such
-  // that we can use apply with them.
-  // Note: Since Arpack uses 1-based indices (Fortran) we need to
-  // take one away before we use them.
-  scalar_type* workd = &(*state.workd_ptr)[0];
-  auto x = make_as_multivector<ptrvec_t>(workd + ipntr[0] - 1, problem.dim());
-  auto y = make_as_multivector<ptrvec_t>(workd + ipntr[1] - 1, problem.dim());
-  auto Bx = make_as_multivector<const ptrvec_t>(workd + ipntr[2] - 1, problem.dim());
-
-  if (mode == 3 && state.ido == -1) {
-    // Arpack wants y = Diag*x.
-    // and Bx is not yet valid.
-    //
-    // Note:
-    // Our definition of Diag differs from the one
-    // Arpack uses for the case mode == 3,
-    // this is why this case is treated specially.
-
-    std::unique_ptr<scalar_type[]> tmp_ptr(new scalar_type[problem.dim()]);
-    auto tmp = make_as_multivector<ptrvec_t>(tmp_ptr.get(), problem.dim());
-    problem.B().apply(x, tmp);  // tmp = B x
-    // y = (A - \sigma B)^{-1} tmp
-    problem.Diag().apply(tmp, y);
-    return;
-  }
+  // Obtain the cached MultiVector<PtrVector> views into the workd
+  // sections ARPACK points us to, such that we can use apply with them.
+  // Note: Since Arpack uses 1-based indices (Fortran) the workd_view
+  // function takes care to take one away before using them.
+  auto& x = state.workd_view(ipntr[0]);
+  auto& y = state.workd_view(ipntr[1]);
 
   switch (state.ido) {
     case -1:
     case 1:
-      // Arpack wants  y = Diag*x
+      // Arpack wants  y = OP*x
       //   - if ido == -1:  Bx is not valid.
       //   - if ido ==  1:  Bx is valid.
-      if (mode == 2) {
+      if (mode == 1) {
+        problem.Diag().apply(x, y);  // y = Diag * x
+      } else if (mode == 2) {
         problem.A().apply(x, y);  // y = A*x
-        // Copy from y to x; Note: This is strictly required by ARPACK
-        std::copy(std::begin(y[0]), std::end(y[0]), std::begin(x[0]));
+        // ARPACK requires x to be overwritten by A*x in mode 2, so we
+        // need this copy. Afterwards we can apply the inverse out of x.
+        std::copy(y[0].memptr(), y[0].memptr() + problem.dim(), x[0].memptr());
         problem.B().apply_inverse(x, y);  // y = B^{-1} * (A*x)
-      } else if (mode == 3) {
-        // This has already been dealt with above, we should
-        // never get here:
-        assert_internal(state.ido == 1);
-
-        // special, since our definition of Diag differs
-        // from ARPACK's (see above)
-        // y = (A - \sigma B)^{-1} * B * x
-        problem.Diag().apply(Bx, y);
+      } else if (mode == 3 || mode == 4) {
+        // mode 3:  y = (A - \sigma B)^{-1} * B * x
+        // mode 4:  y = (A - \sigma B)^{-1} * A * x
+        // where in mode 4 the role of ARPACK's B is taken by A,
+        // such that the product is available in Bx if ido == 1.
+        if (state.ido == 1 && (mode == 4 || Eigenproblem::generalised)) {
+          apply_shifted_inverse(state, state.workd_view(ipntr[2]), y);
+        } else if (mode == 3 && !Eigenproblem::generalised) {
+          apply_shifted_inverse(state, x, y);
+        } else {
+          auto& z = state.scratch_view;
+          if (mode == 3) {
+            problem.B().apply(x, z);
+          } else {
+            problem.A().apply(x, z);
+          }
+          apply_shifted_inverse(state, z, y);
+        }
+      } else if (mode == 5) {
+        // y = (A - \sigma B)^{-1} * (A + \sigma B) * x
+        auto& z = state.scratch_view;
+        problem.A().apply(x, z);  // z = A*x
+
+        // z += sigma * B*x
+        if (state.ido == 1 || !Eigenproblem::generalised) {
+          const auto& bx = Eigenproblem::generalised ? state.workd_view(ipntr[2]) : x;
+          const scalar_type* bxptr = bx[0].memptr();
+          scalar_type* zptr = z[0].memptr();
+          for (size_t i = 0; i < problem.dim(); ++i) zptr[i] += sigma * bxptr[i];
+        } else {
+          problem.B().apply(x, z, Transposed::None, sigma, Constants<scalar_type>::one);
+        }
+        apply_shifted_inverse(state, z, y);
       } else {
-        problem.Diag().apply(x, y);  // y = Diag * x
+        assert_dbg(false, krims::ExcNotImplemented());
       }
       break;
     case 2:
-      problem.B().apply(x, y);  // y = B x
+      // Arpack wants y = B*x, where in mode 4 the role of B is taken by A
+      if (mode == 4) {
+        problem.A().apply(x, y);
+      } else if (Eigenproblem::generalised) {
+        problem.B().apply(x, y);
+      } else {
+        std::copy(x[0].memptr(), x[0].memptr() + problem.dim(), y[0].memptr());
+      }
       break;
     case 3:
       // TODO ido==3 exists, but we do not have it implemented
@@ -469,6 +664,11 @@ void ArpackEigensolver<Eigenproblem, State>::setup_state(state_type& state) cons
   // Clear the ido and the iparam:
   state.ido = 0;
 
+  // Reset the per-solve counters
+  state.n_ido_steps = 0;
+  state.time_in_arpack = std::chrono::duration<double>::zero();
+  state.time_in_applies = std::chrono::duration<double>::zero();
+
   // Setup iparam array:
   std::fill(state.iparam.begin(), state.iparam.end(), 0);
   state.iparam[0] = 1;  // Automatically determine shifts
@@ -494,7 +694,8 @@ void ArpackEigensolver<Eigenproblem, State>::setup_state(state_type& state) cons
         //
         // TODO This entirely my guts feeling. I have not investigated
         //      closely whether this is sensible or not.
-        res(j) += evectors[i](j) / evalues[i];
+        res(j) += detail::arpack_residual_scalar<scalar_type>(evectors[i](j) /
+                                                              evalues[i]);
       }
     }
     res /= norm_l2(res);
@@ -505,13 +706,6 @@ void ArpackEigensolver<Eigenproblem, State>::setup_state(state_type& state) cons
 
 template <typename Eigenproblem, typename State>
 void ArpackEigensolver<Eigenproblem, State>::solve_state(state_type& state) const {
-  // TODO Remove assertions and generalise.
-  assert_implemented(mode == 2 || mode == 1);
-
-  static_assert(std::is_same<typename Eigenproblem::scalar_type, double>::value,
-                "Arpack can only solve real problems at double precision at "
-                "the moment");
-  // -------
   assert_dbg(!state.is_failed(), krims::ExcInvalidState("Cannot solve a failed state"));
 
   const Eigenproblem& problem = state.eigenproblem();
@@ -523,6 +717,15 @@ void ArpackEigensolver<Eigenproblem, State>::solve_state(state_type& state) cons
   // Setup the state for the solver run
   setup_state(state);
 
+#ifdef LAZYTEN_HAVE_LAPACK
+  // In the shift-invert modes factorise A - sigma B once, unless the user
+  // provided the shifted inverse in Diag.
+  state.shift_factorisation_ptr.reset();
+  if (mode >= 3 && &problem.A() == &problem.Diag()) {
+    factorise_shifted_matrix(state, real_symmetric_type{});
+  }
+#endif  // LAZYTEN_HAVE_LAPACK
+
   //
   // Setup local parameters
   //
@@ -542,19 +745,31 @@ void ArpackEigensolver<Eigenproblem, State>::solve_state(state_type& state) cons
   int info = state.have_old_residual ? 1 : 0;
 
   //
-  // Run arpack ds_upd
+  // Run arpack ?s_upd or ?n_upd
   //
 
+  // ARPACK is not reentrant, so only one solve may run at a time
+  std::unique_lock<std::mutex> arpack_lock(detail::arpack_mutex());
+
   // Setup Arpack wrapper
-  detail::ds_upd_wrapper arpack{
-        Eigenproblem::generalised, problem.dim(),    base_type::which, problem.n_ep(),
-        base_type::tolerance,      n_arnoldi_actual, state.resid_ptr,  state.workd_ptr};
+  // Note: In the buckling and Cayley modes ARPACK always needs a B matrix
+  const bool arpack_generalised = Eigenproblem::generalised || mode >= 4;
+  driver_type arpack{
+        arpack_generalised,   problem.dim(),    base_type::which, problem.n_ep(),
+        base_type::tolerance, n_arnoldi_actual, state.resid_ptr,  state.workd_ptr};
 
   // Perform an Arnoldi/Lanczos step in Arpack and then deal with the ido until Arpack
   // flags convergence.
+  typedef std::chrono::steady_clock clock_type;
   while (state.ido != 99) {
+    const auto before_arpack = clock_type::now();
     arpack.arnoldi_step(state.ido, state.iparam, info);
+    const auto before_applies = clock_type::now();
     arpack_ido_step(state, arpack.ipntr);
+
+    state.time_in_arpack += before_applies - before_arpack;
+    state.time_in_applies += clock_type::now() - before_applies;
+    ++state.n_ido_steps;
   }
   state.have_old_residual = true;
 
@@ -565,7 +780,8 @@ void ArpackEigensolver<Eigenproblem, State>::solve_state(state_type& state) cons
   //           implicit restart, usutally this means that the
   //           number of arnoldi vectors has been too small
   solver_assert(info != 3, state, ExcArpackCouldNotApplyShifts(n_arnoldi_actual));
-  solver_assert(info == 0 || info == 1, state, ExcArpackInfo("dsaupd", info));
+  solver_assert(info == 0 || info == 1, state,
+                ExcArpackInfo(driver_type::aupd_name, info));
 
   // Purge eigenpairs from previous runs:
   soln.evalues().clear();
@@ -574,26 +790,49 @@ void ArpackEigensolver<Eigenproblem, State>::solve_state(state_type& state) cons
   //
   // Compute eigenpairs
   //
-  //! Container for eigenvectors, one after another
-  std::vector<double> evectors;
-  //! We currently use no shift (mode 3 not implemented)
-  const double sigma = 0.0;
+  //! Containers for eigenvalues and eigenvectors, one after another
+  std::vector<evalue_type> evalues;
+  std::vector<typename driver_type::evector_scalar_type> evectors;
+  //! The shift is only used in the shift-invert modes
+  const double sigma_ev = mode >= 3 ? sigma : 0.0;
   int info_ev;
-  arpack.eigenpairs(sigma, state.iparam, soln.evalues(), evectors, info_ev);
-  solver_assert(info_ev == 0, state, ExcArpackInfo("dseupd", info_ev));
+  arpack.eigenpairs(sigma_ev, state.iparam, evalues, evectors, info_ev);
+  arpack_lock.unlock();
+  solver_assert(info_ev == 0, state, ExcArpackInfo(driver_type::eupd_name, info_ev));
 
-  size_t converged_ep = problem.n_ep();
+  // Note: dneupd may return one more eigenpair than requested
+  // if the last one is part of a complex conjugate pair.
+  size_t converged_ep = std::min(problem.n_ep(), evalues.size());
   if (info == 1) {
     // Shrink to keep only those eigenpairs which are converged.
-    converged_ep = state.iparam[4];
-    soln.evalues().resize(converged_ep);
+    converged_ep = std::min<size_t>(converged_ep, static_cast<size_t>(state.iparam[4]));
+  }
+  assert_internal(evalues.size() * problem.dim() <= evectors.size());
+
+  // Indices of the eigenpairs to keep in the order in which they should
+  // appear. dseupd yields them ordered ascendingly already, but dneupd and
+  // zneupd do not order them at all.
+  std::vector<size_t> idcs(converged_ep);
+  std::iota(idcs.begin(), idcs.end(), 0);
+  if (!real_symmetric_type::value) {
+    if (mode >= 3) {
+      // In shift-invert mode which refers to the transformed eigenvalues
+      // nu = 1 / (lambda - sigma), so select by those.
+      std::vector<evalue_type> nu(evalues);
+      for (auto& ev : nu) ev = evalue_type(1) / (ev - sigma);
+      idcs = select_eigenvalues(nu.begin(), nu.end(), base_type::which, converged_ep);
+    } else {
+      idcs = select_eigenvalues(evalues.begin(), evalues.end(), base_type::which,
+                                converged_ep);
+    }
   }
 
-  assert_internal(converged_ep * problem.dim() <= evectors.size());
-
+  soln.evalues().reserve(converged_ep);
   soln.evectors().reserve(converged_ep);
-  for (double* begin = evectors.data();
-       begin < evectors.data() + converged_ep * problem.dim(); begin += problem.dim()) {
+  for (const size_t i : idcs) {
+    soln.evalues().push_back(evalues[i]);
+
+    const auto* begin = evectors.data() + i * problem.dim();
     evector_type v(begin, begin + problem.dim());
     soln.evectors().push_back(std::move(v));
   }
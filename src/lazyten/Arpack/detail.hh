@@ -21,10 +21,15 @@
 #include "lazyten/config.hh"
 #ifdef LAZYTEN_HAVE_ARPACK
 
+#include "lazyten/Lapack/detail/ShiftedSymmetricFactorisation.hh"
+#include "lazyten/Lapack/detail/lapack.hh"
+#include "lazyten/LazyMatrixExpression.hh"
 #include <array>
+#include <complex>
 #include <cstring>
 #include <krims/ExceptionSystem.hh>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace lazyten {
@@ -62,11 +67,126 @@ extern "C" void dneupd_(int* rvec, char* howmany, int* select, double* dr, doubl
                         int* ncv, double* v, int* ldv, int* iparam, int* ipntr,
                         double* workd, double* workl, int* lworkl, int* info);
 
+//
+// Implicitly restarted Arnoldi method for complex problems
+//
+// Perform iterations:
+extern "C" void znaupd_(int* ido, char* bmat, const unsigned int* n, char* which,
+                        const unsigned int* nev, const double* tol,
+                        std::complex<double>* resid, int* ncv, std::complex<double>* v,
+                        int* ldv, int* iparam, int* ipntr, std::complex<double>* workd,
+                        std::complex<double>* workl, int* lworkl, double* rwork,
+                        int* info);
+
+// Obtain eigenvectors of complex IRAM
+extern "C" void zneupd_(int* rvec, char* howmany, int* select, std::complex<double>* d,
+                        std::complex<double>* z, int* ldz, std::complex<double>* sigma,
+                        std::complex<double>* workev, char* bmat, const unsigned int* n,
+                        char* which, const unsigned int* nev, const double* tol,
+                        std::complex<double>* resid, int* ncv, std::complex<double>* v,
+                        int* ldv, int* iparam, int* ipntr, std::complex<double>* workd,
+                        std::complex<double>* workl, int* lworkl, double* rwork,
+                        int* info);
+
 namespace detail {
 
-class ds_upd_wrapper {
+/** Common setup for the wrappers around the ARPACK ?aupd and ?eupd
+ *  function pairs below. */
+template <typename Scalar>
+class upd_wrapper_base {
  public:
+  typedef Scalar scalar_type;
+
+  /** The ipntr parameter, which points into important locations
+   *  inside workd and workl */
+  std::array<int, 14> ipntr;
+
+  /** The v array pointer */
+  std::shared_ptr<std::vector<scalar_type>> v_ptr;
+
+  /** The workl array pointer */
+  std::shared_ptr<std::vector<scalar_type>> workl_ptr;
+
+ protected:
+  /**
+   * \param generalised_  General eigenproblem?
+   * \param dim_      Dimensionality of the eigenproblem
+   * \param which_    Which eigenpairs to compute (already in the form
+   *                  the ARPACK routine understands)
+   * \param n_eigenpairs_  How many to compute
+   * \param tolerance_          Tolerance for the eigensolver
+   * \param n_arnoldi_vectors_  Number of arnoldi vectors
+   * \param resid_ptr_      Shared pointer to residual vector data.
+   *                   Has to be of length dim_.
+   * \param workd_ptr_      Shared pointer to the reverse communication
+   *                   workbench. Has to be of length 3*dim_.
+   * \param lworkl_    The size of the workl array
+   */
+  upd_wrapper_base(bool generalised_, size_t dim_, const std::string& which_,
+                   size_t n_eigenpairs_, double tolerance_, size_t n_arnoldi_vectors_,
+                   std::shared_ptr<std::vector<scalar_type>> resid_ptr_,
+                   std::shared_ptr<std::vector<scalar_type>> workd_ptr_, int lworkl_) {
+    if (generalised_) {
+      bmat = {{'G', '\0'}};
+    } else {
+      bmat = {{'I', '\0'}};
+    }
+
+    // Dimensionality of the problem
+    n = static_cast<int>(dim_);
+
+    // Copy the which characters
+    std::strncpy(which.data(), which_.c_str(), 2);
+    which[2] = '\0';
+
+    // Number of eigenpairs to compute
+    nev = static_cast<int>(n_eigenpairs_);
+
+    // Copy the tolerance
+    tol = tolerance_;
+
+    // resid as copied from pointer.
+    assert_size(dim_, resid_ptr_->size());
+    resid_ptr = resid_ptr_;
+
+    // ncv is the number of Arnoldi vectors
+    // ldv is the leading dimension of v (pretty much n)
+    ncv = static_cast<int>(n_arnoldi_vectors_);
+    ldv = n;
+
+    // Resize v: should be n * ncv
+    v_ptr.reset(new std::vector<scalar_type>(ldv * ncv, 0.0));
+
+    // Ipntr: zero the array:
+    std::fill(ipntr.begin(), ipntr.end(), 0.0);
+
+    // workd: Workspace of length 3n
+    assert_size(3 * dim_, workd_ptr_->size());
+    workd_ptr = workd_ptr_;
+
+    lworkl = lworkl_;
+    workl_ptr.reset(new std::vector<scalar_type>(lworkl, 0.0));
+  }
+
+  std::array<char, 2> bmat;
+  unsigned int n;
+  std::array<char, 3> which;
+  unsigned int nev;
+  double tol;
+  std::shared_ptr<std::vector<scalar_type>> resid_ptr;
+  int ncv;
+  int ldv;
+  std::shared_ptr<std::vector<scalar_type>> workd_ptr;
+  int lworkl;
+};
+
+/** Wrapper around dsaupd and dseupd (real symmetric problems) */
+class ds_upd_wrapper : public upd_wrapper_base<double> {
+ public:
+  typedef upd_wrapper_base<double> base_type;
   typedef double scalar_type;
+  typedef double evalue_type;
+  typedef double evector_scalar_type;
 
   /** Call dsaupd function
    *
@@ -122,15 +242,11 @@ class ds_upd_wrapper {
             workl_ptr->data(), &lworkl, &info);
   }
 
-  /** The ipntr parameter, which points into important locations
-   *  inside workd and workl */
-  std::array<int, 14> ipntr;
-
-  /** The v array pointer */
-  std::shared_ptr<std::vector<scalar_type>> v_ptr;
+  /** Name of the iteration routine (for error messages) */
+  static constexpr const char* aupd_name = "dsaupd";
 
-  /** The workl array pointer */
-  std::shared_ptr<std::vector<scalar_type>> workl_ptr;
+  /** Name of the eigenpair routine (for error messages) */
+  static constexpr const char* eupd_name = "dseupd";
 
   /**
    * \param generalised_  General eigenproblem?
@@ -141,78 +257,263 @@ class ds_upd_wrapper {
    * \param n_arnoldi_vectors_  Number of arnoldi vectors
    * \param resid_ptr_      Shared pointer to residual vector data.
    *                   Has to be of length dim_.
-   * \param compute_eigenvectors  Should the eigenvectors be computed
+   * \param workd_ptr_      Shared pointer to the reverse communication
+   *                   workbench. Has to be of length 3*dim_.
    */
   ds_upd_wrapper(bool generalised_, size_t dim_, std::string which_, size_t n_eigenpairs_,
-                 scalar_type tolerance_, size_t n_arnoldi_vectors_,
+                 double tolerance_, size_t n_arnoldi_vectors_,
                  std::shared_ptr<std::vector<scalar_type>> resid_ptr_,
-                 std::shared_ptr<std::vector<scalar_type>> workd_ptr_) {
-    if (generalised_) {
-      bmat = {{'G', '\0'}};
-    } else {
-      bmat = {{'I', '\0'}};
-    }
+                 std::shared_ptr<std::vector<scalar_type>> workd_ptr_)
+        : base_type(generalised_, dim_, arpack_which(which_), n_eigenpairs_, tolerance_,
+                    n_arnoldi_vectors_, resid_ptr_, workd_ptr_,
+                    // size of workl needs to be ncv^2+8*ncv
+                    static_cast<int>(n_arnoldi_vectors_ * n_arnoldi_vectors_ +
+                                     8 * n_arnoldi_vectors_)) {}
 
-    // Dimensionality of the problem
-    n = static_cast<int>(dim_);
+ private:
+  /** Arpack does not understand SR or LR if we deal with a real symmetric
+   *  problem, so translate these to SA and LA */
+  static std::string arpack_which(const std::string& which_) {
+    if (which_ == "SR") return "SA";
+    if (which_ == "LR") return "LA";
+    return which_;
+  }
+};
 
-    if (which_ == "SR") {
-      // Arpack does not understand SR if
-      // we deal with a real problem
-      // -> change to SA
-      which = {{'S', 'A', '\0'}};
-    } else if (which_ == "LR") {
-      which = {{'L', 'A', '\0'}};
-    } else {
-      // Copy the which characters
-      std::strncpy(which.data(), which_.c_str(), 2);
-      which[2] = '\0';
+/** Wrapper around dnaupd and dneupd (real non-symmetric problems)
+ *
+ * The eigenpairs are returned as complex numbers and complex vectors,
+ * i.e. the conjugate pairs ARPACK returns in compressed form are
+ * expanded.
+ */
+class dn_upd_wrapper : public upd_wrapper_base<double> {
+ public:
+  typedef upd_wrapper_base<double> base_type;
+  typedef double scalar_type;
+  typedef std::complex<double> evalue_type;
+  typedef std::complex<double> evector_scalar_type;
+
+  /** Call dnaupd function
+   *
+   * \param  ido     The ido parameter of dnaupd
+   * \param  iparam  The iparam parameter of dnaupd
+   * \param  info    The info parameter of dnaupd
+   */
+  void arnoldi_step(int& ido, std::array<int, 11>& iparam, int& info) {
+    dnaupd_(&ido, bmat.data(), &n, which.data(), &nev, &tol, resid_ptr->data(), &ncv,
+            v_ptr->data(), &ldv, iparam.data(), ipntr.data(), workd_ptr->data(),
+            workl_ptr->data(), &lworkl, &info);
+  }
+
+  /** Call dneupd function
+   *
+   * \param sigma   The (real) shift parameter sigma
+   * \param iparam  The iparam parameter as passed to arnoldi_step
+   * \param evalues The eigenvalues result array. After the call the size
+   *                will be the number of converged Ritz values, which
+   *                may be one more than the number of requested eigenpairs
+   *                if the last requested one is part of a conjugate pair.
+   * \param evectors The eigenvectors result array as a column-major array
+   *                 with one column per eigenvalue
+   *                 (if compute_eigenvectors == false the array
+   *                 is not touched)
+   * \param info    The info parameter as returned from dneupd
+   * \param compute_eigenvectors  Should eigenvectors be computed at all
+   */
+  void eigenpairs(double sigma, std::array<int, 11>& iparam,
+                  std::vector<evalue_type>& evalues,
+                  std::vector<evector_scalar_type>& evectors, int& info,
+                  bool compute_eigenvectors = true) {
+    int rvec = compute_eigenvectors ? 1 : 0;
+    char howmany = 'A';  // All
+    std::vector<int> select(ncv, 1);
+
+    // Real and imaginary parts of the Ritz values
+    // and the Ritz vectors in compressed form
+    std::vector<double> dr(nev + 1, 0.), di(nev + 1, 0.);
+    std::vector<double> z(compute_eigenvectors ? n * (nev + 1) : 1, 0.);
+    std::vector<double> workev(3 * ncv, 0.);
+    int ldz = n;
+    double sigmai = 0.;
+
+    dneupd_(&rvec, &howmany, select.data(), dr.data(), di.data(), z.data(), &ldz, &sigma,
+            &sigmai, workev.data(), bmat.data(), &n, which.data(), &nev, &tol,
+            resid_ptr->data(), &ncv, v_ptr->data(), &ldv, iparam.data(), ipntr.data(),
+            workd_ptr->data(), workl_ptr->data(), &lworkl, &info);
+    if (info != 0) return;
+
+    const size_t n_conv = std::min<size_t>(static_cast<size_t>(iparam[4]), nev + 1);
+    evalues.resize(n_conv);
+    for (size_t j = 0; j < n_conv; ++j) evalues[j] = evalue_type(dr[j], di[j]);
+    if (!compute_eigenvectors) return;
+
+    // For a conjugate pair the column j contains the real and the column j+1
+    // the imaginary part of the eigenvector belonging to the Ritz value with
+    // positive imaginary part. The other vector is the complex conjugate.
+    evectors.resize(n * n_conv);
+    for (size_t j = 0; j < n_conv; ++j) {
+      const double* re = z.data() + j * n;
+      evector_scalar_type* out = evectors.data() + j * n;
+      if (di[j] == 0.) {
+        std::copy(re, re + n, out);
+        continue;
+      }
+
+      const double* im = re + n;
+      const bool have_partner = j + 1 < n_conv;
+      for (size_t i = 0; i < n; ++i) {
+        out[i] = evector_scalar_type(re[i], im[i]);
+        if (have_partner) out[i + n] = std::conj(out[i]);
+      }
+      ++j;  // Partner done as well
     }
+  }
 
-    // Number of eigenpairs to compute
-    nev = static_cast<int>(n_eigenpairs_);
+  /** Name of the iteration routine (for error messages) */
+  static constexpr const char* aupd_name = "dnaupd";
 
-    // Copy the tolerance
-    tol = tolerance_;
+  /** Name of the eigenpair routine (for error messages) */
+  static constexpr const char* eupd_name = "dneupd";
 
-    // resid as copied from pointer.
-    assert_size(dim_, resid_ptr_->size());
-    resid_ptr = resid_ptr_;
+  /** Construct the wrapper, see ds_upd_wrapper for the parameters */
+  dn_upd_wrapper(bool generalised_, size_t dim_, std::string which_, size_t n_eigenpairs_,
+                 double tolerance_, size_t n_arnoldi_vectors_,
+                 std::shared_ptr<std::vector<scalar_type>> resid_ptr_,
+                 std::shared_ptr<std::vector<scalar_type>> workd_ptr_)
+        : base_type(generalised_, dim_, which_, n_eigenpairs_, tolerance_,
+                    n_arnoldi_vectors_, resid_ptr_, workd_ptr_,
+                    // size of workl needs to be 3*ncv^2+6*ncv
+                    static_cast<int>(3 * n_arnoldi_vectors_ * n_arnoldi_vectors_ +
+                                     6 * n_arnoldi_vectors_)) {}
+};
 
-    // ncv is the number of Arnoldi vectors
-    // ldv is the leading dimension of v (pretty much n)
-    ncv = static_cast<int>(n_arnoldi_vectors_);
-    ldv = n;
+/** Wrapper around znaupd and zneupd (complex problems, Hermitian or not) */
+class zn_upd_wrapper : public upd_wrapper_base<std::complex<double>> {
+ public:
+  typedef upd_wrapper_base<std::complex<double>> base_type;
+  typedef std::complex<double> scalar_type;
+  typedef std::complex<double> evalue_type;
+  typedef std::complex<double> evector_scalar_type;
 
-    // Resize v: should be n * ncv
-    v_ptr.reset(new std::vector<scalar_type>(ldv * ncv, 0.0));
+  /** Call znaupd function
+   *
+   * \param  ido     The ido parameter of znaupd
+   * \param  iparam  The iparam parameter of znaupd
+   * \param  info    The info parameter of znaupd
+   */
+  void arnoldi_step(int& ido, std::array<int, 11>& iparam, int& info) {
+    znaupd_(&ido, bmat.data(), &n, which.data(), &nev, &tol, resid_ptr->data(), &ncv,
+            v_ptr->data(), &ldv, iparam.data(), ipntr.data(), workd_ptr->data(),
+            workl_ptr->data(), &lworkl, rwork.data(), &info);
+  }
 
-    // Ipntr: zero the array:
-    std::fill(ipntr.begin(), ipntr.end(), 0.0);
+  /** Call zneupd function
+   *
+   * \param sigma   The (real) shift parameter sigma
+   * \param iparam  The iparam parameter as passed to arnoldi_step
+   * \param evalues The eigenvalues result array. After the call the size
+   *                will be the number of computed eigenpairs.
+   * \param evectors The eigenvectors result array as a column-major array
+   *                 of size n*nev
+   *                 (if compute_eigenvectors == false the array
+   *                 is not touched)
+   * \param info    The info parameter as returned from zneupd
+   * \param compute_eigenvectors  Should eigenvectors be computed at all
+   */
+  void eigenpairs(double sigma, std::array<int, 11>& iparam,
+                  std::vector<evalue_type>& evalues,
+                  std::vector<evector_scalar_type>& evectors, int& info,
+                  bool compute_eigenvectors = true) {
+    int rvec = compute_eigenvectors ? 1 : 0;
+    char howmany = 'A';  // All
+    std::vector<int> select(ncv, 1);
+    std::vector<scalar_type> workev(2 * ncv);
+    scalar_type sigma_cplx(sigma, 0.);
 
-    // workd: Workspace of length 3n
-    assert_size(3 * dim_, workd_ptr_->size());
-    workd_ptr = workd_ptr_;
+    // zneupd needs space for one more eigenvalue as workspace
+    evalues.resize(nev + 1);
 
-    // size of workl needs to be ncv^2+8*ncv
-    lworkl = ncv * ncv + 8 * ncv;
-    workl_ptr.reset(new std::vector<scalar_type>(lworkl, 0.0));
+    int ldz = n;
+    if (compute_eigenvectors) evectors.resize(n * nev);
+
+    zneupd_(&rvec, &howmany, select.data(), evalues.data(), evectors.data(), &ldz,
+            &sigma_cplx, workev.data(), bmat.data(), &n, which.data(), &nev, &tol,
+            resid_ptr->data(), &ncv, v_ptr->data(), &ldv, iparam.data(), ipntr.data(),
+            workd_ptr->data(), workl_ptr->data(), &lworkl, rwork.data(), &info);
+    evalues.resize(nev);
   }
 
+  /** Name of the iteration routine (for error messages) */
+  static constexpr const char* aupd_name = "znaupd";
+
+  /** Name of the eigenpair routine (for error messages) */
+  static constexpr const char* eupd_name = "zneupd";
+
+  /** Construct the wrapper, see ds_upd_wrapper for the parameters */
+  zn_upd_wrapper(bool generalised_, size_t dim_, std::string which_, size_t n_eigenpairs_,
+                 double tolerance_, size_t n_arnoldi_vectors_,
+                 std::shared_ptr<std::vector<scalar_type>> resid_ptr_,
+                 std::shared_ptr<std::vector<scalar_type>> workd_ptr_)
+        : base_type(generalised_, dim_, which_, n_eigenpairs_, tolerance_,
+                    n_arnoldi_vectors_, resid_ptr_, workd_ptr_,
+                    // size of workl needs to be 3*ncv^2+5*ncv
+                    static_cast<int>(3 * n_arnoldi_vectors_ * n_arnoldi_vectors_ +
+                                     5 * n_arnoldi_vectors_)),
+          rwork(n_arnoldi_vectors_, 0.) {}
+
  private:
-  // dnaupd
-  std::array<char, 2> bmat;
-  unsigned int n;
-  std::array<char, 3> which;
-  unsigned int nev;
-  scalar_type tol;
-  std::shared_ptr<std::vector<scalar_type>> resid_ptr;
-  int ncv;
-  int ldv;
-  std::shared_ptr<std::vector<scalar_type>> workd_ptr;
-  int lworkl;
+  /** Real workspace of length ncv */
+  std::vector<double> rwork;
+};
+
+/** Convert a scalar of an eigenvector of a previous solution to the
+ *  scalar type of the ARPACK residual vector. For the real non-symmetric
+ *  driver the eigenvectors are complex, but the residual is real,
+ *  so only the real part is kept. */
+template <typename Scalar>
+Scalar arpack_residual_scalar(const Scalar& value) {
+  return value;
+}
+
+template <typename Scalar>
+Scalar arpack_residual_scalar(const std::complex<Scalar>& value) {
+  return value.real();
+}
+
+/** Select the ARPACK driver for a scalar type and whether the
+ *  problem is Hermitian or not */
+template <typename Scalar, bool Hermitian>
+struct ArpackDriver {
+  static_assert(std::is_same<Scalar, double>::value ||
+                      std::is_same<Scalar, std::complex<double>>::value,
+                "Arpack can only solve problems at double precision.");
+};
+
+template <>
+struct ArpackDriver<double, true> {
+  typedef ds_upd_wrapper type;
 };
 
+template <>
+struct ArpackDriver<double, false> {
+  typedef dn_upd_wrapper type;
+};
+
+template <bool Hermitian>
+struct ArpackDriver<std::complex<double>, Hermitian> {
+  typedef zn_upd_wrapper type;
+};
+
+/** Mutex to serialise all ARPACK runs of the process.
+ *
+ *  The ARPACK routines keep the state of the reverse communication in
+ *  Fortran SAVE variables and common blocks, such that they are not
+ *  reentrant. */
+inline std::mutex& arpack_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
 }  // namespace detail
 
 }  // namespace lazyten
@@ -0,0 +1,246 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/Constants.hh"
+#include "lazyten/detail/balanced_parallel_for.hh"
+#include <algorithm>
+#include <atomic>
+#include <initializer_list>
+#include <iterator>
+#include <krims/TypeUtils.hh>
+#include <thread>
+#include <vector>
+
+namespace lazyten {
+
+/** \name Threading of the reductions in the fallback operations */
+///@{
+namespace detail {
+inline std::atomic<size_t>& reduction_n_threads_storage() {
+  static std::atomic<size_t> n_threads{
+        std::max<size_t>(1, std::thread::hardware_concurrency())};
+  return n_threads;
+}
+}  // namespace detail
+
+/** Return the maximal number of threads used for the fallback reductions
+ *  (accumulate, dot, norms, min, max) */
+inline size_t reduction_n_threads() { return detail::reduction_n_threads_storage(); }
+
+/** Set the maximal number of threads used for the fallback reductions.
+ *
+ * The results of the reductions do not depend on this value, since the
+ * data is always split into the same chunks, which are combined in the
+ * same order.
+ */
+inline void set_reduction_n_threads(size_t n_threads) {
+  detail::reduction_n_threads_storage() = std::max<size_t>(1, n_threads);
+}
+///@}
+
+namespace detail {
+/** Number of elements reduced as one chunk. This is independent of the
+ *  number of threads, such that the results are reproducible. */
+constexpr size_t reduction_chunk_size = 4096;
+
+/** Minimal number of chunks a thread should work on */
+constexpr size_t reduction_min_chunks_per_thread = 16;
+
+/** Below this number of elements summation is done straight away
+ *  in pairwise_sum */
+constexpr size_t pairwise_sum_block_size = 32;
+
+/** Sum value(i) for all i in [begin, end) using pairwise summation,
+ *  i.e. the rounding error grows only like log(end - begin). */
+template <typename Result, typename Value>
+Result pairwise_sum(size_t begin, size_t end, const Value& value) {
+  if (end - begin <= pairwise_sum_block_size) {
+    Result sum = Constants<Result>::zero;
+    for (size_t i = begin; i < end; ++i) sum += value(i);
+    return sum;
+  }
+  const size_t mid = begin + (end - begin) / 2;
+  return pairwise_sum<Result>(begin, mid, value) + pairwise_sum<Result>(mid, end, value);
+}
+
+/** Reduce each chunk of [0, n_elem) using chunk_reduce(begin, end) and
+ *  return the per-chunk results in order.
+ *
+ * If parallel is true, chunk_reduce may be called concurrently for
+ * different chunks, else it is called for one chunk after another.
+ * Inside a parallel region (see balanced_parallel_for) the chunks are
+ * always reduced serially, since the available threads are already busy.
+ */
+template <typename Result, typename ChunkReduce>
+std::vector<Result> reduce_chunks(size_t n_elem, bool parallel,
+                                  const ChunkReduce& chunk_reduce) {
+  const size_t n_chunks = (n_elem + reduction_chunk_size - 1) / reduction_chunk_size;
+  std::vector<Result> partials(n_chunks);
+  auto reduce_range = [&](size_t cbegin, size_t cend) {
+    for (size_t c = cbegin; c < cend; ++c) {
+      const size_t begin = c * reduction_chunk_size;
+      partials[c] = chunk_reduce(begin, std::min(n_elem, begin + reduction_chunk_size));
+    }
+  };
+
+  const bool threaded = parallel && !in_parallel_region();
+  const size_t n_threads =
+        threaded ? std::min(reduction_n_threads(),
+                            n_chunks / reduction_min_chunks_per_thread)
+                 : 1;
+  if (n_threads <= 1) {
+    reduce_range(0, n_chunks);
+    return partials;
+  }
+
+  // Split the chunks into a few contiguous ranges per thread
+  const size_t n_tasks = 4 * n_threads;
+  const std::vector<double> costs(n_tasks, 1.);
+  balanced_parallel_for(costs, n_threads, [&](size_t t) {
+    reduce_range(t * n_chunks / n_tasks, (t + 1) * n_chunks / n_tasks);
+  });
+  return partials;
+}
+
+/** Reducer summing all values by pairwise summation */
+template <typename Result>
+struct PairwiseSumReducer {
+  typedef Result result_type;
+
+  template <typename Value>
+  result_type operator()(size_t begin, size_t end, const Value& value) const {
+    return pairwise_sum<result_type>(begin, end, value);
+  }
+
+  result_type combine(const std::vector<result_type>& partials) const {
+    return pairwise_sum<result_type>(0, partials.size(),
+                                     [&partials](size_t i) { return partials[i]; });
+  }
+};
+
+/** Reducer finding the extremal value, i.e. the minimum for
+ *  Compare = std::less and the maximum for Compare = std::greater */
+template <typename Result, typename Compare>
+struct ExtremumReducer {
+  typedef Result result_type;
+
+  template <typename Value>
+  result_type operator()(size_t begin, size_t end, const Value& value) const {
+    result_type res = value(begin);
+    for (size_t i = begin + 1; i < end; ++i) {
+      const result_type val = value(i);
+      if (Compare{}(val, res)) res = val;
+    }
+    return res;
+  }
+
+  result_type combine(const std::vector<result_type>& partials) const {
+    return (*this)(0, partials.size(), [&partials](size_t i) { return partials[i]; });
+  }
+};
+
+//@{
+/** Is the iterator a random access iterator */
+template <typename Iterator, typename = void>
+struct IsRandomAccessIterator : public std::false_type {};
+
+template <typename Iterator>
+struct IsRandomAccessIterator<
+      Iterator,
+      krims::VoidType<typename std::iterator_traits<Iterator>::iterator_category>>
+      : public std::is_base_of<
+              std::random_access_iterator_tag,
+              typename std::iterator_traits<Iterator>::iterator_category> {};
+//@}
+
+//@{
+/** Are all the iterators random access iterators */
+template <typename... Iterators>
+struct AllRandomAccess;
+
+template <>
+struct AllRandomAccess<> : public std::true_type {};
+
+template <typename Iterator, typename... Iterators>
+struct AllRandomAccess<Iterator, Iterators...>
+      : public std::integral_constant<bool, IsRandomAccessIterator<Iterator>::value &&
+                                                  AllRandomAccess<Iterators...>::value> {
+};
+//@}
+
+/** Reduce the chunks of op(*its...) in parallel using random access */
+template <typename Reducer, typename Op, typename... Iterators>
+std::vector<typename Reducer::result_type> reduce_chunks_iterators(
+      size_t n_elem, const Reducer& reducer, const Op& op, std::true_type,
+      Iterators... its) {
+  auto reduce = [&](size_t begin, size_t end) {
+    return reducer(begin, end, [&](size_t i) { return op(its[i]...); });
+  };
+  return reduce_chunks<typename Reducer::result_type>(n_elem, /* parallel = */ true,
+                                                      reduce);
+}
+
+/** Reduce the chunks of op(*its...) one after another, buffering the values
+ *  of each chunk. The result is exactly the same as for random access. */
+template <typename Reducer, typename Op, typename... Iterators>
+std::vector<typename Reducer::result_type> reduce_chunks_iterators(
+      size_t n_elem, const Reducer& reducer, const Op& op, std::false_type,
+      Iterators... its) {
+  typedef typename std::decay<decltype(op(*its...))>::type value_type;
+  std::vector<value_type> buffer(std::min(n_elem, reduction_chunk_size));
+
+  auto reduce = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      buffer[i - begin] = op(*its...);
+      (void)std::initializer_list<int>{(++its, 0)...};
+    }
+    return reducer(begin, end, [&](size_t i) { return buffer[i - begin]; });
+  };
+  return reduce_chunks<typename Reducer::result_type>(n_elem, /* parallel = */ false,
+                                                      reduce);
+}
+
+/** Reduce the values op(a_i, b_i, ...) for all elements i of the
+ *  indexables a, b, ...
+ *
+ * The elements are split into chunks of fixed size, which are reduced
+ * in parallel if all indexables offer random-access iterators. The chunk
+ * results are then combined in order. Since the splitting does not
+ * depend on the number of threads, neither does the result.
+ */
+template <typename Reducer, typename Op, typename Indexable, typename... Indexables>
+typename Reducer::result_type reduce(const Reducer& reducer, const Op& op,
+                                     const Indexable& a, const Indexables&... others) {
+  typedef AllRandomAccess<decltype(a.begin()), decltype(others.begin())...>
+        random_access;
+  return reducer.combine(reduce_chunks_iterators(a.n_elem(), reducer, op,
+                                                 random_access{}, a.begin(),
+                                                 others.begin()...));
+}
+
+/** Compute the sum of op(a_i, b_i, ...) over all elements i of the
+ *  indexables a, b, ... using chunked, pairwise summation. */
+template <typename Result, typename Op, typename... Indexables>
+Result reduce_sum(const Op& op, const Indexables&... ibles) {
+  return reduce(PairwiseSumReducer<Result>{}, op, ibles...);
+}
+
+}  // namespace detail
+}  // namespace lazyten
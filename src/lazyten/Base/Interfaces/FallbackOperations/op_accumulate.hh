@@ -18,18 +18,23 @@
 //
 
 #pragma once
+#include "detail/reduce.hh"
 #include "lazyten/Base/Interfaces/Indexable_i.hh"
 #include "macro_defs.hh"
-#include <numeric>
 
 namespace lazyten {
 
-/** Compute the sum of all values of the indexable object */
+/** Compute the sum of all values of the indexable object
+ *
+ * Summation is done pairwise in chunks, which are processed in parallel
+ * for indexables with random-access iterators. The result does not
+ * depend on the number of threads (see set_reduction_n_threads).
+ */
 template <typename Indexable>
 ValidIndexableScalarT<Indexable> accumulate(const Indexable& i) {
   lazyten_called_fallback();
   typedef ValidIndexableScalarT<Indexable> scalar_type;
-  return std::accumulate(i.begin(), i.end(), Constants<scalar_type>::zero);
+  return detail::reduce_sum<scalar_type>([](scalar_type v) { return v; }, i);
 }
 
 }  // namespace lazyten
@@ -18,10 +18,10 @@
 //
 
 #pragma once
+#include "detail/reduce.hh"
 #include "lazyten/Base/Interfaces/Indexable_i.hh"
 #include "macro_defs.hh"
 #include "op_elementwise.hh"
-#include <numeric>
 
 namespace lazyten {
 
@@ -42,8 +42,14 @@ dot(const Indexable1& A, const Indexable2& B);
  */
 template <typename Indexable1, typename Indexable2>
 auto cdot(const Indexable1& A, const Indexable2& B) -> decltype(dot(conj(A), B)) {
+  assert_size(A.n_elem(), B.n_elem());
   lazyten_called_fallback();
-  return dot(conj(A), B);
+  typedef decltype(dot(conj(A), B)) ret_type;
+  typedef typename Indexable1::scalar_type scalar1;
+  typedef typename Indexable2::scalar_type scalar2;
+
+  return detail::reduce_sum<ret_type>(
+        [](scalar1 a, scalar2 b) { return krims::ConjFctr{}(a) * b; }, A, B);
 }
 ///@}
 
@@ -57,10 +63,12 @@ typename std::common_type<ValidIndexableScalarT<Indexable1>,
 dot(const Indexable1& A, const Indexable2& B) {
   assert_size(A.n_elem(), B.n_elem());
   lazyten_called_fallback();
-  typedef typename std::common_type<typename Indexable1::scalar_type,
-                                    typename Indexable2::scalar_type>::type ret_type;
+  typedef typename Indexable1::scalar_type scalar1;
+  typedef typename Indexable2::scalar_type scalar2;
+  typedef typename std::common_type<scalar1, scalar2>::type ret_type;
 
-  return std::inner_product(A.begin(), A.end(), B.begin(), Constants<ret_type>::zero);
+  // Summed pairwise in chunks, which are processed in parallel if possible.
+  return detail::reduce_sum<ret_type>([](scalar1 a, scalar2 b) { return a * b; }, A, B);
 }
 
 }  // namespace lazyten
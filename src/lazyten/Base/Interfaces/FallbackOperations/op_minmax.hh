@@ -18,9 +18,10 @@
 //
 
 #pragma once
+#include "detail/reduce.hh"
 #include "lazyten/Base/Interfaces/Indexable_i.hh"
 #include "macro_defs.hh"
-#include <algorithm>
+#include <functional>
 
 namespace lazyten {
 
@@ -28,14 +29,21 @@ namespace lazyten {
 template <typename Indexable>
 ValidIndexableScalarT<Indexable> min(const Indexable& i) {
   lazyten_called_fallback();
-  return *std::min_element(i.begin(), i.end());
+  typedef ValidIndexableScalarT<Indexable> scalar_type;
+  assert_greater(0, i.n_elem());
+  return detail::reduce(detail::ExtremumReducer<scalar_type, std::less<scalar_type>>{},
+                        [](scalar_type v) { return v; }, i);
 }
 
 /** Compute the maximum of all values of an indexable object */
 template <typename Indexable>
 ValidIndexableScalarT<Indexable> max(const Indexable& i) {
   lazyten_called_fallback();
-  return *std::max_element(i.begin(), i.end());
+  typedef ValidIndexableScalarT<Indexable> scalar_type;
+  assert_greater(0, i.n_elem());
+  return detail::reduce(
+        detail::ExtremumReducer<scalar_type, std::greater<scalar_type>>{},
+        [](scalar_type v) { return v; }, i);
 }
 
 }  // namespace lazyten
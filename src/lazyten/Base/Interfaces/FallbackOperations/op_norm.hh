@@ -18,12 +18,14 @@
 //
 
 #pragma once
+#include "detail/reduce.hh"
 #include "lazyten/Base/Interfaces/Indexable_i.hh"
 #include "lazyten/Base/Interfaces/Vector_i.hh"
 #include "macro_defs.hh"
 #include "op_accumulate.hh"
 #include "op_dot.hh"
 #include "op_minmax.hh"
+#include <functional>
 
 namespace lazyten {
 
@@ -34,7 +36,9 @@ template <typename Vector,
           typename std::enable_if<IsVector<Vector>::value, int>::type = 0>
 typename Vector::real_type norm_l1(const Vector& v) {
   lazyten_called_fallback();
-  return accumulate(abs(v));
+  typedef typename Vector::real_type real_type;
+  typedef typename Vector::scalar_type scalar_type;
+  return detail::reduce_sum<real_type>([](scalar_type s) { return std::abs(s); }, v);
 }
 
 /** Calculate the linf norm of the vector (abs. largest element) */
@@ -42,7 +46,11 @@ template <typename Vector,
           typename std::enable_if<IsVector<Vector>::value, int>::type = 0>
 typename Vector::real_type norm_linf(const Vector& v) {
   lazyten_called_fallback();
-  return max(abs(v));
+  typedef typename Vector::real_type real_type;
+  typedef typename Vector::scalar_type scalar_type;
+  if (v.n_elem() == 0) return Constants<real_type>::zero;
+  return detail::reduce(detail::ExtremumReducer<real_type, std::greater<real_type>>{},
+                        [](scalar_type s) { return std::abs(s); }, v);
 }
 
 /** Calculate the l2 norm squared of the vector. */
@@ -50,7 +58,10 @@ template <typename Vector,
           typename std::enable_if<IsVector<Vector>::value, int>::type = 0>
 typename Vector::real_type norm_l2_squared(const Vector& v) {
   lazyten_called_fallback();
-  return std::real(cdot(v, v));
+  typedef typename Vector::real_type real_type;
+  typedef typename Vector::scalar_type scalar_type;
+  return detail::reduce_sum<real_type>(
+        [](scalar_type s) { return static_cast<real_type>(std::norm(s)); }, v);
 }
 
 /** Calculate the l2 norm of the vector */
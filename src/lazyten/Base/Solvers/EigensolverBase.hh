@@ -21,9 +21,27 @@
 #include "EigensolverBaseKeys.hh"
 #include "EigensolverStateBase.hh"
 #include "SolverBase.hh"
+#include <algorithm>
 
 namespace lazyten {
 
+namespace detail {
+/** \brief The residual tolerance used by the native block eigensolvers
+ *
+ * The LOBPCG, Chebyshev and spectrum slicing solvers obtain the images of
+ * their vectors under the problem matrix implicitly (by linear combination
+ * or a polynomial recurrence), such that their residuals carry round-off
+ * of a few hundred machine epsilons. Tolerances below 100 times the default
+ * numeric tolerance can hence not be reached and are raised to this value.
+ * The solvers record the value used in the residual_tolerance field
+ * of their state.
+ */
+template <typename Real>
+Real floored_residual_tolerance(Real tolerance) {
+  return std::max(tolerance, 100 * Constants<Real>::default_tolerance);
+}
+}  // namespace detail
+
 /** Each eigensolver should support the following:
  *
  * - Default construction
@@ -0,0 +1,119 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/Base/Solvers/Eigensolution.hh"
+#include <array>
+#include <numeric>
+
+namespace lazyten {
+
+/** Container of the solution to an eigenproblem of a block-diagonal matrix
+ *
+ * Instead of padding the eigenvectors of each block with explicit zeros
+ * to the full size of the problem, the eigensolution of each block
+ * is kept separately together with the offset of the block.
+ * In other words the eigenvectors are stored in a block-sparse way.
+ *
+ * \tparam Evalue   The type used for the eigenvalues.
+ * \tparam Evector  The type used for the eigenvectors.
+ * \tparam N        The number of blocks.
+ */
+template <typename Evalue, typename Evector, size_t N>
+struct BlockDiagonalEigensolution {
+  /** \name Type definitions */
+  ///@{
+  /** The size type used in this class */
+  typedef typename Evector::size_type size_type;
+
+  /** The type used for the eigenvectors */
+  typedef Evector evector_type;
+
+  /** The type used for the eigenvalues */
+  typedef Evalue evalue_type;
+
+  /** The type of the eigensolution of a single block */
+  typedef Eigensolution<evalue_type, evector_type> block_solution_type;
+
+  /** The number of blocks */
+  static constexpr size_t n_blocks = N;
+  ///@}
+
+  /** \name Member attributes */
+  ///@{
+  /** The eigensolutions of the individual blocks */
+  std::array<block_solution_type, N> blocks;
+
+  /** The index of the first row/column of each block
+   *  in the full block-diagonal matrix */
+  std::array<size_type, N> block_offsets;
+
+  /** The size of the full block-diagonal matrix */
+  size_type dim = 0;
+  ///@}
+
+  /** The total number of eigenpairs over all blocks */
+  size_type n_ep() const {
+    return std::accumulate(
+          std::begin(blocks), std::end(blocks), size_type(0),
+          [](size_type s, const block_solution_type& b) { return s + b.n_ep(); });
+  }
+
+  /** Build the eigensolution of the full problem
+   *
+   * The eigenvectors of each block are padded with explicit zeros
+   * to the full size of the problem. The order is exactly the order of
+   * the eigenpairs inside the blocks, pasted together block by block.
+   */
+  Eigensolution<evalue_type, evector_type> padded() const;
+};
+
+//
+// ------------------------------------------------------
+//
+
+template <typename Evalue, typename Evector, size_t N>
+Eigensolution<Evalue, Evector> BlockDiagonalEigensolution<Evalue, Evector, N>::padded()
+      const {
+  Eigensolution<evalue_type, evector_type> ret;
+  ret.evalues().reserve(n_ep());
+
+  for (size_t b = 0; b < N; ++b) {
+    const block_solution_type& block = blocks[b];
+    ret.evalues().insert(ret.evalues().end(), block.evalues().begin(),
+                         block.evalues().end());
+
+    for (const evector_type& v : block.evectors()) {
+      evector_type padded(dim);  // zero-initialised
+      std::copy(v.begin(), v.end(), padded.begin() + block_offsets[b]);
+      ret.evectors().push_back(std::move(padded));
+    }
+  }
+  return ret;
+}
+
+/** Using statement to determine the block-diagonal eigensolution type for an
+ *  Eigenproblem's isHermitian flag and block-diagonal problem matrix type. */
+template <bool isHermitian, typename BlockMatrix>
+using BlockDiagonalEigensolutionTypeFor =
+      BlockDiagonalEigensolution<detail::Eigenvalue_t<isHermitian, BlockMatrix>,
+                                 detail::Eigenvector_t<isHermitian, BlockMatrix>,
+                                 BlockMatrix::n_blocks>;
+
+}  // namespace lazyten
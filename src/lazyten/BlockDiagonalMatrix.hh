@@ -34,6 +34,7 @@ class BlockDiagonalMatrix : public LazyMatrixExpression<Stored> {
   typedef LazyMatrixExpression<Stored> base_type;
   typedef typename base_type::scalar_type scalar_type;
   typedef typename base_type::stored_matrix_type stored_matrix_type;
+  typedef typename base_type::vector_type vector_type;
   typedef typename base_type::lazy_matrix_expression_ptr_type
         lazy_matrix_expression_ptr_type;
 
@@ -101,6 +102,9 @@ class BlockDiagonalMatrix : public LazyMatrixExpression<Stored> {
                      const scalar_type c_this = 1,
                      const scalar_type c_M = 0) const override;
 
+  /** Extract the diagonal by concatenating the diagonals of the blocks */
+  vector_type extract_diagonal() const override;
+
   template <typename VectorIn, typename VectorOut,
             mat_vec_apply_enabled_t<BlockDiagonalMatrix, VectorIn, VectorOut>...>
   void apply(const MultiVector<VectorIn>& x, MultiVector<VectorOut>& y,
@@ -140,6 +144,7 @@ class BlockDiagonalMatrix : public LazyMatrixExpression<Stored> {
   void update(const krims::GenMap& map) override {
     std::for_each(std::begin(m_blocks), std::end(m_blocks),
                   [&map](Matrix& m) { m.update(map); });
+    this->invalidate_property_cache();
   }
 
   lazy_matrix_expression_ptr_type clone() const override {
@@ -378,6 +383,18 @@ BlockDiagonalMatrix<Matrix, N, Stored>::operator()(size_t row, size_t col) const
   }
 }
 
+template <typename Matrix, size_t N, typename Stored>
+typename BlockDiagonalMatrix<Matrix, N, Stored>::vector_type
+BlockDiagonalMatrix<Matrix, N, Stored>::extract_diagonal() const {
+  vector_type diag(n_rows(), false);
+  for (auto it = std::begin(m_blocks); it != std::end(m_blocks); ++it) {
+    const auto block_diag = it->extract_diagonal();
+    std::copy(std::begin(block_diag), std::end(block_diag),
+              std::begin(diag) + index_range_of(it).front());
+  }
+  return diag;
+}
+
 template <typename Matrix, size_t N, typename Stored>
 void BlockDiagonalMatrix<Matrix, N, Stored>::extract_block(
       stored_matrix_type& M, const size_t start_row, const size_t start_col,
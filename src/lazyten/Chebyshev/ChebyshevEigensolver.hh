@@ -0,0 +1,652 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/Base/Solvers.hh"
+#include "lazyten/Exceptions.hh"
+#include "lazyten/detail/block_ops.hh"
+#include "lazyten/detail/small_eigensystem.hh"
+#include "lazyten/random.hh"
+#include <algorithm>
+#include <cmath>
+
+namespace lazyten {
+
+template <typename Eigenproblem>
+struct ChebyshevEigensolverState : public EigensolverStateBase<Eigenproblem> {
+  typedef EigensolverStateBase<Eigenproblem> base_type;
+  typedef typename base_type::eproblem_type eproblem_type;
+  typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::real_type real_type;
+  typedef typename base_type::size_type size_type;
+
+  /** The number of filter iterations performed */
+  size_t n_iterations;
+
+  /** The number of vectors the matrix A was applied to
+   *  (including the Lanczos steps for the spectral bounds) */
+  size_t n_a_applies;
+
+  /** The number of vectors the metric B was applied to */
+  size_t n_b_applies;
+
+  /** The number of vectors the inverse of the metric B was applied to */
+  size_t n_b_inverse_applies;
+
+  /** The estimates for the lower and upper end of the spectrum,
+   *  which were obtained from the Lanczos steps */
+  real_type lower_bound;
+  real_type upper_bound;
+
+  /** The residual tolerance actually used in the convergence check
+   *  (see detail::floored_residual_tolerance) */
+  real_type residual_tolerance;
+
+  /** Get the number of filter iterations performed */
+  size_t n_iter() const override { return n_iterations; }
+
+  /** Get the number of Problem matrix applies (A*x) */
+  size_t n_mtx_applies() const override { return n_a_applies; }
+
+  /** Setup the initial state from an eigenproblem to solve */
+  ChebyshevEigensolverState(const eproblem_type problem)
+        : base_type(std::move(problem)),
+          n_iterations(0),
+          n_a_applies(0),
+          n_b_applies(0),
+          n_b_inverse_applies(0),
+          lower_bound(0),
+          upper_bound(0),
+          residual_tolerance(0) {}
+};
+
+/** Class which contains all GenMap keys which are understood
+ *  by the ChebyshevEigensolver update_control_params as static string
+ *  members.
+ *  See their doc strings for the types required. */
+struct ChebyshevEigensolverKeys : public EigensolverBaseKeys {
+  /** Maximum number of filter iterations. Type: size_t */
+  static const std::string max_iter;
+
+  /** Degree of the Chebyshev filter polynomial. Type: size_t */
+  static const std::string degree;
+
+  /** Number of additional vectors in the iterated block. Type: size_t */
+  static const std::string n_extra_vectors;
+
+  /** Number of Lanczos steps to estimate the spectral bounds. Type: size_t */
+  static const std::string n_lanczos_steps;
+};
+
+/** \brief Chebyshev-filtered subspace iteration
+ *
+ * Native implementation of the Chebyshev-filtered subspace iteration
+ * (CheFSI) by Zhou and Saad for real Hermitian problems. In each iteration
+ * a Chebyshev polynomial of degree m in the problem operator is applied
+ * to the whole block of vectors, which damps the unwanted part of the
+ * spectrum and amplifies the wanted part, followed by a Rayleigh-Ritz
+ * step in the small subspace spanned by the filtered block.
+ *
+ * The polynomial is applied using the (scaled) three-term recurrence on
+ * the full MultiVector block. Only the two previous iterates and the
+ * image of the operator are held, all of which are allocated once per
+ * filter application and reused for all degrees.
+ *
+ * The damped interval reaches from the least wanted Ritz value of the
+ * current block to the far end of the spectrum, which is estimated by
+ * a few steps of Lanczos at the beginning of the solve.
+ *
+ * The method is especially cheap if a good guess for the subspace is
+ * available, e.g. from the previous step of an SCF procedure. If the
+ * state carries an eigensolution (e.g. via solve_with_guess), its
+ * eigenvectors are used as the initial block.
+ *
+ * \note Only real problems are supported (see EigensystemSolver).
+ *
+ * ## Control parameters and their default values
+ *   - max_iter: Maximum number of filter iterations. Default: 100
+ *   - which:    Which eigenvalues to target. Default: "SR";
+ *     allowed values:
+ *       - "SR"   Smallest real
+ *       - "LR"   Largest real
+ *   - tolerance: Tolerance for eigensolver, i.e. the maximal
+ *                residual norm relative to the magnitude of the
+ *                eigenvalue. Default: Default numeric tolerance
+ *                (as in Constants.hh), but at least the floor of
+ *                detail::floored_residual_tolerance.
+ *   - degree:   The degree of the filter polynomial. Default: 10
+ *   - n_extra_vectors: Number of guard vectors to iterate in addition
+ *                to the requested eigenpairs. Default: 0, which implies
+ *                that std::max(5, n_ep/4) extra vectors are used.
+ *   - n_lanczos_steps: Number of Lanczos steps used to estimate the
+ *                bounds of the spectrum. Default: 10
+ *
+ * ## Generalised problems
+ * Generalised problems are solved by filtering with the operator B^{-1} A,
+ * such that the metric B needs to have an implemented apply_inverse
+ * function (see the inverse() method).
+ *
+ * \tparam Eigenproblem  The eigenproblem to solve.
+ * \tparam State         The state type of the solver.
+ */
+template <typename Eigenproblem,
+          typename State = ChebyshevEigensolverState<Eigenproblem>>
+class ChebyshevEigensolver : public EigensolverBase<State> {
+  static_assert(std::is_same<Eigenproblem, typename State::eproblem_type>::value,
+                "The type Eigenproblem and the implicit eigenproblem type in the SCF "
+                "state have to agree");
+
+  static_assert(Eigenproblem::hermitian,
+                "The Chebyshev filter can only solve Hermitian eigenproblems.");
+
+  static_assert(Eigenproblem::real,
+                "The Chebyshev filter can only solve real problems at the moment.");
+
+ public:
+  //@{
+  /** Forwarded types */
+  typedef EigensolverBase<State> base_type;
+  typedef typename base_type::state_type state_type;
+  typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::real_type real_type;
+  typedef typename base_type::evalue_type evalue_type;
+  typedef typename base_type::evector_type evector_type;
+  typedef typename base_type::esoln_type esoln_type;
+  typedef typename base_type::stored_matrix_type stored_matrix_type;
+  typedef typename state_type::size_type size_type;
+  //@}
+
+  /** \name Constructor */
+  //@{
+  /** Construct an eigensolver with the default parameters */
+  ChebyshevEigensolver() {}
+
+  /** Construct an eigensolver setting the parameters from the map */
+  ChebyshevEigensolver(const krims::GenMap& map) : ChebyshevEigensolver() {
+    update_control_params(map);
+  }
+  //@}
+
+  /** \name Iteration control */
+  ///@{
+  /** Maximum number of filter iterations */
+  size_t max_iter = 100;
+
+  /** Degree of the Chebyshev polynomial */
+  size_t degree = 10;
+
+  /** \brief Number of extra (guard) vectors in the iterated block.
+   *
+   * By default 0, which implies that we use std::max(5, n_ep/4)
+   * extra vectors, but never more than dim - n_ep.
+   */
+  size_t n_extra_vectors = 0;  // i.e. auto-determine
+
+  /** Number of Lanczos steps used to estimate the spectral bounds */
+  size_t n_lanczos_steps = 10;
+
+  /** Update control parameters from Parameter map */
+  void update_control_params(const krims::GenMap& map) {
+    base_type::update_control_params(map);
+    max_iter = map.at(ChebyshevEigensolverKeys::max_iter, max_iter);
+    degree = map.at(ChebyshevEigensolverKeys::degree, degree);
+    n_extra_vectors = map.at(ChebyshevEigensolverKeys::n_extra_vectors, n_extra_vectors);
+    n_lanczos_steps = map.at(ChebyshevEigensolverKeys::n_lanczos_steps, n_lanczos_steps);
+  }
+
+  /** Get the current settings of all internal control parameters and
+   *  update the GenMap accordingly.
+   */
+  void get_control_params(krims::GenMap& map) const {
+    base_type::get_control_params(map);
+    map.update(ChebyshevEigensolverKeys::max_iter, max_iter);
+    map.update(ChebyshevEigensolverKeys::degree, degree);
+    map.update(ChebyshevEigensolverKeys::n_extra_vectors, n_extra_vectors);
+    map.update(ChebyshevEigensolverKeys::n_lanczos_steps, n_lanczos_steps);
+  }
+  ///@}
+
+  /** Implementation of the IterativeSolver method */
+  void solve_state(state_type& state) const override;
+
+ private:
+  /** Assert that the state of the control parameters is sensible.
+   *  In case its not, raise an ExcInvalidEigensolverParameters
+   *  exception */
+  void assert_valid_control_params(state_type& s) const;
+
+  /** Number of vectors in the iterated block */
+  size_type block_size(const Eigenproblem& problem) const;
+
+  /** Apply the operator, i.e. A for normal and B^{-1} A for generalised
+   *  problems, to x and store the result in y. For generalised problems
+   *  ax is used as a workspace for the image of x under A. */
+  void apply_operator(state_type& state, const MultiVector<evector_type>& x,
+                      MultiVector<evector_type>& ax,
+                      MultiVector<evector_type>& y) const;
+
+  /** Compute the image of x under B (or a shallow copy for normal problems) */
+  MultiVector<evector_type> apply_b(state_type& state,
+                                    const MultiVector<evector_type>& x) const;
+
+  /** Estimate the bounds of the spectrum by a few Lanczos steps
+   *  and store them in the state. */
+  void estimate_bounds(state_type& state) const;
+
+  /** Apply the scaled Chebyshev filter of the given degree, which damps the
+   *  interval [lower, upper], in-place to the block x.
+   *
+   *  \param wanted_end  The estimate for the eigenvalue at the wanted end of the
+   *                     spectrum, at which the filter is scaled to one.
+   */
+  void filter(state_type& state, MultiVector<evector_type>& x, real_type lower,
+              real_type upper, real_type wanted_end) const;
+
+  /** B-orthonormalise x in-place by two passes of classical Gram-Schmidt.
+   *  Columns which turn out to be linearly dependent are replaced by random
+   *  vectors. Returns the image of the result under B. */
+  MultiVector<evector_type> orthonormalise(state_type& state,
+                                           MultiVector<evector_type>& x) const;
+};
+
+//
+// ----------------------------------------------------------
+//
+
+template <typename Eigenproblem, typename State>
+void ChebyshevEigensolver<Eigenproblem, State>::assert_valid_control_params(
+      state_type& state) const {
+  const Eigenproblem& problem = state.eigenproblem();
+
+  //
+  // which
+  //
+  const std::string& which = base_type::which;
+  solver_assert(which == "SR" || which == "LR", state,
+                ExcInvalidSolverParametersEncountered(
+                      "The value " + which + " for which is not allowed in a "
+                                             "Chebyshev solver call (only SR and LR "
+                                             "are accepted)."));
+
+  //
+  // A, Diag and B
+  //
+  // note: We compare memory addresses
+  solver_assert(&problem.A() == &problem.Diag(), state,
+                ExcInvalidSolverParametersEncountered("The matrices A and Diag need "
+                                                      "to be the same objects."));
+
+  if (Eigenproblem::generalised) {
+    solver_assert(problem.B().has_apply_inverse(), state,
+                  ExcInvalidSolverParametersEncountered(
+                        "For generalised problems the metric B needs to have an "
+                        "implemented apply_inverse function (See documentation of "
+                        "the function inverse() how to get this)."));
+  }
+
+  //
+  // Iterations and degree
+  //
+  solver_assert(max_iter > 0, state,
+                ExcInvalidSolverParametersEncountered(
+                      "The maximal number of iterations needs to be positive."));
+  solver_assert(degree > 0, state,
+                ExcInvalidSolverParametersEncountered(
+                      "The degree of the Chebyshev filter needs to be positive."));
+  solver_assert(n_lanczos_steps > 1, state,
+                ExcInvalidSolverParametersEncountered(
+                      "At least two Lanczos steps are needed to estimate the bounds "
+                      "of the spectrum."));
+}
+
+template <typename Eigenproblem, typename State>
+typename ChebyshevEigensolver<Eigenproblem, State>::size_type
+ChebyshevEigensolver<Eigenproblem, State>::block_size(const Eigenproblem& problem) const {
+  const size_type n_ep = problem.n_ep();
+  const size_type n_extra =
+        n_extra_vectors > 0 ? n_extra_vectors : std::max<size_type>(5, n_ep / 4);
+  return std::min(problem.dim(), n_ep + n_extra);
+}
+
+template <typename Eigenproblem, typename State>
+void ChebyshevEigensolver<Eigenproblem, State>::apply_operator(
+      state_type& state, const MultiVector<evector_type>& x,
+      MultiVector<evector_type>& ax, MultiVector<evector_type>& y) const {
+  const Eigenproblem& problem = state.eigenproblem();
+  if (Eigenproblem::generalised) {
+    problem.A().apply(x, ax);
+    problem.B().apply_inverse(ax, y);
+    state.n_b_inverse_applies += x.n_vectors();
+  } else {
+    problem.A().apply(x, y);
+  }
+  state.n_a_applies += x.n_vectors();
+}
+
+template <typename Eigenproblem, typename State>
+MultiVector<typename ChebyshevEigensolver<Eigenproblem, State>::evector_type>
+ChebyshevEigensolver<Eigenproblem, State>::apply_b(
+      state_type& state, const MultiVector<evector_type>& x) const {
+  if (!Eigenproblem::generalised) return x;  // Shallow copy
+
+  MultiVector<evector_type> bx(x.n_elem(), x.n_vectors(), false);
+  state.eigenproblem().B().apply(x, bx);
+  state.n_b_applies += x.n_vectors();
+  return bx;
+}
+
+template <typename Eigenproblem, typename State>
+void ChebyshevEigensolver<Eigenproblem, State>::estimate_bounds(state_type& state) const {
+  const Eigenproblem& problem = state.eigenproblem();
+  const size_type dim = problem.dim();
+  const size_type k = std::min(dim, n_lanczos_steps);
+
+  // Lanczos with full reorthogonalisation (k is small), storing
+  // the projected matrix T = V^T A V
+  MultiVector<evector_type> v(dim, k + 1, false);
+  MultiVector<evector_type> bv = Eigenproblem::generalised
+                                       ? MultiVector<evector_type>(dim, k + 1, false)
+                                       : v;  // Shallow copy
+  MultiVector<evector_type> av(dim, 1, false);
+  std::vector<scalar_type> tmat(k * k, Constants<scalar_type>::zero);
+
+  v[0] = random<evector_type>(dim);
+  if (Eigenproblem::generalised) {
+    auto v0 = v.subview({0, 1});
+    auto bv0 = bv.subview({0, 1});
+    problem.B().apply(v0, bv0);
+    ++state.n_b_applies;
+  }
+  const real_type norm = std::sqrt(dot(v[0], bv[0]));
+  v[0] /= norm;
+  if (Eigenproblem::generalised) bv[0] /= norm;
+
+  size_type n_steps = k;
+  real_type beta = 0;
+  for (size_type j = 0; j < k; ++j) {
+    auto vj = v.subview({j, j + 1});
+    auto w = v.subview({j + 1, j + 2});
+    auto bw = bv.subview({j + 1, j + 2});
+    apply_operator(state, vj, av, w);
+    if (Eigenproblem::generalised) bv[j + 1] = av[0];  // B w = A v_j
+
+    auto basis = v.subview({0, j + 1});
+    auto bbasis = bv.subview({0, j + 1});
+    std::vector<scalar_type> coeff(j + 1, Constants<scalar_type>::zero);
+    for (size_t pass = 0; pass < 2; ++pass) {
+      std::vector<scalar_type> c = detail::block_gram(bbasis, w);
+      for (size_type i = 0; i <= j; ++i) {
+        coeff[i] += c[i];
+        c[i] = -c[i];
+      }
+      detail::block_combine(basis, c.data(), j + 1, w, Constants<scalar_type>::one);
+      if (Eigenproblem::generalised) {
+        detail::block_combine(bbasis, c.data(), j + 1, bw, Constants<scalar_type>::one);
+      }
+    }
+    for (size_type i = 0; i <= j; ++i) tmat[j * k + i] = tmat[i * k + j] = coeff[i];
+
+    beta = std::sqrt(std::max(Constants<real_type>::zero, dot(v[j + 1], bv[j + 1])));
+    if (beta <= Constants<real_type>::default_tolerance) {
+      // Invariant subspace found: The Ritz values are exact
+      n_steps = j + 1;
+      beta = 0;
+      break;
+    }
+    v[j + 1] /= beta;
+    if (Eigenproblem::generalised) bv[j + 1] /= beta;
+  }
+
+  // Ritz values of the projected matrix of the steps actually done
+  std::vector<scalar_type> t(n_steps * n_steps);
+  for (size_type j = 0; j < n_steps; ++j) {
+    for (size_type i = 0; i < n_steps; ++i) t[j * n_steps + i] = tmat[j * k + i];
+  }
+  std::vector<scalar_type> evals, evecs;
+  detail::small_eigensystem_hermitian(std::move(t), n_steps, evals, evecs);
+
+  // The extremal Ritz values are off from the true ends
+  // by at most the norm of the residual beta
+  state.lower_bound = evals.front() - beta;
+  state.upper_bound = evals.back() + beta;
+}
+
+template <typename Eigenproblem, typename State>
+void ChebyshevEigensolver<Eigenproblem, State>::filter(state_type& state,
+                                                       MultiVector<evector_type>& x,
+                                                       real_type lower, real_type upper,
+                                                       real_type wanted_end) const {
+  const size_type dim = x.n_elem();
+  const size_type n_vectors = x.n_vectors();
+  const real_type e = (upper - lower) / 2;  // Half-width of the damped interval
+  const real_type c = (upper + lower) / 2;  // Centre of the damped interval
+
+  // Scaling such that the filter is one at the wanted end
+  const real_type sigma1 = e / (wanted_end - c);
+  real_type sigma = sigma1;
+
+  // The two most recent iterates (x holds the older one) and the workspace
+  // for the image under the operator, all allocated once.
+  MultiVector<evector_type> y(dim, n_vectors, false);
+  MultiVector<evector_type> op_y(dim, n_vectors, false);
+  MultiVector<evector_type> ax = Eigenproblem::generalised
+                                       ? MultiVector<evector_type>(dim, n_vectors, false)
+                                       : MultiVector<evector_type>{};
+
+  // y = sigma1 / e * (Op - c) x
+  apply_operator(state, x, ax, op_y);
+  for (size_type k = 0; k < n_vectors; ++k) {
+    auto ity = std::begin(y[k]);
+    auto itx = std::begin(x[k]);
+    for (auto itop = std::begin(op_y[k]); itop != std::end(op_y[k]);
+         ++itop, ++itx, ++ity) {
+      *ity = sigma1 / e * (*itop - c * *itx);
+    }
+  }
+
+  for (size_type deg = 2; deg <= degree; ++deg) {
+    const real_type sigma_new = 1 / (2 / sigma1 - sigma);
+
+    // x_new = 2 sigma_new / e * (Op - c) y - sigma sigma_new x
+    // which is stored in x, since the old x is not needed any more.
+    apply_operator(state, y, ax, op_y);
+    const real_type fac = 2 * sigma_new / e;
+    const real_type fac_old = sigma * sigma_new;
+    for (size_type k = 0; k < n_vectors; ++k) {
+      auto ity = std::begin(y[k]);
+      auto itx = std::begin(x[k]);
+      for (auto itop = std::begin(op_y[k]); itop != std::end(op_y[k]);
+           ++itop, ++itx, ++ity) {
+        *itx = fac * (*itop - c * *ity) - fac_old * *itx;
+      }
+    }
+    std::swap(x, y);  // Swaps the buffers, no copy
+    sigma = sigma_new;
+  }
+
+  // The result of the last step is in y
+  std::swap(x, y);
+}
+
+template <typename Eigenproblem, typename State>
+MultiVector<typename ChebyshevEigensolver<Eigenproblem, State>::evector_type>
+ChebyshevEigensolver<Eigenproblem, State>::orthonormalise(
+      state_type& state, MultiVector<evector_type>& x) const {
+  const size_type dim = x.n_elem();
+  MultiVector<evector_type> bx = apply_b(state, x);
+
+  for (size_type j = 0; j < x.n_vectors(); ++j) {
+    auto basis = x.subview({0, j});
+    auto bbasis = bx.subview({0, j});
+    auto xj = x.subview({j, j + 1});
+    auto bxj = bx.subview({j, j + 1});
+
+    for (size_t attempt = 0; attempt < 5; ++attempt) {
+      const real_type norm0 =
+            std::sqrt(std::max(Constants<real_type>::zero, dot(x[j], bx[j])));
+      for (size_t pass = 0; j > 0 && pass < 2; ++pass) {
+        std::vector<scalar_type> c = detail::block_gram(bbasis, xj);
+        for (auto& elem : c) elem = -elem;
+        detail::block_combine(basis, c.data(), j, xj, Constants<scalar_type>::one);
+        if (Eigenproblem::generalised) {
+          detail::block_combine(bbasis, c.data(), j, bxj, Constants<scalar_type>::one);
+        }
+      }
+
+      const real_type norm =
+            std::sqrt(std::max(Constants<real_type>::zero, dot(x[j], bx[j])));
+      if (norm > Constants<real_type>::default_tolerance * norm0) {
+        x[j] /= norm;
+        if (Eigenproblem::generalised) bx[j] /= norm;
+        break;
+      }
+
+      // Linearly dependent: Try again with a random vector
+      x[j] = random<evector_type>(dim);
+      if (Eigenproblem::generalised) {
+        state.eigenproblem().B().apply(xj, bxj);
+        ++state.n_b_applies;
+      }
+    }
+  }
+  return bx;
+}
+
+template <typename Eigenproblem, typename State>
+void ChebyshevEigensolver<Eigenproblem, State>::solve_state(state_type& state) const {
+  assert_dbg(!state.is_failed(), krims::ExcInvalidState("Cannot solve a failed state"));
+  assert_valid_control_params(state);
+
+  const Eigenproblem& problem = state.eigenproblem();
+  const size_type dim = problem.dim();
+  const size_type n_ep = problem.n_ep();
+  const size_type m = block_size(problem);
+  const bool lowest = base_type::which == "SR";
+  const real_type tolerance = detail::floored_residual_tolerance(base_type::tolerance);
+  state.residual_tolerance = tolerance;
+
+  state.n_iterations = 0;
+  state.n_a_applies = 0;
+  state.n_b_applies = 0;
+  state.n_b_inverse_applies = 0;
+  estimate_bounds(state);
+
+  //
+  // Initial block from the guess, filled up with random vectors
+  //
+  MultiVector<evector_type> x;
+  {
+    const auto& guess = state.eigensolution().evectors();
+    if (guess.n_vectors() > 0 && guess.n_elem() == dim) {
+      const size_type n_guess = std::min(m, guess.n_vectors());
+      for (size_type i = 0; i < n_guess; ++i) x.push_back(evector_type(guess[i]));
+    }
+    while (x.n_vectors() < m) x.push_back(random<evector_type>(dim));
+  }
+
+  std::vector<real_type> theta(m);
+  MultiVector<evector_type> ax(dim, m, false);
+  while (true) {
+    //
+    // Rayleigh-Ritz in the B-orthonormalised block.
+    // The Ritz pairs are stored in order of priority.
+    //
+    MultiVector<evector_type> bx = orthonormalise(state, x);
+    problem.A().apply(x, ax);
+    state.n_a_applies += m;
+
+    std::vector<scalar_type> h = detail::block_gram(x, ax);
+    for (size_type j = 0; j < m; ++j) {
+      for (size_type i = j + 1; i < m; ++i) {
+        h[j * m + i] = h[i * m + j] = (h[j * m + i] + h[i * m + j]) / 2;
+      }
+    }
+    std::vector<scalar_type> evals, evecs;
+    detail::small_eigensystem_hermitian(std::move(h), m, evals, evecs);
+
+    std::vector<scalar_type> c(m * m);
+    for (size_type k = 0; k < m; ++k) {
+      const size_type idx = lowest ? k : m - 1 - k;
+      theta[k] = evals[idx];
+      std::copy(evecs.begin() + static_cast<ptrdiff_t>(idx * m),
+                evecs.begin() + static_cast<ptrdiff_t>((idx + 1) * m),
+                c.begin() + static_cast<ptrdiff_t>(k * m));
+    }
+
+    MultiVector<evector_type> ritz(dim, m, false);
+    MultiVector<evector_type> aritz(dim, m, false);
+    MultiVector<evector_type> britz =
+          Eigenproblem::generalised ? MultiVector<evector_type>(dim, m, false) : ritz;
+    detail::block_combine(x, c.data(), m, ritz);
+    detail::block_combine(ax, c.data(), m, aritz);
+    if (Eigenproblem::generalised) detail::block_combine(bx, c.data(), m, britz);
+    x = std::move(ritz);
+
+    //
+    // Convergence check on the wanted Ritz pairs
+    //
+    size_type n_converged = 0;
+    MultiVector<evector_type> r(dim, 1, false);
+    for (size_type k = 0; k < n_ep; ++k) {
+      auto itax = std::begin(aritz[k]);
+      auto itbx = std::begin(britz[k]);
+      for (auto itr = std::begin(r[0]); itr != std::end(r[0]); ++itr, ++itax, ++itbx) {
+        *itr = *itax - theta[k] * *itbx;
+      }
+      if (norm_l2(r[0]) <= tolerance * std::max<real_type>(1, std::abs(theta[k]))) {
+        ++n_converged;
+      }
+    }
+    if (n_converged == n_ep || m == dim) break;
+
+    solver_assert(state.n_iterations < max_iter, state,
+                  ExcMaximumNumberOfIterationsReached(max_iter));
+    ++state.n_iterations;
+
+    //
+    // Filter the block: Damp the interval between the least wanted
+    // Ritz value and the far end of the spectrum.
+    //
+    const real_type cut = theta[m - 1];
+    const real_type margin = std::max(std::abs(cut - theta[0]),
+                                      tolerance * std::max<real_type>(1, std::abs(cut)));
+
+    // The Ritz values are always within the spectrum, so the far end needs
+    // to be beyond them, which corrects a too optimistic estimate.
+    const real_type far_end = lowest ? std::max(state.upper_bound, cut + margin)
+                                     : std::min(state.lower_bound, cut - margin);
+    filter(state, x, std::min(cut, far_end), std::max(cut, far_end), theta[0]);
+  }
+
+  //
+  // Copy the wanted eigenpairs to the solution (in ascending order)
+  //
+  esoln_type& soln = state.eigensolution();
+  soln.evalues().clear();
+  soln.evectors().clear();
+  soln.evalues().reserve(n_ep);
+  soln.evectors().reserve(n_ep);
+  for (size_type i = 0; i < n_ep; ++i) {
+    const size_type k = lowest ? i : n_ep - 1 - i;
+    soln.evalues().push_back(theta[k]);
+    soln.evectors().push_back(evector_type(x[k]));
+  }
+}
+
+}  // namespace lazyten
@@ -28,6 +28,9 @@ class MatrixIterator;
 namespace detail {
 template <typename Matrix, bool Constness>
 class MatrixIteratorDefaultCore;
+
+template <typename Matrix>
+class MatrixIteratorBufferedCore;
 }  // namespace detail
 
 //! The default matrix iterator
@@ -40,6 +43,11 @@ template <typename Matrix>
 using DefaultMatrixConstIterator =
       MatrixIterator<detail::MatrixIteratorDefaultCore<Matrix, true>>;
 
+//! The matrix const iterator serving elements from buffered row tiles
+template <typename Matrix>
+using BufferedMatrixConstIterator =
+      MatrixIterator<detail::MatrixIteratorBufferedCore<Matrix>>;
+
 }  // namespace lazyten
 
 // This is intentional, in order to make sure that the cyclic dependency
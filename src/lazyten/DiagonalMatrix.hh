@@ -35,6 +35,7 @@ class DiagonalMatrix : public LazyMatrixExpression<StoredMatrix> {
   typedef typename base_type::lazy_matrix_expression_ptr_type
         lazy_matrix_expression_ptr_type;
   typedef typename StoredMatrix::vector_type stored_vector_type;
+  typedef typename base_type::vector_type vector_type;
 
   /** Construct from reference to diagonal elements */
   DiagonalMatrix(const stored_vector_type& diagonal)
@@ -84,6 +85,9 @@ class DiagonalMatrix : public LazyMatrixExpression<StoredMatrix> {
                      const scalar_type c_this = Constants<scalar_type>::one,
                      const scalar_type c_M = Constants<scalar_type>::zero) const override;
 
+  /** Return a copy of the diagonal elements */
+  vector_type extract_diagonal() const override { return *m_diagonal_ptr; }
+
   /** \brief Compute the Matrix-Multivector application -- generic version
    *
    * Loosely speaking we perform
@@ -164,9 +168,13 @@ class DiagonalMatrix : public LazyMatrixExpression<StoredMatrix> {
 
   /** Update method
    *
-   * \note does nothing
+   * \note Only forgets the cached properties, since a referenced
+   *       diagonal may have changed.
    */
-  void update(const krims::GenMap&) override {}
+  void update(const krims::GenMap&) override { this->invalidate_property_cache(); }
+
+  /** The diagonal is owned if the matrix was constructed from a temporary */
+  bool owns_data() const override { return m_diagonal_ptr.is_shared_ptr(); }
 
   /** Clone function */
   lazy_matrix_expression_ptr_type clone() const override {
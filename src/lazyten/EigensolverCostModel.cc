@@ -0,0 +1,109 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "EigensolverCostModel.hh"
+#include <limits>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+namespace lazyten {
+
+const std::string EigensolverCostModelKeys::seconds_per_dense_flop =
+      "seconds_per_dense_flop";
+const std::string EigensolverCostModelKeys::seconds_per_apply_flop =
+      "seconds_per_apply_flop";
+const std::string EigensolverCostModelKeys::seconds_per_ortho_flop =
+      "seconds_per_ortho_flop";
+const std::string EigensolverCostModelKeys::applies_per_eigenpair =
+      "applies_per_eigenpair";
+const std::string EigensolverCostModelKeys::max_dense_memory = "max_dense_memory";
+
+void EigensolverCostModel::update_parameters(const krims::GenMap& map) {
+  seconds_per_dense_flop =
+        map.at(EigensolverCostModelKeys::seconds_per_dense_flop, seconds_per_dense_flop);
+  seconds_per_apply_flop =
+        map.at(EigensolverCostModelKeys::seconds_per_apply_flop, seconds_per_apply_flop);
+  seconds_per_ortho_flop =
+        map.at(EigensolverCostModelKeys::seconds_per_ortho_flop, seconds_per_ortho_flop);
+  applies_per_eigenpair =
+        map.at(EigensolverCostModelKeys::applies_per_eigenpair, applies_per_eigenpair);
+  max_dense_memory = map.at(EigensolverCostModelKeys::max_dense_memory, max_dense_memory);
+}
+
+void EigensolverCostModel::get_parameters(krims::GenMap& map) const {
+  map.update(EigensolverCostModelKeys::seconds_per_dense_flop, seconds_per_dense_flop);
+  map.update(EigensolverCostModelKeys::seconds_per_apply_flop, seconds_per_apply_flop);
+  map.update(EigensolverCostModelKeys::seconds_per_ortho_flop, seconds_per_ortho_flop);
+  map.update(EigensolverCostModelKeys::applies_per_eigenpair, applies_per_eigenpair);
+  map.update(EigensolverCostModelKeys::max_dense_memory, max_dense_memory);
+}
+
+double EigensolverCostModel::dense_flops(size_t dim, size_t n_ep, bool generalised) {
+  const double n = static_cast<double>(dim);
+  const double m = static_cast<double>(n_ep);
+
+  // Householder tridiagonalisation and back-transformation of the eigenvectors
+  double flops = 4. / 3. * n * n * n + 2. * n * n * m;
+
+  // Cholesky factorisation (n^3/3) and reduction to standard form (2 n^3)
+  if (generalised) flops += 7. / 3. * n * n * n;
+  return flops;
+}
+
+double EigensolverCostModel::dense_time(size_t dim, size_t n_ep, bool generalised,
+                                        bool stored, double apply_time) const {
+  const double extract_time = stored ? 0. : static_cast<double>(dim) * apply_time;
+  return seconds_per_dense_flop * dense_flops(dim, n_ep, generalised) + extract_time;
+}
+
+double EigensolverCostModel::iterative_time(size_t dim, size_t n_ep,
+                                            double apply_time) const {
+  const double n = static_cast<double>(dim);
+  const double m = static_cast<double>(n_ep);
+  const double n_applies = applies_per_eigenpair * m;
+  const double ortho_flops = 4. * n * (2. * m + 1.);
+  return n_applies * (apply_time + seconds_per_ortho_flop * ortho_flops);
+}
+
+size_t EigensolverCostModel::dense_memory(size_t dim, bool generalised,
+                                          size_t scalar_size) {
+  // Copy of A, eigenvectors and workspace (divide and conquer: 2 n^2)
+  // plus the copy of B for generalised problems.
+  const size_t n_matrices = generalised ? 5 : 4;
+  return n_matrices * dim * dim * scalar_size;
+}
+
+size_t EigensolverCostModel::available_dense_memory() const {
+  if (max_dense_memory > 0) return max_dense_memory;
+
+#if defined __unix__ && defined _SC_PHYS_PAGES && defined _SC_PAGE_SIZE
+  const long pages = sysconf(_SC_PHYS_PAGES);
+  const long page_size = sysconf(_SC_PAGE_SIZE);
+  if (pages > 0 && page_size > 0) {
+    return static_cast<size_t>(pages) * static_cast<size_t>(page_size) / 2;
+  }
+#endif
+
+  // Unknown: Do not restrict dense methods
+  return std::numeric_limits<size_t>::max();
+}
+
+}  // namespace lazyten
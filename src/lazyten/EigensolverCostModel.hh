@@ -0,0 +1,146 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include <krims/GenMap.hh>
+#include <string>
+
+namespace lazyten {
+
+struct EigensolverCostModelKeys {
+  /** Time in seconds per floating point operation in dense linear
+   *  algebra (Lapack-like) kernels. Type: double */
+  static const std::string seconds_per_dense_flop;
+
+  /** Time in seconds per floating point operation when applying a stored
+   *  matrix to a vector. Type: double */
+  static const std::string seconds_per_apply_flop;
+
+  /** Time in seconds per floating point operation when orthogonalising
+   *  vectors against the subspace of an iterative solver. Type: double */
+  static const std::string seconds_per_ortho_flop;
+
+  /** Estimated number of matrix applies an iterative solver needs
+   *  per requested eigenpair. Type: double */
+  static const std::string applies_per_eigenpair;
+
+  /** Maximal memory (in bytes) a dense method may use.
+   *  Type: size_t */
+  static const std::string max_dense_memory;
+};
+
+/** A simple model for the runtime and memory requirements of dense and
+ *  iterative eigensolvers.
+ *
+ * The model is used by EigensystemSolver to select a method if
+ * method == "auto". The default parameters are rough numbers for a current
+ * desktop machine. Better values for a particular host can be obtained by
+ * running the eigensolver_calibration example program and passing the
+ * printed values as parameters.
+ *
+ * The cost of a *dense* method (tridiagonalisation and back-transformation,
+ * for generalised problems in addition the Cholesky reduction) is taken as
+ * \f[ t_\text{dense} = t_\text{flop} \left(\frac43 n^3 + 2 n^2 n_\text{ep}
+ *                     + g \frac73 n^3 \right) + t_\text{extract}, \f]
+ * where \f$ g \f$ is 1 for generalised problems and 0 otherwise. For lazy
+ * matrices \f$ t_\text{extract} \f$ is the time of n matrix applies, which
+ * are needed to build the dense matrix.
+ *
+ * The cost of an *iterative* method is modelled as
+ * \f[ t_\text{iter} = a\,n_\text{ep} \left( t_\text{apply}
+ *                     + t_\text{ortho} 4 n (2 n_\text{ep} + 1) \right), \f]
+ * i.e. a fixed number of applies a per eigenpair, each of which is
+ * accompanied by the orthogonalisation against a subspace of
+ * size \f$ 2 n_\text{ep} + 1 \f$. The orthogonalisation consists of
+ * dot products and vector updates, which are bound by the memory bandwidth,
+ * so its time per flop \f$ t_\text{ortho} \f$ is a separate parameter.
+ */
+struct EigensolverCostModel {
+  /** \name Model parameters */
+  ///@{
+  /** Time in seconds per floating point operation in dense kernels */
+  double seconds_per_dense_flop = 1e-10;
+
+  /** Time in seconds per floating point operation in a stored
+   *  matrix-vector product */
+  double seconds_per_apply_flop = 1e-9;
+
+  /** Time in seconds per floating point operation in the orthogonalisation
+   *  of an iterative solver */
+  double seconds_per_ortho_flop = 1e-9;
+
+  /** Number of matrix applies an iterative solver needs per eigenpair */
+  double applies_per_eigenpair = 40.;
+
+  /** Maximal memory in bytes a dense method may use.
+   *  If 0, half the physical memory of the host is used. */
+  size_t max_dense_memory = 0;
+  ///@}
+
+  /** Construct a cost model with the default parameters */
+  EigensolverCostModel() = default;
+
+  /** Construct a cost model setting the parameters from the map */
+  explicit EigensolverCostModel(const krims::GenMap& map) { update_parameters(map); }
+
+  /** Update the model parameters from GenMap map */
+  void update_parameters(const krims::GenMap& map);
+
+  /** Get the current model parameters and update the GenMap accordingly. */
+  void get_parameters(krims::GenMap& map) const;
+
+  /** Number of floating point operations of a dense solve
+   *  for n_ep eigenpairs of a problem of size dim. */
+  static double dense_flops(size_t dim, size_t n_ep, bool generalised);
+
+  /** Number of floating point operations of applying a stored dense
+   *  matrix of size dim to a vector. */
+  static double stored_apply_flops(size_t dim) {
+    return 2. * static_cast<double>(dim) * static_cast<double>(dim);
+  }
+
+  /** Estimated time of a single matrix apply for a stored matrix */
+  double stored_apply_time(size_t dim) const {
+    return seconds_per_apply_flop * stored_apply_flops(dim);
+  }
+
+  /** Estimated time in seconds of a dense solve.
+   *
+   * \param apply_time   Time of a single apply of the matrix.
+   * \param stored       Is the matrix already stored. If not its elements
+   *                     need to be extracted first (dim applies).
+   */
+  double dense_time(size_t dim, size_t n_ep, bool generalised, bool stored,
+                    double apply_time) const;
+
+  /** Estimated time in seconds of an iterative solve.
+   *
+   * \param apply_time   Time of a single apply of the matrix.
+   */
+  double iterative_time(size_t dim, size_t n_ep, double apply_time) const;
+
+  /** Estimated memory in bytes a dense method requires for a problem
+   *  of size dim with scalars of size scalar_size */
+  static size_t dense_memory(size_t dim, bool generalised, size_t scalar_size);
+
+  /** The memory in bytes available for dense methods */
+  size_t available_dense_memory() const;
+};
+
+}  // namespace lazyten
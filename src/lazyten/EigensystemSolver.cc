@@ -20,4 +20,5 @@
 
 namespace lazyten {
 const std::string EigensystemSolverKeys::method = "method";
+const std::string EigensystemSolverKeys::n_block_threads = "n_block_threads";
 }  // namespace lazyten
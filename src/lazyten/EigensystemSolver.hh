@@ -21,8 +21,16 @@
 #include "lazyten/Armadillo/ArmadilloEigensolver.hh"
 #include "lazyten/Arpack/ArpackEigensolver.hh"
 #include "lazyten/Base/Solvers.hh"
+#include "lazyten/Chebyshev/ChebyshevEigensolver.hh"
+#include "lazyten/EigensolverCostModel.hh"
+#include "lazyten/Lanczos/LanczosEigensolver.hh"
 #include "lazyten/Lapack/LapackEigensolver.hh"
+#include "lazyten/Lobpcg/LobpcgEigensolver.hh"
+#include "lazyten/SpectrumSlicing/SpectrumSlicingEigensolver.hh"
 #include "lazyten/config.hh"
+#include <chrono>
+#include <memory>
+#include <sstream>
 
 namespace lazyten {
 
@@ -30,15 +38,56 @@ namespace detail {
 /** Run an eigensolver and update the passed state accordingly */
 template <typename Solver>
 struct RunSolver {
+  /** Run the solver on the state.
+   *
+   * If inner_solver is not a nullptr, the solver object is kept inside the
+   * pointed-to shared pointer and reused on the next run, such that data
+   * cached inside the solver (e.g. factorisations) survives between runs.
+   * The caller has to make sure that the same Solver type is used on all
+   * runs sharing an inner_solver.
+   */
   template <typename State>
-  void run(State& state, const krims::GenMap& params) const;
+  void run(State& state, const krims::GenMap& params,
+           std::shared_ptr<void>* inner_solver = nullptr) const;
 };
 
-/** Specialisation of RunSolver for a disabled solver (does nothing) */
+/** Specialisation of RunSolver for a solver, which is disabled since it cannot
+ *  deal with the kind of eigenproblem at hand (e.g. a complex problem for a
+ *  solver only implemented for real problems). Always throws. */
 template <>
 struct RunSolver<void> {
   template <typename State>
-  void run(State&, const krims::GenMap&) const {}
+  void run(State&, const krims::GenMap&, std::shared_ptr<void>* = nullptr) const {
+    assert_throw(false, ExcInvalidSolverParametersEncountered(
+                              "The selected eigensolver method cannot solve this kind "
+                              "of eigenproblem."));
+  }
+};
+
+/** The data carried from one solve of a sequence of related eigenproblems
+ *  to the next, see EigensystemSolver::solve_next */
+template <typename Eigensolution>
+struct EigensystemSequence {
+  /** The number of solves done in this sequence */
+  size_t n_solves = 0;
+
+  /** The dimensionality of the problems in the sequence */
+  size_t dim = 0;
+
+  /** The method requested by the user when the sequence was started */
+  std::string requested_method;
+
+  /** The method used for all solves of the sequence */
+  std::string method;
+
+  /** The number of matrix applies needed for the first (cold) solve */
+  size_t n_mtx_applies_cold = 0;
+
+  /** The eigensolution of the previous solve, used as the guess */
+  Eigensolution solution;
+
+  /** The inner eigensolver object (including its cached data) */
+  std::shared_ptr<void> inner_solver;
 };
 }  // namespace detail
 
@@ -73,14 +122,52 @@ class EigensystemSolverState final : public EigensolverStateBase<Eigenproblem> {
   size_t n_iter() const override final { return m_n_iter; }
   size_t n_mtx_applies() const override final { return m_n_mtx_applies; }
 
+  /** The eigensolver method which was used to solve the problem */
+  const std::string& selected_method() const { return m_selected_method; }
+
+  /** Human-readable reasons why selected_method() was chosen
+   *  (only filled if the method was selected automatically) */
+  const std::vector<std::string>& selection_reasons() const {
+    return m_selection_reasons;
+  }
+
+  /** Set the method used to solve the problem and the reasons for its selection */
+  void set_selected_method(std::string method, std::vector<std::string> reasons = {}) {
+    m_selected_method = std::move(method);
+    m_selection_reasons = std::move(reasons);
+  }
+
+  /** The index of this solve inside a sequence of solves started by
+   *  EigensystemSolver::solve_next (0 for the cold-start solve
+   *  and for solves outside a sequence) */
+  size_t sequence_index = 0;
+
+  /** The number of matrix applies the cold-start solve of the sequence needed
+   *  (equal to n_mtx_applies() for solves outside a sequence) */
+  size_t n_mtx_applies_cold = 0;
+
+  /** The number of matrix applies saved by warm-starting from the previous
+   *  solve of the sequence compared to the cold-start solve. */
+  size_t n_mtx_applies_saved() const {
+    return n_mtx_applies_cold > m_n_mtx_applies ? n_mtx_applies_cold - m_n_mtx_applies
+                                                : 0;
+  }
+
  private:
   size_t m_n_iter;
   size_t m_n_mtx_applies;
+  std::string m_selected_method;
+  std::vector<std::string> m_selection_reasons;
 };
 
 struct EigensystemSolverKeys final : public EigensolverBaseKeys {
   /** The solver method to use. Type: string */
   static const std::string method;
+
+  /** The maximal number of threads used to solve the blocks of a
+   *  BlockDiagonalMatrix concurrently (see eigensystem_hermitian_blocks).
+   *  Type: size_t */
+  static const std::string n_block_threads;
 };
 
 /** \brief Envelope eigensolver that calls some
@@ -95,12 +182,30 @@ struct EigensystemSolverKeys final : public EigensolverBaseKeys {
  * eigensolvers are:
  *   - method:   Enforce that a particular eigensolver method should be
  *               used. Allowed values:
- *       - "auto"   Auto-select solver due to hardcoded criteria
- *                  (tolerance, number of eigenpairs, dimensionality /
- *                   sparsity of matrix, ...)
+ *       - "auto"   Auto-select the solver: Among the applicable methods
+ *                  a dense and an iterative method are chosen. If the
+ *                  dense method fits into memory, the one with lower
+ *                  estimated runtime is used. The estimate is based on
+ *                  the dimensionality, the number of eigenpairs and the
+ *                  cost of applying the matrix (modelled for stored,
+ *                  measured for lazy matrices), see EigensolverCostModel
+ *                  for details and its keys for the parameters.
+ *                  The choice and the reasons are recorded in the
+ *                  returned state.
  *       - "arpack"   Use ARPACK
  *       - "armadillo"   Use Armadillo
+ *       - "chebyshev"   Use the native Chebyshev-filtered subspace iteration
+ *                       (only real Hermitian problems, never selected by
+ *                       "auto"). See ChebyshevEigensolver for the keys.
+ *       - "lanczos"     Use the native thick-restart Lanczos solver
+ *                       (only real Hermitian problems)
  *       - "lapack"      Use Lapack
+ *       - "lobpcg"      Use the native LOBPCG solver
+ *                       (only real Hermitian problems)
+ *       - "slicing"     Use spectrum slicing to compute all eigenpairs
+ *                       in an interval (only real Hermitian problems
+ *                       in double precision, never selected by "auto").
+ *                       See SpectrumSlicingEigensolver for the keys.
  *   - which:    Which eigenvalues to target. Default: "SR";
  *     allowed values (for all eigensolvers):
  *       - "SM"   Smallest magnitude
@@ -112,7 +217,14 @@ struct EigensystemSolverKeys final : public EigensolverBaseKeys {
  *       - "LI"   Largest imaginary
  *                (only for complex scalar types)
  *   - tolerance: Tolerance for eigensolver. Default: Default numeric
- *                tolerance (as in Constants.hh)
+ *                tolerance (as in Constants.hh). The native methods
+ *                "chebyshev", "lobpcg" and "slicing" raise it to at least
+ *                100 times this value, see detail::floored_residual_tolerance.
+ *
+ * The native methods "chebyshev", "lanczos", "lobpcg" and "slicing" only
+ * support real problems. Their solver classes fail to compile for complex
+ * problems and requesting these methods for a complex problem here raises
+ * an ExcInvalidSolverParametersEncountered.
  *
  * \tparam Eigenproblem  The eigenproblem to solve.
  */
@@ -152,10 +264,14 @@ class EigensystemSolver final
   // The method to use to actually solve the underlying eigenproblem.
   std::string method = "auto";
 
+  /** The cost model used to select the method if method == "auto" */
+  EigensolverCostModel cost_model;
+
   /** Update control parameters from GenMap map */
   void update_control_params(const krims::GenMap& map) {
     base_type::update_control_params(map);
     method = map.at(EigensystemSolverKeys::method, method);
+    cost_model.update_parameters(map);
 
     // Copy the map to the internal storage such that we
     // can pass it on to the actual eigensolvers.
@@ -167,18 +283,67 @@ class EigensystemSolver final
   void get_control_params(krims::GenMap& map) const {
     base_type::get_control_params(map);
     map.update(EigensystemSolverKeys::method, method);
+    cost_model.get_parameters(map);
   }
   ///@}
 
   virtual void solve_state(state_type& state) const override final;
 
+  /** \name Sequences of related eigenproblems */
+  ///@{
+  /** \brief Solve the next eigenproblem of a sequence of related eigenproblems
+   *
+   * Typical for example for the SCF procedure, where nearly identical
+   * eigenproblems are solved over and over again. Compared to solve() the
+   * following is carried over from the previous call to solve_next:
+   *   - The method: It is only selected for the first problem of the sequence.
+   *   - The eigenpairs: The previous eigensolution is used as the guess,
+   *     which all iterative methods use to setup their starting
+   *     (Krylov) vectors or blocks.
+   *   - The inner eigensolver object and thus its cached data, e.g. the
+   *     Cholesky factorisation of the metric in the Lapack solver.
+   *
+   * The returned state records the position in the sequence and the
+   * number of matrix applies the cold-start solve needed, such that the
+   * savings can be monitored via n_mtx_applies_saved().
+   *
+   * A new sequence is started if the dimensionality of the problem or the
+   * requested method changes or if reset_sequence() is called.
+   * Since the data is kept inside the solver, the solver object should not
+   * be used from multiple threads when solving sequences.
+   */
+  state_type solve_next(const eproblem_type problem) const;
+
+  /** Forget all data carried over between the solves of a sequence,
+   *  such that the next call to solve_next starts from scratch. */
+  void reset_sequence() { m_sequence = sequence_type{}; }
+  ///@}
+
  private:
+  typedef detail::EigensystemSequence<esoln_type> sequence_type;
+
   bool should_use_arpack(const Eigenproblem& problem) const;
   bool should_use_armadillo(const Eigenproblem& problem) const;
+  bool should_use_lanczos(const Eigenproblem& problem) const;
   bool should_use_lapack(const Eigenproblem& problem) const;
+  bool should_use_lobpcg(const Eigenproblem& problem) const;
+
+  /** Select the method to use by the cost model and append the reasons
+   *  to reasons. Returns an empty string if no method is applicable. */
+  std::string select_method(const Eigenproblem& problem,
+                            std::vector<std::string>& reasons) const;
 
-  /** Setup and solve using the method provided */
-  void solve_with_method(const std::string& method, state_type& state) const;
+  /** Measure the time (in seconds) of a single apply of the matrix A */
+  double measure_apply_time(const Eigenproblem& problem) const;
+
+  /** Determine the method to use (either the user-selected one
+   *  or the automatically selected one) and record it in the state. */
+  std::string determine_method(state_type& state) const;
+
+  /** Setup and solve using the method provided. If inner_solver is not a nullptr,
+   *  the inner solver object is kept in there for the next solve (see RunSolver) */
+  void solve_with_method(const std::string& method, state_type& state,
+                         std::shared_ptr<void>* inner_solver = nullptr) const;
 
   /** Cache of the parameters which will be passed to the eigensolver.
    *
@@ -188,6 +353,9 @@ class EigensystemSolver final
    * get_control_params *before* the actual inner eigensolver invocation.
    */
   mutable krims::GenMap m_solver_params;
+
+  /** The data carried over between the solves of a sequence */
+  mutable sequence_type m_sequence;
 };
 
 //
@@ -197,9 +365,20 @@ class EigensystemSolver final
 namespace detail {
 template <typename Solver>
 template <typename State>
-void RunSolver<Solver>::run(State& state, const krims::GenMap& params) const {
+void RunSolver<Solver>::run(State& state, const krims::GenMap& params,
+                            std::shared_ptr<void>* inner_solver) const {
   typedef typename Solver::state_type solver_state_type;
 
+  // Setup the solver or reuse the one from the previous run:
+  std::shared_ptr<Solver> solver_ptr;
+  if (inner_solver != nullptr && *inner_solver != nullptr) {
+    solver_ptr = std::static_pointer_cast<Solver>(*inner_solver);
+    solver_ptr->update_control_params(params);
+  } else {
+    solver_ptr = std::make_shared<Solver>(params);
+    if (inner_solver != nullptr) *inner_solver = solver_ptr;
+  }
+
   // Setup the inner solver state:
   solver_state_type inner_state{state.eigenproblem()};
 
@@ -207,7 +386,7 @@ void RunSolver<Solver>::run(State& state, const krims::GenMap& params) const {
   inner_state.obtain_guess_from(state);
 
   try {
-    Solver{params}.solve_state(inner_state);
+    solver_ptr->solve_state(inner_state);
     state.push_intermediate_results(std::move(inner_state));
   } catch (SolverException& e) {
     // On exception still update the state reference
@@ -223,9 +402,9 @@ bool EigensystemSolver<Eigenproblem>::should_use_arpack(
 #ifdef LAZYTEN_HAVE_ARPACK
   // Arpack should be used if:
 
-  //   - not a complex or non-hermitian problem:
-  //     (TODO Not yet implemented)
-  if (!Eigenproblem::hermitian || !Eigenproblem::real) return false;
+  //   - a double precision problem
+  //     (real and complex, Hermitian and non-Hermitian are fine)
+  if (!std::is_same<typename Eigenproblem::real_type, double>::value) return false;
 
   //   - not a generalised problem without apply_inverse in B
   if (Eigenproblem::generalised && !problem.B().has_apply_inverse()) return false;
@@ -236,8 +415,11 @@ bool EigensystemSolver<Eigenproblem>::should_use_arpack(
   //      cannot do larger problems)
   if (problem.n_ep() >= problem.dim() / 2) return false;
 
-  //   - not if we desire small magnitude eigenvalues
-  //     (TODO mode 3 is not yet implemented)
+  //   - not if we desire small magnitude eigenvalues: In modes 1 and 2
+  //     ARPACK converges poorly towards the interior of the spectrum and
+  //     mode 3 (with sigma == 0) needs the dense factorisation of A done
+  //     by the solver. Since this already costs O(dim^3) flops and O(dim^2)
+  //     memory, the dense solver is the better choice in this case.
   if (base_type::which == std::string("SM")) return false;
 
   return true;
@@ -250,9 +432,13 @@ template <typename Eigenproblem>
 bool EigensystemSolver<Eigenproblem>::should_use_lapack(
       const Eigenproblem& /*problem*/) const {
 #ifdef LAZYTEN_HAVE_LAPACK
-  // Currently we only have Lapack for real, hermitian eigenproblems
-  // implemented.
-  if (Eigenproblem::real && Eigenproblem::hermitian) return true;
+  // Currently we only have Lapack for hermitian eigenproblems
+  // in single or double precision implemented.
+  typedef typename Eigenproblem::real_type real_type;
+  if (Eigenproblem::hermitian && (std::is_same<real_type, float>::value ||
+                                  std::is_same<real_type, double>::value)) {
+    return true;
+  }
 
   return false;
 #else
@@ -283,8 +469,124 @@ bool EigensystemSolver<Eigenproblem>::should_use_armadillo(
 }
 
 template <typename Eigenproblem>
-void EigensystemSolver<Eigenproblem>::solve_with_method(const std::string& method,
-                                                        state_type& state) const {
+bool EigensystemSolver<Eigenproblem>::should_use_lanczos(
+      const Eigenproblem& problem) const {
+  // The native Lanczos is the iterative method used if ARPACK is not
+  // available. It is only applicable if there is
+  //   - not a complex or non-hermitian problem
+  if (!Eigenproblem::real || !Eigenproblem::hermitian) return false;
+
+  //   - not a generalised problem without apply_inverse in B
+  if (Eigenproblem::generalised && !problem.B().has_apply_inverse()) return false;
+
+  //   - not a large number of eigenvalues is desired
+  if (problem.n_ep() >= problem.dim() / 2) return false;
+
+  //   - only extremal eigenvalues are desired
+  return base_type::which == std::string("SR") || base_type::which == std::string("LR") ||
+         base_type::which == std::string("LM");
+}
+
+template <typename Eigenproblem>
+bool EigensystemSolver<Eigenproblem>::should_use_lobpcg(
+      const Eigenproblem& /*problem*/) const {
+  // LOBPCG is always available, but only implemented for real
+  // hermitian problems and only the extremal ends of the spectrum.
+  // Since it is used as a last resort, it is not further restricted.
+  if (!Eigenproblem::real || !Eigenproblem::hermitian) return false;
+  return base_type::which == std::string("SR") || base_type::which == std::string("LR");
+}
+
+template <typename Eigenproblem>
+double EigensystemSolver<Eigenproblem>::measure_apply_time(
+      const Eigenproblem& problem) const {
+  typedef typename stored_matrix_type::vector_type vector_type;
+  MultiVector<vector_type> x(problem.dim(), 1, false);
+  MultiVector<vector_type> y(problem.dim(), 1, false);
+  std::fill(x[0].begin(), x[0].end(), Constants<scalar_type>::one);
+
+  const auto start = std::chrono::steady_clock::now();
+  problem.A().apply(x, y);
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+template <typename Eigenproblem>
+std::string EigensystemSolver<Eigenproblem>::select_method(
+      const Eigenproblem& problem, std::vector<std::string>& reasons) const {
+  // The applicable dense and iterative methods in order of preference
+  std::string dense;
+  if (should_use_armadillo(problem)) {
+    dense = "armadillo";
+  } else if (should_use_lapack(problem)) {
+    dense = "lapack";
+  }
+
+  std::string iterative;
+  if (should_use_arpack(problem)) {
+    iterative = "arpack";
+  } else if (should_use_lanczos(problem)) {
+    iterative = "lanczos";
+  } else if (should_use_lobpcg(problem)) {
+    iterative = "lobpcg";
+  }
+
+  if (dense.empty() || iterative.empty()) {
+    const std::string& only = dense.empty() ? iterative : dense;
+    if (!only.empty()) {
+      reasons.push_back("Only the " + std::string(dense.empty() ? "iterative" : "dense") +
+                        " method " + only + " is applicable to the problem.");
+    }
+    return only;
+  }
+
+  const size_t dim = problem.dim();
+  const size_t n_ep = problem.n_ep();
+  std::stringstream ss;
+  ss << "Problem dimension " << dim << ", " << n_ep << " eigenpairs (ratio "
+     << static_cast<double>(n_ep) / static_cast<double>(dim) << ").";
+  reasons.push_back(ss.str());
+
+  // Memory needed by the dense method
+  const size_t memory =
+        EigensolverCostModel::dense_memory(dim, Eigenproblem::generalised,
+                                           sizeof(scalar_type));
+  const size_t available = cost_model.available_dense_memory();
+  if (memory > available) {
+    ss.str("");
+    ss << "Dense method " << dense << " needs about " << memory
+       << " bytes of memory, but only " << available
+       << " bytes may be used. Selected iterative method " << iterative << ".";
+    reasons.push_back(ss.str());
+    return iterative;
+  }
+
+  // Estimated runtime of both methods
+  const bool stored = IsStoredMatrix<typename Eigenproblem::matrix_a_type>::value;
+  const double apply_time =
+        stored ? cost_model.stored_apply_time(dim) : measure_apply_time(problem);
+  ss.str("");
+  ss << "Matrix is " << (stored ? "stored" : "lazy") << ", time per apply "
+     << apply_time << " s (" << (stored ? "modelled" : "measured") << ").";
+  reasons.push_back(ss.str());
+
+  const double t_dense =
+        cost_model.dense_time(dim, n_ep, Eigenproblem::generalised, stored, apply_time);
+  const double t_iterative = cost_model.iterative_time(dim, n_ep, apply_time);
+  const std::string& selected = t_dense <= t_iterative ? dense : iterative;
+
+  ss.str("");
+  ss << "Estimated time of dense method " << dense << ": " << t_dense
+     << " s, of iterative method " << iterative << ": " << t_iterative
+     << " s. Selected " << selected << ".";
+  reasons.push_back(ss.str());
+  return selected;
+}
+
+template <typename Eigenproblem>
+void EigensystemSolver<Eigenproblem>::solve_with_method(
+      const std::string& method, state_type& state,
+      std::shared_ptr<void>* inner_solver) const {
   const std::string errorstring = "The eigensolver method " + method +
                                   "(set via the key '" + EigensystemSolverKeys::method +
                                   "') is not compiled into this version of lazyten.";
@@ -298,11 +600,11 @@ void EigensystemSolver<Eigenproblem>::solve_with_method(const std::string& metho
   if (method == std::string("arpack")) {
 #ifdef LAZYTEN_HAVE_ARPACK
     // Only instantiate the Arpack Eigensolver type in case
-    // the problem is hermitian.
-    typedef typename std::conditional<Eigenproblem::hermitian,
-                                      ArpackEigensolver<Eigenproblem>, void>::type
-          cond_arpack_type;
-    detail::RunSolver<cond_arpack_type>{}.run(state, m_solver_params);
+    // the problem is of double precision.
+    typedef typename std::conditional<
+          std::is_same<typename Eigenproblem::real_type, double>::value,
+          ArpackEigensolver<Eigenproblem>, void>::type cond_arpack_type;
+    detail::RunSolver<cond_arpack_type>{}.run(state, m_solver_params, inner_solver);
     return;
 #else
     assert_throw(false, ExcInvalidSolverParametersEncountered(errorstring));
@@ -315,11 +617,13 @@ void EigensystemSolver<Eigenproblem>::solve_with_method(const std::string& metho
   if (method == std::string("lapack")) {
 #ifdef LAZYTEN_HAVE_LAPACK
     // Only instantiate the Lapack Eigensolver type in case
-    // the problem is hermitian.
-    typedef typename std::conditional<Eigenproblem::hermitian,
-                                      LapackEigensolver<Eigenproblem>, void>::type
-          cond_lapack_type;
-    detail::RunSolver<cond_lapack_type>{}.run(state, m_solver_params);
+    // the problem is hermitian and of single or double precision.
+    typedef typename Eigenproblem::real_type real_type;
+    typedef typename std::conditional<
+          Eigenproblem::hermitian && (std::is_same<real_type, float>::value ||
+                                      std::is_same<real_type, double>::value),
+          LapackEigensolver<Eigenproblem>, void>::type cond_lapack_type;
+    detail::RunSolver<cond_lapack_type>{}.run(state, m_solver_params, inner_solver);
     return;
 #else
     assert_throw(false, ExcInvalidSolverParametersEncountered(errorstring));
@@ -331,13 +635,71 @@ void EigensystemSolver<Eigenproblem>::solve_with_method(const std::string& metho
   //
   if (method == std::string("armadillo")) {
 #ifdef LAZYTEN_HAVE_ARMADILLO
-    detail::RunSolver<ArmadilloEigensolver<Eigenproblem>>{}.run(state, m_solver_params);
+    detail::RunSolver<ArmadilloEigensolver<Eigenproblem>>{}.run(state, m_solver_params,
+                                                                inner_solver);
     return;
 #else
     assert_throw(false, ExcInvalidSolverParametersEncountered(errorstring));
 #endif  // LAZYTEN_HAVE_ARMADILLO
   }
 
+  //
+  // Lanczos
+  //
+  if (method == std::string("lanczos")) {
+    // Only instantiate the Lanczos Eigensolver type in case
+    // the problem is real and hermitian.
+    typedef typename std::conditional<Eigenproblem::hermitian && Eigenproblem::real,
+                                      LanczosEigensolver<Eigenproblem>, void>::type
+          cond_lanczos_type;
+    detail::RunSolver<cond_lanczos_type>{}.run(state, m_solver_params, inner_solver);
+    return;
+  }
+
+  //
+  // LOBPCG
+  //
+  if (method == std::string("lobpcg")) {
+    // Only instantiate the LOBPCG Eigensolver type in case
+    // the problem is real and hermitian.
+    typedef typename std::conditional<Eigenproblem::hermitian && Eigenproblem::real,
+                                      LobpcgEigensolver<Eigenproblem>, void>::type
+          cond_lobpcg_type;
+    detail::RunSolver<cond_lobpcg_type>{}.run(state, m_solver_params, inner_solver);
+    return;
+  }
+
+  //
+  // Chebyshev-filtered subspace iteration
+  //
+  if (method == std::string("chebyshev")) {
+    // Only instantiate the Chebyshev Eigensolver type in case
+    // the problem is real and hermitian.
+    typedef typename std::conditional<Eigenproblem::hermitian && Eigenproblem::real,
+                                      ChebyshevEigensolver<Eigenproblem>, void>::type
+          cond_chebyshev_type;
+    detail::RunSolver<cond_chebyshev_type>{}.run(state, m_solver_params, inner_solver);
+    return;
+  }
+
+  //
+  // Spectrum slicing
+  //
+  if (method == std::string("slicing")) {
+#ifdef LAZYTEN_HAVE_LAPACK
+    // Only instantiate the spectrum slicing type in case
+    // the problem is real, hermitian and of double precision.
+    typedef typename std::conditional<
+          Eigenproblem::hermitian && Eigenproblem::real &&
+                std::is_same<typename Eigenproblem::scalar_type, double>::value,
+          SpectrumSlicingEigensolver<Eigenproblem>, void>::type cond_slicing_type;
+    detail::RunSolver<cond_slicing_type>{}.run(state, m_solver_params, inner_solver);
+    return;
+#else
+    assert_throw(false, ExcInvalidSolverParametersEncountered(errorstring));
+#endif  // LAZYTEN_HAVE_LAPACK
+  }
+
   //
   // No method is supported!
   //
@@ -348,34 +710,60 @@ void EigensystemSolver<Eigenproblem>::solve_with_method(const std::string& metho
 }
 
 template <typename Eigenproblem>
-void EigensystemSolver<Eigenproblem>::solve_state(state_type& state) const {
-  assert_dbg(!state.is_failed(), krims::ExcInvalidState("Cannot solve a failed state"));
-
+std::string EigensystemSolver<Eigenproblem>::determine_method(state_type& state) const {
   /** User-selected */
   if (method != std::string("auto")) {
-    solve_with_method(method, state);
-    return;
+    state.set_selected_method(method);
+    return method;
   }
 
-  if (should_use_arpack(state.eigenproblem())) {
-    solve_with_method("arpack", state);
-    return;
-  }
-  if (should_use_armadillo(state.eigenproblem())) {
-    solve_with_method("armadillo", state);
-    return;
-  }
-  if (should_use_lapack(state.eigenproblem())) {
-    solve_with_method("lapack", state);
-    return;
-  }
-
-  assert_throw(false,
+  std::vector<std::string> reasons;
+  const std::string selected = select_method(state.eigenproblem(), reasons);
+  state.set_selected_method(selected, std::move(reasons));
+  assert_throw(!selected.empty(),
                ExcInvalidSolverParametersEncountered(
                      "Could not autodetermine an eigensolver for your eigenproblem. "
                      "This could mean that there are not enough solvers available in "
                      "your lazyten installation. Try forcing the use of an existing "
                      "solver via the \"method\" parameter in this case."));
+  return selected;
+}
+
+template <typename Eigenproblem>
+void EigensystemSolver<Eigenproblem>::solve_state(state_type& state) const {
+  assert_dbg(!state.is_failed(), krims::ExcInvalidState("Cannot solve a failed state"));
+  solve_with_method(determine_method(state), state);
+  state.n_mtx_applies_cold = state.n_mtx_applies();
+}
+
+template <typename Eigenproblem>
+typename EigensystemSolver<Eigenproblem>::state_type
+EigensystemSolver<Eigenproblem>::solve_next(const eproblem_type problem) const {
+  state_type state{std::move(problem)};
+  sequence_type& seq = m_sequence;
+
+  const bool warm = seq.n_solves > 0 && seq.requested_method == method &&
+                    seq.dim == state.eigenproblem().dim();
+  if (warm) {
+    state.obtain_guess_from(seq.solution);
+    const std::string reason =
+          "Method " + seq.method + " kept from the first solve of the sequence.";
+    state.set_selected_method(seq.method, {reason});
+  } else {
+    // Start a new sequence
+    seq = sequence_type{};
+    seq.requested_method = method;
+    seq.dim = state.eigenproblem().dim();
+    seq.method = determine_method(state);
+  }
+
+  solve_with_method(seq.method, state, &seq.inner_solver);
+
+  if (!warm) seq.n_mtx_applies_cold = state.n_mtx_applies();
+  state.sequence_index = seq.n_solves++;
+  state.n_mtx_applies_cold = seq.n_mtx_applies_cold;
+  seq.solution = state.eigensolution();
+  return state;
 }
 
 }  // namespace lazyten
@@ -40,6 +40,7 @@ class InverseProxy : public detail::ProxyBase<Matrix> {
   typedef typename base_type::matrix_type matrix_type;
   typedef typename base_type::size_type size_type;
   typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::vector_type vector_type;
   typedef typename base_type::lazy_matrix_expression_ptr_type
         lazy_matrix_expression_ptr_type;
 
@@ -106,6 +107,30 @@ class InverseProxy : public detail::ProxyBase<Matrix> {
                                            "extremely constly and hence disabled."));
   }
 
+  /** \brief Extract the diagonal of the inverse
+   *
+   * Applies the inverse of the inner matrix to tiles of unit vectors,
+   * i.e. this needs n_rows() inverse applies in total, but no element
+   * access. This is cheap for matrices with a cheap apply_inverse
+   * (e.g. diagonal or block-diagonal matrices).
+   */
+  vector_type extract_diagonal() const override {
+    const size_type n = this->n_rows();
+    const size_type tile = detail::diagonal_extraction_tile_size;
+
+    vector_type diag(n, false);
+    for (size_type start = 0; start < n; start += tile) {
+      const size_type size = std::min(tile, n - start);
+      MultiVector<vector_type> units(n, size);
+      for (size_type i = 0; i < size; ++i) units[i][start + i] = 1;
+
+      MultiVector<vector_type> cols(n, size, false);
+      apply(units, cols, Transposed::None);
+      for (size_type i = 0; i < size; ++i) diag[start + i] = cols[i][start + i];
+    }
+    return diag;
+  }
+
   /** \brief Compute the Matrix-Multivector application -- generic version
    *
    * Loosely speaking we perform
@@ -0,0 +1,573 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/Base/Solvers.hh"
+#include "lazyten/Exceptions.hh"
+#include "lazyten/detail/block_ops.hh"
+#include "lazyten/detail/small_eigensystem.hh"
+#include "lazyten/random.hh"
+#include <krims/Range.hh>
+
+namespace lazyten {
+
+template <typename Eigenproblem>
+struct LanczosEigensolverState : public EigensolverStateBase<Eigenproblem> {
+  typedef EigensolverStateBase<Eigenproblem> base_type;
+  typedef typename base_type::eproblem_type eproblem_type;
+  typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::size_type size_type;
+
+  /** The number of thick restarts performed */
+  size_t n_restarts;
+
+  /** The number of vectors the matrix A was applied to */
+  size_t n_a_applies;
+
+  /** The number of vectors the metric B was applied to */
+  size_t n_b_applies;
+
+  /** The number of vectors the inverse of the metric B was applied to */
+  size_t n_b_inverse_applies;
+
+  /** The number of second Gram-Schmidt passes which were needed
+   *  to keep the Lanczos basis orthogonal */
+  size_t n_reortho_steps;
+
+  /** The number of converged wanted Ritz values */
+  size_t n_conv_ritz;
+
+  /** Get the number of thick restarts performed */
+  size_t n_iter() const override { return n_restarts; }
+
+  /** Get the number of Problem matrix applies (A*x) */
+  size_t n_mtx_applies() const override { return n_a_applies; }
+
+  /** Setup the initial state from an eigenproblem to solve */
+  LanczosEigensolverState(const eproblem_type problem)
+        : base_type(std::move(problem)),
+          n_restarts(0),
+          n_a_applies(0),
+          n_b_applies(0),
+          n_b_inverse_applies(0),
+          n_reortho_steps(0),
+          n_conv_ritz(0) {}
+};
+
+/** Class which contains all GenMap keys which are understood
+ *  by the LanczosSolver update_control_params as static string
+ *  members.
+ *  See their doc strings for the types required. */
+struct LanczosEigensolverKeys : public EigensolverBaseKeys {
+  /** Maximum number of restarts. Type: size_t */
+  static const std::string max_iter;
+
+  /** Number of Lanczos vectors. Type: size_t */
+  static const std::string n_lanczos_vectors;
+
+  /** Number of Ritz vectors kept on restart. Type: size_t */
+  static const std::string n_kept_vectors;
+};
+
+/** \brief Thick-restart Lanczos eigensolver
+ *
+ * Native implementation of the thick-restart Lanczos method by Wu and
+ * Simon for Hermitian problems, which does not depend on ARPACK.
+ * The Lanczos basis is kept orthogonal by a classical Gram-Schmidt
+ * against the full basis, performed as block operations on the
+ * MultiVector of Lanczos vectors. The Lanczos vectors are allocated
+ * separately, such that for stored vectors they are packed chunk by
+ * chunk into a small contiguous buffer, on which BLAS-3 calls are done.
+ * A second Gram-Schmidt pass is only done when the first one cancelled
+ * a significant part of the vector (DGKS criterion). On each restart the
+ * wanted Ritz vectors together with some further Ritz vectors are kept
+ * and the iteration continues from the last Lanczos residual vector.
+ *
+ * \note Only real problems are supported (see EigensystemSolver).
+ *
+ * The memory needed is precisely n_lanczos_vectors + 1 vectors of the
+ * problem dimension (twice that for generalised problems) plus
+ * n_kept_vectors temporary vectors during a restart.
+ *
+ * ## Control parameters and their default values
+ *   - max_iter: Maximum number of restarts. Default: 100
+ *   - which:    Which eigenvalues to target. Default: "SR";
+ *     allowed values:
+ *       - "SR"   Smallest real
+ *       - "LR"   Largest real
+ *       - "LM"   Largest magnitude
+ *   - tolerance: Tolerance for eigensolver. Default: Default numeric
+ *                tolerance (as in Constants.hh)
+ *   - n_lanczos_vectors: The number of Lanczos vectors to use.
+ *                Default: 0, i.e. std::min(dim, std::max(2*n_ep+1, n_ep+20))
+ *   - n_kept_vectors: The number of Ritz vectors which are kept on a restart.
+ *                Has to be at least n_ep and less than n_lanczos_vectors.
+ *                Default: 0, i.e. n_ep + (n_lanczos_vectors - n_ep)/2
+ *
+ * ## Generalised problems
+ * Generalised problems are solved by iterating the operator B^{-1} A
+ * in the B inner product, such that the metric B needs to have an
+ * implemented apply_inverse function (see the inverse() method).
+ *
+ * ## Handlers and events
+ * The functions start_iteration_step and end_iteration_step
+ * are not used by this class.
+ *
+ * \tparam Eigenproblem  The eigenproblem to solve.
+ * \tparam State         The state type of the solver.
+ */
+template <typename Eigenproblem, typename State = LanczosEigensolverState<Eigenproblem>>
+class LanczosEigensolver : public EigensolverBase<State> {
+  static_assert(std::is_same<Eigenproblem, typename State::eproblem_type>::value,
+                "The type Eigenproblem and the implicit eigenproblem type in the SCF "
+                "state have to agree");
+
+  static_assert(Eigenproblem::hermitian,
+                "The Lanczos method can only solve Hermitian eigenproblems.");
+
+  static_assert(Eigenproblem::real,
+                "The Lanczos eigensolver can only solve real problems at the moment.");
+
+ public:
+  //@{
+  /** Forwarded types */
+  typedef EigensolverBase<State> base_type;
+  typedef typename base_type::state_type state_type;
+  typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::real_type real_type;
+  typedef typename base_type::evalue_type evalue_type;
+  typedef typename base_type::evector_type evector_type;
+  typedef typename base_type::esoln_type esoln_type;
+  typedef typename base_type::stored_matrix_type stored_matrix_type;
+  typedef typename state_type::size_type size_type;
+  //@}
+
+  /** \name Constructor */
+  //@{
+  /** Construct an eigensolver with the default parameters */
+  LanczosEigensolver() {}
+
+  /** Construct an eigensolver setting the parameters from the map */
+  LanczosEigensolver(const krims::GenMap& map) : LanczosEigensolver() {
+    update_control_params(map);
+  }
+  //@}
+
+  /** \name Iteration control */
+  ///@{
+  /** Maximum number of restarts */
+  size_t max_iter = 100;
+
+  /** \brief Number of Lanczos vectors
+   *  By default 0, which implies that we use
+   *  std::min(dim, std::max(2*n_ep+1, n_ep+20)) vectors.
+   */
+  size_t n_lanczos_vectors = 0;  // i.e. auto-determine
+
+  /** \brief Number of Ritz vectors kept on restart.
+   *  By default 0, which implies that we keep
+   *  n_ep + (n_lanczos_vectors - n_ep)/2 vectors.
+   */
+  size_t n_kept_vectors = 0;  // i.e. auto-determine
+
+  /** Update control parameters from Parameter map */
+  void update_control_params(const krims::GenMap& map) {
+    base_type::update_control_params(map);
+    max_iter = map.at(LanczosEigensolverKeys::max_iter, max_iter);
+    n_lanczos_vectors =
+          map.at(LanczosEigensolverKeys::n_lanczos_vectors, n_lanczos_vectors);
+    n_kept_vectors = map.at(LanczosEigensolverKeys::n_kept_vectors, n_kept_vectors);
+  }
+
+  /** Get the current settings of all internal control parameters and
+   *  update the GenMap accordingly.
+   */
+  void get_control_params(krims::GenMap& map) const {
+    base_type::get_control_params(map);
+    map.update(LanczosEigensolverKeys::max_iter, max_iter);
+    map.update(LanczosEigensolverKeys::n_lanczos_vectors, n_lanczos_vectors);
+    map.update(LanczosEigensolverKeys::n_kept_vectors, n_kept_vectors);
+  }
+  ///@}
+
+  /** Implementation of the IterativeSolver method */
+  void solve_state(state_type& state) const override;
+
+ private:
+  /** Assert that the state of the control parameters is sensible.
+   *  In case its not, raise an ExcInvalidEigensolverParameters
+   *  exception */
+  void assert_valid_control_params(state_type& s) const;
+
+  /** The number of Lanczos vectors to use for this problem */
+  size_type lanczos_size(const Eigenproblem& problem) const;
+
+  /** The number of Ritz vectors to keep on restart for this problem */
+  size_type kept_size(const Eigenproblem& problem) const;
+
+  /** Indices of the Ritz values in order of priority, i.e. the most wanted first */
+  std::vector<size_type> priority_order(const std::vector<scalar_type>& evals) const;
+
+  /** B-orthogonalise the vector v[j] (with image bv[j]) against the first
+   *  j vectors of the Lanczos basis.
+   *
+   * \param norm0  The B-norm of the vector before orthogonalisation
+   * \param coeff  The Gram-Schmidt coefficients, i.e. the projections
+   *               onto the basis vectors (resized by the function)
+   * \returns The B-norm of the vector after orthogonalisation
+   */
+  real_type orthogonalise(state_type& state, MultiVector<evector_type>& v,
+                          MultiVector<evector_type>& bv, size_type j, real_type norm0,
+                          std::vector<scalar_type>& coeff) const;
+
+  /** Setup the starting vector v[0] and its image bv[0] from the guess
+   *  in the state or randomly */
+  void setup_start_vector(state_type& state, MultiVector<evector_type>& v,
+                          MultiVector<evector_type>& bv) const;
+};
+
+//
+// ----------------------------------------------------------
+//
+
+template <typename Eigenproblem, typename State>
+void LanczosEigensolver<Eigenproblem, State>::assert_valid_control_params(
+      state_type& state) const {
+  const Eigenproblem& problem = state.eigenproblem();
+
+  //
+  // which
+  //
+  const std::string& which = base_type::which;
+  solver_assert(which == "SR" || which == "LR" || which == "LM", state,
+                ExcInvalidSolverParametersEncountered(
+                      "The value " + which + " for which is not allowed in a "
+                                             "Lanczos solver call (only SR, LR and "
+                                             "LM are accepted)."));
+
+  //
+  // A, Diag and B
+  //
+  // note: We compare memory addresses
+  solver_assert(&problem.A() == &problem.Diag(), state,
+                ExcInvalidSolverParametersEncountered("The matrices A and Diag need "
+                                                      "to be the same objects."));
+
+  if (Eigenproblem::generalised) {
+    solver_assert(problem.B().has_apply_inverse(), state,
+                  ExcInvalidSolverParametersEncountered(
+                        "For generalised problems the metric B needs to have an "
+                        "implemented apply_inverse function (See documentation of "
+                        "the function inverse() how to get this)."));
+  }
+
+  //
+  // Eigenpairs
+  //
+  solver_assert(
+        problem.n_ep() < problem.dim(), state,
+        ExcInvalidSolverParametersEncountered(
+              "The number of eigenpairs to compute (==" + std::to_string(problem.n_ep()) +
+              ") must be less than the dimensionality of the problem (== " +
+              std::to_string(problem.dim()) + ")"));
+
+  //
+  // Lanczos and kept vectors
+  //
+  if (n_lanczos_vectors > 0) {
+    solver_assert(n_lanczos_vectors <= problem.dim() &&
+                        n_lanczos_vectors > problem.n_ep(),
+                  state,
+                  ExcInvalidSolverParametersEncountered(
+                        "The number of Lanczos vectors (== " +
+                        std::to_string(n_lanczos_vectors) +
+                        ") needs to be larger than the number of eigenpairs and no "
+                        "larger than the problem size."));
+  }
+
+  if (n_kept_vectors > 0) {
+    solver_assert(n_kept_vectors >= problem.n_ep() &&
+                        n_kept_vectors < lanczos_size(problem),
+                  state,
+                  ExcInvalidSolverParametersEncountered(
+                        "The number of kept vectors (== " +
+                        std::to_string(n_kept_vectors) +
+                        ") needs to be at least the number of eigenpairs and less "
+                        "than the number of Lanczos vectors."));
+  }
+}
+
+template <typename Eigenproblem, typename State>
+typename LanczosEigensolver<Eigenproblem, State>::size_type
+LanczosEigensolver<Eigenproblem, State>::lanczos_size(const Eigenproblem& problem) const {
+  if (n_lanczos_vectors > 0) return n_lanczos_vectors;
+  const size_type n_ep = problem.n_ep();
+  return std::min(problem.dim(), std::max<size_type>(2 * n_ep + 1, n_ep + 20));
+}
+
+template <typename Eigenproblem, typename State>
+typename LanczosEigensolver<Eigenproblem, State>::size_type
+LanczosEigensolver<Eigenproblem, State>::kept_size(const Eigenproblem& problem) const {
+  if (n_kept_vectors > 0) return n_kept_vectors;
+  const size_type n_ep = problem.n_ep();
+  return n_ep + (lanczos_size(problem) - n_ep) / 2;
+}
+
+template <typename Eigenproblem, typename State>
+std::vector<typename LanczosEigensolver<Eigenproblem, State>::size_type>
+LanczosEigensolver<Eigenproblem, State>::priority_order(
+      const std::vector<scalar_type>& evals) const {
+  // Note: evals is sorted ascendingly
+  const std::string& which = base_type::which;
+  if (which == "LM") {
+    return krims::argsort(std::begin(evals), std::end(evals),
+                          [](const scalar_type& a, const scalar_type& b) {
+                            return std::abs(a) > std::abs(b);
+                          });
+  }
+
+  std::vector<size_type> ret(evals.size());
+  std::iota(std::begin(ret), std::end(ret), 0);
+  if (which == "LR") std::reverse(std::begin(ret), std::end(ret));
+  return ret;
+}
+
+template <typename Eigenproblem, typename State>
+typename LanczosEigensolver<Eigenproblem, State>::real_type
+LanczosEigensolver<Eigenproblem, State>::orthogonalise(
+      state_type& state, MultiVector<evector_type>& v, MultiVector<evector_type>& bv,
+      size_type j, real_type norm0, std::vector<scalar_type>& coeff) const {
+  coeff.assign(j, Constants<scalar_type>::zero);
+  real_type norm = norm0;
+  if (j == 0) return norm;
+
+  auto basis = v.subview({0, j});
+  auto bbasis = bv.subview({0, j});
+  auto w = v.subview({j, j + 1});
+  auto bw = bv.subview({j, j + 1});
+
+  // Classical Gram-Schmidt with one optional second pass
+  // if more than 1/sqrt(2) of the norm was cancelled (DGKS criterion)
+  for (size_t pass = 0; pass < 2; ++pass) {
+    std::vector<scalar_type> c = detail::block_gram(bbasis, w);
+    for (size_type i = 0; i < j; ++i) {
+      coeff[i] += c[i];
+      c[i] = -c[i];
+    }
+
+    detail::block_combine(basis, c.data(), j, w, Constants<scalar_type>::one);
+    if (Eigenproblem::generalised) {
+      detail::block_combine(bbasis, c.data(), j, bw, Constants<scalar_type>::one);
+    }
+
+    const real_type norm_prev = norm;
+    norm = std::sqrt(std::max(Constants<real_type>::zero, dot(v[j], bv[j])));
+    if (norm > norm_prev / std::sqrt(real_type(2))) break;
+    if (pass == 0) ++state.n_reortho_steps;
+  }
+  return norm;
+}
+
+template <typename Eigenproblem, typename State>
+void LanczosEigensolver<Eigenproblem, State>::setup_start_vector(
+      state_type& state, MultiVector<evector_type>& v,
+      MultiVector<evector_type>& bv) const {
+  const Eigenproblem& problem = state.eigenproblem();
+  const auto& guess = state.eigensolution().evectors();
+
+  // Use the sum of the guess vectors, such that the Krylov space
+  // is rich in the previously found eigenvectors.
+  if (guess.n_vectors() > 0 && guess.n_elem() == problem.dim()) {
+    v[0].set_zero();
+    for (size_type i = 0; i < guess.n_vectors(); ++i) v[0] += guess[i];
+  } else {
+    v[0] = random<evector_type>(problem.dim());
+  }
+
+  if (Eigenproblem::generalised) {
+    auto v0 = v.subview({0, 1});
+    auto bv0 = bv.subview({0, 1});
+    problem.B().apply(v0, bv0);
+    ++state.n_b_applies;
+  }
+
+  const real_type norm = std::sqrt(dot(v[0], bv[0]));
+  v[0] /= norm;
+  if (Eigenproblem::generalised) bv[0] /= norm;
+}
+
+template <typename Eigenproblem, typename State>
+void LanczosEigensolver<Eigenproblem, State>::solve_state(state_type& state) const {
+  assert_dbg(!state.is_failed(), krims::ExcInvalidState("Cannot solve a failed state"));
+  assert_valid_control_params(state);
+
+  const Eigenproblem& problem = state.eigenproblem();
+  const size_type dim = problem.dim();
+  const size_type n_ep = problem.n_ep();
+  const size_type ncv = lanczos_size(problem);
+  const size_type n_kept = kept_size(problem);
+  const real_type tolerance =
+        std::max(base_type::tolerance, Constants<real_type>::default_tolerance);
+
+  state.n_restarts = 0;
+  state.n_a_applies = 0;
+  state.n_b_applies = 0;
+  state.n_b_inverse_applies = 0;
+  state.n_reortho_steps = 0;
+  state.n_conv_ritz = 0;
+
+  // The Lanczos basis (including the residual vector at index ncv),
+  // its image under B and the projected matrix T = V^T A V.
+  MultiVector<evector_type> v(dim, ncv + 1);
+  MultiVector<evector_type> bv = Eigenproblem::generalised
+                                       ? MultiVector<evector_type>(dim, ncv + 1)
+                                       : v;  // Shallow copy
+  std::vector<scalar_type> tmat(ncv * ncv, Constants<scalar_type>::zero);
+  MultiVector<evector_type> av(dim, 1, false);
+
+  setup_start_vector(state, v, bv);
+
+  size_type k = 0;     // Number of vectors carried over from the last restart
+  real_type beta = 0;  // Coupling of the residual vector to the basis
+  std::vector<scalar_type> evals, evecs;
+  std::vector<size_type> order;
+  std::vector<scalar_type> coeff;
+  while (true) {
+    //
+    // Extend the Lanczos basis from k to ncv vectors
+    //
+    for (size_type j = k; j < ncv; ++j) {
+      auto vj = v.subview({j, j + 1});
+      auto w = v.subview({j + 1, j + 2});
+      problem.A().apply(vj, av);
+      ++state.n_a_applies;
+
+      if (Eigenproblem::generalised) {
+        // w = B^{-1} A v_j and B w = A v_j
+        problem.B().apply_inverse(av, w);
+        ++state.n_b_inverse_applies;
+        bv[j + 1] = av[0];
+      } else {
+        v[j + 1] = av[0];
+      }
+
+      const real_type norm0 = std::sqrt(dot(v[j + 1], bv[j + 1]));
+      beta = orthogonalise(state, v, bv, j + 1, norm0, coeff);
+      for (size_type i = 0; i <= j; ++i) {
+        tmat[j * ncv + i] = tmat[i * ncv + j] = coeff[i];
+      }
+
+      if (beta <= Constants<real_type>::default_tolerance * norm0) {
+        // Invariant subspace found: Continue with a random vector
+        // orthogonal to the current basis, which does not couple to it.
+        beta = 0;
+        if (j + 1 >= dim) break;
+
+        v[j + 1] = random<evector_type>(dim);
+        if (Eigenproblem::generalised) {
+          auto bw = bv.subview({j + 1, j + 2});
+          problem.B().apply(w, bw);
+          ++state.n_b_applies;
+        }
+        const real_type nrand = std::sqrt(dot(v[j + 1], bv[j + 1]));
+        const real_type nnew = orthogonalise(state, v, bv, j + 1, nrand, coeff);
+        v[j + 1] /= nnew;
+        if (Eigenproblem::generalised) bv[j + 1] /= nnew;
+      } else {
+        v[j + 1] /= beta;
+        if (Eigenproblem::generalised) bv[j + 1] /= beta;
+      }
+    }
+
+    //
+    // Ritz values and convergence check
+    //
+    detail::small_eigensystem_hermitian(tmat, ncv, evals, evecs);
+    order = priority_order(evals);
+
+    state.n_conv_ritz = 0;
+    for (size_type i = 0; i < n_ep; ++i) {
+      const size_type idx = order[i];
+      const real_type resid = std::abs(beta * evecs[idx * ncv + ncv - 1]);
+      if (resid <= tolerance * std::max<real_type>(1, std::abs(evals[idx]))) {
+        ++state.n_conv_ritz;
+      }
+    }
+    if (state.n_conv_ritz == n_ep) break;
+
+    solver_assert(state.n_restarts < max_iter, state,
+                  ExcMaximumNumberOfIterationsReached(max_iter));
+    ++state.n_restarts;
+
+    //
+    // Thick restart: Keep the n_kept most wanted Ritz vectors
+    // and continue from the residual vector.
+    //
+    k = n_kept;
+    std::vector<scalar_type> y(ncv * k);
+    for (size_type i = 0; i < k; ++i) {
+      std::copy(evecs.begin() + static_cast<ptrdiff_t>(order[i] * ncv),
+                evecs.begin() + static_cast<ptrdiff_t>((order[i] + 1) * ncv),
+                y.begin() + static_cast<ptrdiff_t>(i * ncv));
+    }
+
+    {
+      MultiVector<evector_type> ritz(dim, k, false);
+      detail::block_combine(v.subview({0, ncv}), y.data(), ncv, ritz);
+      for (size_type i = 0; i < k; ++i) std::swap(v[i], ritz[i]);
+    }
+    if (Eigenproblem::generalised) {
+      MultiVector<evector_type> britz(dim, k, false);
+      detail::block_combine(bv.subview({0, ncv}), y.data(), ncv, britz);
+      for (size_type i = 0; i < k; ++i) std::swap(bv[i], britz[i]);
+    }
+    std::swap(v[k], v[ncv]);
+    if (Eigenproblem::generalised) std::swap(bv[k], bv[ncv]);
+
+    // The projected matrix is diagonal in the kept Ritz vectors. The coupling
+    // to the residual vector is obtained when orthogonalising A v_k.
+    std::fill(tmat.begin(), tmat.end(), Constants<scalar_type>::zero);
+    for (size_type i = 0; i < k; ++i) tmat[i * ncv + i] = evals[order[i]];
+  }
+
+  //
+  // Compute the wanted Ritz vectors and copy them to the solution (ascending order)
+  //
+  std::vector<size_type> wanted(order.begin(),
+                                order.begin() + static_cast<ptrdiff_t>(n_ep));
+  std::sort(wanted.begin(), wanted.end());
+
+  std::vector<scalar_type> y(ncv * n_ep);
+  for (size_type i = 0; i < n_ep; ++i) {
+    std::copy(evecs.begin() + static_cast<ptrdiff_t>(wanted[i] * ncv),
+              evecs.begin() + static_cast<ptrdiff_t>((wanted[i] + 1) * ncv),
+              y.begin() + static_cast<ptrdiff_t>(i * ncv));
+  }
+
+  esoln_type& soln = state.eigensolution();
+  soln.evalues().clear();
+  soln.evalues().reserve(n_ep);
+  for (const size_type idx : wanted) soln.evalues().push_back(evals[idx]);
+
+  MultiVector<evector_type> ritz(dim, n_ep, false);
+  detail::block_combine(v.subview({0, ncv}), y.data(), ncv, ritz);
+  soln.evectors() = std::move(ritz);
+}
+
+}  // namespace lazyten
@@ -18,4 +18,5 @@
 //
 
 #pragma once
+#include "Lapack/LapackBatchedEigensolver.hh"
 #include "Lapack/LapackEigensolver.hh"
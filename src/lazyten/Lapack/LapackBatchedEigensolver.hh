@@ -0,0 +1,312 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/config.hh"
+#ifdef LAZYTEN_HAVE_LAPACK
+
+#include "LapackEigensolver.hh"
+#include "lazyten/detail/balanced_parallel_for.hh"
+#include <memory>
+#include <numeric>
+#include <thread>
+
+namespace lazyten {
+
+/** Class which contains all GenMap keys which are understood
+ *  by eigensystem_hermitian_batched as static string members.
+ *  See their doc strings for the types required. */
+struct LapackBatchedEigensolverKeys {
+  /** The maximal number of threads to use. Type: size_t */
+  static const std::string n_threads;
+};
+
+/** A batch of small dense Hermitian matrices, which are stored back to back
+ *  in a single contiguous buffer.
+ *
+ * Each matrix is stored in column-major order (i.e. in the layout Lapack
+ * expects) and only its lower triangle is referenced. For real symmetric
+ * matrices the storage order is of course irrelevant.
+ */
+template <typename Scalar>
+class HermitianMatrixBatch {
+ public:
+  typedef Scalar scalar_type;
+  typedef size_t size_type;
+
+  /** Construct an empty batch */
+  HermitianMatrixBatch() = default;
+
+  /** Construct a batch from a buffer, which contains the matrices of
+   *  the sizes given in dims back to back (each in column-major order).
+   *
+   *  The buffer is not copied, but moved into the batch.
+   */
+  HermitianMatrixBatch(std::vector<scalar_type> elements, std::vector<size_type> dims);
+
+  /** Reserve space for n_matrices matrices with n_elements elements in total */
+  void reserve(size_type n_matrices, size_type n_elements) {
+    m_dims.reserve(n_matrices);
+    m_offsets.reserve(n_matrices);
+    m_elements.reserve(n_elements);
+  }
+
+  /** Append a copy of a (square) matrix to the batch. */
+  template <typename Matrix, typename = krims::enable_if_t<IsMatrix<Matrix>::value>>
+  void push_back(const Matrix& m);
+
+  /** The number of matrices in the batch */
+  size_type size() const { return m_dims.size(); }
+
+  /** The size of the i-th matrix */
+  size_type dim(size_type i) const { return m_dims[i]; }
+
+  /** The offset of the i-th matrix into the buffer */
+  size_type offset(size_type i) const { return m_offsets[i]; }
+
+  /** Pointer to the elements of the i-th matrix */
+  scalar_type* data(size_type i) { return m_elements.data() + m_offsets[i]; }
+
+  /** Pointer to the elements of the i-th matrix (const version) */
+  const scalar_type* data(size_type i) const { return m_elements.data() + m_offsets[i]; }
+
+  /** Access to the full buffer of all matrices */
+  const std::vector<scalar_type>& elements() const { return m_elements; }
+
+  /** Move the full buffer of all matrices out of the batch,
+   *  which is left empty. */
+  std::vector<scalar_type> release_elements();
+
+ private:
+  std::vector<scalar_type> m_elements;
+  std::vector<size_type> m_dims;
+  std::vector<size_type> m_offsets;
+};
+
+/** The eigenpairs of all problems of a HermitianMatrixBatch
+ *
+ * All eigenvalues and all eigenvectors are stored in two arenas, i.e.
+ * large contiguous buffers, with the eigenpairs of each problem following
+ * each other. For the i-th problem of dimension n, the eigenvalues are
+ * found in ascending order at evalues(i) and the k-th eigenvector at
+ * evectors(i) + k * n.
+ */
+template <typename Scalar>
+struct EigensolutionBatch {
+  /** \name Type definitions */
+  ///@{
+  typedef Scalar scalar_type;
+  typedef typename krims::RealTypeOf<Scalar>::type real_type;
+  typedef size_t size_type;
+  ///@}
+
+  /** \name Member attributes */
+  ///@{
+  /** The dimension of each problem */
+  std::vector<size_type> dims;
+
+  /** The offset of the eigenvectors of each problem into the evector arena */
+  std::vector<size_type> evector_offsets;
+
+  /** The offset of the eigenvalues of each problem into the evalue arena */
+  std::vector<size_type> evalue_offsets;
+
+  /** The arena of all eigenvalues */
+  std::vector<real_type> evalue_arena;
+
+  /** The arena of all eigenvectors */
+  std::shared_ptr<std::vector<scalar_type>> evector_arena;
+  ///@}
+
+  /** The number of problems */
+  size_type size() const { return dims.size(); }
+
+  /** The dimension of the i-th problem */
+  size_type dim(size_type i) const { return dims[i]; }
+
+  /** Pointer to the (ascendingly ordered) eigenvalues of the i-th problem */
+  const real_type* evalues(size_type i) const {
+    return evalue_arena.data() + evalue_offsets[i];
+  }
+
+  /** Pointer to the eigenvectors of the i-th problem (column by column) */
+  const scalar_type* evectors(size_type i) const {
+    return evector_arena->data() + evector_offsets[i];
+  }
+
+  /** Build the Eigensolution object of the i-th problem
+   *
+   * If supported by the vector type, the eigenvectors are views into
+   * the arena (which is kept alive by them), else they are copied.
+   */
+  template <typename Vector>
+  Eigensolution<real_type, Vector> eigensolution(size_type i) const;
+};
+
+/** Solve a batch of small Hermitian eigenproblems for all eigenpairs
+ *
+ * The matrices are diagonalised in-place using the divide-and-conquer
+ * Lapack solver, such that their buffer directly becomes the arena of the
+ * eigenvectors. Contiguous ranges of problems of about equal total cost
+ * are handed out to the threads, which reuse the same Lapack work arrays
+ * for all problems of a range.
+ *
+ * Unlike calling eigensystem_hermitian in a loop, no eigenproblem,
+ * solver or state objects are set up and no per-problem allocations
+ * are done.
+ *
+ * ## Control parameters and their default values
+ *   - n_threads: Maximal number of threads to use. Default: The number of
+ *                hardware threads. With 1 the problems are solved one
+ *                after another in the calling thread.
+ *
+ * \throws  ExcLapackInfo if Lapack fails for one of the problems.
+ */
+template <typename Scalar>
+EigensolutionBatch<Scalar> eigensystem_hermitian_batched(
+      HermitianMatrixBatch<Scalar> batch, const krims::GenMap& map = krims::GenMap());
+
+//
+// ---------------------------------------------------
+//
+
+template <typename Scalar>
+HermitianMatrixBatch<Scalar>::HermitianMatrixBatch(std::vector<scalar_type> elements,
+                                                   std::vector<size_type> dims)
+      : m_elements(std::move(elements)), m_dims(std::move(dims)) {
+  m_offsets.reserve(m_dims.size());
+  size_type offset = 0;
+  for (const size_type n : m_dims) {
+    m_offsets.push_back(offset);
+    offset += n * n;
+  }
+  assert_size(offset, m_elements.size());
+}
+
+template <typename Scalar>
+template <typename Matrix, typename>
+void HermitianMatrixBatch<Scalar>::push_back(const Matrix& m) {
+  assert_size(m.n_rows(), m.n_cols());
+  const size_type n = m.n_rows();
+
+  m_offsets.push_back(m_elements.size());
+  m_dims.push_back(n);
+  m_elements.resize(m_elements.size() + n * n);
+
+  scalar_type* ptr = data(size() - 1);
+  for (size_type j = 0; j < n; ++j) {
+    for (size_type i = 0; i < n; ++i) ptr[j * n + i] = m(i, j);
+  }
+}
+
+template <typename Scalar>
+std::vector<Scalar> HermitianMatrixBatch<Scalar>::release_elements() {
+  std::vector<scalar_type> ret = std::move(m_elements);
+  m_elements.clear();
+  m_dims.clear();
+  m_offsets.clear();
+  return ret;
+}
+
+template <typename Scalar>
+template <typename Vector>
+Eigensolution<typename EigensolutionBatch<Scalar>::real_type, Vector>
+EigensolutionBatch<Scalar>::eigensolution(size_type i) const {
+  typedef detail::VectorView<Vector> view_type;
+  const size_type n = dims[i];
+
+  Eigensolution<real_type, Vector> soln;
+  soln.evalues().assign(evalues(i), evalues(i) + n);
+  soln.evectors().reserve(n);
+  for (size_type k = 0; k < n; ++k) {
+    scalar_type* vbegin = evector_arena->data() + evector_offsets[i] + k * n;
+    if (view_type::available) {
+      soln.evectors().push_back(
+            krims::RCPWrapper<Vector>{view_type::view(vbegin, n, evector_arena)});
+    } else {
+      soln.evectors().emplace_back(vbegin, vbegin + n);
+    }
+  }
+  return soln;
+}
+
+template <typename Scalar>
+EigensolutionBatch<Scalar> eigensystem_hermitian_batched(
+      HermitianMatrixBatch<Scalar> batch, const krims::GenMap& map) {
+  typedef typename EigensolutionBatch<Scalar>::size_type size_type;
+  const size_t n_hardware = std::max(1u, std::thread::hardware_concurrency());
+  const size_t n_threads = map.at(LapackBatchedEigensolverKeys::n_threads, n_hardware);
+
+  EigensolutionBatch<Scalar> ret;
+  const size_type n_problems = batch.size();
+  ret.dims.reserve(n_problems);
+  ret.evector_offsets.reserve(n_problems);
+  ret.evalue_offsets.reserve(n_problems);
+
+  std::vector<double> costs;
+  costs.reserve(n_problems);
+  size_type n_evalues = 0;
+  for (size_type i = 0; i < n_problems; ++i) {
+    ret.dims.push_back(batch.dim(i));
+    ret.evector_offsets.push_back(batch.offset(i));
+    ret.evalue_offsets.push_back(n_evalues);
+    n_evalues += batch.dim(i);
+
+    const double d = static_cast<double>(batch.dim(i));
+    costs.push_back(d * d * d);
+  }
+  ret.evalue_arena.resize(n_evalues);
+  ret.evector_arena = std::make_shared<std::vector<Scalar>>(batch.release_elements());
+
+  // Split the problems into contiguous ranges of about equal cost,
+  // a few per thread such that the ranges can be balanced.
+  const size_t n_ranges =
+        std::max<size_t>(1, std::min<size_t>(n_problems, 4 * n_threads));
+  const double total_cost = std::accumulate(costs.begin(), costs.end(), 0.);
+  const double target_cost = total_cost / static_cast<double>(n_ranges);
+  std::vector<size_type> range_begin{0};
+  std::vector<double> range_costs{0.};
+  for (size_type i = 0; i < n_problems; ++i) {
+    if (range_costs.back() > 0 && range_costs.back() + costs[i] / 2 > target_cost) {
+      range_begin.push_back(i);
+      range_costs.push_back(0.);
+    }
+    range_costs.back() += costs[i];
+  }
+  range_begin.push_back(n_problems);
+
+  auto solve_range = [&ret, &range_begin](size_t r) {
+    detail::SyevdWorkspace<Scalar> workspace;
+    for (size_type i = range_begin[r]; i < range_begin[r + 1]; ++i) {
+      if (ret.dims[i] == 0) continue;
+
+      int info = 0;
+      Scalar* a = ret.evector_arena->data() + ret.evector_offsets[i];
+      auto* evals = ret.evalue_arena.data() + ret.evalue_offsets[i];
+      detail::run_syevd_inplace(ret.dims[i], a, evals, workspace, info);
+      assert_throw(info == 0, ExcLapackInfo("xsyevd", info));
+    }
+  };
+  detail::balanced_parallel_for(range_costs, n_threads, solve_range);
+
+  return ret;
+}
+
+}  // namespace lazyten
+#endif  // LAZYTEN_HAVE_LAPACK
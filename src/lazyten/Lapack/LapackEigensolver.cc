@@ -23,6 +23,8 @@ namespace lazyten {
 
 const std::string LapackEigensolverKeys::prefer_packed_matrices =
       "prefer_packed_matrices";
+const std::string LapackEigensolverKeys::max_subset_ratio = "max_subset_ratio";
+const std::string LapackEigensolverKeys::cache_metric_cholesky = "cache_metric_cholesky";
 
 }  // namespace lazyten
 #endif  // LAZYTEN_HAVE_LAPACK
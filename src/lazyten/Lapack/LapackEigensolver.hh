@@ -21,10 +21,12 @@
 #include "lazyten/config.hh"
 #ifdef LAZYTEN_HAVE_LAPACK
 
+#include "detail/LapackBuffer.hh"
 #include "detail/lapack.hh"
 #include "lazyten/Base/Solvers.hh"
 #include "lazyten/Exceptions.hh"
 #include <krims/Algorithm.hh>
+#include <krims/Functionals.hh>
 
 namespace lazyten {
 
@@ -40,8 +42,13 @@ struct LapackEigensolverState : public EigensolverStateBase<Eigenproblem> {
   typedef typename base_type::scalar_type scalar_type;
   typedef typename base_type::size_type size_type;
 
+  /** Was the Cholesky factorisation of the metric cached from a previous
+   *  solve reused in the last solve */
+  bool reused_metric_factorisation;
+
   /** Setup the initial state from an eigenproblem to solve */
-  LapackEigensolverState(const eproblem_type problem) : base_type(std::move(problem)) {}
+  LapackEigensolverState(const eproblem_type problem)
+        : base_type(std::move(problem)), reused_metric_factorisation(false) {}
 };
 
 /** Class which contains all GenMap keys which are understood
@@ -51,8 +58,31 @@ struct LapackEigensolverState : public EigensolverStateBase<Eigenproblem> {
 struct LapackEigensolverKeys : public EigensolverBaseKeys {
   /** Use packed matrices when solving symmetric eigenproblems. Type: bool */
   static const std::string prefer_packed_matrices;
+
+  /** Maximal ratio n_ep / dim up to which only the requested subset of
+   *  eigenpairs is computed. Type: double */
+  static const std::string max_subset_ratio;
+
+  /** Cache the Cholesky factorisation of the metric between solves. Type: bool */
+  static const std::string cache_metric_cholesky;
 };
 
+namespace detail {
+/** The Cholesky factorisation of a metric matrix B together with the
+ *  data needed to check that it is still valid for a new solve. */
+template <typename Scalar>
+struct LapackCholeskyCache {
+  //! Address of the metric for which the factorisation was computed
+  const void* metric_ptr = nullptr;
+
+  //! The elements of the metric, which was factorised
+  std::vector<Scalar> metric_elements;
+
+  //! The Cholesky factor L (lower triangle) with B = L L^H
+  LapackSymmetricMatrix<Scalar> factor;
+};
+}  // namespace detail
+
 /** \brief Lapack eigensolver class
  *
  * ## Control parameters and their default values
@@ -71,22 +101,53 @@ struct LapackEigensolverKeys : public EigensolverBaseKeys {
  *              to extract only a packed matrix instead
  *              of the full symmetric matrix.
  *              See documentation below for more details.
+ *              Only supported for double precision real problems,
+ *              for all other scalar types it has no effect.
  *              Default: false
+ *   - max_subset_ratio:
+ *              If the ratio of the number of requested eigenpairs
+ *              and the dimension is no larger than this value, only the
+ *              requested eigenpairs are computed (see below).
+ *              Default: 0.5
+ *   - cache_metric_cholesky:
+ *              Keep the Cholesky factorisation of the metric B of
+ *              generalised problems and reuse it in subsequent solves
+ *              as long as the same, unchanged metric is used.
+ *              Only has an effect if packed matrices are not preferred.
+ *              Default: true
+ *
+ * ## Lapack drivers
+ * If only a small fraction of eigenpairs targeted by which == "SR", "LR"
+ * or "LM" is requested, only this subset is computed, using the MRRR
+ * driver dsyevr for normal and dsygvx for generalised problems. In all
+ * other cases all eigenpairs are computed (using the divide-and-conquer
+ * driver dsyevd for normal and dsygv for generalised problems) and the
+ * result is truncated down to the requested number afterwards. If packed
+ * matrices are preferred, dspev and dspgv are always used.
+ *
+ * If cache_metric_cholesky is true, generalised problems are reduced to
+ * standard form using the Cholesky factor of B (dpotrf and dsygst) and then
+ * solved by the drivers for normal problems. Since the factorisation is
+ * cached inside the solver, the solver should not be used from multiple
+ * threads at once in this case.
+ *
+ * ## Scalar types
+ * Real (float, double) and complex (std::complex<float>,
+ * std::complex<double>) Hermitian problems are supported, for which the
+ * respective s, d, c or z variants of the Lapack routines are used.
  *
- * \note Currently only double precision scalar types can be used
  * \note Currently the tolerance parameter has no effect on the
  *       solver.
- * \note This solver implicitly solves for all eigenpairs
- *       and then truncates the result down to the actually requested
- *       number.
  *
  * \tparam Eigenproblem  The eigenproblem to solve.
  * \tparam State         The state type of the solver.
  */
 template <typename Eigenproblem, typename State = LapackEigensolverState<Eigenproblem>>
 class LapackEigensolver : public EigensolverBase<State> {
-  static_assert(std::is_same<typename Eigenproblem::scalar_type, double>::value,
-                "LapackEigensolver is only implemented for double precision scalar type");
+  static_assert(std::is_same<typename Eigenproblem::real_type, float>::value ||
+                      std::is_same<typename Eigenproblem::real_type, double>::value,
+                "LapackEigensolver is only implemented for single and double precision "
+                "scalar types");
 
   static_assert(Eigenproblem::hermitian,
                 "Can only solve Hermitian eigenproblems at the moment.");
@@ -112,7 +173,7 @@ class LapackEigensolver : public EigensolverBase<State> {
 
   /** Construct an eigensolver setting the parameters from the map */
   LapackEigensolver(const krims::GenMap& map) : LapackEigensolver() {
-    base_type::update_control_params(map);
+    update_control_params(map);
   }
   //@}
 
@@ -143,11 +204,26 @@ class LapackEigensolver : public EigensolverBase<State> {
    */
   bool prefer_packed_matrices = false;
 
+  /** \brief Maximal ratio n_ep / dim for computing only a subset.
+   *
+   * Computing a subset of eigenpairs by the MRRR algorithm is much cheaper
+   * than computing all of them if only few eigenpairs are requested.
+   * For larger fractions the divide-and-conquer algorithm for all
+   * eigenpairs is usually faster.
+   */
+  double max_subset_ratio = 0.5;
+
+  /** Cache the Cholesky factorisation of the metric between solves */
+  bool cache_metric_cholesky = true;
+
   /** Update control parameters from Parameter map */
   void update_control_params(const krims::GenMap& map) {
     base_type::update_control_params(map);
     prefer_packed_matrices =
-          (LapackEigensolverKeys::prefer_packed_matrices, prefer_packed_matrices);
+          map.at(LapackEigensolverKeys::prefer_packed_matrices, prefer_packed_matrices);
+    max_subset_ratio = map.at(LapackEigensolverKeys::max_subset_ratio, max_subset_ratio);
+    cache_metric_cholesky =
+          map.at(LapackEigensolverKeys::cache_metric_cholesky, cache_metric_cholesky);
   }
 
   /** Get the current settings of all internal control parameters and
@@ -156,6 +232,8 @@ class LapackEigensolver : public EigensolverBase<State> {
   void get_control_params(krims::GenMap& map) const {
     base_type::get_control_params(map);
     map.update(LapackEigensolverKeys::prefer_packed_matrices, prefer_packed_matrices);
+    map.update(LapackEigensolverKeys::max_subset_ratio, max_subset_ratio);
+    map.update(LapackEigensolverKeys::cache_metric_cholesky, cache_metric_cholesky);
   }
   ///@}
 
@@ -170,21 +248,75 @@ class LapackEigensolver : public EigensolverBase<State> {
    * i.e first build LapackSymmetricMatrix objects for A and B
    * and then run the Lapack solver for those datastructures.
    **/
-  void run_packed(state_type& state, std::vector<double>& evals,
-                  std::vector<double>& evecs) const;
+  void run_packed(state_type& state, std::vector<real_type>& evals,
+                  std::vector<scalar_type>& evecs, std::true_type) const;
+
+  /** Fallback for scalar types for which packed matrices are not supported */
+  void run_packed(state_type& state, std::vector<real_type>& evals,
+                  std::vector<scalar_type>& evecs, std::false_type) const {
+    run_symmetric(state, evals, evecs);
+  }
 
   /** Run the packed version
    * i.e. first build LapackPackedMatrix objects for A and B
    * and then run the Lapack solvers appropriate for those.
    **/
-  void run_symmetric(state_type& state, std::vector<double>& evals,
-                     std::vector<double>& evecs) const;
+  void run_symmetric(state_type& state, std::vector<real_type>& evals,
+                     std::vector<scalar_type>& evecs) const;
+
+  /** Solve the standard problem A x = \lambda x for the requested eigenpairs,
+   *  where A is assumed to be the (possibly transformed) problem matrix. */
+  void run_standard(state_type& state, detail::LapackSymmetricMatrix<scalar_type> A,
+                    std::vector<real_type>& evals, std::vector<scalar_type>& evecs) const;
+
+  /** Return the Cholesky factor of the metric of the problem in the state,
+   *  either from the cache or by computing (and caching) it. */
+  const detail::LapackSymmetricMatrix<scalar_type>& metric_cholesky_factor(
+        state_type& state) const;
+
+  /** Determine the index ranges of eigenpairs (in ascending order of the
+   *  eigenvalues), which need to be computed to satisfy the request.
+   *  Each range is given as a pair (first index, number of eigenpairs).
+   *  An empty return value implies that all eigenpairs should be computed.
+   */
+  std::vector<std::pair<size_t, size_t>> subset_ranges(
+        const Eigenproblem& problem) const;
 
   /** Order the eigenvalues and copy the appropriate ones (selected by which)
    * into the solution data structure */
-  void copy_to_solution(size_type n_ep, const std::vector<evalue_type>& eval,
-                        const std::vector<typename evector_type::scalar_type>& evec,
-                        esoln_type& soln) const;
+  void copy_to_solution(size_type n_ep, const std::vector<real_type>& eval,
+                        std::vector<scalar_type> evec, esoln_type& soln) const;
+
+  /** Append the vector of size n at ptr to the eigenvectors. If views are
+   *  available for evector_type (second overload) the vector refers to the
+   *  memory, which is kept alive by owner, else it is copied. */
+  static void push_evector(MultiVector<evector_type>& evectors, scalar_type* ptr,
+                           size_t n, const std::shared_ptr<void>&, std::false_type) {
+    evectors.emplace_back(ptr, ptr + n);
+  }
+  static void push_evector(MultiVector<evector_type>& evectors, scalar_type* ptr,
+                           size_t n, const std::shared_ptr<void>& owner, std::true_type) {
+    typedef detail::VectorView<evector_type> view_type;
+    evectors.push_back(krims::RCPWrapper<evector_type>{view_type::view(ptr, n, owner)});
+  }
+
+  /** Append the eigenpairs of a subset range to the ones obtained so far */
+  static void append_range(std::vector<real_type> range_evals,
+                           std::vector<scalar_type> range_evecs,
+                           std::vector<real_type>& evals,
+                           std::vector<scalar_type>& evecs) {
+    if (evals.empty()) {
+      // First range: No need to copy anything
+      evals = std::move(range_evals);
+      evecs = std::move(range_evecs);
+    } else {
+      evals.insert(evals.end(), range_evals.begin(), range_evals.end());
+      evecs.insert(evecs.end(), range_evecs.begin(), range_evecs.end());
+    }
+  }
+
+  /** The cached Cholesky factorisation of the metric */
+  mutable detail::LapackCholeskyCache<scalar_type> m_cholesky_cache;
 };
 
 template <typename Eigenproblem, typename State>
@@ -228,11 +360,8 @@ void LapackEigensolver<Eigenproblem, State>::assert_valid_control_params(
 
 template <typename Eigenproblem, typename State>
 void LapackEigensolver<Eigenproblem, State>::run_packed(
-      state_type& state, std::vector<double>& evals, std::vector<double>& evecs) const {
-  static_assert(std::is_same<typename Eigenproblem::scalar_type, double>::value,
-                "LapackEigensolver is only implemented for double precision scalar type");
-  static_assert(Eigenproblem::hermitian,
-                "Can only solve Hermitian eigenproblems at the moment.");
+      state_type& state, std::vector<real_type>& evals, std::vector<scalar_type>& evecs,
+      std::true_type) const {
   const Eigenproblem& problem = state.eigenproblem();
 
   // Run hermitian generalised or normal hermitian
@@ -255,31 +384,154 @@ void LapackEigensolver<Eigenproblem, State>::run_packed(
 
 template <typename Eigenproblem, typename State>
 void LapackEigensolver<Eigenproblem, State>::run_symmetric(
-      state_type& state, std::vector<double>& evals, std::vector<double>& evecs) const {
-  static_assert(std::is_same<typename Eigenproblem::scalar_type, double>::value,
-                "LapackEigensolver is only implemented for double precision scalar type");
-  static_assert(Eigenproblem::hermitian,
-                "Can only solve Hermitian eigenproblems at the moment.");
+      state_type& state, std::vector<real_type>& evals,
+      std::vector<scalar_type>& evecs) const {
   const Eigenproblem& problem = state.eigenproblem();
 
   // Run hermitian generalised or normal hermitian
-  // eigenproblem for double precision using symmetric matrices
+  // eigenproblem using full symmetric / Hermitian matrices
   int info;
-  detail::LapackSymmetricMatrix<double> A{problem.A()};
+  detail::LapackSymmetricMatrix<scalar_type> A{problem.A()};
 
-  if (Eigenproblem::generalised) {
-    detail::LapackSymmetricMatrix<double> B{problem.B()};
-    auto Bp_chol = detail::run_dsygv(std::move(A), std::move(B), evals, evecs, info);
-    // TODO Bp_chol contains the choleski decomposition of B!
-    //      Expose this result!
-    (void)Bp_chol;
-    solver_assert(info == 0, state, ExcLapackInfo("dsygv", info));
+  if (!Eigenproblem::generalised) {
+    run_standard(state, std::move(A), evals, evecs);
+    return;
+  }
+
+  if (cache_metric_cholesky) {
+    // Reduce to the standard problem  L^{-1} A L^{-H} y = \lambda y
+    // using the (possibly cached) Cholesky factor L of B
+    const detail::LapackSymmetricMatrix<scalar_type>& chol =
+          metric_cholesky_factor(state);
+    detail::run_sygst(A, chol, info);
+    solver_assert(info == 0, state, ExcLapackInfo("xsygst", info));
+    run_standard(state, std::move(A), evals, evecs);
+
+    // Back-transform the eigenvectors: x = L^{-H} y
+    detail::run_cholesky_backsubstitute(chol, evecs);
+    return;
+  }
+
+  const std::vector<std::pair<size_t, size_t>> ranges = subset_ranges(problem);
+  if (!ranges.empty()) {
+    // Only compute the requested subset
+    // (the ranges are ordered, so the eigenvalues stay ascending)
+    evals.clear();
+    evecs.clear();
+    std::vector<real_type> range_evals;
+    std::vector<scalar_type> range_evecs;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+      // Lapack overwrites A, so only the last range may consume it
+      const auto& range = ranges[i];
+      detail::LapackSymmetricMatrix<scalar_type> B{problem.B()};
+      if (i + 1 < ranges.size()) {
+        detail::run_sygvx(A, std::move(B), range.first, range.second, range_evals,
+                          range_evecs, info);
+      } else {
+        detail::run_sygvx(std::move(A), std::move(B), range.first, range.second,
+                          range_evals, range_evecs, info);
+      }
+      solver_assert(info == 0, state, ExcLapackInfo("xsygvx", info));
+      append_range(std::move(range_evals), std::move(range_evecs), evals, evecs);
+    }
   } else {
-    detail::run_dsyev(std::move(A), evals, evecs, info);
-    solver_assert(info == 0, state, ExcLapackInfo("dsyev", info));
+    detail::LapackSymmetricMatrix<scalar_type> B{problem.B()};
+    detail::run_sygv(std::move(A), std::move(B), evals, evecs, info);
+    solver_assert(info == 0, state, ExcLapackInfo("xsygv", info));
+  }
+}
+
+template <typename Eigenproblem, typename State>
+void LapackEigensolver<Eigenproblem, State>::run_standard(
+      state_type& state, detail::LapackSymmetricMatrix<scalar_type> A,
+      std::vector<real_type>& evals, std::vector<scalar_type>& evecs) const {
+  int info;
+  const std::vector<std::pair<size_t, size_t>> ranges =
+        subset_ranges(state.eigenproblem());
+  if (ranges.empty()) {
+    detail::run_syevd(std::move(A), evals, evecs, info);
+    solver_assert(info == 0, state, ExcLapackInfo("xsyevd", info));
+    return;
+  }
+
+  // Only compute the requested subset
+  // (the ranges are ordered, so the eigenvalues stay ascending)
+  evals.clear();
+  evecs.clear();
+  std::vector<real_type> range_evals;
+  std::vector<scalar_type> range_evecs;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    // Lapack overwrites A, so only the last range may consume it
+    const auto& range = ranges[i];
+    if (i + 1 < ranges.size()) {
+      detail::run_syevr(A, range.first, range.second, range_evals, range_evecs, info);
+    } else {
+      detail::run_syevr(std::move(A), range.first, range.second, range_evals,
+                        range_evecs, info);
+    }
+    solver_assert(info == 0, state, ExcLapackInfo("xsyevr", info));
+    append_range(std::move(range_evals), std::move(range_evecs), evals, evecs);
   }
 }
 
+template <typename Eigenproblem, typename State>
+const detail::LapackSymmetricMatrix<typename LapackEigensolver<Eigenproblem,
+                                                              State>::scalar_type>&
+LapackEigensolver<Eigenproblem, State>::metric_cholesky_factor(state_type& state) const {
+  const Eigenproblem& problem = state.eigenproblem();
+  detail::LapackSymmetricMatrix<scalar_type> B{problem.B()};
+
+  // The cache is valid if it was built for the same metric object
+  // and the metric has not changed since.
+  // note: We compare memory addresses
+  detail::LapackCholeskyCache<scalar_type>& cache = m_cholesky_cache;
+  if (cache.metric_ptr == &problem.B() && cache.metric_elements == B.elements) {
+    state.reused_metric_factorisation = true;
+    return cache.factor;
+  }
+
+  // Invalidate the cache until the new factorisation is done
+  cache.metric_ptr = nullptr;
+  cache.metric_elements = B.elements;
+
+  int info;
+  detail::run_potrf(B, info);
+  solver_assert(info == 0, state, ExcLapackInfo("xpotrf", info));
+
+  cache.factor = std::move(B);
+  cache.metric_ptr = &problem.B();
+  state.reused_metric_factorisation = false;
+  return cache.factor;
+}
+
+template <typename Eigenproblem, typename State>
+std::vector<std::pair<size_t, size_t>>
+LapackEigensolver<Eigenproblem, State>::subset_ranges(const Eigenproblem& problem) const {
+  const size_t n_ep = problem.n_ep();
+  const size_t dim = problem.dim();
+  const std::string& which = base_type::which;
+
+  // Computing all eigenpairs is cheaper if many are requested.
+  if (n_ep == 0 || n_ep >= dim ||
+      static_cast<double>(n_ep) > max_subset_ratio * static_cast<double>(dim)) {
+    return {};
+  }
+
+  if (which == "SR") {
+    return {{0, n_ep}};
+  } else if (which == "LR") {
+    return {{dim - n_ep, n_ep}};
+  } else if (which == "LM" && 2 * n_ep < dim) {
+    // The eigenvalues of largest magnitude are amongst the n_ep smallest
+    // and the n_ep largest ones.
+    return {{0, n_ep}, {dim - n_ep, n_ep}};
+  }
+
+  // The position of the smallest magnitude eigenvalues is not known
+  // beforehand => compute all.
+  return {};
+}
+
 template <typename Eigenproblem, typename State>
 void LapackEigensolver<Eigenproblem, State>::solve_state(state_type& state) const {
   assert_dbg(!state.is_failed(), krims::ExcInvalidState("Cannot solve a failed state"));
@@ -287,31 +539,40 @@ void LapackEigensolver<Eigenproblem, State>::solve_state(state_type& state) cons
   assert_valid_control_params(state);
 
   // Container for the eigenvalues/vectors as Lapack returns them
-  std::vector<double> evals;
-  std::vector<double> evecs;
+  std::vector<real_type> evals;
+  std::vector<scalar_type> evecs;
 
   if (prefer_packed_matrices) {
-    run_packed(state, evals, evecs);
+    run_packed(state, evals, evecs, std::is_same<scalar_type, double>{});
   } else {
     run_symmetric(state, evals, evecs);
   }
 
+  // The Lapack matrices contain the data of the lazyten matrices in row-major
+  // order, such that Lapack actually sees their transpose. For complex
+  // Hermitian matrices this is the complex conjugate, which has the same
+  // eigenvalues, but complex conjugated eigenvectors.
+  if (krims::IsComplexNumber<scalar_type>::value) {
+    krims::ConjFctr conj{};
+    for (auto& elem : evecs) elem = conj(elem);
+  }
+
   // Check that we get the solution in the expected format.
-  assert_internal(evals.size() * evals.size() == evecs.size());
+  assert_internal(evals.size() * state.eigenproblem().dim() == evecs.size());
   assert_internal(evals.size() >= state.eigenproblem().n_ep());
 
   // Copy the results over to solution data structure:
-  copy_to_solution(state.eigenproblem().n_ep(), evals, evecs, state.eigensolution());
+  copy_to_solution(state.eigenproblem().n_ep(), evals, std::move(evecs),
+                   state.eigensolution());
 }
 
 template <typename Eigenproblem, typename State>
 void LapackEigensolver<Eigenproblem, State>::copy_to_solution(
-      size_type n_ep, const std::vector<evalue_type>& eval,
-      const std::vector<typename evector_type::scalar_type>& evec,
+      size_type n_ep, const std::vector<real_type>& eval, std::vector<scalar_type> evec,
       esoln_type& soln) const {
 
-  // Lapack always sorts its eigenvalues canonically
-  //    TODO check for complex eigenvalues!
+  // Lapack always sorts its (real) eigenvalues canonically (this holds for
+  // the concatenated subset ranges, too)
   const bool sorted_canonically = true;
 
   // (Sorted) indices of eigenvalues to keep
@@ -324,17 +585,28 @@ void LapackEigensolver<Eigenproblem, State>::copy_to_solution(
   soln.evalues().reserve(n_ep);
   soln.evectors().reserve(n_ep);
 
+  // If the eigenvectors we keep make up the larger part of the Lapack output
+  // buffer, we donate it to the eigenvectors, which become views into it.
+  // Otherwise we copy, such that the buffer can be freed.
+  typedef detail::VectorView<evector_type> view_type;
+  const bool donate_buffer = view_type::available && 2 * idcs.size() >= eval.size();
+  const auto buffer = std::make_shared<std::vector<scalar_type>>(std::move(evec));
+
   // The size of the eigenproblem:
-  const size_t N = eval.size();
+  const size_t N = buffer->size() / eval.size();
   for (const auto& idx : idcs) {
-    // The iterator range describing the current vector
+    // The memory range describing the current vector
     // This works, since Fortran arrays are column-major,
     // i.e. column-by-column, vector-by-vector
-    auto vbegin = std::begin(evec) + idx * N;
-    auto vend = std::begin(evec) + (idx + 1) * N;
-
-    soln.evectors().emplace_back(vbegin, vend);
-    soln.evalues().push_back(eval[idx]);
+    scalar_type* vbegin = buffer->data() + idx * N;
+
+    if (donate_buffer) {
+      push_evector(soln.evectors(), vbegin, N, buffer,
+                   std::integral_constant<bool, view_type::available>{});
+    } else {
+      soln.evectors().emplace_back(vbegin, vbegin + N);
+    }
+    soln.evalues().push_back(evalue_type(eval[idx]));
   }
 }
 
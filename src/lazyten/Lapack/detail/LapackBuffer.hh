@@ -0,0 +1,121 @@
+//
+// Copyright (C) 2017 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/config.hh"
+
+#ifdef LAZYTEN_HAVE_LAPACK
+#include <memory>
+
+#ifdef LAZYTEN_HAVE_ARMADILLO
+#include "lazyten/Armadillo/ArmadilloMatrix.hh"
+#include "lazyten/Armadillo/ArmadilloVector.hh"
+#endif  // LAZYTEN_HAVE_ARMADILLO
+
+namespace lazyten {
+namespace detail {
+
+// The protocol by which stored matrices and vectors exchange memory with the
+// buffers passed to Lapack:
+//
+//   - A stored matrix type may *lend* its interface to a Lapack buffer, i.e.
+//     a matrix object operating on memory owned by the Lapack buffer can be
+//     constructed. Extracting a lazy expression into such a matrix fills the
+//     Lapack buffer without intermediate copies.
+//
+//   - A Lapack output buffer may be *donated* to stored vectors, i.e. vector
+//     objects can be constructed, which are views into the buffer and keep
+//     it alive. This way eigenvectors can be returned without copying them.
+//
+// Types which do not support this fall back to element-wise copies.
+
+/** Traits class to construct a matrix of type Matrix, which operates on
+ *  memory it does not own.
+ *
+ *  If ``available`` is true, the function
+ *  ```
+ *  static Matrix borrow(scalar_type* ptr, size_t n_rows, size_t n_cols);
+ *  ```
+ *  is provided, which returns a n_rows x n_cols matrix, which stores its
+ *  elements in row-major order at ptr. The caller has to guarantee that the
+ *  memory outlives the returned object.
+ */
+template <typename Matrix>
+struct BorrowedMatrix {
+  static constexpr bool available = false;
+};
+
+/** Traits class to construct a vector of type Vector as a view into memory,
+ *  which is owned by a different object.
+ *
+ *  If ``available`` is true, the function
+ *  ```
+ *  static std::shared_ptr<Vector> view(scalar_type* ptr, size_t n,
+ *                                      std::shared_ptr<void> owner);
+ *  ```
+ *  is provided, which returns a vector of size n, which refers to the memory
+ *  at ptr. The returned pointer keeps a reference to owner, such that the
+ *  memory stays valid as long as the vector is alive.
+ */
+template <typename Vector>
+struct VectorView {
+  static constexpr bool available = false;
+};
+
+#ifdef LAZYTEN_HAVE_ARMADILLO
+template <typename Scalar>
+struct BorrowedMatrix<ArmadilloMatrix<Scalar>> {
+  static constexpr bool available = true;
+
+  static ArmadilloMatrix<Scalar> borrow(Scalar* ptr, size_t n_rows, size_t n_cols) {
+    // Note that armadillo stores the transposed matrix
+    constexpr bool copy_into_arma = false;    // Do not copy the memory
+    constexpr bool fixed_vector_size = true;  // No memory reallocation
+    arma::Mat<Scalar> m_arma(ptr, n_cols, n_rows, copy_into_arma, fixed_vector_size);
+    assert_internal(m_arma.memptr() == ptr);
+
+    ArmadilloMatrix<Scalar> ret(std::move(m_arma));
+    assert_internal(ret.data().memptr() == ptr);
+    return ret;
+  }
+};
+
+template <typename Scalar>
+struct VectorView<ArmadilloVector<Scalar>> {
+  static constexpr bool available = true;
+
+  static std::shared_ptr<ArmadilloVector<Scalar>> view(Scalar* ptr, size_t n,
+                                                       std::shared_ptr<void> owner) {
+    constexpr bool copy_into_arma = false;    // Do not copy the memory
+    constexpr bool fixed_vector_size = true;  // No memory reallocation
+    arma::Col<Scalar> v_arma(ptr, n, copy_into_arma, fixed_vector_size);
+
+    auto* v = new ArmadilloVector<Scalar>(std::move(v_arma));
+    assert_internal(v->memptr() == ptr);
+
+    // Delete the vector first and only then release the owner of the memory
+    return std::shared_ptr<ArmadilloVector<Scalar>>(
+          v, [owner](ArmadilloVector<Scalar>* p) { delete p; });
+  }
+};
+#endif  // LAZYTEN_HAVE_ARMADILLO
+
+}  // namespace detail
+}  // namespace lazyten
+#endif  // LAZYTEN_HAVE_LAPACK
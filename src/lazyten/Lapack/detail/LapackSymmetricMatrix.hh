@@ -21,17 +21,28 @@
 #include "lazyten/config.hh"
 
 #ifdef LAZYTEN_HAVE_LAPACK
+#include "LapackBuffer.hh"
 #include "lazyten/LazyMatrixExpression.hh"
 #include "lazyten/StoredMatrix_i.hh"
+#include <algorithm>
 #include <vector>
 
-#ifdef LAZYTEN_HAVE_ARMADILLO
-#include "lazyten/Armadillo/ArmadilloMatrix.hh"
-#endif  // LAZYTEN_HAVE_ARMADILLO
-
 namespace lazyten {
 namespace detail {
 
+/** Number of rows a LapackSymmetricMatrix extracts from a lazy matrix
+ *  expression at once if it cannot extract directly into its elements.
+ *
+ *  Each call to extract_block has a fixed overhead (traversing the
+ *  expression tree, setting up the temporaries of the terms), such that
+ *  extracting single rows is slow. On the other hand the intermediate
+ *  buffer of block_rows * n scalars is needed on top of the n * n
+ *  elements of the matrix. With 16 rows the buffer is at most 2% of the
+ *  matrix for n >= 800, where memory starts to matter, while the overhead
+ *  is amortised over 16 rows.
+ */
+constexpr size_t lapack_extract_block_rows = 16;
+
 /** Data structure to represent a matrix for Lapack
  *
  * From the point of view of Fortran this matrix contains
@@ -40,6 +51,7 @@ namespace detail {
 template <typename Scalar>
 struct LapackSymmetricMatrix {
   typedef Scalar scalar_type;
+  typedef typename krims::RealTypeOf<Scalar>::type real_type;
 
   //! The number of rows and columns
   size_t n;
@@ -54,20 +66,24 @@ struct LapackSymmetricMatrix {
    * copying the values in */
   explicit LapackSymmetricMatrix(const StoredMatrix_i<Scalar>& m);
 
-  /** Construct from an armadillo matrix */
-  explicit LapackSymmetricMatrix(const LazyMatrixExpression<ArmadilloMatrix<Scalar>>& m);
-  // TODO Ideally we want something like the above function for every stored matrix type.
-
-  /** Construct from a usual *symmetric* lazyten matrix expression by
-   * copying the values in */
+  /** Construct from a usual *symmetric* lazyten matrix expression.
+   *
+   * If the stored matrix type can borrow memory (see BorrowedMatrix)
+   * the expression is extracted directly into the elements array.
+   * Otherwise it is extracted in blocks of rows, such that only a small
+   * fraction of the matrix is held in an intermediate buffer.
+   */
   template <typename Stored, typename = krims::enable_if_t<IsStoredMatrix<Stored>::value>>
-  explicit LapackSymmetricMatrix(const LazyMatrixExpression<Stored>& m)
-        : LapackSymmetricMatrix(static_cast<Stored>(m)) {
-    assert_dbg(false, krims::ExcDisabled("This version does two copies of the full "
-                                         "matrix and is hence disabled. Implement "
-                                         "similar things to the ArmadilloMatrix version "
-                                         "above for other stored matrix types."));
-  }
+  explicit LapackSymmetricMatrix(const LazyMatrixExpression<Stored>& m);
+
+ private:
+  /** Extract the expression by borrowing the elements array */
+  template <typename Stored>
+  void extract_from(const LazyMatrixExpression<Stored>& m, std::true_type);
+
+  /** Extract the expression block by block */
+  template <typename Stored>
+  void extract_from(const LazyMatrixExpression<Stored>& m, std::false_type);
 };
 
 //
@@ -79,29 +95,47 @@ LapackSymmetricMatrix<Scalar>::LapackSymmetricMatrix(const StoredMatrix_i<Scalar
       : n(m.n_cols()), elements(n * n) {
   // The matrix is symmetric so no need to take care about column-major / row-major
   // between lazyten matrices (column-major) and Fortran (row-major)
-  assert_dbg(m.is_symmetric(100 * lazyten::Constants<scalar_type>::default_tolerance),
-             lazyten::ExcMatrixNotSymmetric());
+  assert_dbg(m.is_hermitian(100 * lazyten::Constants<real_type>::default_tolerance),
+             lazyten::ExcMatrixNotHermitian());
   std::copy(std::begin(m), std::end(m), std::begin(elements));
 }
 
-#ifdef LAZYTEN_HAVE_ARMADILLO
 template <typename Scalar>
+template <typename Stored, typename>
 LapackSymmetricMatrix<Scalar>::LapackSymmetricMatrix(
-      const LazyMatrixExpression<ArmadilloMatrix<Scalar>>& m)
+      const LazyMatrixExpression<Stored>& m)
       : n(m.n_cols()), elements(n * n) {
+  static_assert(std::is_same<typename Stored::scalar_type, Scalar>::value,
+                "The scalar type of the stored matrix and the Lapack matrix have to "
+                "agree.");
+  assert_size(m.n_rows(), m.n_cols());
+  extract_from(m, std::integral_constant<bool, BorrowedMatrix<Stored>::available>{});
+}
 
-  constexpr bool copy_into_arma = false;    // Do not copy the memory
-  constexpr bool fixed_vector_size = true;  // No memory reallocation
-  arma::Mat<Scalar> m_arma(elements.data(), n, n, copy_into_arma, fixed_vector_size);
-  assert_internal(m_arma.memptr() == elements.data());
-
-  ArmadilloMatrix<Scalar> block(std::move(m_arma));
-  assert_internal(block.data().memptr() == elements.data());
-
-  // Extract the block and write into this->elements
+template <typename Scalar>
+template <typename Stored>
+void LapackSymmetricMatrix<Scalar>::extract_from(const LazyMatrixExpression<Stored>& m,
+                                                 std::true_type) {
+  Stored block = BorrowedMatrix<Stored>::borrow(elements.data(), n, n);
   m.extract_block(block, 0, 0);
 }
-#endif  // LAZYTEN_HAVE_ARMADILLO
+
+template <typename Scalar>
+template <typename Stored>
+void LapackSymmetricMatrix<Scalar>::extract_from(const LazyMatrixExpression<Stored>& m,
+                                                 std::false_type) {
+  // Number of rows extracted at once
+  constexpr size_t bs = lapack_extract_block_rows;
+
+  for (size_t row = 0; row < n; row += bs) {
+    const size_t n_block_rows = std::min(bs, n - row);
+    Stored block(n_block_rows, n, false);
+    m.extract_block(block, row, 0);
+
+    // Row-major storage of the full rows of the block
+    std::copy(std::begin(block), std::end(block), std::begin(elements) + row * n);
+  }
+}
 
 }  // namespace detail
 }  // namespace lazyten
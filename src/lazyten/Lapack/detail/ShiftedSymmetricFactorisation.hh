@@ -0,0 +1,138 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/config.hh"
+
+#ifdef LAZYTEN_HAVE_LAPACK
+#include "LapackSymmetricMatrix.hh"
+#include "lapack.hh"
+
+namespace lazyten {
+namespace detail {
+
+/** Factorisation of the shifted matrix A - sigma B, which is used
+ *  to apply (A - sigma B)^{-1} in shift-invert methods and to count
+ *  the eigenvalues below sigma.
+ *
+ * The factorisation is a Bunch-Kaufman factorisation L D L^T of the full
+ * matrix, such that it works for indefinite shifted matrices, too.
+ */
+template <typename StoredMatrix>
+class ShiftedSymmetricFactorisation {
+ public:
+  typedef double scalar_type;
+
+  /** Factorise A - sigma B.
+   *
+   * \param A      The problem matrix
+   * \param B      Pointer to the metric or nullptr for the identity
+   * \param sigma_  The shift
+   */
+  ShiftedSymmetricFactorisation(const LazyMatrixExpression<StoredMatrix>& A,
+                                const LazyMatrixExpression<StoredMatrix>* B,
+                                scalar_type sigma_)
+        : ShiftedSymmetricFactorisation(
+                LapackSymmetricMatrix<scalar_type>{A},
+                B != nullptr ? LapackSymmetricMatrix<scalar_type>{*B}
+                             : LapackSymmetricMatrix<scalar_type>{},
+                sigma_) {}
+
+  /** Factorise A - sigma B, where A and B have already been extracted.
+   *  An empty B (with zero elements) denotes the identity. */
+  ShiftedSymmetricFactorisation(LapackSymmetricMatrix<scalar_type> A,
+                                const LapackSymmetricMatrix<scalar_type>& B,
+                                scalar_type sigma_)
+        : sigma(sigma_), info(0), m_factor{std::move(A)}, m_ipiv{} {
+    if (!B.elements.empty()) {
+      assert_size(B.elements.size(), m_factor.elements.size());
+      for (size_t i = 0; i < B.elements.size(); ++i) {
+        m_factor.elements[i] -= sigma * B.elements[i];
+      }
+    } else {
+      for (size_t i = 0; i < m_factor.n; ++i) {
+        m_factor.elements[i * m_factor.n + i] -= sigma;
+      }
+    }
+    run_dsytrf(m_factor, m_ipiv, info);
+  }
+
+  /** Compute y = (A - sigma B)^{-1} x
+   *
+   *  \returns the info parameter of the Lapack solve (0 on success)
+   */
+  int solve(const scalar_type* x, scalar_type* y) const { return solve(x, y, 1); }
+
+  /** Compute Y = (A - sigma B)^{-1} X for nrhs column-major vectors at once
+   *
+   *  \returns the info parameter of the Lapack solve (0 on success)
+   */
+  int solve(const scalar_type* x, scalar_type* y, size_t nrhs) const {
+    std::copy(x, x + m_factor.n * nrhs, y);
+    int info_solve = 0;
+    run_dsytrs(m_factor, m_ipiv, y, nrhs, info_solve);
+    return info_solve;
+  }
+
+  /** The number of negative eigenvalues of A - sigma B, i.e. by Sylvester's
+   *  law of inertia the number of eigenvalues of the (generalised)
+   *  eigenproblem, which are smaller than sigma.
+   *
+   *  The count is obtained from the signs of the 1x1 and 2x2 blocks of D.
+   */
+  size_t n_negative() const {
+    const size_t n = m_factor.n;
+    const auto& d = m_factor.elements;
+    size_t count = 0;
+    for (size_t k = 0; k < n; ++k) {
+      const scalar_type dkk = d[k * n + k];
+      if (m_ipiv[k] > 0 || k + 1 == n) {
+        // 1x1 block
+        if (dkk < 0) ++count;
+        continue;
+      }
+
+      // 2x2 block in rows and columns k and k+1
+      const scalar_type dnext = d[(k + 1) * n + k + 1];
+      const scalar_type doff = d[k * n + k + 1];
+      const scalar_type det = dkk * dnext - doff * doff;
+      if (det < 0) {
+        count += 1;  // one positive and one negative eigenvalue
+      } else if (dkk + dnext < 0) {
+        count += 2;
+      }
+      ++k;  // Skip the second row of the block
+    }
+    return count;
+  }
+
+  /** The shift */
+  scalar_type sigma;
+
+  /** The info parameter returned from the factorisation */
+  int info;
+
+ private:
+  LapackSymmetricMatrix<scalar_type> m_factor;
+  std::vector<int> m_ipiv;
+};
+
+}  // namespace detail
+}  // namespace lazyten
+#endif  // LAZYTEN_HAVE_LAPACK
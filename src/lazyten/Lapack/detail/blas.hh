@@ -0,0 +1,121 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/config.hh"
+#include <complex>
+#include <cstddef>
+#include <type_traits>
+
+// Thin wrappers around BLAS (and a few LAPACK) routines on raw memory. In
+// contrast to lapack.hh this header does not depend on any lazyten matrix or
+// vector types, such that it can be used from the low-level vector code as well.
+
+namespace lazyten {
+namespace detail {
+
+/** Is the scalar type supported by the BLAS wrappers,
+ *  i.e. float, double, std::complex<float> or std::complex<double> */
+template <typename Scalar>
+struct IsBlasScalar : public std::false_type {};
+
+template <>
+struct IsBlasScalar<float> : public std::true_type {};
+template <>
+struct IsBlasScalar<double> : public std::true_type {};
+template <>
+struct IsBlasScalar<std::complex<float>> : public std::true_type {};
+template <>
+struct IsBlasScalar<std::complex<double>> : public std::true_type {};
+
+#ifdef LAZYTEN_HAVE_LAPACK
+
+/** Compute C = A^T B using the BLAS routine xgemm
+ *
+ * No complex conjugation is done.
+ *
+ * \param n    The number of rows of A and B
+ * \param k    The number of columns of A
+ * \param l    The number of columns of B
+ * \param a    Pointer to A (column-major with leading dimension lda)
+ * \param b    Pointer to B (column-major with leading dimension ldb)
+ * \param c    Pointer to C (column-major k x l matrix, leading dimension k)
+ */
+template <typename Scalar>
+void run_gemm_tn(size_t n, size_t k, size_t l, const Scalar* a, size_t lda,
+                 const Scalar* b, size_t ldb, Scalar* c);
+
+/** Compute C = A B + beta C using the BLAS routine xgemm
+ *
+ * \param n    The number of rows of A and C
+ * \param k    The number of columns of A (rows of B)
+ * \param l    The number of columns of B and C
+ * \param a    Pointer to A (column-major with leading dimension lda)
+ * \param b    Pointer to B (column-major with leading dimension ldb)
+ * \param beta Coefficient for the current content of C. If it is zero, C
+ *             is not read.
+ * \param c    Pointer to C (column-major with leading dimension ldc)
+ */
+template <typename Scalar>
+void run_gemm_nn(size_t n, size_t k, size_t l, const Scalar* a, size_t lda,
+                 const Scalar* b, size_t ldb, Scalar beta, Scalar* c, size_t ldc);
+
+/** Compute the upper triangle of C = A^T A using the BLAS routine xsyrk
+ *
+ * No complex conjugation is done, i.e. C is complex symmetric.
+ * The strict lower triangle of C is not referenced.
+ *
+ * \param n    The number of rows of A
+ * \param k    The number of columns of A
+ * \param a    Pointer to A (column-major with leading dimension lda)
+ * \param c    Pointer to C (column-major k x k matrix, leading dimension k)
+ */
+template <typename Scalar>
+void run_syrk_t(size_t n, size_t k, const Scalar* a, size_t lda, Scalar* c);
+
+/** Compute the QR factorisation A = Q R using the blocked LAPACK routine xgeqrf
+ *
+ * On return the upper triangle of A contains R and the part below the
+ * diagonal together with tau describes the Householder reflectors making
+ * up Q.
+ *
+ * \param n    The number of rows of A (at least k)
+ * \param k    The number of columns of A
+ * \param a    Pointer to A (column-major with leading dimension lda)
+ * \param tau  Pointer to the k scalar factors of the reflectors (output)
+ * \param info The info flag returned by LAPACK
+ */
+template <typename Scalar>
+void run_geqrf(size_t n, size_t k, Scalar* a, size_t lda, Scalar* tau, int& info);
+
+/** Form the first k columns of Q from the output of run_geqrf in-place using
+ *  the blocked LAPACK routine xorgqr (real) or xungqr (complex).
+ *
+ * \param n    The number of rows of A
+ * \param k    The number of columns of A
+ * \param a    Pointer to the A returned by run_geqrf (leading dimension lda)
+ * \param tau  Pointer to the tau returned by run_geqrf
+ * \param info The info flag returned by LAPACK
+ */
+template <typename Scalar>
+void run_ungqr(size_t n, size_t k, Scalar* a, size_t lda, const Scalar* tau, int& info);
+
+#endif  // LAZYTEN_HAVE_LAPACK
+}  // namespace detail
+}  // namespace lazyten
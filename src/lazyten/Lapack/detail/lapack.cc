@@ -19,7 +19,9 @@
 
 #include "lazyten/config.hh"
 #ifdef LAZYTEN_HAVE_LAPACK
+#include "blas.hh"
 #include "lapack.hh"
+#include <complex>
 
 namespace lazyten {
 namespace detail {
@@ -110,16 +112,619 @@ LapackPackedMatrix<double> run_dspgv(LapackPackedMatrix<double> ap,
 }
 
 //
-// dsygv: Real generalised symmetric eigenproblem (A and B as full matrices)
+// dsytrf: Bunch-Kaufman factorisation of a real symmetric matrix
 //
-extern "C" void dsygv_(int* itype, char* jobz, char* uplo, int* n, double* a, int* lda,
-                       double* b, int* ldb, double* w, double* work, int* lwork,
-                       int* info);
+extern "C" void dsytrf_(char* uplo, int* n, double* a, int* lda, int* ipiv, double* work,
+                        int* lwork, int* info);
 
-LapackPackedMatrix<double> run_dsygv(LapackSymmetricMatrix<double> a,
-                                     LapackSymmetricMatrix<double> b,
-                                     std::vector<double>& evals,
-                                     std::vector<double>& evecs, int& info) {
+void run_dsytrf(LapackSymmetricMatrix<double>& a, std::vector<int>& ipiv, int& info) {
+  assert_size(a.n * a.n, a.elements.size());
+  ipiv.resize(a.n);
+
+  int n = static_cast<int>(a.n);
+  char uplo = 'L';  //< Use the lower triangle of A
+
+  // Determine optimal work array size:
+  double wkopt;
+  int lwork = -1;
+  dsytrf_(&uplo, &n, nullptr, &n, nullptr, &wkopt, &lwork, &info);
+  if (info != 0) return;  // Error!
+
+  // check that we don't get a wrongfully large size and allocate work array
+  const auto wksize = std::max<size_t>(1, static_cast<size_t>(wkopt));
+  assert_internal(wksize <= std::max<size_t>(a.n * a.n, 10000));
+  std::vector<double> work(wksize);
+  lwork = static_cast<int>(wksize);
+
+  dsytrf_(&uplo, &n, a.elements.data(), &n, ipiv.data(), work.data(), &lwork, &info);
+}
+
+//
+// dsytrs: Solve a linear system using the factorisation from dsytrf
+//
+extern "C" void dsytrs_(char* uplo, int* n, int* nrhs, const double* a, int* lda,
+                        const int* ipiv, double* b, int* ldb, int* info);
+
+void run_dsytrs(const LapackSymmetricMatrix<double>& a, const std::vector<int>& ipiv,
+                double* b, size_t nrhs, int& info) {
+  assert_size(a.n * a.n, a.elements.size());
+  assert_size(a.n, ipiv.size());
+
+  int n = static_cast<int>(a.n);
+  int nrhs_int = static_cast<int>(nrhs);
+  char uplo = 'L';  //< The lower triangle contains the factorisation
+  dsytrs_(&uplo, &n, &nrhs_int, a.elements.data(), &n, ipiv.data(), b, &n, &info);
+}
+
+//
+// Routines available for all four scalar types
+//
+// The s, d, c and z variants of each routine are declared below and
+// dispatched to via the static members of the LapackRoutines
+// specialisations. For a common interface the real variants accept (and
+// ignore) the real workspace arrays, which only the complex variants need.
+// Note that the complex variants have "he" instead of "sy" in their names.
+//
+extern "C" {
+// xsyevr / xheevr: MRRR eigensolver for a subset of eigenpairs
+void ssyevr_(char* jobz, char* range, char* uplo, int* n, float* a, int* lda, float* vl,
+             float* vu, int* il, int* iu, float* abstol, int* m, float* w, float* z,
+             int* ldz, int* isuppz, float* work, int* lwork, int* iwork, int* liwork,
+             int* info);
+void dsyevr_(char* jobz, char* range, char* uplo, int* n, double* a, int* lda, double* vl,
+             double* vu, int* il, int* iu, double* abstol, int* m, double* w, double* z,
+             int* ldz, int* isuppz, double* work, int* lwork, int* iwork, int* liwork,
+             int* info);
+void cheevr_(char* jobz, char* range, char* uplo, int* n, std::complex<float>* a,
+             int* lda, float* vl, float* vu, int* il, int* iu, float* abstol, int* m,
+             float* w, std::complex<float>* z, int* ldz, int* isuppz,
+             std::complex<float>* work, int* lwork, float* rwork, int* lrwork, int* iwork,
+             int* liwork, int* info);
+void zheevr_(char* jobz, char* range, char* uplo, int* n, std::complex<double>* a,
+             int* lda, double* vl, double* vu, int* il, int* iu, double* abstol, int* m,
+             double* w, std::complex<double>* z, int* ldz, int* isuppz,
+             std::complex<double>* work, int* lwork, double* rwork, int* lrwork,
+             int* iwork, int* liwork, int* info);
+
+// xsyevd / xheevd: Divide and conquer eigensolver for all eigenpairs
+void ssyevd_(char* jobz, char* uplo, int* n, float* a, int* lda, float* w, float* work,
+             int* lwork, int* iwork, int* liwork, int* info);
+void dsyevd_(char* jobz, char* uplo, int* n, double* a, int* lda, double* w, double* work,
+             int* lwork, int* iwork, int* liwork, int* info);
+void cheevd_(char* jobz, char* uplo, int* n, std::complex<float>* a, int* lda, float* w,
+             std::complex<float>* work, int* lwork, float* rwork, int* lrwork, int* iwork,
+             int* liwork, int* info);
+void zheevd_(char* jobz, char* uplo, int* n, std::complex<double>* a, int* lda, double* w,
+             std::complex<double>* work, int* lwork, double* rwork, int* lrwork,
+             int* iwork, int* liwork, int* info);
+
+// xsygvx / xhegvx: Generalised eigensolver for a subset of eigenpairs
+void ssygvx_(int* itype, char* jobz, char* range, char* uplo, int* n, float* a, int* lda,
+             float* b, int* ldb, float* vl, float* vu, int* il, int* iu, float* abstol,
+             int* m, float* w, float* z, int* ldz, float* work, int* lwork, int* iwork,
+             int* ifail, int* info);
+void dsygvx_(int* itype, char* jobz, char* range, char* uplo, int* n, double* a, int* lda,
+             double* b, int* ldb, double* vl, double* vu, int* il, int* iu,
+             double* abstol, int* m, double* w, double* z, int* ldz, double* work,
+             int* lwork, int* iwork, int* ifail, int* info);
+void chegvx_(int* itype, char* jobz, char* range, char* uplo, int* n,
+             std::complex<float>* a, int* lda, std::complex<float>* b, int* ldb,
+             float* vl, float* vu, int* il, int* iu, float* abstol, int* m, float* w,
+             std::complex<float>* z, int* ldz, std::complex<float>* work, int* lwork,
+             float* rwork, int* iwork, int* ifail, int* info);
+void zhegvx_(int* itype, char* jobz, char* range, char* uplo, int* n,
+             std::complex<double>* a, int* lda, std::complex<double>* b, int* ldb,
+             double* vl, double* vu, int* il, int* iu, double* abstol, int* m, double* w,
+             std::complex<double>* z, int* ldz, std::complex<double>* work, int* lwork,
+             double* rwork, int* iwork, int* ifail, int* info);
+
+// xsygv / xhegv: Generalised eigensolver for all eigenpairs
+void ssygv_(int* itype, char* jobz, char* uplo, int* n, float* a, int* lda, float* b,
+            int* ldb, float* w, float* work, int* lwork, int* info);
+void dsygv_(int* itype, char* jobz, char* uplo, int* n, double* a, int* lda, double* b,
+            int* ldb, double* w, double* work, int* lwork, int* info);
+void chegv_(int* itype, char* jobz, char* uplo, int* n, std::complex<float>* a, int* lda,
+            std::complex<float>* b, int* ldb, float* w, std::complex<float>* work,
+            int* lwork, float* rwork, int* info);
+void zhegv_(int* itype, char* jobz, char* uplo, int* n, std::complex<double>* a, int* lda,
+            std::complex<double>* b, int* ldb, double* w, std::complex<double>* work,
+            int* lwork, double* rwork, int* info);
+
+// xpotrf: Cholesky factorisation
+void spotrf_(char* uplo, int* n, float* a, int* lda, int* info);
+void dpotrf_(char* uplo, int* n, double* a, int* lda, int* info);
+void cpotrf_(char* uplo, int* n, std::complex<float>* a, int* lda, int* info);
+void zpotrf_(char* uplo, int* n, std::complex<double>* a, int* lda, int* info);
+
+// xsygst / xhegst: Reduction of a generalised eigenproblem to standard form
+void ssygst_(int* itype, char* uplo, int* n, float* a, int* lda, const float* b, int* ldb,
+             int* info);
+void dsygst_(int* itype, char* uplo, int* n, double* a, int* lda, const double* b,
+             int* ldb, int* info);
+void chegst_(int* itype, char* uplo, int* n, std::complex<float>* a, int* lda,
+             const std::complex<float>* b, int* ldb, int* info);
+void zhegst_(int* itype, char* uplo, int* n, std::complex<double>* a, int* lda,
+             const std::complex<double>* b, int* ldb, int* info);
+
+// xtrsm: Solve triangular system with multiple right-hand sides (BLAS)
+void strsm_(char* side, char* uplo, char* transa, char* diag, int* m, int* n,
+            float* alpha, const float* a, int* lda, float* b, int* ldb);
+void dtrsm_(char* side, char* uplo, char* transa, char* diag, int* m, int* n,
+            double* alpha, const double* a, int* lda, double* b, int* ldb);
+void ctrsm_(char* side, char* uplo, char* transa, char* diag, int* m, int* n,
+            std::complex<float>* alpha, const std::complex<float>* a, int* lda,
+            std::complex<float>* b, int* ldb);
+void ztrsm_(char* side, char* uplo, char* transa, char* diag, int* m, int* n,
+            std::complex<double>* alpha, const std::complex<double>* a, int* lda,
+            std::complex<double>* b, int* ldb);
+
+// xgemm: General matrix-matrix product (BLAS)
+void sgemm_(char* transa, char* transb, int* m, int* n, int* k, float* alpha,
+            const float* a, int* lda, const float* b, int* ldb, float* beta, float* c,
+            int* ldc);
+void dgemm_(char* transa, char* transb, int* m, int* n, int* k, double* alpha,
+            const double* a, int* lda, const double* b, int* ldb, double* beta,
+            double* c, int* ldc);
+void cgemm_(char* transa, char* transb, int* m, int* n, int* k,
+            std::complex<float>* alpha, const std::complex<float>* a, int* lda,
+            const std::complex<float>* b, int* ldb, std::complex<float>* beta,
+            std::complex<float>* c, int* ldc);
+void zgemm_(char* transa, char* transb, int* m, int* n, int* k,
+            std::complex<double>* alpha, const std::complex<double>* a, int* lda,
+            const std::complex<double>* b, int* ldb, std::complex<double>* beta,
+            std::complex<double>* c, int* ldc);
+
+// xsyrk: Symmetric rank-k update (BLAS)
+void ssyrk_(char* uplo, char* trans, int* n, int* k, float* alpha, const float* a,
+            int* lda, float* beta, float* c, int* ldc);
+void dsyrk_(char* uplo, char* trans, int* n, int* k, double* alpha, const double* a,
+            int* lda, double* beta, double* c, int* ldc);
+void csyrk_(char* uplo, char* trans, int* n, int* k, std::complex<float>* alpha,
+            const std::complex<float>* a, int* lda, std::complex<float>* beta,
+            std::complex<float>* c, int* ldc);
+void zsyrk_(char* uplo, char* trans, int* n, int* k, std::complex<double>* alpha,
+            const std::complex<double>* a, int* lda, std::complex<double>* beta,
+            std::complex<double>* c, int* ldc);
+
+// xgeqrf: Blocked Householder QR factorisation
+void sgeqrf_(int* m, int* n, float* a, int* lda, float* tau, float* work, int* lwork,
+             int* info);
+void dgeqrf_(int* m, int* n, double* a, int* lda, double* tau, double* work, int* lwork,
+             int* info);
+void cgeqrf_(int* m, int* n, std::complex<float>* a, int* lda, std::complex<float>* tau,
+             std::complex<float>* work, int* lwork, int* info);
+void zgeqrf_(int* m, int* n, std::complex<double>* a, int* lda, std::complex<double>* tau,
+             std::complex<double>* work, int* lwork, int* info);
+
+// xorgqr / xungqr: Form Q from the Householder reflectors of xgeqrf
+void sorgqr_(int* m, int* n, int* k, float* a, int* lda, const float* tau, float* work,
+             int* lwork, int* info);
+void dorgqr_(int* m, int* n, int* k, double* a, int* lda, const double* tau,
+             double* work, int* lwork, int* info);
+void cungqr_(int* m, int* n, int* k, std::complex<float>* a, int* lda,
+             const std::complex<float>* tau, std::complex<float>* work, int* lwork,
+             int* info);
+void zungqr_(int* m, int* n, int* k, std::complex<double>* a, int* lda,
+             const std::complex<double>* tau, std::complex<double>* work, int* lwork,
+             int* info);
+}
+
+namespace {
+template <typename Scalar>
+struct LapackRoutines;
+
+template <>
+struct LapackRoutines<float> {
+  typedef float S;
+  typedef float R;
+  static void syevr(char* jobz, char* range, char* uplo, int* n, S* a, int* lda, R* vl,
+                    R* vu, int* il, int* iu, R* abstol, int* m, R* w, S* z, int* ldz,
+                    int* isuppz, S* work, int* lwork, R*, int*, int* iwork, int* liwork,
+                    int* info) {
+    ssyevr_(jobz, range, uplo, n, a, lda, vl, vu, il, iu, abstol, m, w, z, ldz, isuppz,
+            work, lwork, iwork, liwork, info);
+  }
+  static void syevd(char* jobz, char* uplo, int* n, S* a, int* lda, R* w, S* work,
+                    int* lwork, R*, int*, int* iwork, int* liwork, int* info) {
+    ssyevd_(jobz, uplo, n, a, lda, w, work, lwork, iwork, liwork, info);
+  }
+  static void sygvx(int* itype, char* jobz, char* range, char* uplo, int* n, S* a,
+                    int* lda, S* b, int* ldb, R* vl, R* vu, int* il, int* iu, R* abstol,
+                    int* m, R* w, S* z, int* ldz, S* work, int* lwork, R*, int* iwork,
+                    int* ifail, int* info) {
+    ssygvx_(itype, jobz, range, uplo, n, a, lda, b, ldb, vl, vu, il, iu, abstol, m, w, z,
+            ldz, work, lwork, iwork, ifail, info);
+  }
+  static void sygv(int* itype, char* jobz, char* uplo, int* n, S* a, int* lda, S* b,
+                   int* ldb, R* w, S* work, int* lwork, R*, int* info) {
+    ssygv_(itype, jobz, uplo, n, a, lda, b, ldb, w, work, lwork, info);
+  }
+  static void potrf(char* uplo, int* n, S* a, int* lda, int* info) {
+    spotrf_(uplo, n, a, lda, info);
+  }
+  static void sygst(int* itype, char* uplo, int* n, S* a, int* lda, const S* b, int* ldb,
+                    int* info) {
+    ssygst_(itype, uplo, n, a, lda, b, ldb, info);
+  }
+  static void trsm(char* side, char* uplo, char* transa, char* diag, int* m, int* n,
+                   S* alpha, const S* a, int* lda, S* b, int* ldb) {
+    strsm_(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb);
+  }
+  static void gemm(char* transa, char* transb, int* m, int* n, int* k, S* alpha,
+                   const S* a, int* lda, const S* b, int* ldb, S* beta, S* c, int* ldc) {
+    sgemm_(transa, transb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+  }
+  static void syrk(char* uplo, char* trans, int* n, int* k, S* alpha, const S* a,
+                   int* lda, S* beta, S* c, int* ldc) {
+    ssyrk_(uplo, trans, n, k, alpha, a, lda, beta, c, ldc);
+  }
+  static void geqrf(int* m, int* n, S* a, int* lda, S* tau, S* work, int* lwork,
+                    int* info) {
+    sgeqrf_(m, n, a, lda, tau, work, lwork, info);
+  }
+  static void ungqr(int* m, int* n, int* k, S* a, int* lda, const S* tau, S* work,
+                    int* lwork, int* info) {
+    sorgqr_(m, n, k, a, lda, tau, work, lwork, info);
+  }
+};
+
+template <>
+struct LapackRoutines<double> {
+  typedef double S;
+  typedef double R;
+  static void syevr(char* jobz, char* range, char* uplo, int* n, S* a, int* lda, R* vl,
+                    R* vu, int* il, int* iu, R* abstol, int* m, R* w, S* z, int* ldz,
+                    int* isuppz, S* work, int* lwork, R*, int*, int* iwork, int* liwork,
+                    int* info) {
+    dsyevr_(jobz, range, uplo, n, a, lda, vl, vu, il, iu, abstol, m, w, z, ldz, isuppz,
+            work, lwork, iwork, liwork, info);
+  }
+  static void syevd(char* jobz, char* uplo, int* n, S* a, int* lda, R* w, S* work,
+                    int* lwork, R*, int*, int* iwork, int* liwork, int* info) {
+    dsyevd_(jobz, uplo, n, a, lda, w, work, lwork, iwork, liwork, info);
+  }
+  static void sygvx(int* itype, char* jobz, char* range, char* uplo, int* n, S* a,
+                    int* lda, S* b, int* ldb, R* vl, R* vu, int* il, int* iu, R* abstol,
+                    int* m, R* w, S* z, int* ldz, S* work, int* lwork, R*, int* iwork,
+                    int* ifail, int* info) {
+    dsygvx_(itype, jobz, range, uplo, n, a, lda, b, ldb, vl, vu, il, iu, abstol, m, w, z,
+            ldz, work, lwork, iwork, ifail, info);
+  }
+  static void sygv(int* itype, char* jobz, char* uplo, int* n, S* a, int* lda, S* b,
+                   int* ldb, R* w, S* work, int* lwork, R*, int* info) {
+    dsygv_(itype, jobz, uplo, n, a, lda, b, ldb, w, work, lwork, info);
+  }
+  static void potrf(char* uplo, int* n, S* a, int* lda, int* info) {
+    dpotrf_(uplo, n, a, lda, info);
+  }
+  static void sygst(int* itype, char* uplo, int* n, S* a, int* lda, const S* b, int* ldb,
+                    int* info) {
+    dsygst_(itype, uplo, n, a, lda, b, ldb, info);
+  }
+  static void trsm(char* side, char* uplo, char* transa, char* diag, int* m, int* n,
+                   S* alpha, const S* a, int* lda, S* b, int* ldb) {
+    dtrsm_(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb);
+  }
+  static void gemm(char* transa, char* transb, int* m, int* n, int* k, S* alpha,
+                   const S* a, int* lda, const S* b, int* ldb, S* beta, S* c, int* ldc) {
+    dgemm_(transa, transb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+  }
+  static void syrk(char* uplo, char* trans, int* n, int* k, S* alpha, const S* a,
+                   int* lda, S* beta, S* c, int* ldc) {
+    dsyrk_(uplo, trans, n, k, alpha, a, lda, beta, c, ldc);
+  }
+  static void geqrf(int* m, int* n, S* a, int* lda, S* tau, S* work, int* lwork,
+                    int* info) {
+    dgeqrf_(m, n, a, lda, tau, work, lwork, info);
+  }
+  static void ungqr(int* m, int* n, int* k, S* a, int* lda, const S* tau, S* work,
+                    int* lwork, int* info) {
+    dorgqr_(m, n, k, a, lda, tau, work, lwork, info);
+  }
+};
+
+template <>
+struct LapackRoutines<std::complex<float>> {
+  typedef std::complex<float> S;
+  typedef float R;
+  static void syevr(char* jobz, char* range, char* uplo, int* n, S* a, int* lda, R* vl,
+                    R* vu, int* il, int* iu, R* abstol, int* m, R* w, S* z, int* ldz,
+                    int* isuppz, S* work, int* lwork, R* rwork, int* lrwork, int* iwork,
+                    int* liwork, int* info) {
+    cheevr_(jobz, range, uplo, n, a, lda, vl, vu, il, iu, abstol, m, w, z, ldz, isuppz,
+            work, lwork, rwork, lrwork, iwork, liwork, info);
+  }
+  static void syevd(char* jobz, char* uplo, int* n, S* a, int* lda, R* w, S* work,
+                    int* lwork, R* rwork, int* lrwork, int* iwork, int* liwork,
+                    int* info) {
+    cheevd_(jobz, uplo, n, a, lda, w, work, lwork, rwork, lrwork, iwork, liwork, info);
+  }
+  static void sygvx(int* itype, char* jobz, char* range, char* uplo, int* n, S* a,
+                    int* lda, S* b, int* ldb, R* vl, R* vu, int* il, int* iu, R* abstol,
+                    int* m, R* w, S* z, int* ldz, S* work, int* lwork, R* rwork,
+                    int* iwork, int* ifail, int* info) {
+    chegvx_(itype, jobz, range, uplo, n, a, lda, b, ldb, vl, vu, il, iu, abstol, m, w, z,
+            ldz, work, lwork, rwork, iwork, ifail, info);
+  }
+  static void sygv(int* itype, char* jobz, char* uplo, int* n, S* a, int* lda, S* b,
+                   int* ldb, R* w, S* work, int* lwork, R* rwork, int* info) {
+    chegv_(itype, jobz, uplo, n, a, lda, b, ldb, w, work, lwork, rwork, info);
+  }
+  static void potrf(char* uplo, int* n, S* a, int* lda, int* info) {
+    cpotrf_(uplo, n, a, lda, info);
+  }
+  static void sygst(int* itype, char* uplo, int* n, S* a, int* lda, const S* b, int* ldb,
+                    int* info) {
+    chegst_(itype, uplo, n, a, lda, b, ldb, info);
+  }
+  static void trsm(char* side, char* uplo, char* transa, char* diag, int* m, int* n,
+                   S* alpha, const S* a, int* lda, S* b, int* ldb) {
+    ctrsm_(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb);
+  }
+  static void gemm(char* transa, char* transb, int* m, int* n, int* k, S* alpha,
+                   const S* a, int* lda, const S* b, int* ldb, S* beta, S* c, int* ldc) {
+    cgemm_(transa, transb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+  }
+  static void syrk(char* uplo, char* trans, int* n, int* k, S* alpha, const S* a,
+                   int* lda, S* beta, S* c, int* ldc) {
+    csyrk_(uplo, trans, n, k, alpha, a, lda, beta, c, ldc);
+  }
+  static void geqrf(int* m, int* n, S* a, int* lda, S* tau, S* work, int* lwork,
+                    int* info) {
+    cgeqrf_(m, n, a, lda, tau, work, lwork, info);
+  }
+  static void ungqr(int* m, int* n, int* k, S* a, int* lda, const S* tau, S* work,
+                    int* lwork, int* info) {
+    cungqr_(m, n, k, a, lda, tau, work, lwork, info);
+  }
+};
+
+template <>
+struct LapackRoutines<std::complex<double>> {
+  typedef std::complex<double> S;
+  typedef double R;
+  static void syevr(char* jobz, char* range, char* uplo, int* n, S* a, int* lda, R* vl,
+                    R* vu, int* il, int* iu, R* abstol, int* m, R* w, S* z, int* ldz,
+                    int* isuppz, S* work, int* lwork, R* rwork, int* lrwork, int* iwork,
+                    int* liwork, int* info) {
+    zheevr_(jobz, range, uplo, n, a, lda, vl, vu, il, iu, abstol, m, w, z, ldz, isuppz,
+            work, lwork, rwork, lrwork, iwork, liwork, info);
+  }
+  static void syevd(char* jobz, char* uplo, int* n, S* a, int* lda, R* w, S* work,
+                    int* lwork, R* rwork, int* lrwork, int* iwork, int* liwork,
+                    int* info) {
+    zheevd_(jobz, uplo, n, a, lda, w, work, lwork, rwork, lrwork, iwork, liwork, info);
+  }
+  static void sygvx(int* itype, char* jobz, char* range, char* uplo, int* n, S* a,
+                    int* lda, S* b, int* ldb, R* vl, R* vu, int* il, int* iu, R* abstol,
+                    int* m, R* w, S* z, int* ldz, S* work, int* lwork, R* rwork,
+                    int* iwork, int* ifail, int* info) {
+    zhegvx_(itype, jobz, range, uplo, n, a, lda, b, ldb, vl, vu, il, iu, abstol, m, w, z,
+            ldz, work, lwork, rwork, iwork, ifail, info);
+  }
+  static void sygv(int* itype, char* jobz, char* uplo, int* n, S* a, int* lda, S* b,
+                   int* ldb, R* w, S* work, int* lwork, R* rwork, int* info) {
+    zhegv_(itype, jobz, uplo, n, a, lda, b, ldb, w, work, lwork, rwork, info);
+  }
+  static void potrf(char* uplo, int* n, S* a, int* lda, int* info) {
+    zpotrf_(uplo, n, a, lda, info);
+  }
+  static void sygst(int* itype, char* uplo, int* n, S* a, int* lda, const S* b, int* ldb,
+                    int* info) {
+    zhegst_(itype, uplo, n, a, lda, b, ldb, info);
+  }
+  static void trsm(char* side, char* uplo, char* transa, char* diag, int* m, int* n,
+                   S* alpha, const S* a, int* lda, S* b, int* ldb) {
+    ztrsm_(side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb);
+  }
+  static void gemm(char* transa, char* transb, int* m, int* n, int* k, S* alpha,
+                   const S* a, int* lda, const S* b, int* ldb, S* beta, S* c, int* ldc) {
+    zgemm_(transa, transb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+  }
+  static void syrk(char* uplo, char* trans, int* n, int* k, S* alpha, const S* a,
+                   int* lda, S* beta, S* c, int* ldc) {
+    zsyrk_(uplo, trans, n, k, alpha, a, lda, beta, c, ldc);
+  }
+  static void geqrf(int* m, int* n, S* a, int* lda, S* tau, S* work, int* lwork,
+                    int* info) {
+    zgeqrf_(m, n, a, lda, tau, work, lwork, info);
+  }
+  static void ungqr(int* m, int* n, int* k, S* a, int* lda, const S* tau, S* work,
+                    int* lwork, int* info) {
+    zungqr_(m, n, k, a, lda, tau, work, lwork, info);
+  }
+};
+
+/** Convert the optimal workspace size returned by a Lapack workspace query
+ *  and check that it is not wrongfully large */
+template <typename T>
+size_t workspace_size(const T& wkopt, const size_t max_size) {
+  using std::real;
+  const auto wksize = std::max<size_t>(1, static_cast<size_t>(real(wkopt)));
+  assert_internal(wksize <= std::max<size_t>(max_size, 10000));
+  return wksize;
+}
+}  // namespace
+
+//
+// xsyevd / xheevd
+//
+template <typename Scalar>
+void run_syevd_inplace(size_t n_size, Scalar* a, RealOf<Scalar>* evals,
+                       SyevdWorkspace<Scalar>& ws, int& info) {
+  typedef LapackRoutines<Scalar> routines;
+  typedef RealOf<Scalar> real_type;
+
+  int n = static_cast<int>(n_size);
+  char jobz = 'V';  //< Compute eigenvalues and eigenvectors
+  char uplo = 'L';  //< Use the lower triangle of A
+
+  // Determine optimal work array sizes:
+  Scalar wkopt;
+  real_type rwkopt = 1;
+  int iwkopt;
+  int lwork = -1;
+  int lrwork = -1;
+  int liwork = -1;
+  routines::syevd(&jobz, &uplo, &n, nullptr, &n, nullptr, &wkopt, &lwork, &rwkopt,
+                  &lrwork, &iwkopt, &liwork, &info);
+  if (info != 0) return;  // Error!
+
+  // Grow work arrays if needed
+  // (divide and conquer needs about 2*n^2 workspace)
+  const size_t max_size = 2 * n_size * n_size + 6 * n_size + 1;
+  if (ws.work.size() < workspace_size(wkopt, max_size)) {
+    ws.work.resize(workspace_size(wkopt, max_size));
+  }
+  if (ws.rwork.size() < workspace_size(rwkopt, max_size)) {
+    ws.rwork.resize(workspace_size(rwkopt, max_size));
+  }
+  if (ws.iwork.size() < workspace_size(iwkopt, max_size)) {
+    ws.iwork.resize(workspace_size(iwkopt, max_size));
+  }
+  lwork = static_cast<int>(ws.work.size());
+  lrwork = static_cast<int>(ws.rwork.size());
+  liwork = static_cast<int>(ws.iwork.size());
+
+  routines::syevd(&jobz, &uplo, &n, a, &n, evals, ws.work.data(), &lwork,
+                  ws.rwork.data(), &lrwork, ws.iwork.data(), &liwork, &info);
+}
+
+template <typename Scalar>
+void run_syevd(LapackSymmetricMatrix<Scalar> a, std::vector<RealOf<Scalar>>& evals,
+               std::vector<Scalar>& evecs, int& info) {
+  assert_size(a.n * a.n, a.elements.size());
+  evals.resize(a.n);
+
+  SyevdWorkspace<Scalar> ws;
+  run_syevd_inplace(a.n, a.elements.data(), evals.data(), ws, info);
+
+  // Copy eigenvectors (which are returned inside the A-array)
+  evecs = std::move(a.elements);
+}
+
+//
+// xsyevr / xheevr
+//
+template <typename Scalar>
+void run_syevr(LapackSymmetricMatrix<Scalar> a, size_t first, size_t count,
+               std::vector<RealOf<Scalar>>& evals, std::vector<Scalar>& evecs,
+               int& info) {
+  typedef LapackRoutines<Scalar> routines;
+  typedef RealOf<Scalar> real_type;
+  assert_size(a.n * a.n, a.elements.size());
+  assert_greater(0, count);
+  assert_greater_equal(first + count, a.n);
+
+  int n = static_cast<int>(a.n);
+  char jobz = 'V';   //< Compute eigenvalues and eigenvectors
+  char range = 'I';  //< Select eigenpairs by index
+  char uplo = 'L';   //< Use the lower triangle of A
+  real_type vl = 0, vu = 0;
+  int il = static_cast<int>(first + 1);  //< Fortran indices are 1-based
+  int iu = static_cast<int>(first + count);
+  real_type abstol = 0;  //< Use default tolerance
+  int m = 0;
+
+  // Note: w needs space for all eigenvalues
+  evals.resize(a.n);
+  evecs.resize(a.n * count);
+  std::vector<int> isuppz(2 * count);
+
+  // Determine optimal work array sizes:
+  Scalar wkopt;
+  real_type rwkopt = 1;
+  int iwkopt;
+  int lwork = -1;
+  int lrwork = -1;
+  int liwork = -1;
+  routines::syevr(&jobz, &range, &uplo, &n, nullptr, &n, &vl, &vu, &il, &iu, &abstol, &m,
+                  nullptr, nullptr, &n, nullptr, &wkopt, &lwork, &rwkopt, &lrwork,
+                  &iwkopt, &liwork, &info);
+  if (info != 0) return;  // Error!
+
+  // Allocate work arrays
+  const size_t max_size = a.n * a.n;
+  std::vector<Scalar> work(workspace_size(wkopt, max_size));
+  std::vector<real_type> rwork(workspace_size(rwkopt, max_size));
+  std::vector<int> iwork(workspace_size(iwkopt, max_size));
+  lwork = static_cast<int>(work.size());
+  lrwork = static_cast<int>(rwork.size());
+  liwork = static_cast<int>(iwork.size());
+
+  routines::syevr(&jobz, &range, &uplo, &n, a.elements.data(), &n, &vl, &vu, &il, &iu,
+                  &abstol, &m, evals.data(), evecs.data(), &n, isuppz.data(),
+                  work.data(), &lwork, rwork.data(), &lrwork, iwork.data(), &liwork,
+                  &info);
+  if (info != 0) return;  // Error!
+
+  assert_internal(static_cast<size_t>(m) == count);
+  evals.resize(count);
+}
+
+//
+// xsygvx / xhegvx
+//
+template <typename Scalar>
+void run_sygvx(LapackSymmetricMatrix<Scalar> a, LapackSymmetricMatrix<Scalar> b,
+               size_t first, size_t count, std::vector<RealOf<Scalar>>& evals,
+               std::vector<Scalar>& evecs, int& info) {
+  typedef LapackRoutines<Scalar> routines;
+  typedef RealOf<Scalar> real_type;
+  assert_size(a.n, b.n);
+  assert_size(a.elements.size(), b.elements.size());
+  assert_size(a.n * a.n, a.elements.size());
+  assert_greater(0, count);
+  assert_greater_equal(first + count, a.n);
+
+  int n = static_cast<int>(a.n);
+  int itype = 1;     //< Jobtype to do (here: A*v = \lambda*B*v
+  char jobz = 'V';   //< Compute eigenvalues and eigenvectors
+  char range = 'I';  //< Select eigenpairs by index
+  char uplo = 'L';   //< Use the lower triangles of A and B
+  real_type vl = 0, vu = 0;
+  int il = static_cast<int>(first + 1);  //< Fortran indices are 1-based
+  int iu = static_cast<int>(first + count);
+  real_type abstol = 0;  //< Use default tolerance
+  int m = 0;
+
+  // Note: w needs space for all eigenvalues
+  evals.resize(a.n);
+  evecs.resize(a.n * count);
+  std::vector<real_type> rwork(7 * a.n);
+  std::vector<int> iwork(5 * a.n);
+  std::vector<int> ifail(a.n);
+
+  // Determine optimal work array size:
+  Scalar wkopt;
+  int lwork = -1;
+  routines::sygvx(&itype, &jobz, &range, &uplo, &n, nullptr, &n, nullptr, &n, &vl, &vu,
+                  &il, &iu, &abstol, &m, nullptr, nullptr, &n, &wkopt, &lwork, nullptr,
+                  nullptr, nullptr, &info);
+  if (info != 0) return;  // Error!
+
+  std::vector<Scalar> work(workspace_size(wkopt, a.n * a.n));
+  lwork = static_cast<int>(work.size());
+
+  routines::sygvx(&itype, &jobz, &range, &uplo, &n, a.elements.data(), &n,
+                  b.elements.data(), &n, &vl, &vu, &il, &iu, &abstol, &m, evals.data(),
+                  evecs.data(), &n, work.data(), &lwork, rwork.data(), iwork.data(),
+                  ifail.data(), &info);
+  if (info != 0) return;  // Error!
+
+  assert_internal(static_cast<size_t>(m) == count);
+  evals.resize(count);
+}
+
+//
+// xsygv / xhegv
+//
+template <typename Scalar>
+void run_sygv(LapackSymmetricMatrix<Scalar> a, LapackSymmetricMatrix<Scalar> b,
+              std::vector<RealOf<Scalar>>& evals, std::vector<Scalar>& evecs,
+              int& info) {
+  typedef LapackRoutines<Scalar> routines;
+  typedef RealOf<Scalar> real_type;
   assert_size(a.n, b.n);
   assert_size(a.elements.size(), b.elements.size());
   assert_size(a.n * a.n, a.elements.size());
@@ -129,39 +734,202 @@ LapackPackedMatrix<double> run_dsygv(LapackSymmetricMatrix<double> a,
   int itype = 1;    //< Jobtype to do (here: A*v = \lambda*B*v
   char jobz = 'V';  //< Compute eigenvalues and eigenvectors
   char uplo = 'L';  //< Use the lower triangles of A and B
+  std::vector<real_type> rwork(std::max<size_t>(1, 3 * a.n));
 
   // Determine optimal work array size:
-  double wkopt;
+  Scalar wkopt;
   int lwork = -1;
-  dsygv_(&itype, &jobz, &uplo, &n, nullptr, &n, nullptr, &n, nullptr, &wkopt, &lwork,
-         &info);
-  if (info != 0) return LapackPackedMatrix<double>{};  // Error!
+  routines::sygv(&itype, &jobz, &uplo, &n, nullptr, &n, nullptr, &n, nullptr, &wkopt,
+                 &lwork, nullptr, &info);
+  if (info != 0) return;  // Error!
 
-  // check that we don't get a wrongfully large size and allocate work array
-  const auto wksize = static_cast<size_t>(wkopt);
-  assert_internal(wksize > 0 && wksize <= std::max<size_t>(a.n * a.n, 10000));
-  std::vector<double> work(wksize);
-  lwork = static_cast<int>(wksize);
+  std::vector<Scalar> work(workspace_size(wkopt, a.n * a.n));
+  lwork = static_cast<int>(work.size());
 
-  // Call to solve ...
-  dsygv_(&itype, &jobz, &uplo, &n, a.elements.data(), &n, b.elements.data(), &n,
-         evals.data(), work.data(), &lwork, &info);
+  routines::sygv(&itype, &jobz, &uplo, &n, a.elements.data(), &n, b.elements.data(), &n,
+                 evals.data(), work.data(), &lwork, rwork.data(), &info);
 
   // Copy eigenvectors (which are returned inside the A-array)
   evecs = std::move(a.elements);
+}
 
-  // Build the matrix to return with the choleski decomposition of the B matrix
-  // (This is stored in the first n_chol elements of the B.elements array)
-  LapackPackedMatrix<double> ret;
-  ret.n = b.n;
-  const size_t n_chol = b.n * (b.n + 1) / 2;
-  ret.elements.resize(n_chol);
-  std::move(std::begin(b.elements),
-            std::begin(b.elements) + static_cast<ptrdiff_t>(n_chol),
-            std::begin(ret.elements));
-  return ret;
+//
+// xpotrf
+//
+template <typename Scalar>
+void run_potrf(LapackSymmetricMatrix<Scalar>& b, int& info) {
+  assert_size(b.n * b.n, b.elements.size());
+  int n = static_cast<int>(b.n);
+  char uplo = 'L';  //< Compute B = L L^H
+  LapackRoutines<Scalar>::potrf(&uplo, &n, b.elements.data(), &n, &info);
 }
 
+//
+// xsygst / xhegst
+//
+template <typename Scalar>
+void run_sygst(LapackSymmetricMatrix<Scalar>& a,
+               const LapackSymmetricMatrix<Scalar>& chol, int& info) {
+  assert_size(a.n, chol.n);
+  assert_size(a.n * a.n, a.elements.size());
+  assert_size(chol.n * chol.n, chol.elements.size());
+
+  int n = static_cast<int>(a.n);
+  int itype = 1;    //< Problem type A*v = \lambda*B*v
+  char uplo = 'L';  //< Use the lower triangles of A and chol
+  LapackRoutines<Scalar>::sygst(&itype, &uplo, &n, a.elements.data(), &n,
+                                chol.elements.data(), &n, &info);
+}
+
+//
+// xtrsm
+//
+template <typename Scalar>
+void run_cholesky_backsubstitute(const LapackSymmetricMatrix<Scalar>& chol,
+                                 std::vector<Scalar>& evecs) {
+  assert_size(chol.n * chol.n, chol.elements.size());
+  if (evecs.empty()) return;
+  assert_internal(evecs.size() % chol.n == 0);
+
+  int m = static_cast<int>(chol.n);
+  int nrhs = static_cast<int>(evecs.size() / chol.n);
+  char side = 'L';    //< Solve L^H X = Y
+  char uplo = 'L';    //< chol contains the lower triangle L
+  char transa = 'C';  //< Use L^H (equivalent to L^T for real types)
+  char diag = 'N';    //< Non-unit diagonal
+  Scalar alpha = Constants<Scalar>::one;
+  LapackRoutines<Scalar>::trsm(&side, &uplo, &transa, &diag, &m, &nrhs, &alpha,
+                               chol.elements.data(), &m, evecs.data(), &m);
+}
+
+//
+// xgemm
+//
+template <typename Scalar>
+void run_gemm_tn(size_t n, size_t k, size_t l, const Scalar* a, size_t lda,
+                 const Scalar* b, size_t ldb, Scalar* c) {
+  int m_int = static_cast<int>(k);
+  int n_int = static_cast<int>(l);
+  int k_int = static_cast<int>(n);
+  int lda_int = static_cast<int>(lda);
+  int ldb_int = static_cast<int>(ldb);
+  char transa = 'T';  //< Use A^T (no complex conjugation)
+  char transb = 'N';
+  Scalar alpha = Constants<Scalar>::one;
+  Scalar beta = Constants<Scalar>::zero;
+  LapackRoutines<Scalar>::gemm(&transa, &transb, &m_int, &n_int, &k_int, &alpha, a,
+                               &lda_int, b, &ldb_int, &beta, c, &m_int);
+}
+
+template <typename Scalar>
+void run_gemm_nn(size_t n, size_t k, size_t l, const Scalar* a, size_t lda,
+                 const Scalar* b, size_t ldb, Scalar beta, Scalar* c, size_t ldc) {
+  int m_int = static_cast<int>(n);
+  int n_int = static_cast<int>(l);
+  int k_int = static_cast<int>(k);
+  int lda_int = static_cast<int>(lda);
+  int ldb_int = static_cast<int>(ldb);
+  int ldc_int = static_cast<int>(ldc);
+  char transa = 'N';
+  char transb = 'N';
+  Scalar alpha = Constants<Scalar>::one;
+  LapackRoutines<Scalar>::gemm(&transa, &transb, &m_int, &n_int, &k_int, &alpha, a,
+                               &lda_int, b, &ldb_int, &beta, c, &ldc_int);
+}
+
+//
+// xsyrk
+//
+template <typename Scalar>
+void run_syrk_t(size_t n, size_t k, const Scalar* a, size_t lda, Scalar* c) {
+  int n_int = static_cast<int>(k);
+  int k_int = static_cast<int>(n);
+  int lda_int = static_cast<int>(lda);
+  char uplo = 'U';   //< Compute the upper triangle
+  char trans = 'T';  //< C = A^T A
+  Scalar alpha = Constants<Scalar>::one;
+  Scalar beta = Constants<Scalar>::zero;
+  LapackRoutines<Scalar>::syrk(&uplo, &trans, &n_int, &k_int, &alpha, a, &lda_int, &beta,
+                               c, &n_int);
+}
+
+//
+// xgeqrf
+//
+template <typename Scalar>
+void run_geqrf(size_t n, size_t k, Scalar* a, size_t lda, Scalar* tau, int& info) {
+  typedef LapackRoutines<Scalar> routines;
+  int m_int = static_cast<int>(n);
+  int n_int = static_cast<int>(k);
+  int lda_int = static_cast<int>(lda);
+
+  // Determine optimal work array size:
+  Scalar wkopt;
+  int lwork = -1;
+  routines::geqrf(&m_int, &n_int, nullptr, &lda_int, nullptr, &wkopt, &lwork, &info);
+  if (info != 0) return;  // Error!
+
+  std::vector<Scalar> work(workspace_size(wkopt, n * k));
+  lwork = static_cast<int>(work.size());
+  routines::geqrf(&m_int, &n_int, a, &lda_int, tau, work.data(), &lwork, &info);
+}
+
+//
+// xorgqr / xungqr
+//
+template <typename Scalar>
+void run_ungqr(size_t n, size_t k, Scalar* a, size_t lda, const Scalar* tau, int& info) {
+  typedef LapackRoutines<Scalar> routines;
+  int m_int = static_cast<int>(n);
+  int n_int = static_cast<int>(k);
+  int lda_int = static_cast<int>(lda);
+
+  // Determine optimal work array size:
+  Scalar wkopt;
+  int lwork = -1;
+  routines::ungqr(&m_int, &n_int, &n_int, nullptr, &lda_int, nullptr, &wkopt, &lwork,
+                  &info);
+  if (info != 0) return;  // Error!
+
+  std::vector<Scalar> work(workspace_size(wkopt, n * k));
+  lwork = static_cast<int>(work.size());
+  routines::ungqr(&m_int, &n_int, &n_int, a, &lda_int, tau, work.data(), &lwork, &info);
+}
+
+//
+// Explicit instantiation
+//
+#define INSTANTIATE(SCALAR)                                                            \
+  template void run_syevd(LapackSymmetricMatrix<SCALAR>, std::vector<RealOf<SCALAR>>&, \
+                          std::vector<SCALAR>&, int&);                                 \
+  template void run_syevd_inplace(size_t, SCALAR*, RealOf<SCALAR>*,                    \
+                                  SyevdWorkspace<SCALAR>&, int&);                      \
+  template void run_syevr(LapackSymmetricMatrix<SCALAR>, size_t, size_t,               \
+                          std::vector<RealOf<SCALAR>>&, std::vector<SCALAR>&, int&);   \
+  template void run_sygvx(LapackSymmetricMatrix<SCALAR>, LapackSymmetricMatrix<SCALAR>, \
+                          size_t, size_t, std::vector<RealOf<SCALAR>>&,                \
+                          std::vector<SCALAR>&, int&);                                 \
+  template void run_sygv(LapackSymmetricMatrix<SCALAR>, LapackSymmetricMatrix<SCALAR>,  \
+                         std::vector<RealOf<SCALAR>>&, std::vector<SCALAR>&, int&);    \
+  template void run_potrf(LapackSymmetricMatrix<SCALAR>&, int&);                       \
+  template void run_sygst(LapackSymmetricMatrix<SCALAR>&,                              \
+                          const LapackSymmetricMatrix<SCALAR>&, int&);                 \
+  template void run_cholesky_backsubstitute(const LapackSymmetricMatrix<SCALAR>&,      \
+                                            std::vector<SCALAR>&);                     \
+  template void run_gemm_tn(size_t, size_t, size_t, const SCALAR*, size_t,             \
+                            const SCALAR*, size_t, SCALAR*);                           \
+  template void run_gemm_nn(size_t, size_t, size_t, const SCALAR*, size_t,             \
+                            const SCALAR*, size_t, SCALAR, SCALAR*, size_t);           \
+  template void run_syrk_t(size_t, size_t, const SCALAR*, size_t, SCALAR*);          \
+  template void run_geqrf(size_t, size_t, SCALAR*, size_t, SCALAR*, int&);           \
+  template void run_ungqr(size_t, size_t, SCALAR*, size_t, const SCALAR*, int&);
+
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(std::complex<float>)
+INSTANTIATE(std::complex<double>)
+#undef INSTANTIATE
+
 }  // namespace detail
 }  // namespace lazyten
 #endif  // LAZYTEN_HAVE_LAPACK
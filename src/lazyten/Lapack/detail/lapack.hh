@@ -23,6 +23,7 @@
 
 #include "LapackPackedMatrix.hh"
 #include "LapackSymmetricMatrix.hh"
+#include <krims/TypeUtils.hh>
 
 namespace lazyten {
 namespace detail {
@@ -75,7 +76,18 @@ LapackPackedMatrix<double> run_dspgv(LapackPackedMatrix<double> ap,
                                      std::vector<double>& evals,
                                      std::vector<double>& evecs, int& info);
 
-/** Run the generalised Lapack eigensolver dsygv
+//
+// The following routines are available for the scalar types float, double,
+// std::complex<float> and std::complex<double>, where for the complex
+// types the Hermitian variants of the Lapack routines are used.
+// Explicit instantiations for these types can be found in lapack.cc
+//
+
+/** The real type corresponding to a scalar type */
+template <typename Scalar>
+using RealOf = typename krims::RealTypeOf<Scalar>::type;
+
+/** Run the generalised Lapack eigensolver xsygv / xhegv
  *
  * The A array is copied in and destroyed internally
  * The B array is copied in as well
@@ -87,13 +99,148 @@ LapackPackedMatrix<double> run_dspgv(LapackPackedMatrix<double> ap,
  * \param evals   The eigenvalues ordered by value
  *                (will be resized by the function)
  * \param info   The info parameter returned by Lapack
+ */
+template <typename Scalar>
+void run_sygv(LapackSymmetricMatrix<Scalar> a, LapackSymmetricMatrix<Scalar> b,
+              std::vector<RealOf<Scalar>>& evals, std::vector<Scalar>& evecs,
+              int& info);
+
+/** Run the divide-and-conquer Lapack eigensolver xsyevd / xheevd
  *
- * \returns  The Choleski factorisation of B in lower-triangle packed format.
+ * Computes all eigenpairs, typically faster than xsyev for larger
+ * matrices at the expense of more workspace.
+ *
+ * \param A  A array in symmetric lapack matrix format
+ * \param evecs   The eigenvectors (in Fortran format, i.e. column-major)
+ *                (will be resized by the function)
+ * \param evals   The eigenvalues ordered by value
+ *                (will be resized by the function)
+ * \param info   The info parameter returned by Lapack
  */
-LapackPackedMatrix<double> run_dsygv(LapackSymmetricMatrix<double> a,
-                                     LapackSymmetricMatrix<double> b,
-                                     std::vector<double>& evals,
-                                     std::vector<double>& evecs, int& info);
+template <typename Scalar>
+void run_syevd(LapackSymmetricMatrix<Scalar> a, std::vector<RealOf<Scalar>>& evals,
+               std::vector<Scalar>& evecs, int& info);
+
+/** Work arrays for the Lapack eigensolver xsyevd / xheevd, which may be
+ *  reused between calls to run_syevd_inplace. The arrays only grow, such that
+ *  a sequence of problems of similar size is solved without reallocation.
+ */
+template <typename Scalar>
+struct SyevdWorkspace {
+  std::vector<Scalar> work;
+  std::vector<RealOf<Scalar>> rwork;
+  std::vector<int> iwork;
+};
+
+/** Run the divide-and-conquer Lapack eigensolver xsyevd / xheevd in-place
+ *
+ * Computes all eigenpairs of the n x n matrix stored column-major at a,
+ * which is overwritten by the eigenvectors (again column-major).
+ *
+ * \param n      The size of the matrix
+ * \param a      Pointer to the matrix elements (lower triangle is used)
+ * \param evals  Pointer to space for the n eigenvalues (ordered by value)
+ * \param ws     The work arrays (resized by the function if too small)
+ * \param info   The info parameter returned by Lapack
+ */
+template <typename Scalar>
+void run_syevd_inplace(size_t n, Scalar* a, RealOf<Scalar>* evals,
+                       SyevdWorkspace<Scalar>& ws, int& info);
+
+/** Run the MRRR Lapack eigensolver xsyevr / xheevr for a range of eigenpairs
+ *
+ * Only the eigenpairs with indices first to first + count - 1
+ * (0-based, in ascending order of the eigenvalues) are computed.
+ *
+ * \param A  A array in symmetric lapack matrix format
+ * \param first   Index of the first eigenpair to compute
+ * \param count   Number of eigenpairs to compute
+ * \param evecs   The eigenvectors (in Fortran format, i.e. column-major)
+ *                of size n * count (will be resized by the function)
+ * \param evals   The count eigenvalues ordered by value
+ *                (will be resized by the function)
+ * \param info   The info parameter returned by Lapack
+ */
+template <typename Scalar>
+void run_syevr(LapackSymmetricMatrix<Scalar> a, size_t first, size_t count,
+               std::vector<RealOf<Scalar>>& evals, std::vector<Scalar>& evecs,
+               int& info);
+
+/** Run the generalised Lapack eigensolver xsygvx / xhegvx for a range
+ *  of eigenpairs
+ *
+ * Only the eigenpairs with indices first to first + count - 1
+ * (0-based, in ascending order of the eigenvalues) are computed.
+ *
+ * \param A  A array in symmetric lapack matrix format
+ * \param B  B array in symmetric lapack matrix format
+ * \param first   Index of the first eigenpair to compute
+ * \param count   Number of eigenpairs to compute
+ * \param evecs   The eigenvectors (in Fortran format, i.e. column-major)
+ *                of size n * count (will be resized by the function)
+ * \param evals   The count eigenvalues ordered by value
+ *                (will be resized by the function)
+ * \param info   The info parameter returned by Lapack
+ */
+template <typename Scalar>
+void run_sygvx(LapackSymmetricMatrix<Scalar> a, LapackSymmetricMatrix<Scalar> b,
+               size_t first, size_t count, std::vector<RealOf<Scalar>>& evals,
+               std::vector<Scalar>& evecs, int& info);
+
+/** Compute the Cholesky factorisation B = L L^H of a symmetric / Hermitian
+ *  positive definite matrix using the Lapack routine xpotrf
+ *
+ * \param b     On input the matrix B, on output L in the lower triangle
+ *              (the strict upper triangle is not referenced)
+ * \param info  The info parameter returned by Lapack
+ */
+template <typename Scalar>
+void run_potrf(LapackSymmetricMatrix<Scalar>& b, int& info);
+
+/** Reduce the generalised eigenproblem A x = \lambda B x to standard form
+ *  L^{-1} A L^{-H} y = \lambda y using the Lapack routine xsygst / xhegst
+ *
+ * \param a     On input the matrix A, on output the transformed matrix
+ * \param chol  The Cholesky factorisation of B as returned from run_potrf
+ * \param info  The info parameter returned by Lapack
+ */
+template <typename Scalar>
+void run_sygst(LapackSymmetricMatrix<Scalar>& a,
+               const LapackSymmetricMatrix<Scalar>& chol, int& info);
+
+/** Back-transform eigenvectors of the reduced standard problem to
+ *  eigenvectors of the generalised problem, i.e. compute x = L^{-H} y
+ *  (BLAS routine xtrsm)
+ *
+ * \param chol   The Cholesky factorisation of B as returned from run_potrf
+ * \param evecs  The eigenvectors (column-major with leading dimension
+ *               chol.n), which are overwritten.
+ */
+template <typename Scalar>
+void run_cholesky_backsubstitute(const LapackSymmetricMatrix<Scalar>& chol,
+                                 std::vector<Scalar>& evecs);
+
+/** Compute the Bunch-Kaufman factorisation A = L D L^T of a real symmetric
+ *  (possibly indefinite) matrix using the Lapack routine dsytrf
+ *
+ * \param a     On input the matrix A, on output its factorisation
+ * \param ipiv  The pivoting indices (will be resized by the function)
+ * \param info  The info parameter returned by Lapack
+ */
+void run_dsytrf(LapackSymmetricMatrix<double>& a, std::vector<int>& ipiv, int& info);
+
+/** Solve the linear system A X = B using the factorisation
+ *  obtained from run_dsytrf (Lapack routine dsytrs)
+ *
+ * \param a     The factorisation of A as returned from run_dsytrf
+ * \param ipiv  The pivoting indices as returned from run_dsytrf
+ * \param b     Pointer to the right-hand sides (column-major with leading
+ *              dimension a.n), which are overwritten by the solution
+ * \param nrhs  The number of right-hand sides
+ * \param info  The info parameter returned by Lapack
+ */
+void run_dsytrs(const LapackSymmetricMatrix<double>& a, const std::vector<int>& ipiv,
+                double* b, size_t nrhs, int& info);
 
 }  // namespace detail
 }  // namespace lazyten
@@ -25,7 +25,11 @@
 #include "lazyten/LazyMatrixSum.hh"
 #include "lazyten/Matrix_i.hh"
 #include "lazyten/StoredMatrix_i.hh"
+#include <algorithm>
 #include <krims/GenMap.hh>
+#include <limits>
+#include <mutex>
+#include <numeric>
 
 namespace lazyten {
 
@@ -55,8 +59,16 @@ class LazyMatrixExpression : public Matrix_i<typename StoredMatrix::scalar_type>
   typedef typename stored_matrix_type::vector_type vector_type;
   typedef Matrix_i<typename StoredMatrix::scalar_type> base_type;
   typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::real_type real_type;
   typedef typename base_type::size_type size_type;
 
+  /** The iterator type (a const iterator serving elements from row tiles,
+   *  which are extracted blockwise using extract_block) */
+  typedef BufferedMatrixConstIterator<LazyMatrixExpression<StoredMatrix>> iterator;
+
+  //! The const iterator type
+  typedef BufferedMatrixConstIterator<LazyMatrixExpression<StoredMatrix>> const_iterator;
+
   /** The pointer type to use for pointers to LazyMatrixExpressions */
   typedef std::unique_ptr<LazyMatrixExpression<StoredMatrix>>
         lazy_matrix_expression_ptr_type;
@@ -150,6 +162,41 @@ class LazyMatrixExpression : public Matrix_i<typename StoredMatrix::scalar_type>
     extract_block(ret, 0, 0);
     return ret;
   }
+
+  /** \brief Extract the diagonal of the matrix
+   *
+   * Returns the vector of the elements (i,i) for i in [0, min(n_rows, n_cols)).
+   *
+   * The default implementation extracts square tiles along the diagonal
+   * using extract_block. Child classes should override this if the
+   * diagonal can be obtained more cheaply from their structure.
+   */
+  virtual vector_type extract_diagonal() const;
+  ///@}
+
+  /** \name Iterators
+   *
+   * In contrast to the Matrix_i iterators these do not call operator() for
+   * each element, but extract tiles of rows at once via extract_block.
+   */
+  ///@{
+  /** Return an iterator to the beginning */
+  iterator begin() { return iterator(*this, {0, 0}); }
+
+  /** Return a const_iterator to the beginning */
+  const_iterator begin() const { return cbegin(); }
+
+  /** Return a const_iterator to the beginning */
+  const_iterator cbegin() const { return const_iterator(*this, {0, 0}); }
+
+  /** Return an iterator to the end */
+  iterator end() { return iterator(*this); }
+
+  /** Return a const_iterator to the end */
+  const_iterator end() const { return cend(); }
+
+  /** Return a const_iterator to the end */
+  const_iterator cend() const { return const_iterator(*this); }
   ///@}
 
   /** \name Matrix application and matrix products
@@ -274,6 +321,8 @@ class LazyMatrixExpression : public Matrix_i<typename StoredMatrix::scalar_type>
 
   /** \brief Update the internal data of all objects in this expression
    * given the GenMap
+   *
+   * \note Implementations need to call invalidate_property_cache().
    * */
   virtual void update(const krims::GenMap& map) = 0;
 
@@ -283,6 +332,91 @@ class LazyMatrixExpression : public Matrix_i<typename StoredMatrix::scalar_type>
    * lazy_matrix_expression_ptr_type
    */
   virtual lazy_matrix_expression_ptr_type clone() const = 0;
+
+  /** \brief Does the expression own all data it depends on
+   *
+   * This is the case if the represented matrix can only change by calls to
+   * members of this object (e.g. update()), i.e. if no stored matrix,
+   * vector or other object referenced from elsewhere enters it. Only for
+   * such expressions the results of is_symmetric() and is_hermitian() are
+   * cached. The default implementation returns false.
+   */
+  virtual bool owns_data() const { return false; }
+
+ protected:
+  /** \brief Forget the cached results of is_symmetric() and is_hermitian()
+   *
+   * Since obtaining matrix elements from lazy matrices can be expensive,
+   * the outcome of symmetry checks is remembered if owns_data() is true.
+   * This function needs to be called by all functions changing the
+   * represented matrix, in particular by update().
+   */
+  void invalidate_property_cache() { m_symmetry_cache.clear(); }
+
+  /** \brief Compare all pairs m(i,j) and m(j,i) with i <= j
+   *
+   * Looks up the cached results first if owns_data() is true. Otherwise pairs
+   * of tiles from the upper and the lower triangle are obtained using
+   * extract_block and compared until the first violating pair.
+   */
+  bool check_symmetry(real_type tolerance, bool hermitian) const override;
+
+ private:
+  /** Compare the tiles of the upper and lower triangle without any caching */
+  bool compare_symmetric_tiles(real_type tolerance, bool hermitian) const;
+
+  /** Known outcomes of the symmetry checks: For is_symmetric() (index 0) and
+   *  is_hermitian() (index 1) the smallest tolerance for which the check
+   *  passed and the largest tolerance for which it failed.
+   *
+   *  Access is guarded by a mutex, such that concurrent calls to the const
+   *  is_symmetric() or is_hermitian() are safe. Copies start empty. */
+  class SymmetryCheckCache {
+   public:
+    SymmetryCheckCache() = default;
+    SymmetryCheckCache(const SymmetryCheckCache&) {}
+    SymmetryCheckCache& operator=(const SymmetryCheckCache&) {
+      clear();
+      return *this;
+    }
+
+    /** Look up the outcome of a check. Returns false if it is not known. */
+    bool lookup(bool hermitian, real_type tolerance, bool& outcome) const {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      const Entry& entry = m_entries[hermitian ? 1 : 0];
+      outcome = tolerance >= entry.passed;
+      return outcome || tolerance <= entry.failed;
+    }
+
+    /** Store the outcome of a check */
+    void store(bool hermitian, real_type tolerance, bool outcome) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      Entry& entry = m_entries[hermitian ? 1 : 0];
+      if (outcome) {
+        entry.passed = std::min(entry.passed, tolerance);
+      } else {
+        entry.failed = std::max(entry.failed, tolerance);
+      }
+    }
+
+    /** Forget all known outcomes */
+    void clear() {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_entries[0] = Entry{};
+      m_entries[1] = Entry{};
+    }
+
+   private:
+    struct Entry {
+      real_type passed = std::numeric_limits<real_type>::infinity();
+      real_type failed = -Constants<real_type>::one;
+    };
+
+    mutable std::mutex m_mutex;
+    Entry m_entries[2];
+  };
+
+  mutable SymmetryCheckCache m_symmetry_cache;
 };
 
 //@{
@@ -301,6 +435,107 @@ struct IsLazyMatrix<Matrix, krims::VoidType<typename Matrix::stored_matrix_type>
                                Matrix> {};
 //@}
 
+//
+// ---------------------------------------------------------------
+//
+
+template <typename StoredMatrix>
+bool LazyMatrixExpression<StoredMatrix>::check_symmetry(real_type tolerance,
+                                                        bool hermitian) const {
+  const bool cached = owns_data();
+  bool outcome;
+  if (cached && m_symmetry_cache.lookup(hermitian, tolerance, outcome)) return outcome;
+
+  outcome = compare_symmetric_tiles(tolerance, hermitian);
+  if (cached) m_symmetry_cache.store(hermitian, tolerance, outcome);
+  return outcome;
+}
+
+template <typename StoredMatrix>
+bool LazyMatrixExpression<StoredMatrix>::compare_symmetric_tiles(real_type tolerance,
+                                                                 bool hermitian) const {
+  using krims::numerical_error;
+
+  const size_type n = this->n_rows();
+  const size_type tile = detail::symmetry_check_tile_size;
+  for (size_type jtile = 0; jtile < n; jtile += tile) {
+    const size_type nj = std::min(tile, n - jtile);
+    for (size_type itile = 0; itile <= jtile; itile += tile) {
+      const size_type ni = std::min(tile, n - itile);
+      const bool diagonal = itile == jtile;
+
+      // Tile from the upper triangle and its mirror image from the lower one
+      stored_matrix_type upper(ni, nj, false);
+      extract_block(upper, itile, jtile);
+      stored_matrix_type lower_tile(diagonal ? 0 : nj, diagonal ? 0 : ni, false);
+      if (!diagonal) extract_block(lower_tile, jtile, itile);
+      const stored_matrix_type& lower = diagonal ? upper : lower_tile;
+
+      for (size_type j = 0; j < nj; ++j) {
+        for (size_type i = 0; i < (diagonal ? j + 1 : ni); ++i) {
+          const scalar_type aij =
+                hermitian ? krims::ConjFctr{}(upper(i, j)) : upper(i, j);
+          const real_type error =
+                std::abs(numerical_error<scalar_type>(aij - lower(j, i), 0));
+          if (error > tolerance) return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+template <typename StoredMatrix>
+typename LazyMatrixExpression<StoredMatrix>::vector_type
+LazyMatrixExpression<StoredMatrix>::extract_diagonal() const {
+  const size_type n = std::min(this->n_rows(), this->n_cols());
+  const size_type tile = detail::diagonal_extraction_tile_size;
+
+  vector_type diag(n, false);
+  for (size_type start = 0; start < n; start += tile) {
+    const size_type size = std::min(tile, n - start);
+    stored_matrix_type block(size, size, false);
+    extract_block(block, start, start);
+    for (size_type i = 0; i < size; ++i) diag[start + i] = block(i, i);
+  }
+  return diag;
+}
+
+//
+// Diagonal and trace
+//
+/** \brief Extract the diagonal of a stored matrix */
+template <typename Matrix,
+          typename = krims::enable_if_t<IsStoredMatrix<Matrix>::value>>
+typename Matrix::vector_type extract_diagonal(const Matrix& m) {
+  const size_t n = std::min(m.n_rows(), m.n_cols());
+  typename Matrix::vector_type diag(n, false);
+  for (size_t i = 0; i < n; ++i) diag[i] = m(i, i);
+  return diag;
+}
+
+/** \brief Extract the diagonal of a lazy matrix
+ *
+ * Calls the extract_diagonal member function, such that
+ * generic code can treat lazy and stored matrices alike. */
+template <typename StoredMatrix>
+typename StoredMatrix::vector_type extract_diagonal(
+      const LazyMatrixExpression<StoredMatrix>& m) {
+  return m.extract_diagonal();
+}
+
+/** \brief Compute the trace of a lazy matrix
+ *
+ * In contrast to the generic version for Matrix_i, which calls operator()
+ * for each diagonal element, this uses extract_diagonal. */
+template <typename StoredMatrix>
+typename StoredMatrix::scalar_type trace(const LazyMatrixExpression<StoredMatrix>& m) {
+  assert_dbg(m.n_rows() == m.n_cols(), ExcMatrixNotSquare());
+  const auto diag = m.extract_diagonal();
+  return std::accumulate(std::begin(diag), std::end(diag),
+                         Constants<typename StoredMatrix::scalar_type>::zero);
+}
+
 //
 // Multiplication
 //
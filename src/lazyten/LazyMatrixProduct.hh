@@ -21,6 +21,7 @@
 #include "detail/scale_or_set.hh"
 #include "lazyten/Constants.hh"
 #include "lazyten/LazyMatrixExpression.hh"
+#include "lazyten/Matrix_i.hh"
 #include "lazyten/MultiVector.hh"
 #include <algorithm>
 #include <iterator>
@@ -98,6 +99,7 @@ class LazyMatrixProduct : public LazyMatrixExpression<StoredMatrix> {
   explicit LazyMatrixProduct(LazyMatrixProduct prod, scalar_type factor) {
     swap(*this, prod);
     m_coefficient *= factor;
+    this->invalidate_property_cache();
   }
 
   //@{
@@ -124,6 +126,7 @@ class LazyMatrixProduct : public LazyMatrixExpression<StoredMatrix> {
 
     // Place into m_factors by moving a copy there
     m_factors.push_back(std::move(e.clone()));
+    this->invalidate_property_cache();
   }
 
   /** \brief Push back all factors of a product onto another product
@@ -140,6 +143,7 @@ class LazyMatrixProduct : public LazyMatrixExpression<StoredMatrix> {
 
     // Adjust the scaling:
     m_coefficient *= prod.m_coefficient;
+    this->invalidate_property_cache();
   }
 
   //
@@ -150,6 +154,7 @@ class LazyMatrixProduct : public LazyMatrixExpression<StoredMatrix> {
   void scale(const scalar_type c) {
     assert_finite(c);
     m_coefficient *= c;
+    this->invalidate_property_cache();
   }
 
   //
@@ -205,6 +210,14 @@ class LazyMatrixProduct : public LazyMatrixExpression<StoredMatrix> {
                      const scalar_type c_this = Constants<scalar_type>::one,
                      const scalar_type c_M = Constants<scalar_type>::zero) const override;
 
+  /** \brief Extract the diagonal of the matrix
+   *
+   * Element i is computed as the dot product of row i of the first factor
+   * and column i of the product of all other factors. The latter columns
+   * are formed tile by tile, such that the full product is never formed.
+   */
+  vector_type extract_diagonal() const override;
+
   /** \brief Compute the Matrix-Multivector application -- generic version
    *
    * Loosely speaking we perform
@@ -261,6 +274,7 @@ class LazyMatrixProduct : public LazyMatrixExpression<StoredMatrix> {
     for (auto& expression : m_factors) {
       expression->update(map);
     }
+    this->invalidate_property_cache();
   }
 
   /** \brief Clone the expression */
@@ -269,6 +283,13 @@ class LazyMatrixProduct : public LazyMatrixExpression<StoredMatrix> {
     return lazy_matrix_expression_ptr_type(new LazyMatrixProduct(*this));
   }
 
+  /** \brief Does the product own all data it depends on,
+   *  i.e. do all factors own their data. */
+  bool owns_data() const override {
+    return std::all_of(std::begin(m_factors), std::end(m_factors),
+                       [](const factor_ptr_type& f) { return f->owns_data(); });
+  }
+
   /** \brief Is this object empty? */
   bool empty() const { return m_factors.empty(); }
 
@@ -509,6 +530,48 @@ void LazyMatrixProduct<StoredMatrix>::extract_block(
   }
 }
 
+template <typename StoredMatrix>
+typename LazyMatrixProduct<StoredMatrix>::vector_type
+LazyMatrixProduct<StoredMatrix>::extract_diagonal() const {
+  // Not yet implemented for empty products ... they should behave
+  // as a diagonal matrix with value m_coefficient
+  assert_implemented(!empty());
+
+  if (m_factors.size() == 1) {
+    vector_type diag = m_factors.front()->extract_diagonal();
+    for (auto& elem : diag) elem *= m_coefficient;
+    return diag;
+  }
+
+  const size_type n = std::min(n_rows(), n_cols());
+  const size_type tile = detail::diagonal_extraction_tile_size;
+  const auto& first = m_factors.front();
+  const auto& last = m_factors.back();
+
+  vector_type diag(n, false);
+  for (size_type start = 0; start < n; start += tile) {
+    const size_type size = std::min(tile, n - start);
+
+    // Columns [start, start + size) of the product of all factors but the first
+    stored_matrix_type cols(last->n_rows(), size, false);
+    last->extract_block(cols, 0, start);
+    multiply_in_place(m_factors.rbegin() + 1, m_factors.rend() - 1, cols,
+                      Transposed::None);
+
+    // The matching rows of the first factor
+    stored_matrix_type rows(size, first->n_cols(), false);
+    first->extract_block(rows, start, 0);
+    assert_internal(rows.n_cols() == cols.n_rows());
+
+    for (size_type i = 0; i < size; ++i) {
+      scalar_type sum = Constants<scalar_type>::zero;
+      for (size_type k = 0; k < rows.n_cols(); ++k) sum += rows(i, k) * cols(k, i);
+      diag[start + i] = m_coefficient * sum;
+    }
+  }
+  return diag;
+}
+
 template <typename StoredMatrix>
 template <typename BidirectIterator>
 void LazyMatrixProduct<StoredMatrix>::extract_block_inner(
@@ -67,6 +67,7 @@ class LazyMatrixSum : public LazyMatrixExpression<StoredMatrix> {
   typedef typename base_type::stored_matrix_type stored_matrix_type;
   typedef typename base_type::size_type size_type;
   typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::vector_type vector_type;
   typedef typename base_type::lazy_matrix_expression_ptr_type
         lazy_matrix_expression_ptr_type;
 
@@ -199,6 +200,7 @@ class LazyMatrixSum : public LazyMatrixExpression<StoredMatrix> {
 
     // Push back
     m_lazy_terms.push_back(std::move(term));
+    this->invalidate_property_cache();
   }
 
   /** Push back a further lazy matrix expression */
@@ -227,6 +229,7 @@ class LazyMatrixSum : public LazyMatrixExpression<StoredMatrix> {
     stored_term_type term(mat, factor);
 
     m_stored_terms.push_back(std::move(term));
+    this->invalidate_property_cache();
   }
 
   void push_term(LazyMatrixSum sum) {
@@ -244,6 +247,7 @@ class LazyMatrixSum : public LazyMatrixExpression<StoredMatrix> {
     // Move all stored terms of sum to the end of this object
     std::move(std::begin(sum.m_stored_terms), std::end(sum.m_stored_terms),
               back_inserter(m_stored_terms));
+    this->invalidate_property_cache();
   }
 
   //
@@ -260,6 +264,7 @@ class LazyMatrixSum : public LazyMatrixExpression<StoredMatrix> {
     for (auto& term : m_lazy_terms) {
       term *= c;
     }
+    this->invalidate_property_cache();
   }
 
   //
@@ -300,6 +305,14 @@ class LazyMatrixSum : public LazyMatrixExpression<StoredMatrix> {
                      const scalar_type c_this = Constants<scalar_type>::one,
                      const scalar_type c_M = Constants<scalar_type>::zero) const override;
 
+  /** \brief Extract the diagonal of the matrix
+   *
+   * Accumulates the diagonals of all terms, i.e. the stored terms
+   * are accessed element-wise and the lazy terms are asked for their
+   * diagonal via extract_diagonal.
+   */
+  vector_type extract_diagonal() const override;
+
   /** \brief Compute the Matrix-Multivector application -- generic version
    *
    * Loosely speaking we perform
@@ -356,6 +369,7 @@ class LazyMatrixSum : public LazyMatrixExpression<StoredMatrix> {
     for (auto& expression : m_lazy_terms) {
       expression.update(map);
     }
+    this->invalidate_property_cache();
   }
 
   /** \brief Clone the expression */
@@ -364,6 +378,14 @@ class LazyMatrixSum : public LazyMatrixExpression<StoredMatrix> {
     return lazy_matrix_expression_ptr_type(new LazyMatrixSum(*this));
   }
 
+  /** \brief Does the sum own all data it depends on, i.e. are there no
+   *  (referenced) stored terms and do all lazy terms own their data. */
+  bool owns_data() const override {
+    return m_stored_terms.empty() &&
+           std::all_of(std::begin(m_lazy_terms), std::end(m_lazy_terms),
+                       [](const lazy_term_type& t) { return t.owns_data(); });
+  }
+
   /** \brief Is this object empty? */
   bool empty() const { return m_stored_terms.size() == 0 && m_lazy_terms.size() == 0; }
 
@@ -620,6 +642,25 @@ void LazyMatrixSum<StoredMatrix>::extract_block(
   }
 }
 
+template <typename StoredMatrix>
+typename LazyMatrixSum<StoredMatrix>::vector_type
+LazyMatrixSum<StoredMatrix>::extract_diagonal() const {
+  const size_type n = std::min(n_rows(), n_cols());
+  vector_type diag(n);
+
+  for (const auto& stored_term : m_stored_terms) {
+    const scalar_type coeff = stored_term.coefficient();
+    const stored_matrix_type& mat = stored_term.matrix();
+    for (size_type i = 0; i < n; ++i) diag[i] += coeff * mat(i, i);
+  }
+
+  for (const auto& lazy_term : m_lazy_terms) {
+    const vector_type term_diag = lazy_term.extract_diagonal();
+    for (size_type i = 0; i < n; ++i) diag[i] += term_diag[i];
+  }
+  return diag;
+}
+
 template <typename StoredMatrix>
 void LazyMatrixSum<StoredMatrix>::apply(
       const MultiVector<const MutableMemoryVector_i<scalar_type>>& x,
@@ -35,6 +35,7 @@ class LazyMatrixWrapper : public LazyMatrixExpression<StoredMatrix> {
   typedef typename base_type::stored_matrix_type stored_matrix_type;
   typedef typename base_type::size_type size_type;
   typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::vector_type vector_type;
   typedef typename base_type::lazy_matrix_expression_ptr_type
         lazy_matrix_expression_ptr_type;
 
@@ -118,6 +119,14 @@ class LazyMatrixWrapper : public LazyMatrixExpression<StoredMatrix> {
     m_inner->extract_block(M, start_row, start_col, mode, c_this, c_M);
   }
 
+  /** \brief Extract the diagonal of the matrix
+   *
+   * Reads the diagonal elements of the inner stored matrix directly.
+   */
+  vector_type extract_diagonal() const override {
+    return lazyten::extract_diagonal(*m_inner);
+  }
+
   /** \brief Compute the Matrix-Multivector application -- generic version
    *
    * Loosely speaking we perform
@@ -199,11 +208,10 @@ class LazyMatrixWrapper : public LazyMatrixExpression<StoredMatrix> {
 
   /** \brief Update the internal data
    *
-   *  In this case does nothing.
+   *  In this case only forgets the cached properties, since the
+   *  inner matrix may have changed.
    * */
-  void update(const krims::GenMap&) override {
-    // Do nothing.
-  }
+  void update(const krims::GenMap&) override { this->invalidate_property_cache(); }
 
   /** \brief Clone the expression */
   lazy_matrix_expression_ptr_type clone() const override {
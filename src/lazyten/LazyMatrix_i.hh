@@ -81,6 +81,11 @@ namespace lazyten {
  *      the methods ``has_apply_inverse`` and ``inverse_apply`` (see LazyMatrixExpression)
  *      should be overloaded as well.
  *
+ * If ``owns_data`` is overridden to return true, the results of is_symmetric()
+ * and is_hermitian() are cached. In any case implementations of ``update`` or
+ * of any other function changing the matrix need to call
+ * ``invalidate_property_cache()``.
+ *
  * \tparam StoredMatrix   The type of stored matrix to use
  */
 template <typename StoredMatrix>
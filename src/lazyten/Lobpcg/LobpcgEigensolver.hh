@@ -0,0 +1,700 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/Base/Solvers.hh"
+#include "lazyten/Exceptions.hh"
+#include "lazyten/LazyMatrixExpression.hh"
+#include "lazyten/detail/block_ops.hh"
+#include "lazyten/detail/small_eigensystem.hh"
+#include "lazyten/random.hh"
+#include <memory>
+
+namespace lazyten {
+
+template <typename Eigenproblem>
+struct LobpcgEigensolverState : public EigensolverStateBase<Eigenproblem> {
+  typedef EigensolverStateBase<Eigenproblem> base_type;
+  typedef typename base_type::eproblem_type eproblem_type;
+  typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::real_type real_type;
+  typedef typename base_type::size_type size_type;
+
+  /** The number of LOBPCG iterations performed */
+  size_t n_iterations;
+
+  /** The number of vectors the matrix A was applied to */
+  size_t n_a_applies;
+
+  /** The number of vectors the metric B was applied to
+   *  (always zero for normal eigenproblems) */
+  size_t n_b_applies;
+
+  /** The number of vectors the preconditioner was applied to */
+  size_t n_preconditioner_applies;
+
+  /** The number of Ritz pairs, which were converged and hence
+   *  soft-locked at the end of the most recent iteration */
+  size_t n_locked;
+
+  /** The residual tolerance actually used in the convergence check
+   *  (see detail::floored_residual_tolerance) */
+  real_type residual_tolerance;
+
+  /** Get the number of LOBPCG iterations performed */
+  size_t n_iter() const override { return n_iterations; }
+
+  /** Get the number of Problem matrix applies (A*x) */
+  size_t n_mtx_applies() const override { return n_a_applies; }
+
+  /** Setup the initial state from an eigenproblem to solve */
+  LobpcgEigensolverState(const eproblem_type problem)
+        : base_type(std::move(problem)),
+          n_iterations(0),
+          n_a_applies(0),
+          n_b_applies(0),
+          n_preconditioner_applies(0),
+          n_locked(0),
+          residual_tolerance(0) {}
+};
+
+DefSolverException2(ExcLobpcgRayleighRitzFailed, size_t, iteration, size_t, n_subspace,
+                    << "The Rayleigh-Ritz step of LOBPCG iteration " << iteration
+                    << " failed, since the projected metric of the " << n_subspace
+                    << "-dimensional search space was not positive definite.");
+
+DefSolverException1(ExcLobpcgBlockDegenerate, size_t, n_vectors,
+                    << "Could not build an initial LOBPCG block of " << n_vectors
+                    << " linearly independent vectors.");
+
+/** Class which contains all GenMap keys which are understood
+ *  by the LobpcgSolver update_control_params as static string
+ *  members.
+ *  See their doc strings for the types required. */
+struct LobpcgEigensolverKeys : public EigensolverBaseKeys {
+  /** Maximum number of iterations. Type: size_t */
+  static const std::string max_iter;
+
+  /** Number of additional vectors in the iterated block. Type: size_t */
+  static const std::string n_extra_vectors;
+};
+
+namespace detail {
+/** A block of vectors together with its images under the problem matrix A
+ *  and the metric B as they are propagated through the LOBPCG iteration.
+ *
+ * For normal eigenproblems bx is only a shallow copy of x.
+ * Empty ax or bx MultiVectors denote that the respective image
+ * has not been computed yet.
+ */
+template <typename Vector>
+struct LobpcgBlock {
+  MultiVector<Vector> x;
+  MultiVector<Vector> ax;
+  MultiVector<Vector> bx;
+
+  size_t n_vectors() const { return x.n_vectors(); }
+};
+}  // namespace detail
+
+/** \brief Locally optimal block preconditioned conjugate gradient eigensolver
+ *
+ * Native implementation of the LOBPCG algorithm by Knyazev for real
+ * Hermitian (generalised) eigenproblems. The method only needs the
+ * action of the problem matrix A (and the metric B) on blocks of
+ * vectors, such that it is well-suited for large lazy matrices,
+ * for which only an apply method is implemented. In contrast to
+ * ARPACK mode 2 no apply_inverse of the metric is required.
+ *
+ * In each iteration a Rayleigh-Ritz procedure is performed on the
+ * search space spanned by the current block of Ritz vectors X,
+ * the preconditioned residuals W and the previous search directions P.
+ * All images A*X, B*X, A*P, B*P are updated by linear combination,
+ * such that each iteration requires only one apply of A and B
+ * per active residual vector. Ritz pairs, which are converged are
+ * soft-locked, i.e. they stay in the Rayleigh-Ritz procedure, but no
+ * further search directions are computed for them.
+ *
+ * If the state carries an eigensolution from a previous solve
+ * (e.g. via solve_with_guess), its eigenvectors are used as the
+ * initial block.
+ *
+ * \note Only real problems are supported (see EigensystemSolver).
+ *
+ * ## Control parameters and their default values
+ *   - max_iter: Maximum number of iterations. Default: 100
+ *   - which:    Which eigenvalues to target. Default: "SR";
+ *     allowed values:
+ *       - "SR"   Smallest real
+ *       - "LR"   Largest real
+ *   - tolerance: Tolerance for eigensolver, i.e. the maximal
+ *                residual norm relative to the magnitude of the
+ *                eigenvalue. Default: Default numeric tolerance
+ *                (as in Constants.hh), but at least the floor of
+ *                detail::floored_residual_tolerance.
+ *   - n_extra_vectors: Number of guard vectors to iterate in addition
+ *                to the requested eigenpairs. Default: 0, which implies
+ *                that std::max(2, n_ep/2) extra vectors are used.
+ *
+ * ## Preconditioning
+ * A (symmetric positive definite) preconditioner T for A can be
+ * supplied by setting the preconditioner member. It should
+ * approximate the inverse of A - \lambda B (shifted to be positive
+ * definite) for the targeted eigenvalues \lambda. If it is not set,
+ * no preconditioning is done.
+ *
+ * ## Handlers and events
+ * The functions start_iteration_step and end_iteration_step
+ * are not used by this class.
+ *
+ * \tparam Eigenproblem  The eigenproblem to solve.
+ * \tparam State         The state type of the solver.
+ */
+template <typename Eigenproblem, typename State = LobpcgEigensolverState<Eigenproblem>>
+class LobpcgEigensolver : public EigensolverBase<State> {
+  static_assert(std::is_same<Eigenproblem, typename State::eproblem_type>::value,
+                "The type Eigenproblem and the implicit eigenproblem type in the SCF "
+                "state have to agree");
+
+  static_assert(Eigenproblem::hermitian,
+                "LOBPCG can only solve Hermitian eigenproblems.");
+
+  static_assert(Eigenproblem::real,
+                "LOBPCG can only solve real problems at the moment.");
+
+ public:
+  //@{
+  /** Forwarded types */
+  typedef EigensolverBase<State> base_type;
+  typedef typename base_type::state_type state_type;
+  typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::real_type real_type;
+  typedef typename base_type::evalue_type evalue_type;
+  typedef typename base_type::evector_type evector_type;
+  typedef typename base_type::esoln_type esoln_type;
+  typedef typename base_type::stored_matrix_type stored_matrix_type;
+  typedef typename state_type::size_type size_type;
+  //@}
+
+  /** \name Constructor */
+  //@{
+  /** Construct an eigensolver with the default parameters */
+  LobpcgEigensolver() {}
+
+  /** Construct an eigensolver setting the parameters from the map */
+  LobpcgEigensolver(const krims::GenMap& map) : LobpcgEigensolver() {
+    update_control_params(map);
+  }
+  //@}
+
+  /** \name Iteration control */
+  ///@{
+  /** Maximum number of iterations */
+  size_t max_iter = 100;
+
+  /** \brief Number of extra (guard) vectors in the iterated block.
+   *
+   * By default 0, which implies that we use std::max(2, n_ep/2)
+   * extra vectors, but never more than dim - n_ep.
+   */
+  size_t n_extra_vectors = 0;  // i.e. auto-determine
+
+  /** The preconditioner to use or a nullptr if no preconditioning
+   *  should be done */
+  std::shared_ptr<const LazyMatrixExpression<stored_matrix_type>> preconditioner =
+        nullptr;
+
+  /** Update control parameters from Parameter map */
+  void update_control_params(const krims::GenMap& map) {
+    base_type::update_control_params(map);
+    max_iter = map.at(LobpcgEigensolverKeys::max_iter, max_iter);
+    n_extra_vectors = map.at(LobpcgEigensolverKeys::n_extra_vectors, n_extra_vectors);
+  }
+
+  /** Get the current settings of all internal control parameters and
+   *  update the GenMap accordingly.
+   */
+  void get_control_params(krims::GenMap& map) const {
+    base_type::get_control_params(map);
+    map.update(LobpcgEigensolverKeys::max_iter, max_iter);
+    map.update(LobpcgEigensolverKeys::n_extra_vectors, n_extra_vectors);
+  }
+  ///@}
+
+  /** Implementation of the IterativeSolver method */
+  void solve_state(state_type& state) const override;
+
+ private:
+  typedef detail::LobpcgBlock<evector_type> block_type;
+
+  /** Assert that the state of the control parameters is sensible.
+   *  In case its not, raise an ExcInvalidEigensolverParameters
+   *  exception */
+  void assert_valid_control_params(state_type& s) const;
+
+  /** Number of vectors in the iterated block */
+  size_type block_size(const Eigenproblem& problem) const;
+
+  /** Build the initial B-orthonormal block of size n_vectors from the
+   *  guess in the state, filling up with random vectors as needed. */
+  block_type initial_block(state_type& state, size_type n_vectors) const;
+
+  /** Compute the image of blk.x under A and store it in blk.ax */
+  void apply_a(state_type& state, block_type& blk) const;
+
+  /** Compute the image of blk.x under B and store it in blk.bx */
+  void apply_b(state_type& state, block_type& blk) const;
+
+  /** Form the linear combinations of the vectors in blk using the
+   *  column-major coefficient matrix c with ldc rows and n_cols columns.
+   *  The images under A and B are transformed alongside (if present). */
+  block_type combine(const block_type& blk, const std::vector<scalar_type>& c,
+                     size_type ldc, size_type n_cols) const;
+
+  /** Remove the components along the B-orthonormal block q from blk
+   *  (with respect to the B inner product). */
+  void project_out(const block_type& q, block_type& blk) const;
+
+  /** B-orthonormalise a block, dropping all directions which are
+   *  numerically linearly dependent. The columns are normalised first,
+   *  such that small columns are not mistaken as dependent.
+   *  Requires blk.bx to be set. */
+  block_type orthonormalise(const block_type& blk) const;
+
+  /** Perform the Rayleigh-Ritz step on the search space s.
+   *
+   * \param evals   The Ritz values (ascending)
+   * \param evecs   The coefficients of the Ritz vectors (column-major)
+   * \returns false if the projected metric was not positive definite.
+   */
+  bool rayleigh_ritz(const block_type& s, std::vector<scalar_type>& evals,
+                     std::vector<scalar_type>& evecs) const;
+
+  /** Shallow copy of the selected columns of a block */
+  block_type select_columns(const block_type& blk,
+                            const std::vector<size_type>& idcs) const;
+
+  /** Shallow concatenation of a number of blocks */
+  block_type concatenate(std::initializer_list<const block_type*> blocks) const;
+};
+
+//
+// ----------------------------------------------------------
+//
+
+template <typename Eigenproblem, typename State>
+void LobpcgEigensolver<Eigenproblem, State>::assert_valid_control_params(
+      state_type& state) const {
+  const Eigenproblem& problem = state.eigenproblem();
+
+  //
+  // which
+  //
+  const std::string& which = base_type::which;
+  solver_assert(which == "SR" || which == "LR", state,
+                ExcInvalidSolverParametersEncountered(
+                      "The value " + which + " for which is not allowed in a "
+                                             "LOBPCG solver call (only SR and LR "
+                                             "are accepted)."));
+
+  //
+  // A and Diag
+  //
+  // note: We compare memory addresses
+  solver_assert(&problem.A() == &problem.Diag(), state,
+                ExcInvalidSolverParametersEncountered("The matrices A and Diag need "
+                                                      "to be the same objects."));
+
+  //
+  // Preconditioner
+  //
+  if (preconditioner != nullptr) {
+    solver_assert(preconditioner->n_rows() == problem.dim() &&
+                        preconditioner->n_cols() == problem.dim(),
+                  state,
+                  ExcInvalidSolverParametersEncountered(
+                        "The preconditioner needs to be of the same size as the "
+                        "problem matrix."));
+  }
+
+  //
+  // Iterations
+  //
+  solver_assert(max_iter > 0, state,
+                ExcInvalidSolverParametersEncountered(
+                      "The maximal number of iterations needs to be positive."));
+}
+
+template <typename Eigenproblem, typename State>
+typename LobpcgEigensolver<Eigenproblem, State>::size_type
+LobpcgEigensolver<Eigenproblem, State>::block_size(const Eigenproblem& problem) const {
+  const size_type n_ep = problem.n_ep();
+  const size_type n_extra =
+        n_extra_vectors > 0 ? n_extra_vectors : std::max<size_type>(2, n_ep / 2);
+  return std::min(problem.dim(), n_ep + n_extra);
+}
+
+template <typename Eigenproblem, typename State>
+void LobpcgEigensolver<Eigenproblem, State>::apply_a(state_type& state,
+                                                     block_type& blk) const {
+  const Eigenproblem& problem = state.eigenproblem();
+  blk.ax = MultiVector<evector_type>(problem.dim(), blk.n_vectors(), false);
+  if (blk.n_vectors() == 0) return;
+  problem.A().apply(blk.x, blk.ax);
+  state.n_a_applies += blk.n_vectors();
+}
+
+template <typename Eigenproblem, typename State>
+void LobpcgEigensolver<Eigenproblem, State>::apply_b(state_type& state,
+                                                     block_type& blk) const {
+  if (!Eigenproblem::generalised) {
+    blk.bx = blk.x;  // Shallow copy
+    return;
+  }
+
+  const Eigenproblem& problem = state.eigenproblem();
+  blk.bx = MultiVector<evector_type>(problem.dim(), blk.n_vectors(), false);
+  if (blk.n_vectors() == 0) return;
+  problem.B().apply(blk.x, blk.bx);
+  state.n_b_applies += blk.n_vectors();
+}
+
+template <typename Eigenproblem, typename State>
+typename LobpcgEigensolver<Eigenproblem, State>::block_type
+LobpcgEigensolver<Eigenproblem, State>::combine(const block_type& blk,
+                                                const std::vector<scalar_type>& c,
+                                                size_type ldc, size_type n_cols) const {
+  assert_size(c.size(), ldc * n_cols);
+  const size_type n_elem = blk.x.n_elem();
+  const bool have_ax = blk.ax.n_vectors() == blk.n_vectors();
+  const bool have_bx = blk.bx.n_vectors() == blk.n_vectors();
+
+  block_type res;
+  res.x = MultiVector<evector_type>(n_elem, n_cols, false);
+  detail::block_combine(blk.x, c.data(), ldc, res.x);
+  if (have_ax) {
+    res.ax = MultiVector<evector_type>(n_elem, n_cols, false);
+    detail::block_combine(blk.ax, c.data(), ldc, res.ax);
+  }
+  if (have_bx && Eigenproblem::generalised) {
+    res.bx = MultiVector<evector_type>(n_elem, n_cols, false);
+    detail::block_combine(blk.bx, c.data(), ldc, res.bx);
+  } else if (have_bx) {
+    res.bx = res.x;  // Shallow copy
+  }
+  return res;
+}
+
+template <typename Eigenproblem, typename State>
+void LobpcgEigensolver<Eigenproblem, State>::project_out(const block_type& q,
+                                                         block_type& blk) const {
+  if (q.n_vectors() == 0 || blk.n_vectors() == 0) return;
+
+  // Coefficients -<q_i | B | v_j> for blk -= q * C
+  std::vector<scalar_type> c = detail::block_gram(q.bx, blk.x);
+  for (auto& elem : c) elem = -elem;
+
+  const size_type ldc = q.n_vectors();
+  detail::block_combine(q.x, c.data(), ldc, blk.x, Constants<scalar_type>::one);
+  if (blk.ax.n_vectors() == blk.n_vectors()) {
+    detail::block_combine(q.ax, c.data(), ldc, blk.ax, Constants<scalar_type>::one);
+  }
+  if (Eigenproblem::generalised && blk.bx.n_vectors() == blk.n_vectors()) {
+    detail::block_combine(q.bx, c.data(), ldc, blk.bx, Constants<scalar_type>::one);
+  }
+}
+
+template <typename Eigenproblem, typename State>
+typename LobpcgEigensolver<Eigenproblem, State>::block_type
+LobpcgEigensolver<Eigenproblem, State>::orthonormalise(const block_type& blk) const {
+  assert_internal(blk.bx.n_vectors() == blk.n_vectors());
+  const size_type n = blk.n_vectors();
+  if (n == 0) return blk;
+
+  // Scale the columns of V to unit B-norm by S, such that the threshold
+  // below tests for linear dependence and not for the (possibly very
+  // different) magnitudes of the columns. Exact zeros are left alone.
+  std::vector<scalar_type> gram = detail::block_gram(blk.x, blk.bx);
+  std::vector<scalar_type> scale(n, Constants<scalar_type>::one);
+  for (size_type i = 0; i < n; ++i) {
+    if (gram[i * n + i] > Constants<scalar_type>::zero) {
+      scale[i] = 1 / std::sqrt(gram[i * n + i]);
+    }
+  }
+
+  // Diagonalise the scaled Gram matrix S V^T B V S = Z D Z^T, such that
+  // V S Z D^{-1/2} is B-orthonormal. Directions belonging to tiny
+  // eigenvalues are linearly dependent and dropped.
+  for (size_type j = 0; j < n; ++j) {
+    gram[j * n + j] *= scale[j] * scale[j];
+    for (size_type i = j + 1; i < n; ++i) {
+      const scalar_type avg =
+            (gram[j * n + i] + gram[i * n + j]) / 2 * scale[i] * scale[j];
+      gram[j * n + i] = gram[i * n + j] = avg;
+    }
+  }
+
+  std::vector<scalar_type> evals;
+  std::vector<scalar_type> evecs;
+  detail::small_eigensystem_hermitian(std::move(gram), n, evals, evecs);
+  if (evals.back() <= Constants<scalar_type>::zero) return combine(blk, {}, n, 0);
+
+  const scalar_type threshold = static_cast<scalar_type>(blk.x.n_elem()) *
+                                Constants<scalar_type>::default_tolerance * evals.back();
+  std::vector<scalar_type> c;
+  c.reserve(n * n);
+  size_type n_keep = 0;
+  for (size_type k = 0; k < n; ++k) {
+    if (evals[k] <= threshold) continue;
+    const scalar_type fac = 1 / std::sqrt(evals[k]);
+    for (size_type i = 0; i < n; ++i) c.push_back(scale[i] * evecs[k * n + i] * fac);
+    ++n_keep;
+  }
+  return combine(blk, c, n, n_keep);
+}
+
+template <typename Eigenproblem, typename State>
+bool LobpcgEigensolver<Eigenproblem, State>::rayleigh_ritz(
+      const block_type& s, std::vector<scalar_type>& evals,
+      std::vector<scalar_type>& evecs) const {
+  const size_type n = s.n_vectors();
+  std::vector<scalar_type> ga = detail::block_gram(s.x, s.ax);
+  std::vector<scalar_type> gb = detail::block_gram(s.x, s.bx);
+
+  // Symmetrise to remove the round-off from the implicit updates
+  for (size_type j = 0; j < n; ++j) {
+    for (size_type i = j + 1; i < n; ++i) {
+      ga[j * n + i] = ga[i * n + j] = (ga[j * n + i] + ga[i * n + j]) / 2;
+      gb[j * n + i] = gb[i * n + j] = (gb[j * n + i] + gb[i * n + j]) / 2;
+    }
+  }
+  return detail::small_eigensystem_hermitian(std::move(ga), std::move(gb), n, evals,
+                                             evecs);
+}
+
+template <typename Eigenproblem, typename State>
+typename LobpcgEigensolver<Eigenproblem, State>::block_type
+LobpcgEigensolver<Eigenproblem, State>::select_columns(
+      const block_type& blk, const std::vector<size_type>& idcs) const {
+  const bool have_ax = blk.ax.n_vectors() == blk.n_vectors();
+
+  // Shallow copy, which gives non-const access to the shared vectors
+  block_type src = blk;
+  block_type res;
+  for (const size_type i : idcs) {
+    res.x.push_back(src.x.at_ptr(i));
+    if (have_ax) res.ax.push_back(src.ax.at_ptr(i));
+    if (Eigenproblem::generalised) res.bx.push_back(src.bx.at_ptr(i));
+  }
+  if (!Eigenproblem::generalised) res.bx = res.x;
+  return res;
+}
+
+template <typename Eigenproblem, typename State>
+typename LobpcgEigensolver<Eigenproblem, State>::block_type
+LobpcgEigensolver<Eigenproblem, State>::concatenate(
+      std::initializer_list<const block_type*> blocks) const {
+  block_type res;
+  for (const block_type* blk : blocks) {
+    // Mutable shallow copy, since we need non-const pointers to append
+    block_type copy = *blk;
+    detail::block_append(res.x, copy.x);
+    detail::block_append(res.ax, copy.ax);
+    if (Eigenproblem::generalised) detail::block_append(res.bx, copy.bx);
+  }
+  if (!Eigenproblem::generalised) res.bx = res.x;
+  return res;
+}
+
+template <typename Eigenproblem, typename State>
+typename LobpcgEigensolver<Eigenproblem, State>::block_type
+LobpcgEigensolver<Eigenproblem, State>::initial_block(state_type& state,
+                                                      size_type n_vectors) const {
+  const size_type dim = state.eigenproblem().dim();
+  const auto& guess = state.eigensolution().evectors();
+
+  block_type blk;
+  if (guess.n_vectors() > 0 && guess.n_elem() == dim) {
+    const size_type n_guess = std::min(n_vectors, guess.n_vectors());
+    for (size_type i = 0; i < n_guess; ++i) blk.x.push_back(evector_type(guess[i]));
+  }
+
+  // Fill up with random vectors until we have a linearly independent block.
+  // Usually this needs a single pass.
+  for (size_t attempt = 0; attempt < 5 && blk.n_vectors() < n_vectors; ++attempt) {
+    while (blk.x.n_vectors() < n_vectors) blk.x.push_back(random<evector_type>(dim));
+    blk.ax.clear();
+    apply_b(state, blk);
+    blk = orthonormalise(blk);
+  }
+  solver_assert(blk.n_vectors() == n_vectors, state, ExcLobpcgBlockDegenerate(n_vectors));
+
+  apply_a(state, blk);
+  return blk;
+}
+
+template <typename Eigenproblem, typename State>
+void LobpcgEigensolver<Eigenproblem, State>::solve_state(state_type& state) const {
+  assert_dbg(!state.is_failed(), krims::ExcInvalidState("Cannot solve a failed state"));
+  assert_valid_control_params(state);
+
+  const Eigenproblem& problem = state.eigenproblem();
+  const size_type n_ep = problem.n_ep();
+  const size_type m = block_size(problem);
+  const bool lowest = base_type::which == "SR";
+  const real_type tolerance = detail::floored_residual_tolerance(base_type::tolerance);
+  state.residual_tolerance = tolerance;
+
+  state.n_iterations = 0;
+  state.n_a_applies = 0;
+  state.n_b_applies = 0;
+  state.n_preconditioner_applies = 0;
+  state.n_locked = 0;
+
+  // The current Ritz vectors X, the search directions P and their images.
+  // Ritz values and vectors are kept in order of priority, i.e. the
+  // best approximation to the most wanted eigenpair comes first.
+  block_type x = initial_block(state, m);
+  block_type p;
+  std::vector<scalar_type> theta(m);
+
+  // Ritz pairs of the search space s, which are to be kept
+  auto select_ritz = [&](size_type n_s, const std::vector<scalar_type>& evals,
+                         const std::vector<scalar_type>& evecs,
+                         std::vector<scalar_type>& c) {
+    c.resize(n_s * m);
+    for (size_type k = 0; k < m; ++k) {
+      const size_type idx = lowest ? k : n_s - 1 - k;
+      theta[k] = evals[idx];
+      std::copy(evecs.begin() + static_cast<ptrdiff_t>(idx * n_s),
+                evecs.begin() + static_cast<ptrdiff_t>((idx + 1) * n_s),
+                c.begin() + static_cast<ptrdiff_t>(k * n_s));
+    }
+  };
+
+  // Initial Rayleigh-Ritz on the starting block
+  {
+    std::vector<scalar_type> evals, evecs, c;
+    solver_assert(rayleigh_ritz(x, evals, evecs), state,
+                  ExcLobpcgRayleighRitzFailed(0, m));
+    select_ritz(m, evals, evecs, c);
+    x = combine(x, c, m, m);
+  }
+
+  while (true) {
+    //
+    // Residuals R = AX - BX diag(theta) and convergence check
+    //
+    MultiVector<evector_type> r(problem.dim(), m, false);
+    std::vector<size_type> active;
+    size_type n_wanted_converged = 0;
+    for (size_type k = 0; k < m; ++k) {
+      auto itax = std::begin(x.ax[k]);
+      auto itbx = std::begin(x.bx[k]);
+      for (auto itr = std::begin(r[k]); itr != std::end(r[k]); ++itr, ++itax, ++itbx) {
+        *itr = *itax - theta[k] * *itbx;
+      }
+
+      const real_type limit = tolerance * std::max<real_type>(1, std::abs(theta[k]));
+      if (norm_l2(r[k]) <= limit) {
+        if (k < n_ep) ++n_wanted_converged;
+      } else {
+        active.push_back(k);
+      }
+    }
+    state.n_locked = m - active.size();
+    if (n_wanted_converged == n_ep) break;
+
+    solver_assert(state.n_iterations < max_iter, state,
+                  ExcMaximumNumberOfIterationsReached(max_iter));
+    ++state.n_iterations;
+
+    //
+    // Preconditioned residuals of the active (not soft-locked) columns
+    //
+    block_type w;
+    {
+      MultiVector<evector_type> r_active;
+      for (const size_type k : active) r_active.push_back(r.at_ptr(k));
+
+      if (preconditioner != nullptr) {
+        w.x = MultiVector<evector_type>(problem.dim(), active.size(), false);
+        preconditioner->apply(r_active, w.x);
+        state.n_preconditioner_applies += active.size();
+      } else {
+        w.x = r_active;
+      }
+    }
+    project_out(x, w);
+    apply_b(state, w);
+    project_out(x, w);  // Twice is enough
+    w = orthonormalise(w);
+    apply_a(state, w);
+
+    //
+    // Search directions of the active columns
+    //
+    if (p.n_vectors() > 0) {
+      p = select_columns(p, active);
+      project_out(x, p);
+      project_out(w, p);
+      p = orthonormalise(p);
+    }
+
+    //
+    // Rayleigh-Ritz on the search space [X, W, P]. If the
+    // projected metric is ill-conditioned, restart without P.
+    //
+    block_type s = concatenate({&x, &w, &p});
+    std::vector<scalar_type> evals, evecs, c;
+    if (!rayleigh_ritz(s, evals, evecs)) {
+      p = block_type{};
+      s = concatenate({&x, &w});
+      solver_assert(rayleigh_ritz(s, evals, evecs), state,
+                    ExcLobpcgRayleighRitzFailed(state.n_iterations, s.n_vectors()));
+    }
+    const size_type n_s = s.n_vectors();
+    select_ritz(n_s, evals, evecs, c);
+
+    // New Ritz vectors and new search directions, which are the components
+    // of the Ritz vectors along W and P only.
+    x = combine(s, c, n_s, m);
+    for (size_type k = 0; k < m; ++k) {
+      std::fill(c.begin() + static_cast<ptrdiff_t>(k * n_s),
+                c.begin() + static_cast<ptrdiff_t>(k * n_s + m), 0);
+    }
+    p = combine(s, c, n_s, m);
+  }
+
+  //
+  // Copy the wanted eigenpairs to the solution (in ascending order)
+  //
+  esoln_type& soln = state.eigensolution();
+  soln.evalues().clear();
+  soln.evectors().clear();
+  soln.evalues().reserve(n_ep);
+  soln.evectors().reserve(n_ep);
+  for (size_type i = 0; i < n_ep; ++i) {
+    const size_type k = lowest ? i : n_ep - 1 - i;
+    soln.evalues().push_back(theta[k]);
+    soln.evectors().push_back(evector_type(x.x[k]));
+  }
+}
+
+}  // namespace lazyten
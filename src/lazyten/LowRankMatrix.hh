@@ -0,0 +1,315 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+#pragma once
+#include "LazyMatrixExpression.hh"
+#include "detail/block_ops.hh"
+#include "detail/scale_or_set.hh"
+#include <krims/Functionals.hh>
+#include <vector>
+
+namespace lazyten {
+
+/** \brief A lazy matrix of low rank, given in factorised form
+ *
+ * Represents the matrix
+ * \[ A = U \, \text{diag}(\sigma) \, V^T \]
+ * where U and V are MultiVectors with rank() vectors each, i.e. the matrix
+ * is the sum of rank() outer products $\sigma_l u_l v_l^T$. If U and V have
+ * orthonormal columns and the $\sigma$ are real and non-negative, this is
+ * a (truncated) singular value decomposition. See randomised_svd for
+ * a way to obtain such a factorisation for an arbitrary lazy matrix.
+ *
+ * Applying the matrix to a vector costs O(rank * (n_rows + n_cols)).
+ */
+template <typename StoredMatrix>
+class LowRankMatrix : public LazyMatrixExpression<StoredMatrix> {
+ public:
+  typedef LazyMatrixExpression<StoredMatrix> base_type;
+  typedef typename base_type::stored_matrix_type stored_matrix_type;
+  typedef typename base_type::size_type size_type;
+  typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::lazy_matrix_expression_ptr_type
+        lazy_matrix_expression_ptr_type;
+  typedef typename StoredMatrix::vector_type stored_vector_type;
+  typedef typename base_type::vector_type vector_type;
+
+  /** Construct from the factors
+   *
+   * \param u      The left factors (n_rows elements each)
+   * \param sigma  The weights of each outer product
+   * \param v      The right factors (n_cols elements each)
+   */
+  LowRankMatrix(MultiVector<stored_vector_type> u, std::vector<scalar_type> sigma,
+                MultiVector<stored_vector_type> v)
+        : m_u(std::move(u)), m_sigma(std::move(sigma)), m_v(std::move(v)) {
+    assert_size(m_u.n_vectors(), m_sigma.size());
+    assert_size(m_v.n_vectors(), m_sigma.size());
+  }
+
+  /** The rank, i.e. the number of outer products */
+  size_type rank() const { return m_sigma.size(); }
+
+  /** The left factors U (e.g. the left singular vectors) */
+  const MultiVector<stored_vector_type>& left_factors() const { return m_u; }
+
+  /** The weights $\sigma$ (e.g. the singular values) */
+  const std::vector<scalar_type>& weights() const { return m_sigma; }
+
+  /** The right factors V (e.g. the right singular vectors) */
+  const MultiVector<stored_vector_type>& right_factors() const { return m_v; }
+
+  /** Number of rows */
+  size_type n_rows() const override { return m_u.n_elem(); }
+
+  /** Number of columns */
+  size_type n_cols() const override { return m_v.n_elem(); }
+
+  /** Element access */
+  scalar_type operator()(size_type row, size_type col) const override {
+    assert_greater(row, n_rows());
+    assert_greater(col, n_cols());
+    scalar_type ret = Constants<scalar_type>::zero;
+    for (size_type l = 0; l < rank(); ++l) ret += m_u[l][row] * m_sigma[l] * m_v[l][col];
+    return ret;
+  }
+
+  //
+  // LazyMatrixExpression interface
+  //
+  /** Are operation modes Transposed::Trans and Transposed::ConjTrans
+   *  supported for this matrix type.
+   **/
+  bool has_transpose_operation_mode() const override { return true; }
+
+  /** Extract the diagonal, which costs O(rank * min(n_rows, n_cols)) */
+  vector_type extract_diagonal() const override {
+    const size_type n = std::min(n_rows(), n_cols());
+    vector_type diag(n);
+    for (size_type l = 0; l < rank(); ++l) {
+      for (size_type i = 0; i < n; ++i) diag[i] += m_u[l][i] * m_sigma[l] * m_v[l][i];
+    }
+    return diag;
+  }
+
+  /** Extract a block of a matrix and (optionally) add it to
+   * a different matrix.
+   *
+   *  Loosely speaking we perform
+   *  \[ M = c_M \cdot M + (A^{mode})_{rowrange,colrange} \]
+   *  where
+   *    - rowrange = [start_row, start_row+in.n_rows() ) and
+   *    - colrange = [start_col, start_col+in.n_cols() )
+   *
+   * More details can be found in the same function in
+   * LazyMatrixExpression
+   */
+  void extract_block(stored_matrix_type& M, const size_type start_row,
+                     const size_type start_col, const Transposed mode = Transposed::None,
+                     const scalar_type c_this = Constants<scalar_type>::one,
+                     const scalar_type c_M = Constants<scalar_type>::zero) const override;
+
+  /** \brief Compute the Matrix-Multivector application -- generic version
+   *
+   * Loosely speaking we perform
+   * \[ y = c_this \cdot A^\text{mode} \cdot x + c_y \cdot y. \]
+   *
+   * See LazyMatrixExpression for more details
+   */
+  template <typename VectorIn, typename VectorOut,
+            mat_vec_apply_enabled_t<LowRankMatrix, VectorIn, VectorOut>...>
+  void apply(const MultiVector<VectorIn>& x, MultiVector<VectorOut>& y,
+             const Transposed mode = Transposed::None,
+             const scalar_type c_this = Constants<scalar_type>::one,
+             const scalar_type c_y = Constants<scalar_type>::zero) const {
+    MultiVector<const MutableMemoryVector_i<scalar_type>> x_wrapped(x);
+    MultiVector<MutableMemoryVector_i<scalar_type>> y_wrapped(y);
+    apply(x_wrapped, y_wrapped, mode, c_this, c_y);
+  }
+
+  /** \brief Compute the Matrix-Multivector application
+   *
+   * Loosely speaking we perform
+   * \[ y = c_this \cdot A^\text{mode} \cdot x + c_y \cdot y. \]
+   *
+   * See LazyMatrixExpression for more details
+   */
+  void apply(const MultiVector<const MutableMemoryVector_i<scalar_type>>& x,
+             MultiVector<MutableMemoryVector_i<scalar_type>>& y,
+             const Transposed mode = Transposed::None,
+             const scalar_type c_this = Constants<scalar_type>::one,
+             const scalar_type c_y = Constants<scalar_type>::zero) const override;
+
+  /** Perform a matrix-matrix product.
+   *
+   * Loosely performs the operation
+   * \[ out = c_this \cdot A^\text{mode} \cdot in + c_out \cdot out. \]
+   *
+   * See LazyMatrixExpression for more details
+   */
+  void mmult(const stored_matrix_type& in, stored_matrix_type& out,
+             const Transposed mode = Transposed::None,
+             const scalar_type c_this = Constants<scalar_type>::one,
+             const scalar_type c_out = Constants<scalar_type>::zero) const override;
+
+  /** Update method
+   *
+   * \note Only forgets the cached properties, since the factor vectors
+   *       may be shared with other MultiVectors and have changed.
+   */
+  void update(const krims::GenMap&) override { this->invalidate_property_cache(); }
+
+  /** Clone function */
+  lazy_matrix_expression_ptr_type clone() const override {
+    return lazy_matrix_expression_ptr_type(new LowRankMatrix(*this));
+  }
+
+ private:
+  /** The factor multiplied with the input in the given mode
+   *  (V for Transposed::None, else U) */
+  const MultiVector<stored_vector_type>& inner_factors(Transposed mode) const {
+    return mode == Transposed::None ? m_v : m_u;
+  }
+
+  /** The factor forming the output in the given mode
+   *  (U for Transposed::None, else V) */
+  const MultiVector<stored_vector_type>& outer_factors(Transposed mode) const {
+    return mode == Transposed::None ? m_u : m_v;
+  }
+
+  /** The factors as MultiVector of the interface vector type for the
+   *  block operations. This is a shallow copy, except for ConjTrans with
+   *  complex scalars, where the factors are conjugated into storage. */
+  MultiVector<const MutableMemoryVector_i<scalar_type>> factors_for_mode(
+        const MultiVector<stored_vector_type>& factors, Transposed mode,
+        MultiVector<stored_vector_type>& storage) const {
+    if (mode != Transposed::ConjTrans || !krims::IsComplexNumber<scalar_type>::value) {
+      return MultiVector<const MutableMemoryVector_i<scalar_type>>(factors);
+    }
+    storage = factors.copy_deep();
+    for (auto& vec : storage) {
+      for (auto& elem : vec) elem = conj_if(mode, elem);
+    }
+    return MultiVector<const MutableMemoryVector_i<scalar_type>>(storage);
+  }
+
+  /** Apply complex conjugation to a value if mode is ConjTrans */
+  static scalar_type conj_if(Transposed mode, scalar_type s) {
+    krims::ConjFctr conj;
+    return mode == Transposed::ConjTrans ? conj(s) : s;
+  }
+
+  MultiVector<stored_vector_type> m_u;
+  std::vector<scalar_type> m_sigma;
+  MultiVector<stored_vector_type> m_v;
+};
+
+//
+// ----------------------------------------------------------------------
+//
+
+template <typename StoredMatrix>
+void LowRankMatrix<StoredMatrix>::extract_block(
+      stored_matrix_type& M, const size_type start_row, const size_type start_col,
+      const Transposed mode, const scalar_type c_this, const scalar_type c_M) const {
+  assert_finite(c_this);
+  assert_finite(c_M);
+  const auto& outer = outer_factors(mode);
+  const auto& inner = inner_factors(mode);
+  assert_greater_equal(start_row + M.n_rows(), outer.n_elem());
+  assert_greater_equal(start_col + M.n_cols(), inner.n_elem());
+
+  // For empty matrices there is nothing to do
+  if (M.n_rows() == 0 || M.n_cols() == 0) return;
+
+  // This deals entirely with the coefficient c_M
+  detail::scale_or_set(M, c_M);
+  if (c_this == Constants<scalar_type>::zero) return;
+
+  for (size_type l = 0; l < rank(); ++l) {
+    const scalar_type fac = c_this * conj_if(mode, m_sigma[l]);
+    for (size_type j = 0; j < M.n_cols(); ++j) {
+      const scalar_type fac_j = fac * conj_if(mode, inner[l][start_col + j]);
+      for (size_type i = 0; i < M.n_rows(); ++i) {
+        M(i, j) += conj_if(mode, outer[l][start_row + i]) * fac_j;
+      }  // i
+    }    // j
+  }      // l
+}
+
+template <typename StoredMatrix>
+void LowRankMatrix<StoredMatrix>::apply(
+      const MultiVector<const MutableMemoryVector_i<scalar_type>>& x,
+      MultiVector<MutableMemoryVector_i<scalar_type>>& y, const Transposed mode,
+      const scalar_type c_this, const scalar_type c_y) const {
+  assert_finite(c_this);
+  assert_finite(c_y);
+  assert_size(x.n_vectors(), y.n_vectors());
+  assert_size(x.n_elem(), inner_factors(mode).n_elem());
+  assert_size(y.n_elem(), outer_factors(mode).n_elem());
+
+  // Deal with c_y (scale or set to zero)
+  for (auto& vec : y) detail::scale_or_set(vec, c_y);
+  if (c_this == Constants<scalar_type>::zero || rank() == 0) return;
+
+  // Coefficients W = c_this * diag(sigma) * inner^T * X for all vectors
+  // at once, followed by Y += outer * W
+  MultiVector<stored_vector_type> inner_storage, outer_storage;
+  const auto inner = factors_for_mode(inner_factors(mode), mode, inner_storage);
+  const auto outer = factors_for_mode(outer_factors(mode), mode, outer_storage);
+  std::vector<scalar_type> w = detail::block_gram(inner, x);
+  for (size_type vi = 0; vi < x.n_vectors(); ++vi) {
+    for (size_type l = 0; l < rank(); ++l) {
+      w[vi * rank() + l] *= c_this * conj_if(mode, m_sigma[l]);
+    }
+  }
+  detail::block_combine(outer, w.data(), rank(), y, Constants<scalar_type>::one);
+}
+
+template <typename StoredMatrix>
+void LowRankMatrix<StoredMatrix>::mmult(const stored_matrix_type& in,
+                                        stored_matrix_type& out, const Transposed mode,
+                                        const scalar_type c_this,
+                                        const scalar_type c_out) const {
+  assert_finite(c_this);
+  assert_finite(c_out);
+  assert_size(in.n_cols(), out.n_cols());
+  const auto& outer = outer_factors(mode);
+  const auto& inner = inner_factors(mode);
+  assert_size(inner.n_elem(), in.n_rows());
+  assert_size(outer.n_elem(), out.n_rows());
+
+  // This deals entirely with the coefficient c_out
+  detail::scale_or_set(out, c_out);
+  if (c_this == Constants<scalar_type>::zero) return;
+
+  // Apply to the columns of in as a MultiVector, such that the products
+  // are formed by the block operations of apply.
+  MultiVector<stored_vector_type> x(in.n_rows(), in.n_cols(), false);
+  for (size_type k = 0; k < in.n_cols(); ++k) {
+    for (size_type j = 0; j < in.n_rows(); ++j) x[k][j] = in(j, k);
+  }
+  MultiVector<stored_vector_type> y(out.n_rows(), out.n_cols(), false);
+  apply(x, y, mode, c_this);
+
+  for (size_type k = 0; k < out.n_cols(); ++k) {
+    for (size_type i = 0; i < out.n_rows(); ++i) out(i, k) += y[k][i];
+  }
+}
+
+}  // namespace lazyten
@@ -22,8 +22,10 @@
 #include "lazyten/Exceptions.hh"
 #include "lazyten/Matrix_i.hh"
 #include "lazyten/StoredMatrix_i.hh"
+#include <algorithm>
 #include <iterator>
 #include <krims/SubscriptionPointer.hh>
+#include <memory>
 #include <type_traits>
 
 namespace lazyten {
@@ -37,6 +39,10 @@ class StoredMatrix_i;
 
 namespace detail {
 
+/** Number of matrix elements MatrixIteratorBufferedCore aims to hold in its
+ *  row tile buffer */
+constexpr size_t matrix_iterator_tile_size = 4096;
+
 /** \brief Class to enforce a reference to be returned
  *
  * The class requires prior knowledge about the situation
@@ -263,6 +269,94 @@ class MatrixIteratorDefaultCore : public MatrixIteratorCoreBase<Matrix, Constnes
   EnforceReference<value_type, Constness> make_ref;
 };
 
+/** \brief Const MatrixIteratorCoreBase implementation serving elements
+ *         from a buffer of row tiles.
+ *
+ * Instead of calling operator() of the matrix for each element, which
+ * for lazy matrices usually amounts to a full ``extract_block`` call
+ * per element, this core extracts a tile of complete rows at once into
+ * an internal stored matrix and serves the elements from there. A tile
+ * holds about matrix_iterator_tile_size elements, but at least one row.
+ *
+ * Copies of the iterator share the current tile. It is only modified
+ * in-place if no other copy refers to it any more.
+ *
+ * \tparam Matrix  The matrix type to iterate over. Needs to provide
+ *                 a typedef stored_matrix_type and an extract_block
+ *                 function like LazyMatrixExpression does.
+ */
+template <typename Matrix>
+class MatrixIteratorBufferedCore : public MatrixIteratorCoreBase<Matrix, true> {
+ public:
+  typedef MatrixIteratorCoreBase<Matrix, true> base_type;
+  typedef typename base_type::original_matrix_type original_matrix_type;
+  typedef typename base_type::matrix_type matrix_type;
+  typedef typename base_type::size_type size_type;
+  typedef typename base_type::index_type index_type;
+  typedef typename base_type::value_type value_type;
+  typedef typename base_type::reference reference;
+  typedef typename base_type::pointer pointer;
+  typedef typename original_matrix_type::stored_matrix_type stored_matrix_type;
+
+  //
+  // Constructor, destructor and assignment
+  //
+  /** Default constructor */
+  MatrixIteratorBufferedCore();
+
+  /** \brief Constructor of a Matrix iterator pointing to
+   *  the past-the-end position. */
+  explicit MatrixIteratorBufferedCore(matrix_type& mat);
+
+  /** \brief Construct an iterator giving the initial value
+   * it should point to. */
+  MatrixIteratorBufferedCore(matrix_type& mat, index_type start_index);
+
+  //
+  // Matrix information
+  //
+  /** The row currently pointed to */
+  size_type row() const override;
+
+  /** The column currently pointed to */
+  size_type col() const override;
+
+ protected:
+  /** Obtain value of current element. */
+  value_type value() const override;
+
+  /** Return a pointer to the currently pointed-to value inside the tile buffer */
+  const pointer ptr_to_value() const override;
+
+  //
+  // Seeking and increment:
+  //
+  /** \brief Seek to the next element, fetching the next tile
+   *         of rows if required */
+  void seek_next_element() override;
+
+  /** \brief Seek to the provided element, fetching the tile
+   *         containing it if required */
+  void seek_to_element(index_type element) override;
+
+  /** \brief Assert that the internal state of the index, the matrix
+   *  pointer and the tile buffer makes sense. */
+  void assert_valid_state() const override;
+
+ private:
+  /** Make sure the row tile buffer contains the row ``row`` */
+  void fetch_tile(size_type row);
+
+  index_type m_index;
+  krims::SubscriptionPointer<matrix_type> m_matrix_ptr;
+
+  /** Index of the first row held in the tile buffer */
+  size_type m_tile_start;
+
+  /** The tile buffer (shared between copies of the iterator) */
+  std::shared_ptr<stored_matrix_type> m_tile_ptr;
+};
+
 //
 // ----------------------------------------------------------------
 //
@@ -391,5 +485,130 @@ void MatrixIteratorDefaultCore<Matrix, Constness>::seek_to_element(index_type el
   m_index = element;
 }
 
+//
+// MatrixIteratorBufferedCore
+//
+template <typename Matrix>
+MatrixIteratorBufferedCore<Matrix>::MatrixIteratorBufferedCore()
+      : m_index{base_type::invalid_pos},
+        m_matrix_ptr{"MatrixIteratorBufferedCore"},
+        m_tile_start{0},
+        m_tile_ptr{nullptr} {}
+
+template <typename Matrix>
+MatrixIteratorBufferedCore<Matrix>::MatrixIteratorBufferedCore(matrix_type& mat)
+      : m_index{base_type::invalid_pos},
+        m_matrix_ptr{"MatrixIteratorBufferedCore", mat},
+        m_tile_start{0},
+        m_tile_ptr{nullptr} {}
+
+template <typename Matrix>
+MatrixIteratorBufferedCore<Matrix>::MatrixIteratorBufferedCore(matrix_type& mat,
+                                                               index_type start_index)
+      : m_index{start_index},
+        m_matrix_ptr{"MatrixIteratorBufferedCore", mat},
+        m_tile_start{0},
+        m_tile_ptr{nullptr} {
+  if (start_index.first >= mat.n_rows() || start_index.second >= mat.n_cols()) {
+    // Already at the start we are past the end
+    m_index = base_type::invalid_pos;
+  } else {
+    fetch_tile(start_index.first);
+    assert_valid_state();
+  }
+}
+
+template <typename Matrix>
+typename MatrixIteratorBufferedCore<Matrix>::size_type
+MatrixIteratorBufferedCore<Matrix>::row() const {
+  return m_index.first;
+}
+
+template <typename Matrix>
+typename MatrixIteratorBufferedCore<Matrix>::size_type
+MatrixIteratorBufferedCore<Matrix>::col() const {
+  return m_index.second;
+}
+
+template <typename Matrix>
+typename MatrixIteratorBufferedCore<Matrix>::value_type
+MatrixIteratorBufferedCore<Matrix>::value() const {
+  return (*m_tile_ptr)(m_index.first - m_tile_start, m_index.second);
+}
+
+template <typename Matrix>
+const typename MatrixIteratorBufferedCore<Matrix>::pointer
+MatrixIteratorBufferedCore<Matrix>::ptr_to_value() const {
+  return &(*m_tile_ptr)(m_index.first - m_tile_start, m_index.second);
+}
+
+template <typename Matrix>
+void MatrixIteratorBufferedCore<Matrix>::seek_next_element() {
+  const size_type row = m_index.first;
+  const size_type col = m_index.second;
+
+  // Row-wise seek to the next valid index
+  if (col + 1 < m_matrix_ptr->n_cols()) {
+    m_index.second = col + 1;  // Same row => same tile
+  } else if (row + 1 < m_matrix_ptr->n_rows()) {
+    seek_to_element({row + 1, 0});
+  } else {
+    // Make invalid:
+    m_index = base_type::invalid_pos;
+  }
+}
+
+template <typename Matrix>
+void MatrixIteratorBufferedCore<Matrix>::seek_to_element(index_type element) {
+  // Assert that the indices are not too large:
+  assert_greater(element.first, m_matrix_ptr->n_rows());
+  assert_greater(element.second, m_matrix_ptr->n_cols());
+
+  // Assert that we make progress in the right direction:
+  assert_greater_equal(m_index.first, element.first);
+  if (element.first == m_index.first) {
+    assert_greater_equal(m_index.second, element.second);
+  }
+
+  m_index = element;
+  fetch_tile(element.first);
+}
+
+template <typename Matrix>
+void MatrixIteratorBufferedCore<Matrix>::fetch_tile(size_type row) {
+  if (m_tile_ptr != nullptr && m_tile_start <= row &&
+      row < m_tile_start + m_tile_ptr->n_rows()) {
+    return;  // Row already in the buffer
+  }
+
+  const size_type n_rows = m_matrix_ptr->n_rows();
+  const size_type n_cols = m_matrix_ptr->n_cols();
+  const size_type rows_per_tile =
+        std::max<size_type>(1, matrix_iterator_tile_size / n_cols);
+  const size_type tile_rows = std::min(n_rows - row, rows_per_tile);
+
+  // Only reuse the buffer if no other iterator copy still refers to it
+  if (m_tile_ptr == nullptr || m_tile_ptr.use_count() > 1 ||
+      m_tile_ptr->n_rows() != tile_rows) {
+    m_tile_ptr = std::make_shared<stored_matrix_type>(tile_rows, n_cols, false);
+  }
+  m_matrix_ptr->extract_block(*m_tile_ptr, row, 0);
+  m_tile_start = row;
+}
+
+template <typename Matrix>
+void MatrixIteratorBufferedCore<Matrix>::assert_valid_state() const {
+  assert_dbg(m_matrix_ptr,
+             krims::ExcInvalidState("MatrixIterator does not point to any matrix"));
+
+  assert_dbg(m_index.first != base_type::invalid_pos.first &&
+                   m_index.second != base_type::invalid_pos.second,
+             krims::ExcIteratorPastEnd());
+
+  assert_dbg(m_tile_ptr != nullptr && m_tile_start <= m_index.first &&
+                   m_index.first < m_tile_start + m_tile_ptr->n_rows(),
+             krims::ExcInvalidState("Row tile buffer does not hold the current row"));
+}
+
 }  // namespace detail
 }  // namespace lazyten
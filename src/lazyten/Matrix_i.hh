@@ -26,6 +26,7 @@
 #include "MultiVector.hh"
 #include "PtrVector.hh"
 #include "io/MatrixPrinter.hh"
+#include <algorithm>
 #include <complex>
 #include <cstddef>
 #include <iomanip>
@@ -40,6 +41,16 @@
 
 namespace lazyten {
 
+namespace detail {
+/** Edge length of the square tiles in which symmetry checks
+ *  visit the upper triangle of a matrix */
+constexpr size_t symmetry_check_tile_size = 64;
+
+/** Edge length of the tiles along the diagonal, which are processed
+ *  at once when extracting the diagonal of lazy matrices */
+constexpr size_t diagonal_extraction_tile_size = 64;
+}  // namespace detail
+
 // TODO subview for Matrices
 
 template <typename IteratorCore>
@@ -134,16 +145,24 @@ class Matrix_i : public Indexable_i<Scalar> {
   ///@{
   /** \brief Check whether the matrix is symmetric
    *
-   * Loops over all elements and check whether the difference
-   * between m(i,j) and m(j,i) is less than the tolerance given
+   * Loops over the upper triangle and checks whether the difference
+   * between m(i,j) and m(j,i) is less than the tolerance given.
+   * Stops at the first pair violating this.
+   *
+   * \note Lazy matrices owning their data cache the result
+   *       (see LazyMatrixExpression::owns_data).
    * */
   bool is_symmetric(real_type tolerance = 10 *
                                           Constants<real_type>::default_tolerance) const;
 
   /** \brief Check whether the matrix is Hermitian
    *
-   * Loops over all elements and check whether the difference
-   * between conj(m(i,j)) and m(j,i) is less than the tolerance given
+   * Loops over the upper triangle and checks whether the difference
+   * between conj(m(i,j)) and m(j,i) is less than the tolerance given.
+   * Stops at the first pair violating this.
+   *
+   * \note Lazy matrices owning their data cache the result
+   *       (see LazyMatrixExpression::owns_data).
    * */
   bool is_hermitian(real_type tolerance = 10 *
                                           Constants<real_type>::default_tolerance) const;
@@ -178,6 +197,19 @@ class Matrix_i : public Indexable_i<Scalar> {
   }
   ///@}
 
+ protected:
+  /** \brief Compare all pairs m(i,j) and m(j,i) with i <= j
+   *
+   * Returns true if the difference between m(i,j) (or conj(m(i,j)) if
+   * hermitian is true) and m(j,i) is below the tolerance for all pairs.
+   * The matrix is guaranteed to be square.
+   *
+   * The default implementation works on tiles of the upper triangle,
+   * such that the accessed rows and columns stay in cache, and exits
+   * at the first violating pair.
+   */
+  virtual bool check_symmetry(real_type tolerance, bool hermitian) const;
+
  private:
   // TODO tmp: Remove once we have property forwarding in products and sums
   OperatorProperties m_properties = OperatorProperties::None;
@@ -265,36 +297,37 @@ typename Matrix_i<Scalar>::scalar_type Matrix_i<Scalar>::operator[](size_type i)
 
 template <typename Scalar>
 bool Matrix_i<Scalar>::is_symmetric(real_type tolerance) const {
-  using krims::numerical_error;
-  const auto& A(*this);
-
   // Check that the matrix is quadratic:
   if (n_rows() != n_cols()) return false;
-
-  // Check if lower and upper triangle agree:
-  for (size_type i = 0; i < n_rows(); ++i) {
-    for (size_type j = 0; j < n_cols(); ++j) {
-      const Scalar error = numerical_error<Scalar>(A(i, j) - A(j, i), 0);
-      if (error > tolerance) return false;
-    }
-  }
-  return true;
+  return check_symmetry(tolerance, /* hermitian = */ false);
 }
 
 template <typename Scalar>
 bool Matrix_i<Scalar>::is_hermitian(real_type tolerance) const {
-  using krims::numerical_error;
-  const auto& A(*this);
-
   // Check that the matrix is quadratic:
   if (n_rows() != n_cols()) return false;
+  return check_symmetry(tolerance, /* hermitian = */ true);
+}
 
-  // Check if lower and upper triangle agree:
-  krims::ConjFctr conj{};
-  for (size_type i = 0; i < n_rows(); ++i) {
-    for (size_type j = 0; j < n_cols(); ++j) {
-      const Scalar error = numerical_error<Scalar>(conj(A(i, j)) - A(j, i), 0);
-      if (error > tolerance) return false;
+template <typename Scalar>
+bool Matrix_i<Scalar>::check_symmetry(real_type tolerance, bool hermitian) const {
+  using krims::numerical_error;
+  const auto& A(*this);
+  const size_type n = n_rows();
+  const size_type tile = detail::symmetry_check_tile_size;
+
+  // Check if lower and upper triangle agree tile by tile:
+  for (size_type jtile = 0; jtile < n; jtile += tile) {
+    const size_type jend = std::min(n, jtile + tile);
+    for (size_type itile = 0; itile <= jtile; itile += tile) {
+      for (size_type j = jtile; j < jend; ++j) {
+        const size_type iend = std::min(j + 1, itile + tile);
+        for (size_type i = itile; i < iend; ++i) {
+          const Scalar aij = hermitian ? krims::ConjFctr{}(A(i, j)) : A(i, j);
+          const real_type error = std::abs(numerical_error<Scalar>(aij - A(j, i), 0));
+          if (error > tolerance) return false;
+        }
+      }
     }
   }
   return true;
@@ -18,7 +18,10 @@
 //
 
 #pragma once
+#include "Lapack/detail/blas.hh"
 #include "detail/MultiVectorBase.hh"
+#include "lazyten/config.hh"
+#include <algorithm>
 #include <initializer_list>
 #include <krims/Range.hh>
 
@@ -246,6 +249,131 @@ std::vector<typename Vector::real_type> norm_l2(const MultiVector<Vector>& mv) {
   return res;
 }
 
+namespace detail {
+/** The number of elements processed at once by the cache-blocked
+ *  Gram matrix kernel */
+constexpr size_t gram_chunk_size = 512;
+
+/** Are the vectors of u and v the very same objects */
+template <typename VectorU, typename VectorV>
+bool same_vectors(const MultiVector<VectorU>& u, const MultiVector<VectorV>& v) {
+  if (u.n_vectors() != v.n_vectors()) return false;
+  for (size_t i = 0; i < u.n_vectors(); ++i) {
+    if (&u[i] != &v[i]) return false;
+  }
+  return true;
+}
+
+/** If the vectors of mv are equally spaced in memory (e.g. columns of a
+ *  single buffer), return the distance between two of them, else 0. */
+template <typename Vector>
+size_t memory_stride(const MultiVector<Vector>& mv) {
+  const auto* first = mv[0].memptr();
+  if (mv.n_vectors() == 1) return mv.n_elem();
+
+  const auto stride = mv[1].memptr() - first;
+  if (stride < static_cast<decltype(stride)>(mv.n_elem())) return 0;
+  for (size_t i = 2; i < mv.n_vectors(); ++i) {
+    if (mv[i].memptr() != first + i * static_cast<size_t>(stride)) return 0;
+  }
+  return static_cast<size_t>(stride);
+}
+
+/** Compute the Gram matrix by a single BLAS call if the memory
+ *  layout permits. Returns false if this is not possible. */
+template <typename VectorU, typename VectorV>
+bool gram_blas(const MultiVector<VectorU>& u, const MultiVector<VectorV>& v,
+               bool symmetric, typename VectorU::scalar_type* c, std::true_type) {
+#ifdef LAZYTEN_HAVE_LAPACK
+  const size_t ldu = memory_stride(u);
+  const size_t ldv = symmetric ? ldu : memory_stride(v);
+  if (ldu == 0 || ldv == 0) return false;
+
+  if (symmetric) {
+    run_syrk_t(u.n_elem(), u.n_vectors(), u[0].memptr(), ldu, c);
+  } else {
+    run_gemm_tn(u.n_elem(), u.n_vectors(), v.n_vectors(), u[0].memptr(), ldu,
+                v[0].memptr(), ldv, c);
+  }
+  return true;
+#else
+  (void)u, (void)v, (void)symmetric, (void)c;
+  return false;
+#endif  // LAZYTEN_HAVE_LAPACK
+}
+
+template <typename VectorU, typename VectorV>
+bool gram_blas(const MultiVector<VectorU>&, const MultiVector<VectorV>&, bool,
+               typename VectorU::scalar_type*, std::false_type) {
+  return false;
+}
+
+/** Compute the Gram matrix of vectors with accessible memory.
+ *
+ * For strided vectors this is a single gemm (or syrk if u and v are the
+ * same vectors), else the elements are processed in chunks, which fit into
+ * cache together for all vectors.
+ */
+template <typename VectorU, typename VectorV>
+void gram_memory(const MultiVector<VectorU>& u, const MultiVector<VectorV>& v,
+                 bool symmetric, typename VectorU::scalar_type* c) {
+  typedef typename VectorU::scalar_type scalar_type;
+  const size_t k = u.n_vectors();
+  const size_t l = v.n_vectors();
+  typedef IsBlasScalar<scalar_type> blas_type;
+  if (gram_blas(u, v, symmetric, c, blas_type{})) return;
+
+  std::vector<const scalar_type*> pu(k);
+  std::vector<const scalar_type*> pv(l);
+  for (size_t i = 0; i < k; ++i) pu[i] = u[i].memptr();
+  for (size_t j = 0; j < l; ++j) pv[j] = v[j].memptr();
+  std::fill(c, c + k * l, Constants<scalar_type>::zero);
+
+  for (size_t begin = 0; begin < u.n_elem(); begin += gram_chunk_size) {
+    const size_t end = std::min(begin + gram_chunk_size, u.n_elem());
+    for (size_t j = 0; j < l; ++j) {
+      for (size_t i = 0; i < (symmetric ? j + 1 : k); ++i) {
+        scalar_type sum = Constants<scalar_type>::zero;
+        for (size_t e = begin; e < end; ++e) sum += pu[i][e] * pv[j][e];
+        c[j * k + i] += sum;
+      }
+    }
+  }
+}
+
+/** Compute the Gram matrix of vectors without accessible memory
+ *  by one dot product per pair. */
+template <typename VectorU, typename VectorV>
+void gram_generic(const MultiVector<VectorU>& u, const MultiVector<VectorV>& v,
+                  bool symmetric, typename VectorU::scalar_type* c) {
+  const size_t k = u.n_vectors();
+  for (size_t j = 0; j < v.n_vectors(); ++j) {
+    for (size_t i = 0; i < (symmetric ? j + 1 : k); ++i) c[j * k + i] = dot(u[i], v[j]);
+  }
+}
+
+template <typename VectorU, typename VectorV>
+void gram(const MultiVector<VectorU>& u, const MultiVector<VectorV>& v, bool symmetric,
+          typename VectorU::scalar_type* c, std::true_type) {
+  gram_memory(u, v, symmetric, c);
+}
+
+template <typename VectorU, typename VectorV>
+void gram(const MultiVector<VectorU>& u, const MultiVector<VectorV>& v, bool symmetric,
+          typename VectorU::scalar_type* c, std::false_type) {
+  gram_generic(u, v, symmetric, c);
+}
+}  // namespace detail
+
+/** Compute the matrix of all dot products between the vectors of u
+ *  and the vectors of v, i.e. the Gram matrix U^T V (without complex
+ *  conjugation).
+ *
+ * The result is computed as one gemm if both sets of vectors are
+ * equally spaced in memory and as one syrk (computing only half of the
+ * matrix) if u and v are the same vectors. For vectors scattered in
+ * memory a cache-blocked kernel is used.
+ */
 template <typename Vector, typename Vector2,
           typename = krims::enable_if_t<
                 std::is_same<typename std::remove_const<Vector>::type,
@@ -254,15 +382,24 @@ typename Vector::type_family::template matrix<typename Vector::scalar_type> dot(
       const MultiVector<Vector>& u, const lazyten::MultiVector<Vector2>& v) {
   typedef typename Vector::type_family::template matrix<typename Vector::scalar_type>
         matrix_type;
-  if (u.n_vectors() == 0 || v.n_vectors() == 0) {
+  typedef typename Vector::scalar_type scalar_type;
+  if (u.n_vectors() == 0 || v.n_vectors() == 0 || u.n_elem() == 0) {
     return matrix_type(u.n_vectors(), v.n_vectors());
   }
   assert_size(u.n_elem(), v.n_elem());
 
-  matrix_type ret(u.n_vectors(), v.n_vectors(), false);
-  for (size_t ui = 0; ui < u.n_vectors(); ++ui) {
-    for (size_t vi = 0; vi < v.n_vectors(); ++vi) {
-      ret(ui, vi) = dot(v[vi], u[ui]);
+  const size_t k = u.n_vectors();
+  const size_t l = v.n_vectors();
+  const bool symmetric = detail::same_vectors(u, v);
+  std::vector<scalar_type> c(k * l);
+  typedef IsMutableMemoryVector<typename std::remove_const<Vector>::type> memory_type;
+  detail::gram(u, v, symmetric, c.data(), memory_type{});
+
+  matrix_type ret(k, l, false);
+  for (size_t j = 0; j < l; ++j) {
+    for (size_t i = 0; i < (symmetric ? j + 1 : k); ++i) {
+      ret(i, j) = c[j * k + i];
+      if (symmetric) ret(j, i) = c[j * k + i];
     }
   }
   return ret;
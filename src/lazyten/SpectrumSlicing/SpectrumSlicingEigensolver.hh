@@ -0,0 +1,682 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/config.hh"
+#ifdef LAZYTEN_HAVE_LAPACK
+
+#include "lazyten/Base/Solvers.hh"
+#include "lazyten/EigensolverCostModel.hh"
+#include "lazyten/Exceptions.hh"
+#include "lazyten/Lapack/detail/ShiftedSymmetricFactorisation.hh"
+#include "lazyten/Lapack/detail/blas.hh"
+#include "lazyten/detail/balanced_parallel_for.hh"
+#include "lazyten/detail/small_eigensystem.hh"
+#include "lazyten/ortho.hh"
+#include <krims/Algorithm.hh>
+#include <random>
+#include <thread>
+
+namespace lazyten {
+
+template <typename Eigenproblem>
+struct SpectrumSlicingEigensolverState : public EigensolverStateBase<Eigenproblem> {
+  typedef EigensolverStateBase<Eigenproblem> base_type;
+  typedef typename base_type::eproblem_type eproblem_type;
+  typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::size_type size_type;
+  typedef typename base_type::real_type real_type;
+
+  /** The number of eigenvalues in each window as obtained from the
+   *  inertia of the shifted matrices at the window boundaries */
+  std::vector<size_t> window_counts;
+
+  /** The number of LDL^T factorisations of shifted matrices */
+  size_t n_factorisations;
+
+  /** The largest number of subspace iterations needed in a window */
+  size_t n_iterations;
+
+  /** The number of vectors the matrix A was applied to (in all windows) */
+  size_t n_a_applies;
+
+  /** The number of eigenpairs which were found twice and dropped on merging */
+  size_t n_duplicates;
+
+  /** The residual tolerance actually used in the convergence check
+   *  (see detail::floored_residual_tolerance) */
+  real_type residual_tolerance;
+
+  /** Get the number of subspace iterations (of the slowest window) */
+  size_t n_iter() const override { return n_iterations; }
+
+  /** Get the number of Problem matrix applies (A*x) */
+  size_t n_mtx_applies() const override { return n_a_applies; }
+
+  /** Setup the initial state from an eigenproblem to solve */
+  SpectrumSlicingEigensolverState(const eproblem_type problem)
+        : base_type(std::move(problem)),
+          window_counts{},
+          n_factorisations(0),
+          n_iterations(0),
+          n_a_applies(0),
+          n_duplicates(0),
+          residual_tolerance(0) {}
+};
+
+DefSolverException2(ExcSpectrumSlicingIncomplete, size_t, expected, size_t, found,
+                    << "Spectrum slicing found " << found << " distinct eigenpairs, "
+                    << "but according to the inertia there are " << expected
+                    << " eigenvalues in the interval.");
+
+DefSolverException2(ExcSpectrumSlicingFactorisationFailed, double, sigma, int, info,
+                    << "The LDL^T factorisation of the matrix shifted by " << sigma
+                    << " failed with Lapack info value " << info << ".");
+
+/** Class which contains all GenMap keys which are understood
+ *  by the SpectrumSlicingEigensolver update_control_params as static
+ *  string members.
+ *  See their doc strings for the types required. */
+struct SpectrumSlicingEigensolverKeys : public EigensolverBaseKeys {
+  /** Lower end of the eigenvalue interval. Type: double */
+  static const std::string lower;
+
+  /** Upper end of the eigenvalue interval. Type: double */
+  static const std::string upper;
+
+  /** Number of windows the interval is split into. Type: size_t */
+  static const std::string n_windows;
+
+  /** Number of threads to process windows with. Type: size_t */
+  static const std::string n_threads;
+
+  /** Maximum number of subspace iterations per window. Type: size_t */
+  static const std::string max_iter;
+
+  /** Number of additional vectors in the iterated subspace. Type: size_t */
+  static const std::string n_extra_vectors;
+};
+
+namespace detail {
+/** The eigenpairs found in one window [lower, upper) of the spectrum */
+struct SpectrumSlice {
+  double lower = 0;
+  double upper = 0;
+
+  /** The number of eigenvalues in the window (from the inertia) */
+  size_t expected = 0;
+
+  /** The number of subspace iterations performed */
+  size_t n_iter = 0;
+
+  /** The number of vectors A was applied to */
+  size_t n_a_applies = 0;
+
+  /** Info of the factorisation (0 on success) */
+  int info = 0;
+
+  /** Have all expected eigenpairs converged */
+  bool converged = false;
+
+  /** The eigenvalues found (ascending) */
+  std::vector<double> evals;
+
+  /** The eigenvectors found (column-major, dim * evals.size()) */
+  std::vector<double> evecs;
+};
+
+/** Compute Y = M X for a dense symmetric matrix M and ncols column-major
+ *  vectors X. If M is empty it is taken as the identity. */
+inline void dense_symmetric_apply(const LapackSymmetricMatrix<double>& m,
+                                  const std::vector<double>& x, std::vector<double>& y,
+                                  size_t n, size_t ncols) {
+  y.resize(n * ncols);
+  if (m.elements.empty()) {
+    std::copy(x.begin(), x.begin() + static_cast<ptrdiff_t>(n * ncols), y.begin());
+    return;
+  }
+  run_gemm_nn(n, n, ncols, m.elements.data(), n, x.data(), n, 0., y.data(), n);
+}
+
+/** Form out = in * coeff for column-major blocks, where in has n rows
+ *  and k columns and coeff is a k x l column-major matrix. */
+inline void dense_combine(const std::vector<double>& in, const std::vector<double>& coeff,
+                          std::vector<double>& out, size_t n, size_t k, size_t l) {
+  out.resize(n * l);
+  run_gemm_nn(n, k, l, in.data(), n, coeff.data(), k, 0., out.data(), n);
+}
+}  // namespace detail
+
+/** \brief Spectrum-slicing eigensolver for all eigenpairs in an interval
+ *
+ * Computes all eigenpairs of a real Hermitian (generalised) eigenproblem
+ * with eigenvalues inside the interval [lower, upper). This is meant
+ * for problems where many interior eigenpairs are needed, for which
+ * a single Krylov run scales poorly.
+ *
+ * The interval is split into n_windows windows of equal width, which are
+ * processed independently and concurrently on n_threads threads:
+ *   - The number of eigenvalues in each window is obtained from the
+ *     inertia of the LDL^T factorisations of A - t B at the window
+ *     boundaries t (Sylvester's law of inertia).
+ *   - Inside each window a shift-invert subspace iteration with the shift
+ *     at the window centre is run until as many Ritz pairs as the
+ *     inertia count predicts have converged.
+ * Finally the windows are checked for completeness against the inertia
+ * counts and the eigenpairs are merged and deduplicated.
+ *
+ * Since the shifted matrices need to be factorised, A and B are
+ * extracted into dense matrices once at the beginning. Each factorisation
+ * (at a boundary or a window centre) works on its own dense copy of the
+ * shifted matrix, such that the peak memory is about (n_concurrent + 2) n^2
+ * doubles for generalised problems and (n_concurrent + 1) n^2 otherwise,
+ * plus the subspaces of the windows in flight. The number n_concurrent of
+ * factorisations processed at once is therefore n_threads reduced to
+ * what fits into max_dense_memory.
+ * The n_ep of the eigenproblem is ignored, since the number of eigenpairs
+ * is determined by the interval.
+ *
+ * ## Control parameters and their default values
+ *   - lower, upper: The interval of eigenvalues to compute.
+ *                   Needs to be set and lower < upper.
+ *   - n_windows:    The number of windows. Default: 0, i.e. n_threads
+ *   - n_threads:    Number of threads. Default: hardware concurrency
+ *   - max_iter:     Maximum number of subspace iterations per window.
+ *                   Default: 100
+ *   - n_extra_vectors: Number of vectors iterated in each window in addition
+ *                   to the expected eigenpairs (improves convergence).
+ *                   Default: 0, i.e. std::max(10, count)
+ *   - tolerance:    Tolerance for the residual norms relative to the magnitude
+ *                   of the eigenvalue. Default: Default numeric tolerance
+ *                   (as in Constants.hh), but at least the floor of
+ *                   detail::floored_residual_tolerance.
+ *   - max_dense_memory: Maximal memory in bytes for the dense matrices
+ *                   and factorisations (key as in EigensolverCostModelKeys).
+ *                   Default: 0, i.e. half the physical memory
+ *
+ * \tparam Eigenproblem  The eigenproblem to solve.
+ * \tparam State         The state type of the solver.
+ */
+template <typename Eigenproblem,
+          typename State = SpectrumSlicingEigensolverState<Eigenproblem>>
+class SpectrumSlicingEigensolver : public EigensolverBase<State> {
+  static_assert(std::is_same<Eigenproblem, typename State::eproblem_type>::value,
+                "The type Eigenproblem and the implicit eigenproblem type in the SCF "
+                "state have to agree");
+
+  static_assert(Eigenproblem::hermitian && Eigenproblem::real,
+                "Spectrum slicing can only solve real Hermitian eigenproblems.");
+
+  static_assert(std::is_same<typename Eigenproblem::scalar_type, double>::value,
+                "Spectrum slicing is only implemented for double precision.");
+
+ public:
+  //@{
+  /** Forwarded types */
+  typedef EigensolverBase<State> base_type;
+  typedef typename base_type::state_type state_type;
+  typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::real_type real_type;
+  typedef typename base_type::evalue_type evalue_type;
+  typedef typename base_type::evector_type evector_type;
+  typedef typename base_type::esoln_type esoln_type;
+  typedef typename base_type::stored_matrix_type stored_matrix_type;
+  typedef typename state_type::size_type size_type;
+  //@}
+
+  /** \name Constructor */
+  //@{
+  /** Construct an eigensolver with the default parameters */
+  SpectrumSlicingEigensolver() {}
+
+  /** Construct an eigensolver setting the parameters from the map */
+  SpectrumSlicingEigensolver(const krims::GenMap& map) : SpectrumSlicingEigensolver() {
+    update_control_params(map);
+  }
+  //@}
+
+  /** \name Iteration control */
+  ///@{
+  /** Lower end of the eigenvalue interval */
+  double lower = 0;
+
+  /** Upper end of the eigenvalue interval */
+  double upper = 0;
+
+  /** Number of windows (0: use n_threads windows) */
+  size_t n_windows = 0;
+
+  /** Number of threads used to process the windows */
+  size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  /** Maximum number of subspace iterations per window */
+  size_t max_iter = 100;
+
+  /** \brief Number of extra vectors in the subspace of each window
+   *  By default 0, which implies std::max(10, count) */
+  size_t n_extra_vectors = 0;
+
+  /** \brief Maximal memory in bytes used by the dense matrices and factorisations
+   *  By default 0, which implies half the physical memory */
+  size_t max_dense_memory = 0;
+
+  /** Update control parameters from Parameter map */
+  void update_control_params(const krims::GenMap& map) {
+    base_type::update_control_params(map);
+    lower = map.at(SpectrumSlicingEigensolverKeys::lower, lower);
+    upper = map.at(SpectrumSlicingEigensolverKeys::upper, upper);
+    n_windows = map.at(SpectrumSlicingEigensolverKeys::n_windows, n_windows);
+    n_threads = map.at(SpectrumSlicingEigensolverKeys::n_threads, n_threads);
+    max_iter = map.at(SpectrumSlicingEigensolverKeys::max_iter, max_iter);
+    n_extra_vectors =
+          map.at(SpectrumSlicingEigensolverKeys::n_extra_vectors, n_extra_vectors);
+    max_dense_memory =
+          map.at(EigensolverCostModelKeys::max_dense_memory, max_dense_memory);
+  }
+
+  /** Get the current settings of all internal control parameters and
+   *  update the GenMap accordingly.
+   */
+  void get_control_params(krims::GenMap& map) const {
+    base_type::get_control_params(map);
+    map.update(SpectrumSlicingEigensolverKeys::lower, lower);
+    map.update(SpectrumSlicingEigensolverKeys::upper, upper);
+    map.update(SpectrumSlicingEigensolverKeys::n_windows, n_windows);
+    map.update(SpectrumSlicingEigensolverKeys::n_threads, n_threads);
+    map.update(SpectrumSlicingEigensolverKeys::max_iter, max_iter);
+    map.update(SpectrumSlicingEigensolverKeys::n_extra_vectors, n_extra_vectors);
+    map.update(EigensolverCostModelKeys::max_dense_memory, max_dense_memory);
+  }
+  ///@}
+
+  /** Implementation of the IterativeSolver method */
+  void solve_state(state_type& state) const override;
+
+ private:
+  typedef detail::LapackSymmetricMatrix<double> dense_type;
+  typedef detail::ShiftedSymmetricFactorisation<stored_matrix_type> factorisation_type;
+
+  /** Assert that the state of the control parameters is sensible.
+   *  In case its not, raise an ExcInvalidEigensolverParameters
+   *  exception */
+  void assert_valid_control_params(state_type& s) const;
+
+  /** The number of vectors iterated in a window with count eigenvalues */
+  size_t subspace_size(size_t n, size_t count) const {
+    const size_t extra =
+          n_extra_vectors > 0 ? n_extra_vectors : std::max<size_t>(10, count);
+    return std::min(n, count + extra);
+  }
+
+  /** The number of threads for tasks needing task_memory bytes each, such
+   *  that together with the shared_memory bytes of the extracted matrices
+   *  max_dense_memory is not exceeded. At least 1 and at most n_threads. */
+  size_t n_concurrent(size_t shared_memory, size_t task_memory) const;
+
+  /** Run the shift-invert subspace iteration inside a window until the
+   *  residuals are below tolerance. The slice needs to have lower, upper
+   *  and expected set. The seed is used for the random initial subspace. */
+  void solve_window(const dense_type& a, const dense_type& b,
+                    detail::SpectrumSlice& slice, size_t seed,
+                    double tolerance) const;
+
+  /** B-orthonormalise the columns of y (with images by = B y) as a whole
+   *  block by CholQR2 (see detail::cholqr2_passes). If the block turns out
+   *  to be numerically linearly dependent, it is replaced by random vectors. */
+  void b_orthonormalise(const dense_type& b, std::vector<double>& y,
+                        std::vector<double>& by, size_t n, size_t p,
+                        std::mt19937& engine) const;
+};
+
+//
+// ----------------------------------------------------------
+//
+
+template <typename Eigenproblem, typename State>
+void SpectrumSlicingEigensolver<Eigenproblem, State>::assert_valid_control_params(
+      state_type& state) const {
+  solver_assert(lower < upper, state,
+                ExcInvalidSolverParametersEncountered(
+                      "The interval [lower, upper) for spectrum slicing needs to be set "
+                      "via the keys " +
+                      SpectrumSlicingEigensolverKeys::lower + " and " +
+                      SpectrumSlicingEigensolverKeys::upper + " with lower < upper."));
+  solver_assert(max_iter > 0, state,
+                ExcInvalidSolverParametersEncountered(
+                      "The maximal number of iterations needs to be positive."));
+}
+
+template <typename Eigenproblem, typename State>
+size_t SpectrumSlicingEigensolver<Eigenproblem, State>::n_concurrent(
+      size_t shared_memory, size_t task_memory) const {
+  EigensolverCostModel model;
+  model.max_dense_memory = max_dense_memory;
+  const size_t available = model.available_dense_memory();
+  if (available <= shared_memory) return 1;
+
+  const size_t fitting = (available - shared_memory) / std::max<size_t>(1, task_memory);
+  return std::max<size_t>(1, std::min(n_threads, fitting));
+}
+
+template <typename Eigenproblem, typename State>
+void SpectrumSlicingEigensolver<Eigenproblem, State>::b_orthonormalise(
+      const dense_type& b, std::vector<double>& y, std::vector<double>& by, size_t n,
+      size_t p, std::mt19937& engine) const {
+  std::uniform_real_distribution<double> distribution(-1., 1.);
+  std::vector<double> r(p * p), tmp(n * p);
+
+  // One pass of Cholesky QR: Y <- Y R^{-1} and BY <- BY R^{-1}
+  // with R^T R = Y^T B Y + shift
+  auto pass = [&](const double shift, double& trace) {
+    detail::run_gemm_tn(n, p, p, y.data(), n, by.data(), n, r.data());
+    if (!detail::cholqr_inverse_factor(r, p, shift, trace)) return false;
+    detail::run_gemm_nn(n, p, p, y.data(), n, r.data(), p, 0., tmp.data(), n);
+    y.swap(tmp);
+    detail::run_gemm_nn(n, p, p, by.data(), n, r.data(), p, 0., tmp.data(), n);
+    by.swap(tmp);
+    return true;
+  };
+
+  for (size_t attempt = 0; attempt < 3; ++attempt) {
+    // The shift-invert scales the columns very differently, so normalise
+    // them first to make the conditioning only depend on their directions.
+    for (size_t j = 0; j < p; ++j) {
+      double* yj = y.data() + j * n;
+      double* byj = by.data() + j * n;
+      const double norm =
+            std::sqrt(std::max(0., std::inner_product(yj, yj + n, byj, 0.)));
+      if (norm == 0) continue;
+      for (size_t k = 0; k < n; ++k) {
+        yj[k] /= norm;
+        byj[k] /= norm;
+      }
+    }
+    if (detail::cholqr2_passes<double>(n, p, pass)) return;
+
+    // Linearly dependent: Replace by random vectors and try again
+    for (auto& elem : y) elem = distribution(engine);
+    detail::dense_symmetric_apply(b, y, by, n, p);
+  }
+}
+
+template <typename Eigenproblem, typename State>
+void SpectrumSlicingEigensolver<Eigenproblem, State>::solve_window(
+      const dense_type& a, const dense_type& b, detail::SpectrumSlice& slice,
+      size_t seed, double tolerance) const {
+  const size_t n = a.n;
+  const size_t m = slice.expected;
+  if (m == 0) {
+    slice.converged = true;
+    return;
+  }
+
+  // Factorise A - sigma B with the shift at the window centre. If the shift
+  // happens to be an eigenvalue, move it slightly.
+  const double width = slice.upper - slice.lower;
+  double sigma = slice.lower + width / 2;
+  std::unique_ptr<factorisation_type> factor_ptr(new factorisation_type(a, b, sigma));
+  for (size_t shift = 1; factor_ptr->info > 0 && shift < 5; ++shift) {
+    sigma += width * 1e-3 * static_cast<double>(shift);
+    factor_ptr.reset(new factorisation_type(a, b, sigma));
+  }
+  slice.info = factor_ptr->info;
+  if (slice.info != 0) return;
+
+  // Size of the iterated subspace
+  const size_t p = subspace_size(n, m);
+
+  // Random initial subspace (thread-local engine, such that results are
+  // reproducible independent of the scheduling of the windows)
+  std::mt19937 engine(static_cast<std::mt19937::result_type>(seed));
+  std::uniform_real_distribution<double> distribution(-1., 1.);
+  std::vector<double> x(n * p);
+  for (auto& elem : x) elem = distribution(engine);
+  std::vector<double> bx;
+  detail::dense_symmetric_apply(b, x, bx, n, p);
+
+  std::vector<double> y(n * p), by, ay, theta, coeff;
+  std::vector<double> ax, h(p * p);
+  const double slack =
+        tolerance * std::max(1., std::max(std::abs(slice.lower), std::abs(slice.upper)));
+  const double lower_eff = slice.lower - slack / 2;
+  const double upper_eff = slice.upper - slack / 2;
+  for (slice.n_iter = 1; slice.n_iter <= max_iter; ++slice.n_iter) {
+    // Y = (A - sigma B)^{-1} B X
+    slice.info = factor_ptr->solve(bx.data(), y.data(), p);
+    if (slice.info != 0) return;
+    detail::dense_symmetric_apply(b, y, by, n, p);
+    b_orthonormalise(b, y, by, n, p, engine);
+
+    // Rayleigh-Ritz with A in the B-orthonormal subspace
+    detail::dense_symmetric_apply(a, y, ay, n, p);
+    slice.n_a_applies += p;
+    detail::run_gemm_tn(n, p, p, y.data(), n, ay.data(), n, h.data());
+    for (size_t j = 0; j < p; ++j) {
+      for (size_t i = 0; i < j; ++i) {
+        h[j * p + i] = h[i * p + j] = (h[j * p + i] + h[i * p + j]) / 2;
+      }
+    }
+    detail::small_eigensystem_hermitian(h, p, theta, coeff);
+    detail::dense_combine(y, coeff, x, n, p, p);
+    detail::dense_combine(ay, coeff, ax, n, p, p);
+    detail::dense_combine(by, coeff, bx, n, p, p);
+
+    // The candidates are the m Ritz pairs closest to the window. The window
+    // is shifted down by half the slack, such that eigenvalues sitting
+    // numerically on a boundary are attributed like the inertia does,
+    // i.e. to the window to their right.
+    std::vector<double> distance(p, 0.);
+    for (size_t i = 0; i < p; ++i) {
+      if (theta[i] < lower_eff) {
+        distance[i] = lower_eff - theta[i];
+      } else if (theta[i] >= upper_eff) {
+        distance[i] = theta[i] - upper_eff + slack;  // upper end is excluded
+      }
+    }
+    std::vector<size_t> closest = krims::argsort(distance.begin(), distance.end());
+    closest.resize(m);
+    std::sort(closest.begin(), closest.end());
+
+    bool converged = true;
+    for (const size_t i : closest) {
+      if (distance[i] > 0) {
+        converged = false;
+        break;
+      }
+
+      double resnorm2 = 0;
+      for (size_t k = 0; k < n; ++k) {
+        const double r = ax[i * n + k] - theta[i] * bx[i * n + k];
+        resnorm2 += r * r;
+      }
+      if (std::sqrt(resnorm2) > tolerance * std::max(1., std::abs(theta[i]))) {
+        converged = false;
+        break;
+      }
+    }
+
+    if (converged) {
+      slice.converged = true;
+      slice.evals.clear();
+      slice.evecs.resize(n * m);
+      for (size_t c = 0; c < m; ++c) {
+        slice.evals.push_back(theta[closest[c]]);
+        std::copy(x.begin() + static_cast<ptrdiff_t>(closest[c] * n),
+                  x.begin() + static_cast<ptrdiff_t>((closest[c] + 1) * n),
+                  slice.evecs.begin() + static_cast<ptrdiff_t>(c * n));
+      }
+      return;
+    }
+  }
+  slice.n_iter = max_iter;
+}
+
+template <typename Eigenproblem, typename State>
+void SpectrumSlicingEigensolver<Eigenproblem, State>::solve_state(
+      state_type& state) const {
+  assert_dbg(!state.is_failed(), krims::ExcInvalidState("Cannot solve a failed state"));
+  assert_valid_control_params(state);
+
+  const Eigenproblem& problem = state.eigenproblem();
+  const size_type dim = problem.dim();
+  const size_t n_win = n_windows > 0 ? n_windows : std::max<size_t>(1, n_threads);
+  const real_type tolerance = detail::floored_residual_tolerance(base_type::tolerance);
+  state.residual_tolerance = tolerance;
+
+  // Extract the matrices once, all windows share them read-only.
+  const dense_type a{problem.A()};
+  const dense_type b = Eigenproblem::generalised ? dense_type{problem.B()} : dense_type{};
+
+  // Each factorisation needs its own dense copy of the shifted matrix
+  // next to the extracted A and B, so limit their number by memory.
+  const size_t matrix_memory = dim * dim * sizeof(double);
+  const size_t shared_memory = (Eigenproblem::generalised ? 2 : 1) * matrix_memory;
+
+  //
+  // Inertia counts at the window boundaries
+  //
+  std::vector<double> boundaries(n_win + 1);
+  for (size_t k = 0; k <= n_win; ++k) {
+    boundaries[k] = lower + (upper - lower) * static_cast<double>(k) /
+                                  static_cast<double>(n_win);
+  }
+  boundaries[n_win] = upper;
+
+  std::vector<size_t> n_below(n_win + 1);
+  std::vector<int> infos(n_win + 1);
+  detail::balanced_parallel_for(std::vector<double>(n_win + 1, 1.),
+                                n_concurrent(shared_memory, matrix_memory),
+                                [&](size_t k) {
+                                  const factorisation_type factor(a, b, boundaries[k]);
+                                  infos[k] = factor.info;
+                                  n_below[k] = factor.n_negative();
+                                });
+  state.n_factorisations += n_win + 1;
+  for (size_t k = 0; k <= n_win; ++k) {
+    // Positive info values denote an exactly singular D, i.e. the boundary
+    // is an eigenvalue. The inertia is still valid in this case.
+    solver_assert(infos[k] >= 0, state,
+                  ExcSpectrumSlicingFactorisationFailed(boundaries[k], infos[k]));
+  }
+
+  //
+  // Solve inside the windows
+  //
+  std::vector<detail::SpectrumSlice> slices(n_win);
+  std::vector<double> costs(n_win);
+  size_t max_p = 0;
+  state.window_counts.resize(n_win);
+  for (size_t k = 0; k < n_win; ++k) {
+    slices[k].lower = boundaries[k];
+    slices[k].upper = boundaries[k + 1];
+    slices[k].expected = n_below[k + 1] >= n_below[k] ? n_below[k + 1] - n_below[k] : 0;
+    state.window_counts[k] = slices[k].expected;
+    costs[k] = static_cast<double>(dim + 3 * slices[k].expected);
+    if (slices[k].expected > 0) {
+      max_p = std::max(max_p, subspace_size(dim, slices[k].expected));
+    }
+  }
+
+  // A window holds its factorisation and about 9 blocks of p vectors
+  const size_t window_memory = matrix_memory + 9 * dim * max_p * sizeof(double);
+  detail::balanced_parallel_for(costs, n_concurrent(shared_memory, window_memory),
+                                [&](size_t k) {
+                                  solve_window(a, b, slices[k], k, tolerance);
+                                });
+
+  for (const auto& slice : slices) {
+    if (slice.expected == 0) continue;
+    ++state.n_factorisations;
+    state.n_a_applies += slice.n_a_applies;
+    state.n_iterations = std::max(state.n_iterations, slice.n_iter);
+  }
+
+  // Check that all windows were successful
+  for (const auto& slice : slices) {
+    solver_assert(slice.info == 0, state,
+                  ExcSpectrumSlicingFactorisationFailed(
+                        slice.lower + (slice.upper - slice.lower) / 2, slice.info));
+    solver_assert(slice.converged, state, ExcMaximumNumberOfIterationsReached(max_iter));
+  }
+
+  //
+  // Merge and deduplicate
+  //
+  struct Pair {
+    double eval;
+    size_t window;
+    size_t index;
+  };
+  std::vector<Pair> pairs;
+  for (size_t k = 0; k < n_win; ++k) {
+    for (size_t i = 0; i < slices[k].evals.size(); ++i) {
+      pairs.push_back(Pair{slices[k].evals[i], k, i});
+    }
+  }
+  std::stable_sort(pairs.begin(), pairs.end(),
+                   [](const Pair& p, const Pair& q) { return p.eval < q.eval; });
+
+  auto evec_ptr = [&slices, dim](const Pair& p) {
+    return slices[p.window].evecs.data() + p.index * dim;
+  };
+
+  std::vector<Pair> kept;
+  std::vector<double> bvec, vec(dim);
+  for (const Pair& p : pairs) {
+    bool duplicate = false;
+    for (auto it = kept.rbegin(); it != kept.rend(); ++it) {
+      const double slack = tolerance * std::max(1., std::abs(p.eval));
+      if (p.eval - it->eval > slack) break;
+      if (it->window == p.window) continue;
+
+      // Same eigenvalue from another window: Duplicate if the vectors overlap
+      std::copy(evec_ptr(*it), evec_ptr(*it) + dim, vec.begin());
+      detail::dense_symmetric_apply(b, vec, bvec, dim, 1);
+      const double overlap =
+            std::inner_product(bvec.begin(), bvec.end(), evec_ptr(p), 0.);
+      if (std::abs(overlap) > 0.5) {
+        duplicate = true;
+        break;
+      }
+    }
+    if (duplicate) {
+      ++state.n_duplicates;
+    } else {
+      kept.push_back(p);
+    }
+  }
+
+  // Check completeness against the inertia counts
+  const size_t expected = n_below[n_win] - n_below[0];
+  solver_assert(kept.size() == expected, state,
+                ExcSpectrumSlicingIncomplete(expected, kept.size()));
+
+  esoln_type& soln = state.eigensolution();
+  soln.evalues().clear();
+  soln.evalues().reserve(kept.size());
+  MultiVector<evector_type> evectors(dim, kept.size(), false);
+  for (size_t i = 0; i < kept.size(); ++i) {
+    soln.evalues().push_back(kept[i].eval);
+    std::copy(evec_ptr(kept[i]), evec_ptr(kept[i]) + dim, evectors[i].begin());
+  }
+  soln.evectors() = std::move(evectors);
+}
+
+}  // namespace lazyten
+#endif  // LAZYTEN_HAVE_LAPACK
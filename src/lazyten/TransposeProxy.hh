@@ -37,6 +37,7 @@ class TransposeProxy : public detail::ProxyBase<Matrix> {
   typedef typename base_type::matrix_type matrix_type;
   typedef typename base_type::size_type size_type;
   typedef typename base_type::scalar_type scalar_type;
+  typedef typename base_type::vector_type vector_type;
   typedef typename base_type::lazy_matrix_expression_ptr_type
         lazy_matrix_expression_ptr_type;
 
@@ -100,6 +101,14 @@ class TransposeProxy : public detail::ProxyBase<Matrix> {
                      const scalar_type c_this = Constants<scalar_type>::one,
                      const scalar_type c_M = Constants<scalar_type>::zero) const override;
 
+  /** \brief Extract the diagonal of the matrix
+   *
+   * This is just the diagonal of the inner matrix.
+   */
+  vector_type extract_diagonal() const override {
+    return lazyten::extract_diagonal(base_type::inner_matrix());
+  }
+
   /** \brief Compute the Matrix-Multivector application -- generic version
    *
    * Loosely speaking we perform
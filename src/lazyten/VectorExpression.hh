@@ -0,0 +1,387 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/Base/Interfaces.hh"
+#include <iterator>
+#include <type_traits>
+
+namespace lazyten {
+
+/** \brief Base class of all fused vector expressions.
+ *
+ * A vector expression represents an elementwise arithmetic expression
+ * of vectors (sums, differences and scalings), which is only evaluated
+ * once it is assigned to a vector via assign() or used in a reduction
+ * like dot(), accumulate() or norm_l2(). All operations are then done in a
+ * single pass over the data, without any temporary vectors.
+ *
+ * Expressions are built from vectors using as_expression() and only hold
+ * references to the vectors they are built from. So they should not outlive
+ * these, i.e. typically they are not stored, but directly evaluated:
+ * ```
+ * assign(r, a * as_expression(x) + b * as_expression(y) - as_expression(z));
+ * ```
+ *
+ * Derived classes need to implement a non-virtual function
+ * ``scalar_type eval(size_type i) const`` returning the i-th element,
+ * which is what the evaluation in assign() and the iterators use.
+ */
+template <typename Derived, typename Scalar>
+class VectorExpression : public Vector_i<Scalar> {
+ public:
+  typedef Vector_i<Scalar> base_type;
+  typedef typename base_type::size_type size_type;
+  typedef typename base_type::scalar_type scalar_type;
+
+  /** The type of the actual expression */
+  typedef Derived expression_type;
+
+  class const_iterator;
+  typedef const_iterator iterator;
+
+  /** Access to the actual expression */
+  const Derived& derived() const { return static_cast<const Derived&>(*this); }
+
+  /** \brief return an element of the vector */
+  scalar_type operator[](size_type i) const override {
+    assert_range(0, i, this->n_elem());
+    return derived().eval(i);
+  }
+
+  /** \brief return an element of the vector */
+  scalar_type operator()(size_type i) const override { return (*this)[i]; }
+
+  /** \name Iterators */
+  ///@{
+  /** Return a const_iterator to the beginning */
+  const_iterator begin() const { return cbegin(); }
+
+  /** Return a const_iterator to the beginning */
+  const_iterator cbegin() const { return const_iterator(derived(), 0); }
+
+  /** Return a const_iterator to the end */
+  const_iterator end() const { return cend(); }
+
+  /** Return a const_iterator to the end */
+  const_iterator cend() const { return const_iterator(derived(), this->n_elem()); }
+  ///@}
+};
+
+/** The iterator of vector expressions, which evaluates the expression
+ *  element by element. */
+template <typename Derived, typename Scalar>
+class VectorExpression<Derived, Scalar>::const_iterator
+      : public std::iterator<std::random_access_iterator_tag, const Scalar,
+                             std::ptrdiff_t, const Scalar*, const Scalar> {
+ public:
+  typedef std::iterator<std::random_access_iterator_tag, const Scalar, std::ptrdiff_t,
+                        const Scalar*, const Scalar>
+        base_type;
+  typedef typename base_type::difference_type difference_type;
+  typedef typename base_type::value_type value_type;
+
+  /** Construct from expression and index */
+  const_iterator(const Derived& expr, size_t i) : m_expr_ptr(&expr), m_i(i) {}
+
+  /** Default-construct */
+  const_iterator() : m_expr_ptr(nullptr), m_i(0) {}
+
+  /** Evaluate the expression at the current position */
+  value_type operator*() const { return m_expr_ptr->eval(m_i); }
+
+  /** Evaluate the expression at an offset from the current position */
+  value_type operator[](difference_type n) const { return m_expr_ptr->eval(m_i + n); }
+
+  /** Increment, decrement and arithmetic */
+  //@{
+  const_iterator& operator++() {
+    ++m_i;
+    return *this;
+  }
+  const_iterator operator++(int) {
+    const_iterator copy(*this);
+    ++m_i;
+    return copy;
+  }
+  const_iterator& operator--() {
+    --m_i;
+    return *this;
+  }
+  const_iterator operator--(int) {
+    const_iterator copy(*this);
+    --m_i;
+    return copy;
+  }
+  const_iterator& operator+=(difference_type n) {
+    m_i += n;
+    return *this;
+  }
+  const_iterator& operator-=(difference_type n) {
+    m_i -= n;
+    return *this;
+  }
+  const_iterator operator+(difference_type n) const {
+    return const_iterator(*m_expr_ptr, m_i + n);
+  }
+  const_iterator operator-(difference_type n) const {
+    return const_iterator(*m_expr_ptr, m_i - n);
+  }
+  difference_type operator-(const const_iterator& other) const {
+    return static_cast<difference_type>(m_i) - static_cast<difference_type>(other.m_i);
+  }
+  //@}
+
+  /** Comparison */
+  //@{
+  bool operator==(const const_iterator& other) const {
+    return m_expr_ptr == other.m_expr_ptr && m_i == other.m_i;
+  }
+  bool operator!=(const const_iterator& other) const { return !(*this == other); }
+  bool operator<(const const_iterator& other) const { return m_i < other.m_i; }
+  bool operator>(const const_iterator& other) const { return other < *this; }
+  bool operator<=(const const_iterator& other) const { return !(other < *this); }
+  bool operator>=(const const_iterator& other) const { return !(*this < other); }
+  //@}
+
+ private:
+  const Derived* m_expr_ptr;
+  size_t m_i;
+};
+
+//@{
+/** \brief Is T a vector expression */
+template <typename T, typename = void>
+struct IsVectorExpression : public std::false_type {};
+
+template <typename T>
+struct IsVectorExpression<T, krims::VoidType<typename T::expression_type>>
+      : public std::is_base_of<
+              VectorExpression<typename T::expression_type, typename T::scalar_type>,
+              T> {};
+//@}
+
+namespace detail {
+/** Leaf of a vector expression: Reference to a vector, which is
+ *  accessed via operator[] */
+template <typename Vector, typename = void>
+class VectorExpressionLeaf
+      : public VectorExpression<VectorExpressionLeaf<Vector>,
+                                typename Vector::scalar_type> {
+ public:
+  typedef typename Vector::scalar_type scalar_type;
+  typedef typename Vector::size_type size_type;
+
+  explicit VectorExpressionLeaf(const Vector& v) : m_vector(v) {}
+  size_type n_elem() const override { return m_vector.n_elem(); }
+  scalar_type eval(size_type i) const { return m_vector[i]; }
+
+ private:
+  const Vector& m_vector;
+};
+
+/** Leaf of a vector expression: Reference to a vector, which is
+ *  accessed directly via its memory */
+template <typename Vector>
+class VectorExpressionLeaf<Vector,
+                           krims::enable_if_t<IsMutableMemoryVector<Vector>::value>>
+      : public VectorExpression<VectorExpressionLeaf<Vector>,
+                                typename Vector::scalar_type> {
+ public:
+  typedef typename Vector::scalar_type scalar_type;
+  typedef typename Vector::size_type size_type;
+
+  explicit VectorExpressionLeaf(const Vector& v)
+        : m_ptr(v.memptr()), m_n_elem(v.n_elem()) {}
+  size_type n_elem() const override { return m_n_elem; }
+  scalar_type eval(size_type i) const { return m_ptr[i]; }
+
+ private:
+  const scalar_type* m_ptr;
+  size_type m_n_elem;
+};
+
+/** Map a vector or an expression to the type used inside expressions */
+template <typename T, typename = void>
+struct ExpressionOf {
+  typedef VectorExpressionLeaf<T> type;
+};
+
+template <typename T>
+struct ExpressionOf<T, krims::enable_if_t<IsVectorExpression<T>::value>> {
+  typedef T type;
+};
+
+/** Elementwise sum or difference of two expressions */
+template <typename Lhs, typename Rhs, bool Subtract>
+class VectorSumExpression
+      : public VectorExpression<
+              VectorSumExpression<Lhs, Rhs, Subtract>,
+              typename std::common_type<typename Lhs::scalar_type,
+                                        typename Rhs::scalar_type>::type> {
+ public:
+  typedef typename std::common_type<typename Lhs::scalar_type,
+                                    typename Rhs::scalar_type>::type scalar_type;
+  typedef size_t size_type;
+
+  VectorSumExpression(Lhs lhs, Rhs rhs) : m_lhs(std::move(lhs)), m_rhs(std::move(rhs)) {
+    assert_size(m_lhs.n_elem(), m_rhs.n_elem());
+  }
+  size_type n_elem() const override { return m_lhs.n_elem(); }
+  scalar_type eval(size_type i) const {
+    return Subtract ? m_lhs.eval(i) - m_rhs.eval(i) : m_lhs.eval(i) + m_rhs.eval(i);
+  }
+
+ private:
+  Lhs m_lhs;
+  Rhs m_rhs;
+};
+
+/** Expression scaled by a scalar */
+template <typename Expr>
+class ScaledVectorExpression
+      : public VectorExpression<ScaledVectorExpression<Expr>,
+                                typename Expr::scalar_type> {
+ public:
+  typedef typename Expr::scalar_type scalar_type;
+  typedef size_t size_type;
+
+  ScaledVectorExpression(scalar_type scale, Expr expr)
+        : m_scale(scale), m_expr(std::move(expr)) {}
+  size_type n_elem() const override { return m_expr.n_elem(); }
+  scalar_type eval(size_type i) const { return m_scale * m_expr.eval(i); }
+
+ private:
+  scalar_type m_scale;
+  Expr m_expr;
+};
+
+/** Enable a binary operation if both operands are vectors and at least
+ *  one of them is a vector expression */
+template <typename Lhs, typename Rhs, typename Result>
+using enable_if_expression_operands_t = krims::enable_if_t<
+      IsVector<Lhs>::value && IsVector<Rhs>::value &&
+            (IsVectorExpression<Lhs>::value || IsVectorExpression<Rhs>::value),
+      Result>;
+}  // namespace detail
+
+/** \name Construction of vector expressions */
+///@{
+/** Make a vector expression out of a vector, which can be combined with
+ *  others to a fused expression. Memory vectors are directly accessed via
+ *  their memory. */
+template <typename Vector,
+          typename = krims::enable_if_t<IsVector<Vector>::value &&
+                                        !IsVectorExpression<Vector>::value>>
+detail::VectorExpressionLeaf<Vector> as_expression(const Vector& v) {
+  return detail::VectorExpressionLeaf<Vector>(v);
+}
+
+/** Vector expressions are passed through */
+template <typename Derived, typename Scalar>
+const Derived& as_expression(const VectorExpression<Derived, Scalar>& expr) {
+  return expr.derived();
+}
+
+/** Elementwise sum of vectors, where at least one is a vector expression */
+template <typename Lhs, typename Rhs>
+detail::enable_if_expression_operands_t<
+      Lhs, Rhs,
+      detail::VectorSumExpression<typename detail::ExpressionOf<Lhs>::type,
+                                  typename detail::ExpressionOf<Rhs>::type, false>>
+operator+(const Lhs& lhs, const Rhs& rhs) {
+  return {as_expression(lhs), as_expression(rhs)};
+}
+
+/** Elementwise difference of vectors, where at least one is a vector expression */
+template <typename Lhs, typename Rhs>
+detail::enable_if_expression_operands_t<
+      Lhs, Rhs,
+      detail::VectorSumExpression<typename detail::ExpressionOf<Lhs>::type,
+                                  typename detail::ExpressionOf<Rhs>::type, true>>
+operator-(const Lhs& lhs, const Rhs& rhs) {
+  return {as_expression(lhs), as_expression(rhs)};
+}
+
+/** Scale a vector expression */
+template <typename Derived, typename Scalar>
+detail::ScaledVectorExpression<Derived> operator*(
+      typename VectorExpression<Derived, Scalar>::scalar_type s,
+      const VectorExpression<Derived, Scalar>& expr) {
+  return {s, expr.derived()};
+}
+
+/** Scale a vector expression */
+template <typename Derived, typename Scalar>
+detail::ScaledVectorExpression<Derived> operator*(
+      const VectorExpression<Derived, Scalar>& expr,
+      typename VectorExpression<Derived, Scalar>::scalar_type s) {
+  return {s, expr.derived()};
+}
+
+/** Divide a vector expression by a scalar */
+template <typename Derived, typename Scalar>
+detail::ScaledVectorExpression<Derived> operator/(
+      const VectorExpression<Derived, Scalar>& expr,
+      typename VectorExpression<Derived, Scalar>::scalar_type s) {
+  return {Constants<Scalar>::one / s, expr.derived()};
+}
+
+/** Negate a vector expression */
+template <typename Derived, typename Scalar>
+detail::ScaledVectorExpression<Derived> operator-(
+      const VectorExpression<Derived, Scalar>& expr) {
+  return {-Constants<Scalar>::one, expr.derived()};
+}
+///@}
+
+/** Evaluate a vector expression and assign the result to a vector.
+ *
+ * The expression is evaluated in a single pass. The vector may appear
+ * in the expression itself, e.g. ``assign(y, as_expression(y) + a * x)``.
+ */
+template <typename Vector, typename Derived, typename Scalar>
+krims::enable_if_t<IsMutableMemoryVector<Vector>::value, Vector&> assign(
+      Vector& out, const VectorExpression<Derived, Scalar>& expr) {
+  assert_size(out.n_elem(), expr.n_elem());
+  const Derived& e = expr.derived();
+  typename Vector::scalar_type* ptr = out.memptr();
+  const size_t n_elem = out.n_elem();
+  for (size_t i = 0; i < n_elem; ++i) ptr[i] = e.eval(i);
+  return out;
+}
+
+/** Evaluate a vector expression and assign the result to a vector.
+ *
+ * The expression is evaluated in a single pass. The vector may appear
+ * in the expression itself, e.g. ``assign(y, as_expression(y) + a * x)``.
+ */
+template <typename Vector, typename Derived, typename Scalar>
+krims::enable_if_t<IsMutableVector<Vector>::value &&
+                         !IsMutableMemoryVector<Vector>::value,
+                   Vector&>
+assign(Vector& out, const VectorExpression<Derived, Scalar>& expr) {
+  assert_size(out.n_elem(), expr.n_elem());
+  const Derived& e = expr.derived();
+  const size_t n_elem = out.n_elem();
+  for (size_t i = 0; i < n_elem; ++i) out[i] = e.eval(i);
+  return out;
+}
+
+}  // namespace lazyten
@@ -41,9 +41,10 @@ class ProxyBase : public LazyMatrixExpression<StoredMatrix> {
 
   /** \brief Update the internal data
    *
-   *  In this case does nothing.
+   *  In this case only forgets the cached properties, since the
+   *  inner stored matrix may have changed.
    * */
-  void update(const krims::GenMap&) override {}
+  void update(const krims::GenMap&) override { this->invalidate_property_cache(); }
 
   /** Does this class own the inner matrix
    *
@@ -87,6 +88,7 @@ class ProxyBase<Matrix, StoredMatrix, /*isStored*/ false,
     assert_dbg(false, krims::ExcDisabled("Update is not possible for this Matrix "
                                          "expression, since the matrix inside the "
                                          "Proxy object is const."));
+    this->invalidate_property_cache();
   }
 
   /** Does this class own the inner matrix
@@ -128,7 +130,10 @@ class ProxyBase<Matrix, StoredMatrix, /*isStored*/ false,
    *  In this case does nothing, since the internal object is
    *  either a stored matrix or const.
    * */
-  void update(const krims::GenMap& map) override { m_inner.update(map); }
+  void update(const krims::GenMap& map) override {
+    m_inner.update(map);
+    this->invalidate_property_cache();
+  }
 
   /** Does this class own the inner matrix
    *
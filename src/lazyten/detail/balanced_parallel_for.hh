@@ -0,0 +1,129 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <numeric>
+#include <vector>
+
+namespace lazyten {
+namespace detail {
+
+/** Flag whether the calling thread currently runs a task of a
+ *  multi-threaded balanced_parallel_for */
+inline bool& in_parallel_region_flag() {
+  static thread_local bool flag = false;
+  return flag;
+}
+
+/** Is the calling thread currently running a task of a multi-threaded
+ *  balanced_parallel_for. Code which could spawn threads of its own (e.g. the
+ *  fallback reductions) should run serially if this is true. */
+inline bool in_parallel_region() { return in_parallel_region_flag(); }
+
+/** Marks the calling thread as being inside a parallel region
+ *  for the lifetime of the object */
+class ParallelRegionGuard {
+ public:
+  ParallelRegionGuard() : m_previous(in_parallel_region_flag()) {
+    in_parallel_region_flag() = true;
+  }
+  ~ParallelRegionGuard() { in_parallel_region_flag() = m_previous; }
+
+  ParallelRegionGuard(const ParallelRegionGuard&) = delete;
+  ParallelRegionGuard& operator=(const ParallelRegionGuard&) = delete;
+
+ private:
+  bool m_previous;
+};
+
+/** Call task(i) for all i in [0, costs.size()) using up to n_threads
+ *  threads (including the calling thread).
+ *
+ * The tasks are started in order of decreasing estimated cost and each
+ * thread picks the next task as soon as it is done with its previous
+ * one (longest-processing-time-first scheduling). This gives a good
+ * balance for a small number of tasks of rather different size.
+ *
+ * If a task throws, the exception is passed on to the caller once all
+ * threads have finished.
+ *
+ * While the tasks run on more than one thread, all threads involved are
+ * marked by in_parallel_region(). Nested calls from within such a task run
+ * serially in the calling thread, such that the total number of threads
+ * never exceeds the n_threads of the outermost loop.
+ *
+ * \param costs      The estimated cost of each task (arbitrary units)
+ * \param n_threads  The maximal number of threads to use.
+ *                   If this is 0 or 1 all tasks are run in order
+ *                   in the calling thread.
+ * \param task       Functor to run the task with a given index.
+ */
+template <typename Task>
+void balanced_parallel_for(const std::vector<double>& costs, size_t n_threads,
+                           Task task) {
+  const size_t n_tasks = costs.size();
+  std::vector<size_t> order(n_tasks);
+  std::iota(std::begin(order), std::end(order), size_t(0));
+
+  n_threads = in_parallel_region() ? 1 : std::min(n_threads, n_tasks);
+  if (n_threads <= 1) {
+    for (const size_t i : order) task(i);
+    return;
+  }
+
+  // Most expensive tasks first (stable, such that ties keep their order)
+  std::stable_sort(std::begin(order), std::end(order),
+                   [&costs](size_t i, size_t j) { return costs[i] > costs[j]; });
+
+  std::atomic<size_t> next{0};
+  auto worker = [&order, &next, &task, n_tasks] {
+    ParallelRegionGuard guard;
+    for (size_t k = next++; k < n_tasks; k = next++) task(order[k]);
+  };
+
+  std::vector<std::future<void>> futures;
+  futures.reserve(n_threads - 1);
+  for (size_t t = 1; t < n_threads; ++t) {
+    futures.push_back(std::async(std::launch::async, worker));
+  }
+
+  // Work in this thread as well, but make sure all other threads are
+  // done before passing on any exception.
+  std::exception_ptr error;
+  try {
+    worker();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  for (auto& f : futures) {
+    try {
+      f.get();
+    } catch (...) {
+      if (!error) error = std::current_exception();
+    }
+  }
+  if (error) std::rethrow_exception(error);
+}
+
+}  // namespace detail
+}  // namespace lazyten
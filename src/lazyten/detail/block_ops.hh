@@ -0,0 +1,268 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+#pragma once
+#include "lazyten/MultiVector.hh"
+#include "lazyten/detail/scale_or_set.hh"
+#include <algorithm>
+#include <vector>
+
+namespace lazyten {
+namespace detail {
+
+// Block operations on MultiVectors used by the native iterative eigensolvers
+// and LowRankMatrix.
+// Small dense coefficient matrices are passed as column-major std::vectors.
+//
+// For vectors with accessible memory and a BLAS scalar type both operations
+// are BLAS-3 calls (see Lapack/detail/blas.hh). If the vectors are equally
+// spaced in memory (e.g. the columns of a single buffer) the BLAS routine
+// works on them directly, else they are packed chunk by chunk into a
+// contiguous buffer first.
+
+/** The number of scalars packed at once into the contiguous buffers of the
+ *  BLAS-3 kernels for vectors scattered in memory. This is 256 KiB for
+ *  doubles, such that the packed data stays in the L2 cache while the
+ *  BLAS routine works on it. */
+constexpr size_t block_ops_pack_size = 32768;
+
+/** Copy the elements [begin, begin + len) of all vectors of mv
+ *  column-major into buf (leading dimension len) */
+template <typename Vector>
+void pack_rows(const MultiVector<Vector>& mv, const size_t begin, const size_t len,
+               typename Vector::scalar_type* buf) {
+  for (size_t i = 0; i < mv.n_vectors(); ++i) {
+    const auto* ptr = mv[i].memptr() + begin;
+    std::copy(ptr, ptr + len, buf + i * len);
+  }
+}
+
+/** Copy back the data packed with pack_rows into the vectors of mv */
+template <typename Vector>
+void unpack_rows(const typename Vector::scalar_type* buf, const size_t begin,
+                 const size_t len, MultiVector<Vector>& mv) {
+  for (size_t i = 0; i < mv.n_vectors(); ++i) {
+    std::copy(buf + i * len, buf + (i + 1) * len, mv[i].memptr() + begin);
+  }
+}
+
+/** The number of elements per vector to pack at once,
+ *  if n_vectors vectors are packed together */
+inline size_t pack_chunk_length(const size_t n_vectors) {
+  return std::max<size_t>(64, block_ops_pack_size / std::max<size_t>(1, n_vectors));
+}
+
+/** Compute the Gram matrix by xgemm (or xsyrk if symmetric).
+ *  Returns false if BLAS is not available. */
+template <typename VectorU, typename VectorV>
+bool block_gram_blas(const MultiVector<VectorU>& u, const MultiVector<VectorV>& v,
+                     const bool symmetric, typename VectorU::scalar_type* c) {
+#ifdef LAZYTEN_HAVE_LAPACK
+  typedef typename VectorU::scalar_type scalar_type;
+  if (gram_blas(u, v, symmetric, c, std::true_type{})) return true;
+
+  // The vectors are scattered in memory: Pack them
+  const size_t k = u.n_vectors();
+  const size_t l = v.n_vectors();
+  const size_t chunk = pack_chunk_length(symmetric ? k : k + l);
+  std::vector<scalar_type> bu(chunk * k);
+  std::vector<scalar_type> bv(symmetric ? 0 : chunk * l);
+  std::vector<scalar_type> part(k * l, Constants<scalar_type>::zero);
+  std::fill(c, c + k * l, Constants<scalar_type>::zero);
+
+  for (size_t begin = 0; begin < u.n_elem(); begin += chunk) {
+    const size_t len = std::min(chunk, u.n_elem() - begin);
+    pack_rows(u, begin, len, bu.data());
+    if (symmetric) {
+      run_syrk_t(len, k, bu.data(), len, part.data());
+    } else {
+      pack_rows(v, begin, len, bv.data());
+      run_gemm_tn(len, k, l, bu.data(), len, bv.data(), len, part.data());
+    }
+    for (size_t i = 0; i < k * l; ++i) c[i] += part[i];
+  }
+  return true;
+#else
+  (void)u, (void)v, (void)symmetric, (void)c;
+  return false;
+#endif  // LAZYTEN_HAVE_LAPACK
+}
+
+template <typename VectorU, typename VectorV>
+void block_gram_dispatch(const MultiVector<VectorU>& u, const MultiVector<VectorV>& v,
+                         const bool symmetric, typename VectorU::scalar_type* c,
+                         std::true_type) {
+  if (!block_gram_blas(u, v, symmetric, c)) gram(u, v, symmetric, c, std::true_type{});
+}
+
+template <typename VectorU, typename VectorV>
+void block_gram_dispatch(const MultiVector<VectorU>& u, const MultiVector<VectorV>& v,
+                         const bool symmetric, typename VectorU::scalar_type* c,
+                         std::false_type) {
+  typedef typename std::remove_const<VectorU>::type vector_u_type;
+  gram(u, v, symmetric, c, IsMutableMemoryVector<vector_u_type>{});
+}
+
+/** Compute the matrix of all inner products between the vectors of u and v,
+ *  i.e. \f$ G_{ij} = \langle u_i | v_j \rangle \f$.
+ *
+ * The result is returned column-major with leading dimension u.n_vectors().
+ * If u and v are the same vectors, only half of the matrix is computed
+ * (by xsyrk) and mirrored.
+ */
+template <typename VectorU, typename VectorV>
+std::vector<typename VectorU::scalar_type> block_gram(const MultiVector<VectorU>& u,
+                                                      const MultiVector<VectorV>& v) {
+  typedef typename VectorU::scalar_type scalar_type;
+  typedef typename std::remove_const<VectorU>::type vector_u_type;
+  typedef typename std::remove_const<VectorV>::type vector_v_type;
+  static_assert(std::is_same<vector_u_type, vector_v_type>::value,
+                "The vectors of u and v need to be of the same type.");
+
+  const size_t k = u.n_vectors();
+  std::vector<scalar_type> ret(k * v.n_vectors());
+  if (ret.empty()) return ret;
+  assert_size(u.n_elem(), v.n_elem());
+  if (u.n_elem() == 0) return ret;
+
+  const bool symmetric = same_vectors(u, v);
+  typedef std::integral_constant<bool, IsMutableMemoryVector<vector_u_type>::value &&
+                                             IsBlasScalar<scalar_type>::value>
+        blas_type;
+  block_gram_dispatch(u, v, symmetric, ret.data(), blas_type{});
+
+  if (symmetric) {
+    for (size_t j = 0; j < k; ++j) {
+      for (size_t i = j + 1; i < k; ++i) ret[j * k + i] = ret[i * k + j];
+    }
+  }
+  return ret;
+}
+
+/** Form the linear combinations by xgemm. Returns false if BLAS
+ *  is not available. */
+template <typename VectorIn, typename VectorOut>
+bool block_combine_blas(const MultiVector<VectorIn>& in,
+                        const typename VectorIn::scalar_type* c, const size_t ldc,
+                        MultiVector<VectorOut>& out,
+                        const typename VectorIn::scalar_type c_out) {
+#ifdef LAZYTEN_HAVE_LAPACK
+  typedef typename VectorIn::scalar_type scalar_type;
+  const size_t k = in.n_vectors();
+  const size_t l = out.n_vectors();
+  const size_t ldin = memory_stride(in);
+  const size_t ldout = memory_stride(out);
+  if (ldin != 0 && ldout != 0) {
+    run_gemm_nn(in.n_elem(), k, l, in[0].memptr(), ldin, c, ldc, c_out,
+                out[0].memptr(), ldout);
+    return true;
+  }
+
+  // The vectors are scattered in memory: Pack them
+  const bool read_out = c_out != Constants<scalar_type>::zero;
+  const size_t chunk = pack_chunk_length(k + l);
+  std::vector<scalar_type> bin(chunk * k);
+  std::vector<scalar_type> bout(chunk * l);
+  for (size_t begin = 0; begin < in.n_elem(); begin += chunk) {
+    const size_t len = std::min(chunk, in.n_elem() - begin);
+    pack_rows(in, begin, len, bin.data());
+    if (read_out) pack_rows(out, begin, len, bout.data());
+    run_gemm_nn(len, k, l, bin.data(), len, c, ldc, c_out, bout.data(), len);
+    unpack_rows(bout.data(), begin, len, out);
+  }
+  return true;
+#else
+  (void)in, (void)c, (void)ldc, (void)out, (void)c_out;
+  return false;
+#endif  // LAZYTEN_HAVE_LAPACK
+}
+
+template <typename VectorIn, typename VectorOut>
+bool block_combine_dispatch(const MultiVector<VectorIn>& in,
+                            const typename VectorIn::scalar_type* c, const size_t ldc,
+                            MultiVector<VectorOut>& out,
+                            const typename VectorIn::scalar_type c_out, std::true_type) {
+  return block_combine_blas(in, c, ldc, out, c_out);
+}
+
+template <typename VectorIn, typename VectorOut>
+bool block_combine_dispatch(const MultiVector<VectorIn>&,
+                            const typename VectorIn::scalar_type*, const size_t,
+                            MultiVector<VectorOut>&, const typename VectorIn::scalar_type,
+                            std::false_type) {
+  return false;
+}
+
+/** Form linear combinations of a block of vectors, i.e. compute
+ *  \f[ \text{out}_j = c_\text{out} \text{out}_j + \sum_i \text{in}_i C_{ij}. \f]
+ *
+ * \param in     The input vectors
+ * \param c      Pointer to the coefficients, column-major with leading
+ *               dimension ldc. Column j is used for output vector j.
+ * \param ldc    Leading dimension of the coefficient array
+ *               (at least in.n_vectors())
+ * \param out    The output vectors. They may not share memory with in.
+ * \param c_out  Coefficient for the current content of out. If this is zero
+ *               the current content of out is never read.
+ */
+template <typename VectorIn, typename VectorOut>
+void block_combine(const MultiVector<VectorIn>& in,
+                   const typename VectorIn::scalar_type* c, const size_t ldc,
+                   MultiVector<VectorOut>& out,
+                   const typename VectorIn::scalar_type c_out = 0) {
+  typedef typename VectorIn::scalar_type scalar_type;
+  typedef typename std::remove_const<VectorIn>::type vector_in_type;
+  static_assert(std::is_same<vector_in_type, VectorOut>::value,
+                "The vectors of in and out need to be of the same type.");
+  assert_greater_equal(in.n_vectors(), ldc);
+  if (out.n_vectors() == 0) return;
+
+  if (in.n_vectors() > 0) {
+    assert_size(in.n_elem(), out.n_elem());
+
+    typedef std::integral_constant<bool, IsMutableMemoryVector<VectorOut>::value &&
+                                               IsBlasScalar<scalar_type>::value>
+          blas_type;
+    if (out.n_elem() == 0) return;
+    if (block_combine_dispatch(in, c, ldc, out, c_out, blas_type{})) return;
+  }
+
+  for (size_t j = 0; j < out.n_vectors(); ++j) {
+    auto& vout = out[j];
+    if (c_out != Constants<scalar_type>::one) scale_or_set(vout, c_out);
+
+    for (size_t i = 0; i < in.n_vectors(); ++i) {
+      const scalar_type cij = c[j * ldc + i];
+      if (cij == Constants<scalar_type>::zero) continue;
+
+      auto itout = std::begin(vout);
+      for (auto itin = std::begin(in[i]); itin != std::end(in[i]); ++itin, ++itout) {
+        *itout += cij * *itin;
+      }
+    }  // i
+  }    // j
+}
+
+/** Append shallow copies of all vectors of a MultiVector to another one */
+template <typename Vector, typename OtherVector>
+void block_append(MultiVector<Vector>& to, MultiVector<OtherVector>& from) {
+  for (size_t i = 0; i < from.n_vectors(); ++i) to.push_back(from.at_ptr(i));
+}
+
+}  // namespace detail
+}  // namespace lazyten
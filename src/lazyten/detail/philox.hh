@@ -0,0 +1,62 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace lazyten {
+namespace detail {
+
+/** Multiply two 32-bit words and return the high word, storing the low word in lo */
+inline uint32_t philox_mulhilo(uint32_t a, uint32_t b, uint32_t& lo) {
+  const uint64_t product = static_cast<uint64_t>(a) * static_cast<uint64_t>(b);
+  lo = static_cast<uint32_t>(product);
+  return static_cast<uint32_t>(product >> 32);
+}
+
+/** The Philox4x32-10 counter-based random bijection
+ *
+ * Maps a 128-bit counter and a 64-bit key to 128 pseudo-random bits.
+ * Distinct counters give statistically independent outputs, such that
+ * the n-th random number of a stream can be computed directly without
+ * generating all previous ones. See J. K. Salmon et al., "Parallel random
+ * numbers: As easy as 1, 2, 3", SC11 (2011) for details.
+ */
+inline std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> ctr,
+                                          std::array<uint32_t, 2> key) {
+  constexpr uint32_t mult0 = 0xD2511F53;
+  constexpr uint32_t mult1 = 0xCD9E8D57;
+  constexpr uint32_t weyl0 = 0x9E3779B9;
+  constexpr uint32_t weyl1 = 0xBB67AE85;
+
+  for (int round = 0; round < 10; ++round) {
+    if (round > 0) {
+      key[0] += weyl0;
+      key[1] += weyl1;
+    }
+    uint32_t lo0, lo1;
+    const uint32_t hi0 = philox_mulhilo(mult0, ctr[0], lo0);
+    const uint32_t hi1 = philox_mulhilo(mult1, ctr[2], lo1);
+    ctr = {{hi1 ^ ctr[1] ^ key[0], lo1, hi0 ^ ctr[3] ^ key[1], lo0}};
+  }
+  return ctr;
+}
+
+}  // namespace detail
+}  // namespace lazyten
@@ -0,0 +1,310 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+#include "lazyten/Constants.hh"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <krims/Algorithm.hh>
+#include <krims/ExceptionSystem.hh>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace lazyten {
+namespace detail {
+
+// Helper routines for the tiny dense symmetric eigenproblems, which
+// arise in the Rayleigh-Ritz steps of the native iterative eigensolvers.
+//
+// All matrices are expected as column-major std::vectors of size n*n.
+// The routines are deliberately free of any dependency on Lapack, since the
+// projected problems are only of the size of a few times the block size.
+
+/** Compute the Cholesky factorisation A = L L^T of a real symmetric
+ *  positive definite matrix in-place.
+ *
+ * Only the lower triangle of a is referenced. On return the lower
+ * triangle contains L and the strict upper triangle is zeroed.
+ *
+ * \returns false if a non-positive pivot was encountered, i.e. if the
+ *          matrix is not (numerically) positive definite.
+ */
+template <typename Scalar>
+bool small_cholesky(std::vector<Scalar>& a, const size_t n) {
+  static_assert(std::is_floating_point<Scalar>::value,
+                "Only implemented for real floating point types");
+  assert_size(a.size(), n * n);
+
+  for (size_t j = 0; j < n; ++j) {
+    Scalar diag = a[j * n + j];
+    for (size_t k = 0; k < j; ++k) diag -= a[k * n + j] * a[k * n + j];
+    if (!(diag > Constants<Scalar>::zero)) return false;
+    diag = std::sqrt(diag);
+    a[j * n + j] = diag;
+
+    for (size_t i = j + 1; i < n; ++i) {
+      Scalar sum = a[j * n + i];
+      for (size_t k = 0; k < j; ++k) sum -= a[k * n + i] * a[k * n + j];
+      a[j * n + i] = sum / diag;
+    }
+    for (size_t i = 0; i < j; ++i) a[j * n + i] = Constants<Scalar>::zero;
+  }
+  return true;
+}
+
+/** Solve a real symmetric eigenproblem using the cyclic Jacobi method.
+ *
+ * \param a       The matrix (copied in, only full storage is supported)
+ * \param n       The dimension
+ * \param evals   The eigenvalues, sorted ascendingly (resized by the function)
+ * \param evecs   The eigenvectors in column-major order, such that the i-th
+ *                column belongs to evals[i] (resized by the function)
+ */
+template <typename Scalar>
+void small_eigensystem_hermitian(std::vector<Scalar> a, const size_t n,
+                                 std::vector<Scalar>& evals, std::vector<Scalar>& evecs) {
+  static_assert(std::is_floating_point<Scalar>::value,
+                "Only implemented for real floating point types");
+  assert_size(a.size(), n * n);
+
+  std::vector<Scalar> v(n * n, Constants<Scalar>::zero);
+  for (size_t i = 0; i < n; ++i) v[i * n + i] = Constants<Scalar>::one;
+
+  const Scalar eps = Constants<Scalar>::default_tolerance;
+  const size_t max_sweeps = 100;
+  for (size_t sweep = 0; sweep < max_sweeps; ++sweep) {
+    Scalar off = 0;
+    Scalar frob = 0;
+    for (size_t q = 0; q < n; ++q) {
+      for (size_t p = 0; p < n; ++p) {
+        const Scalar sq = a[q * n + p] * a[q * n + p];
+        frob += sq;
+        if (p != q) off += sq;
+      }
+    }
+    if (off <= eps * eps * frob) break;
+
+    for (size_t p = 0; p + 1 < n; ++p) {
+      for (size_t q = p + 1; q < n; ++q) {
+        const Scalar apq = a[q * n + p];
+        if (std::abs(apq) <= eps * eps * std::sqrt(frob)) continue;
+
+        // Rotation angle which annihilates a(p,q)
+        const Scalar theta = (a[q * n + q] - a[p * n + p]) / (2 * apq);
+        const Scalar sgn = theta >= 0 ? Constants<Scalar>::one : -Constants<Scalar>::one;
+        const Scalar t = sgn / (std::abs(theta) + std::sqrt(theta * theta + 1));
+        const Scalar c = 1 / std::sqrt(t * t + 1);
+        const Scalar s = t * c;
+
+        // A <- A J  (columns p and q)
+        for (size_t k = 0; k < n; ++k) {
+          const Scalar akp = a[p * n + k];
+          const Scalar akq = a[q * n + k];
+          a[p * n + k] = c * akp - s * akq;
+          a[q * n + k] = s * akp + c * akq;
+        }
+        // A <- J^T A  (rows p and q)
+        for (size_t k = 0; k < n; ++k) {
+          const Scalar apk = a[k * n + p];
+          const Scalar aqk = a[k * n + q];
+          a[k * n + p] = c * apk - s * aqk;
+          a[k * n + q] = s * apk + c * aqk;
+        }
+        // V <- V J
+        for (size_t k = 0; k < n; ++k) {
+          const Scalar vkp = v[p * n + k];
+          const Scalar vkq = v[q * n + k];
+          v[p * n + k] = c * vkp - s * vkq;
+          v[q * n + k] = s * vkp + c * vkq;
+        }
+      }  // q
+    }    // p
+  }      // sweep
+
+  // Sort the eigenpairs ascendingly:
+  std::vector<Scalar> diag(n);
+  for (size_t i = 0; i < n; ++i) diag[i] = a[i * n + i];
+  const std::vector<size_t> idcs =
+        krims::argsort(std::begin(diag), std::end(diag), std::less<Scalar>());
+
+  evals.resize(n);
+  evecs.resize(n * n);
+  for (size_t i = 0; i < n; ++i) {
+    evals[i] = diag[idcs[i]];
+    std::copy(std::begin(v) + static_cast<ptrdiff_t>(idcs[i] * n),
+              std::begin(v) + static_cast<ptrdiff_t>((idcs[i] + 1) * n),
+              std::begin(evecs) + static_cast<ptrdiff_t>(i * n));
+  }
+}
+
+/** Solve a real symmetric generalised eigenproblem $A x = \lambda B x$
+ *  by a Cholesky reduction to standard form.
+ *
+ * The eigenvectors are returned B-orthonormal and the eigenvalues
+ * sorted ascendingly.
+ *
+ * \returns false if B was not found to be positive definite
+ *          (in which case evals and evecs are not touched)
+ */
+template <typename Scalar>
+bool small_eigensystem_hermitian(std::vector<Scalar> a, std::vector<Scalar> b,
+                                 const size_t n, std::vector<Scalar>& evals,
+                                 std::vector<Scalar>& evecs) {
+  assert_size(a.size(), n * n);
+  assert_size(b.size(), n * n);
+  if (!small_cholesky(b, n)) return false;
+  const std::vector<Scalar>& l = b;
+
+  // Compute C = L^{-1} A L^{-T} column by column:
+  // First Y = L^{-1} A by forward substitution on each column
+  for (size_t j = 0; j < n; ++j) {
+    for (size_t i = 0; i < n; ++i) {
+      Scalar sum = a[j * n + i];
+      for (size_t k = 0; k < i; ++k) sum -= l[k * n + i] * a[j * n + k];
+      a[j * n + i] = sum / l[i * n + i];
+    }
+  }
+  // Then C = L^{-1} Y^T, using the symmetry of A
+  std::vector<Scalar> c(n * n);
+  for (size_t j = 0; j < n; ++j) {
+    for (size_t i = 0; i < n; ++i) {
+      Scalar sum = a[i * n + j];
+      for (size_t k = 0; k < i; ++k) sum -= l[k * n + i] * c[j * n + k];
+      c[j * n + i] = sum / l[i * n + i];
+    }
+  }
+  // Symmetrise to kill the round-off:
+  for (size_t j = 0; j < n; ++j) {
+    for (size_t i = j + 1; i < n; ++i) {
+      const Scalar avg = (c[j * n + i] + c[i * n + j]) / 2;
+      c[j * n + i] = c[i * n + j] = avg;
+    }
+  }
+
+  small_eigensystem_hermitian(std::move(c), n, evals, evecs);
+
+  // Back-transform the eigenvectors: x = L^{-T} z
+  for (size_t j = 0; j < n; ++j) {
+    for (size_t ii = n; ii > 0; --ii) {
+      const size_t i = ii - 1;
+      Scalar sum = evecs[j * n + i];
+      for (size_t k = i + 1; k < n; ++k) sum -= l[i * n + k] * evecs[j * n + k];
+      evecs[j * n + i] = sum / l[i * n + i];
+    }
+  }
+  return true;
+}
+
+/** Compute the singular value decomposition A = U diag(sigma) V^T of a real
+ *  m x n matrix with m >= n using the one-sided Jacobi method.
+ *
+ * Pairs of columns of A are rotated until all columns are mutually
+ * orthogonal, which determines also small singular values to high
+ * relative accuracy.
+ *
+ * \param a      The matrix (column-major, copied in)
+ * \param m      The number of rows
+ * \param n      The number of columns
+ * \param sigma  The singular values, sorted descendingly (resized by the function)
+ * \param u      The m x n matrix of left singular vectors in column-major order.
+ *               Columns belonging to a zero singular value are zero.
+ *               (resized by the function)
+ * \param v      The n x n matrix of right singular vectors in column-major order
+ *               (resized by the function)
+ */
+template <typename Scalar>
+void small_svd(std::vector<Scalar> a, const size_t m, const size_t n,
+               std::vector<Scalar>& sigma, std::vector<Scalar>& u,
+               std::vector<Scalar>& v) {
+  static_assert(std::is_floating_point<Scalar>::value,
+                "Only implemented for real floating point types");
+  assert_size(a.size(), m * n);
+  assert_greater_equal(n, m);
+
+  std::vector<Scalar> w(n * n, Constants<Scalar>::zero);
+  for (size_t i = 0; i < n; ++i) w[i * n + i] = Constants<Scalar>::one;
+
+  const Scalar eps = std::numeric_limits<Scalar>::epsilon();
+  const size_t max_sweeps = 100;
+  for (size_t sweep = 0; sweep < max_sweeps; ++sweep) {
+    bool rotated = false;
+    for (size_t p = 0; p + 1 < n; ++p) {
+      for (size_t q = p + 1; q < n; ++q) {
+        Scalar alpha = 0, beta = 0, gamma = 0;
+        for (size_t k = 0; k < m; ++k) {
+          alpha += a[p * m + k] * a[p * m + k];
+          beta += a[q * m + k] * a[q * m + k];
+          gamma += a[p * m + k] * a[q * m + k];
+        }
+        if (std::abs(gamma) <= eps * std::sqrt(alpha * beta)) continue;
+        rotated = true;
+
+        // Rotation angle which makes columns p and q orthogonal
+        const Scalar zeta = (beta - alpha) / (2 * gamma);
+        const Scalar sgn = zeta >= 0 ? Constants<Scalar>::one : -Constants<Scalar>::one;
+        const Scalar t = sgn / (std::abs(zeta) + std::sqrt(zeta * zeta + 1));
+        const Scalar c = 1 / std::sqrt(t * t + 1);
+        const Scalar s = t * c;
+
+        for (size_t k = 0; k < m; ++k) {
+          const Scalar akp = a[p * m + k];
+          const Scalar akq = a[q * m + k];
+          a[p * m + k] = c * akp - s * akq;
+          a[q * m + k] = s * akp + c * akq;
+        }
+        for (size_t k = 0; k < n; ++k) {
+          const Scalar wkp = w[p * n + k];
+          const Scalar wkq = w[q * n + k];
+          w[p * n + k] = c * wkp - s * wkq;
+          w[q * n + k] = s * wkp + c * wkq;
+        }
+      }  // q
+    }    // p
+    if (!rotated) break;
+  }  // sweep
+
+  // The column norms are the singular values
+  std::vector<Scalar> norms(n);
+  for (size_t j = 0; j < n; ++j) {
+    Scalar sum = 0;
+    for (size_t k = 0; k < m; ++k) sum += a[j * m + k] * a[j * m + k];
+    norms[j] = std::sqrt(sum);
+  }
+  const std::vector<size_t> idcs =
+        krims::argsort(std::begin(norms), std::end(norms), std::greater<Scalar>());
+
+  sigma.resize(n);
+  u.assign(m * n, Constants<Scalar>::zero);
+  v.resize(n * n);
+  for (size_t j = 0; j < n; ++j) {
+    const size_t jj = idcs[j];
+    sigma[j] = norms[jj];
+    if (sigma[j] > Constants<Scalar>::zero) {
+      for (size_t k = 0; k < m; ++k) u[j * m + k] = a[jj * m + k] / sigma[j];
+    }
+    std::copy(std::begin(w) + static_cast<ptrdiff_t>(jj * n),
+              std::begin(w) + static_cast<ptrdiff_t>((jj + 1) * n),
+              std::begin(v) + static_cast<ptrdiff_t>(j * n));
+  }
+}
+
+}  // namespace detail
+}  // namespace lazyten
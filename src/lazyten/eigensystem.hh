@@ -18,9 +18,13 @@
 //
 
 #pragma once
+#include "BlockDiagonalEigensolution.hh"
 #include "BlockDiagonalMatrix.hh"
 #include "EigensystemSolver.hh"
+#include "Lapack/LapackBatchedEigensolver.hh"
+#include "detail/balanced_parallel_for.hh"
 #include <iterator>
+#include <thread>
 
 namespace lazyten {
 
@@ -60,6 +64,10 @@ EigensolutionTypeFor<true, Matrix> eigensystem_hermitian(
  *       of blocks. This array shall contain the number of
  *        eigenpairs to be seeked in each block.
  *
+ * \note The blocks are solved in parallel, see
+ *       eigensystem_hermitian_blocks. Use this function instead
+ *       to avoid the zero-padding of the eigenvectors.
+ *
  * \note The interface of this function is very likely to change
  *       again in the near future. Especially the meaning
  *       of n_ep could change.
@@ -111,11 +119,15 @@ EigensolutionTypeFor<true, MatrixA> eigensystem_hermitian(
  *             the blocks with earlier blocks getting a larger
  *             part of the share to break the tie.
  *
- * \note The key n_ep_per_block in the parametermap can be used
+ * \note The key n_ep_block in the parametermap can be used
  *       to supply an array<size_t, N>, where N is the number
  *       of blocks. This array shall contain the number of
  *        eigenpairs to be seeked in each block.
  *
+ * \note The blocks are solved in parallel, see
+ *       eigensystem_hermitian_blocks. Use this function instead
+ *       to avoid the zero-padding of the eigenvectors.
+ *
  * \note The interface of this function is very likely to change
  *       again in the near future. Especially the meaning
  *       of n_ep could change.
@@ -128,6 +140,53 @@ EigensolutionTypeFor<true, BlockMatrixA> eigensystem_hermitian(
                               size_t>::type n_ep = Constants<size_t>::all,
       const krims::GenMap& map = krims::GenMap());
 
+/** Solve a Hermitian eigensystem in blocked form, keeping the eigenvectors
+ *  in block-sparse form.
+ *
+ * The eigenproblems of the individual blocks are solved concurrently.
+ * Each block is solved by the EigensystemSolver with the parameters
+ * provided in \t map. The blocks are scheduled by their estimated cost,
+ * most expensive first.
+ *
+ * \param n_ep Total number of eigenpairs to obtain.
+ *             The number will be evenly spread between
+ *             the blocks with earlier blocks getting a larger
+ *             part of the share to break the tie.
+ *
+ * \note The key n_ep_per_block in the parametermap can be used
+ *       to supply an array<size_t, N>, where N is the number
+ *       of blocks. This array shall contain the number of
+ *       eigenpairs to be seeked in each block.
+ *
+ * \note The key EigensystemSolverKeys::n_block_threads in the parametermap
+ *       can be used to supply the maximal number of threads (of type size_t)
+ *       to use for solving the blocks. With a value of 1 the blocks
+ *       are solved one after the other. By default as many threads as
+ *       there are hardware threads are used. Since ARPACK is not
+ *       reentrant, its solves are always serialised, such that no speedup
+ *       can be expected for blocks solved by ARPACK.
+ */
+template <typename BlockMatrix>
+BlockDiagonalEigensolutionTypeFor<true, BlockMatrix> eigensystem_hermitian_blocks(
+      const BlockMatrix& A,
+      typename std::enable_if<IsBlockDiagonalMatrix<BlockMatrix>::value, size_t>::type
+            n_ep = Constants<size_t>::all,
+      const krims::GenMap& map = krims::GenMap());
+
+/** Solve a generalised Hermitian eigensystem in blocked form, keeping the
+ *  eigenvectors in block-sparse form.
+ *
+ * See the non-generalised version for details. The only difference is that
+ * the key to supply the number of eigenpairs per block is n_ep_block.
+ */
+template <typename BlockMatrixA, typename BlockMatrixB>
+BlockDiagonalEigensolutionTypeFor<true, BlockMatrixA> eigensystem_hermitian_blocks(
+      const BlockMatrixA& A, const BlockMatrixB& B,
+      typename std::enable_if<IsBlockDiagonalMatrix<BlockMatrixA>::value &&
+                                    IsBlockDiagonalMatrix<BlockMatrixB>::value,
+                              size_t>::type n_ep = Constants<size_t>::all,
+      const krims::GenMap& map = krims::GenMap());
+
 /** Solve a normal eigensystem
  *
  * The Parameter map \t map may be used to provide configurable parameters
@@ -197,50 +256,7 @@ EigensolutionTypeFor<true, BlockMatrix> eigensystem_hermitian(
       typename std::enable_if<IsBlockDiagonalMatrix<BlockMatrix>::value, size_t>::type
             n_ep,
       const krims::GenMap& map) {
-  typedef typename EigensolutionTypeFor<true, BlockMatrix>::evector_type evector_type;
-
-  // How many eigenpairs to compute per block
-  const size_t n_ep_per_block = n_ep / A.diag_blocks().size();
-  const size_t n_ep_rest = n_ep - n_ep_per_block * A.diag_blocks().size();
-
-  std::array<size_t, BlockMatrix::n_blocks> n_ep_block;
-  if (map.exists("n_ep_per_block")) {
-    n_ep_block = map.at<std::array<size_t, BlockMatrix::n_blocks>>("n_ep_per_block");
-  } else {
-    for (auto it = std::begin(n_ep_block); it < std::end(n_ep_block); ++it) {
-      const size_t b_idx = it - std::begin(n_ep_block);
-      *it = n_ep_per_block + (b_idx < n_ep_rest ? 1 : 0);
-    }
-  }
-
-  EigensolutionTypeFor<true, BlockMatrix> ret;
-
-  // Solve individual problems:
-  auto it_nep = std::begin(n_ep_block);
-  size_t begin_index = 0;  // of the current block
-  for (auto it = std::begin(A.diag_blocks()); it != std::end(A.diag_blocks());
-       ++it, ++it_nep) {
-    auto block_soln = eigensystem_hermitian(*it, *it_nep, map);
-    assert_internal(block_soln.n_ep() == *it_nep);
-
-    // Lambda to pad the vector with zeros at beginning and end
-    auto pad_with_zeros = [&begin_index, &A](const evector_type& v) {
-      evector_type padded(A.n_cols());
-      std::copy(v.begin(), v.end(), padded.begin() + begin_index);
-      return padded;
-    };
-
-    // Copy into solution data structure and pad the eigenvectors with zeros
-    std::copy(block_soln.evalues().begin(), block_soln.evalues().end(),
-              std::back_inserter(ret.evalues()));
-    std::transform(block_soln.evectors().begin(), block_soln.evectors().end(),
-                   std::back_inserter(ret.evectors()), pad_with_zeros);
-
-    begin_index += it->n_rows();
-  }
-  assert_internal(begin_index == A.n_rows());
-
-  return ret;
+  return eigensystem_hermitian_blocks(A, n_ep, map).padded();
 }
 
 template <typename MatrixA, typename MatrixB>
@@ -263,55 +279,125 @@ EigensolutionTypeFor<true, BlockMatrixA> eigensystem_hermitian(
                                     IsBlockDiagonalMatrix<BlockMatrixB>::value,
                               size_t>::type n_ep,
       const krims::GenMap& map) {
-  static_assert(BlockMatrixA::n_blocks == BlockMatrixB::n_blocks,
-                "The number of blocks has to agree.");
-
-  // How many eigenpairs to compute per block
-  const size_t n_ep_per_block = n_ep / A.diag_blocks().size();
-  const size_t n_ep_rest = n_ep - n_ep_per_block * A.diag_blocks().size();
+  return eigensystem_hermitian_blocks(A, B, n_ep, map).padded();
+}
 
-  std::array<size_t, BlockMatrixA::n_blocks> n_ep_block;
-  if (map.exists("n_ep_block")) {
-    n_ep_block = map.at<std::array<size_t, BlockMatrixA::n_blocks>>("n_ep_block");
+namespace detail {
+/** Determine the number of eigenpairs to compute in each block.
+ *
+ * If the key is present in the map, the array stored there is used,
+ * else n_ep is evenly spread between the blocks with earlier blocks
+ * getting a larger part of the share to break the tie. */
+template <size_t N>
+std::array<size_t, N> n_ep_per_block(size_t n_ep, const krims::GenMap& map,
+                                     const std::string& key) {
+  std::array<size_t, N> n_ep_block;
+  if (map.exists(key)) {
+    n_ep_block = map.at<std::array<size_t, N>>(key);
   } else {
-    for (auto it = std::begin(n_ep_block); it < std::end(n_ep_block); ++it) {
-      const size_t b_idx = it - std::begin(n_ep_block);
-      *it = n_ep_per_block + (b_idx < n_ep_rest ? 1 : 0);
+    const size_t n_ep_per_block = n_ep / N;
+    const size_t n_ep_rest = n_ep - n_ep_per_block * N;
+    for (size_t b = 0; b < N; ++b) {
+      n_ep_block[b] = n_ep_per_block + (b < n_ep_rest ? 1 : 0);
     }
   }
+  return n_ep_block;
+}
+
+/** Estimated cost of solving the eigenproblem of a block of size dim
+ *  for n_ep eigenpairs (in arbitrary units).
+ *
+ * The blocks typically are small enough to be solved by a dense method,
+ * hence we use the dim^3 scaling of a dense diagonalisation.
+ */
+inline double estimated_block_cost(size_t dim, size_t n_ep) {
+  const double d = static_cast<double>(dim);
+  return n_ep == 0 ? 0. : d * d * d;
+}
+
+/** The number of threads to use for solving the blocks.
+ *
+ * By default this is the number of hardware threads for all methods.
+ * ARPACK keeps its state in Fortran SAVE variables, but its solves are
+ * serialised by the ArpackEigensolver, such that this is safe for "auto"
+ * and "arpack" as well.
+ */
+inline size_t n_block_threads(const krims::GenMap& map) {
+  const size_t n_default = std::max(1u, std::thread::hardware_concurrency());
+  return map.at(EigensystemSolverKeys::n_block_threads, n_default);
+}
+}  // namespace detail
+
+template <typename BlockMatrix>
+BlockDiagonalEigensolutionTypeFor<true, BlockMatrix> eigensystem_hermitian_blocks(
+      const BlockMatrix& A,
+      typename std::enable_if<IsBlockDiagonalMatrix<BlockMatrix>::value, size_t>::type
+            n_ep,
+      const krims::GenMap& map) {
+  constexpr size_t N = BlockMatrix::n_blocks;
+  const std::array<size_t, N> n_ep_block =
+        detail::n_ep_per_block<N>(n_ep, map, "n_ep_per_block");
 
-  typedef typename EigensolutionTypeFor<true, BlockMatrixA>::evector_type evector_type;
-  EigensolutionTypeFor<true, BlockMatrixA> ret;
+  BlockDiagonalEigensolutionTypeFor<true, BlockMatrix> ret;
+  ret.dim = A.n_cols();
+
+  std::vector<double> costs(N);
+  size_t begin_index = 0;  // of the current block
+  for (size_t b = 0; b < N; ++b) {
+    ret.block_offsets[b] = begin_index;
+    costs[b] = detail::estimated_block_cost(A.diag_blocks()[b].n_rows(), n_ep_block[b]);
+    begin_index += A.diag_blocks()[b].n_rows();
+  }
+  assert_internal(begin_index == A.n_rows());
 
   // Solve individual problems:
-  auto it_nep = std::begin(n_ep_block);
-  auto itb = std::begin(B.diag_blocks());
+  auto solve_block = [&A, &map, &n_ep_block, &ret](size_t b) {
+    ret.blocks[b] = eigensystem_hermitian(A.diag_blocks()[b], n_ep_block[b], map);
+    assert_internal(ret.blocks[b].n_ep() == n_ep_block[b]);
+  };
+  detail::balanced_parallel_for(costs, detail::n_block_threads(map), solve_block);
+
+  return ret;
+}
+
+template <typename BlockMatrixA, typename BlockMatrixB>
+BlockDiagonalEigensolutionTypeFor<true, BlockMatrixA> eigensystem_hermitian_blocks(
+      const BlockMatrixA& A, const BlockMatrixB& B,
+      typename std::enable_if<IsBlockDiagonalMatrix<BlockMatrixA>::value &&
+                                    IsBlockDiagonalMatrix<BlockMatrixB>::value,
+                              size_t>::type n_ep,
+      const krims::GenMap& map) {
+  static_assert(BlockMatrixA::n_blocks == BlockMatrixB::n_blocks,
+                "The number of blocks has to agree.");
+  constexpr size_t N = BlockMatrixA::n_blocks;
+  const std::array<size_t, N> n_ep_block =
+        detail::n_ep_per_block<N>(n_ep, map, "n_ep_block");
+
+  BlockDiagonalEigensolutionTypeFor<true, BlockMatrixA> ret;
+  ret.dim = A.n_cols();
+
+  std::vector<double> costs(N);
   size_t begin_index = 0;  // of the current block
-  for (auto ita = std::begin(A.diag_blocks()); ita != std::end(A.diag_blocks());
-       ++itb, ++ita, ++it_nep) {
-    assert_size(ita->n_cols(), itb->n_cols());
-    assert_size(ita->n_rows(), itb->n_rows());
-
-    auto block_soln = eigensystem_hermitian(*ita, *itb, *it_nep, map);
-    assert_internal(block_soln.n_ep() == std::min(*it_nep, ita->n_rows()));
-
-    // Lambda to pad the vector with zeros at beginning and end
-    auto pad_with_zeros = [&begin_index, &A](const evector_type& v) {
-      evector_type padded(A.n_cols());
-      std::copy(v.begin(), v.end(), padded.begin() + begin_index);
-      return padded;
-    };
-
-    // Copy into solution data structure and pad the eigenvectors with zeros
-    std::copy(block_soln.evalues().begin(), block_soln.evalues().end(),
-              std::back_inserter(ret.evalues()));
-    std::transform(block_soln.evectors().begin(), block_soln.evectors().end(),
-                   std::back_inserter(ret.evectors()), pad_with_zeros);
-
-    begin_index += ita->n_cols();
+  for (size_t b = 0; b < N; ++b) {
+    const auto& a_block = A.diag_blocks()[b];
+    assert_size(a_block.n_cols(), B.diag_blocks()[b].n_cols());
+    assert_size(a_block.n_rows(), B.diag_blocks()[b].n_rows());
+
+    ret.block_offsets[b] = begin_index;
+    costs[b] = detail::estimated_block_cost(a_block.n_cols(), n_ep_block[b]);
+    begin_index += a_block.n_cols();
   }
   assert_internal(begin_index == A.n_cols());
 
+  // Solve individual problems:
+  auto solve_block = [&A, &B, &map, &n_ep_block, &ret](size_t b) {
+    const auto& a_block = A.diag_blocks()[b];
+    ret.blocks[b] =
+          eigensystem_hermitian(a_block, B.diag_blocks()[b], n_ep_block[b], map);
+    assert_internal(ret.blocks[b].n_ep() == std::min(n_ep_block[b], a_block.n_rows()));
+  };
+  detail::balanced_parallel_for(costs, detail::n_block_threads(map), solve_block);
+
   return ret;
 }
 
@@ -20,78 +20,429 @@
 #pragma once
 #include "Matrix_i.hh"
 #include "MultiVector.hh"
+#include "detail/block_ops.hh"
+#include <krims/Functionals.hh>
 #include <krims/GenMap.hh>
 #include <krims/TypeUtils/EnableIfLibrary.hh>
+#include <complex>
+#include <limits>
 
 namespace lazyten {
 
 DefException1(ExcInvalidInnerProduct, std::string, << arg1);
+DefException1(ExcInvalidOrthoParameters, std::string, << arg1);
+DefException1(ExcLinearlyDependentVectors, size_t,
+              << "Could not orthonormalise the " << arg1
+              << " vectors, since they are (numerically) linearly dependent.");
 
-/** Orthonormalise a set of vectors with respect to an orthogonalisation function
+/** Class which contains all GenMap keys which are understood
+ *  by the ortho functions as static string members.
+ *  See their doc strings for the types required. */
+struct OrthoKeys {
+  /** The orthonormalisation method to use. Type: std::string */
+  static const std::string method;
+
+  /** The number of vectors processed as one block by the "cgs2" method.
+   *  Type: size_t */
+  static const std::string block_size;
+};
+
+namespace detail {
+/** Compute the Cholesky factorisation G = R^H R of a Hermitian positive
+ *  definite matrix in-place.
  *
- * The inner product function is expected to take two arguments of the
- * type MultiVector<Vector> and return a matrix of values which are the
- * inner products of each vector with each other.
- **/
-template <typename Vector, typename InnerProduct,
-          typename = krims::enable_if_t<!IsMatrix<krims::decay_t<InnerProduct>>::value>>
-MultiVector<Vector> ortho(const MultiVector<Vector>& vs, InnerProduct&& prod,
-                          const krims::GenMap& /*params*/ = krims::GenMap()) {
+ * On return the upper triangle of g (column-major) contains R and the
+ * strict lower triangle is zeroed.
+ *
+ * \returns false if a non-positive pivot was encountered.
+ */
+template <typename Scalar>
+bool ortho_cholesky(std::vector<Scalar>& g, const size_t n) {
+  krims::ConjFctr conj{};
+  for (size_t j = 0; j < n; ++j) {
+    auto diag = std::real(g[j * n + j]);
+    for (size_t k = 0; k < j; ++k) diag -= std::norm(g[j * n + k]);
+    if (!(diag > 0)) return false;
+    diag = std::sqrt(diag);
+    g[j * n + j] = diag;
+
+    for (size_t i = j + 1; i < n; ++i) {
+      Scalar sum = g[i * n + j];
+      for (size_t k = 0; k < j; ++k) sum -= conj(g[j * n + k]) * g[i * n + k];
+      g[i * n + j] = sum / diag;
+    }
+    for (size_t i = j + 1; i < n; ++i) g[j * n + i] = Constants<Scalar>::zero;
+  }
+  return true;
+}
+
+/** Invert an upper triangular matrix (column-major) in-place */
+template <typename Scalar>
+void ortho_invert_upper(std::vector<Scalar>& r, const size_t n) {
+  // Column j of the inverse only needs the inverse of the leading
+  // j x j block, which is already done, and column j of R.
+  for (size_t j = 0; j < n; ++j) {
+    const Scalar inv_diag = Constants<Scalar>::one / r[j * n + j];
+    r[j * n + j] = inv_diag;
+    for (size_t i = 0; i < j; ++i) {
+      Scalar sum = Constants<Scalar>::zero;
+      for (size_t k = i; k < j; ++k) sum += r[k * n + i] * r[j * n + k];
+      r[j * n + i] = -sum * inv_diag;
+    }
+  }
+}
+
+/** Evaluate a user-provided inner product function on two blocks of vectors
+ *  and return the resulting matrix column-major (as detail::block_gram) */
+template <typename Vector, typename InnerProduct>
+std::vector<typename Vector::scalar_type> ortho_product_gram(
+      InnerProduct& prod, const MultiVector<Vector>& u, const MultiVector<Vector>& v) {
+  const size_t k = u.n_vectors();
+  const auto innprods = prod(u, v);
+  assert_internal(innprods.n_rows() == k && innprods.n_cols() == v.n_vectors());
+
+  std::vector<typename Vector::scalar_type> ret(k * v.n_vectors());
+  for (size_t j = 0; j < v.n_vectors(); ++j) {
+    for (size_t i = 0; i < k; ++i) ret[j * k + i] = innprods(i, j);
+  }
+  return ret;
+}
+
+/** Replace the Gram matrix g of n vectors (column-major) in-place by
+ *  R^{-1}, where G + shift = R^H R. Only the upper triangle of G is read.
+ *
+ * \param gram_trace  Set to the trace of G
+ * \returns false if the Cholesky factorisation failed.
+ */
+template <typename Scalar, typename Real>
+bool cholqr_inverse_factor(std::vector<Scalar>& g, const size_t n, const Real shift,
+                           Real& gram_trace) {
+  assert_internal(g.size() == n * n);
+  gram_trace = 0;
+  for (size_t j = 0; j < n; ++j) {
+    gram_trace += std::abs(g[j * n + j]);
+    g[j * n + j] += shift;
+  }
+  if (!ortho_cholesky(g, n)) return false;
+  ortho_invert_upper(g, n);
+  return true;
+}
+
+/** Perform one pass of Cholesky QR on the vectors v, i.e. replace v by
+ *  V R^{-1}, where G + shift = R^H R and G is the Gram matrix of v returned
+ *  by the functor gram. The metric is applied once to the whole block.
+ *
+ * \param gram_trace  Set to the trace of G
+ * \returns false if the Cholesky factorisation failed (v is not touched).
+ */
+template <typename Vector, typename Gram>
+bool cholqr_pass(MultiVector<Vector>& v, Gram& gram,
+                 const typename Vector::real_type shift,
+                 typename Vector::real_type& gram_trace) {
   typedef typename Vector::scalar_type scalar_type;
-  using lazyten::as_multivector;
-  // TODO For now this is plain and stupid Gram-Schmidt
-  //      Better use svd or Householder reflections once they are there.
+  const size_t n = v.n_vectors();
 
-  if (vs.n_vectors() == 0) return vs;
+  std::vector<scalar_type> r = gram(v, v);
+  if (!cholqr_inverse_factor(r, n, shift, gram_trace)) return false;
+
+  MultiVector<Vector> q(v.n_elem(), n, false);
+  block_combine(v, r.data(), n, q);
+  v = std::move(q);
+  return true;
+}
+
+/** Run the passes of CholQR2 on a block of n vectors with m elements each,
+ *  where pass(shift, gram_trace) performs one pass of Cholesky QR like
+ *  cholqr_pass. If the vectors are too ill-conditioned for the first pass,
+ *  a shifted pass is performed first (shifted CholeskyQR3).
+ *
+ * \returns false if a pass failed, i.e. the vectors are numerically
+ *          linearly dependent.
+ */
+template <typename Real, typename Pass>
+bool cholqr2_passes(const size_t m, const size_t n, Pass&& pass) {
+  if (n == 0) return true;
+
+  Real trace;
+  if (!pass(Real(0), trace)) {
+    // Shift by a multiple of the round-off in the Gram matrix,
+    // using its trace as an estimate for its norm.
+    const Real mr = static_cast<Real>(m);
+    const Real shift =
+          11 * (mr * n + n * (n + 1)) * std::numeric_limits<Real>::epsilon() * trace;
+    if (!pass(shift, trace) || !pass(Real(0), trace)) return false;
+  }
+  return pass(Real(0), trace);
+}
+
+/** Orthonormalise the vectors v in-place by CholQR2, i.e. two passes of
+ *  Cholesky QR (see cholqr2_passes).
+ */
+template <typename Vector, typename Gram>
+void cholqr2(MultiVector<Vector>& v, Gram& gram) {
+  typedef typename Vector::real_type real_type;
+  const size_t n = v.n_vectors();
+  if (n == 0) return;
+
+  auto pass = [&v, &gram](const real_type shift, real_type& trace) {
+    return cholqr_pass(v, gram, shift, trace);
+  };
+  assert_throw(cholqr2_passes<real_type>(v.n_elem(), n, pass),
+               ExcLinearlyDependentVectors(n));
+}
 
-  // For now this is just a (slow) modified Gram-Schmidt procedure.
+/** Orthonormalise by block classical Gram-Schmidt with reorthogonalisation
+ *  (BCGS2). Each block is projected twice against all previous blocks and
+ *  then orthonormalised within itself by CholQR2. */
+template <typename Vector, typename Gram>
+MultiVector<Vector> ortho_bcgs2(const MultiVector<Vector>& vs, Gram& gram,
+                                const size_t block_size) {
+  typedef typename Vector::scalar_type scalar_type;
   MultiVector<Vector> done;
   done.reserve(vs.n_vectors());
 
-  // Deal with first vector:
-  done.push_back(Vector(vs[0]));
-  auto norm0 = as_scalar(prod(as_multivector(vs[0]), as_multivector(vs[0])));
-  assert_dbg(norm0 >= 0, ExcInvalidInnerProduct("<v|v> needs to be non-negative."));
-  done[0] /= std::sqrt(norm0);
-
-  for (size_t i = 1; i < vs.n_vectors(); ++i) {
-    // Compute inner products with all vectors we had so far:
-    auto innprods = prod(as_multivector(vs[i]), done);
-    assert_internal(innprods.n_rows() == 1);
-    assert_internal(innprods.n_cols() == i);
-
-    done.push_back(Vector(vs[i]));
-    assert_internal(done.n_vectors() == i + 1);
-    for (size_t j = 0; j < i; ++j) {
-      auto j_norm = as_scalar(prod(as_multivector(done[j]), as_multivector(done[j])));
-      assert_dbg(j_norm >= 0, ExcInvalidInnerProduct("<v|v> needs to be non-negative."));
-      done[i] -= innprods[j] * done[j] / j_norm;
+  for (size_t begin = 0; begin < vs.n_vectors(); begin += block_size) {
+    const size_t end = std::min(begin + block_size, vs.n_vectors());
+    MultiVector<Vector> block;
+    block.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) block.push_back(Vector(vs[i]));
+
+    for (size_t pass = 0; done.n_vectors() > 0 && pass < 2; ++pass) {
+      // block -= done * <done|block>
+      std::vector<scalar_type> c = gram(done, block);
+      for (auto& elem : c) elem = -elem;
+      block_combine(done, c.data(), done.n_vectors(), block,
+                    Constants<scalar_type>::one);
     }
-    scalar_type norm = as_scalar(prod(as_multivector(done[i]), as_multivector(done[i])));
-    assert_dbg(norm >= 0, ExcInvalidInnerProduct("<v|v> needs to be non-negative."));
-    done[i] /= std::sqrt(norm);
+
+    cholqr2(block, gram);
+    block_append(done, block);
   }
   return done;
 }
 
+/** Householder QR of the n x k column-major array a by the blocked LAPACK
+ *  routines xgeqrf and xungqr, i.e. by BLAS-3 operations. On return a
+ *  contains Q and r_diag the diagonal of R.
+ *
+ * \returns false if LAPACK is not available.
+ */
+template <typename Scalar>
+bool householder_lapack(std::vector<Scalar>& a, const size_t n, const size_t k,
+                        std::vector<Scalar>& r_diag, std::true_type) {
+#ifdef LAZYTEN_HAVE_LAPACK
+  std::vector<Scalar> tau(k);
+  int info = 0;
+  run_geqrf(n, k, a.data(), n, tau.data(), info);
+  assert_internal(info == 0);
+  for (size_t j = 0; j < k; ++j) r_diag[j] = a[j * n + j];
+
+  run_ungqr(n, k, a.data(), n, tau.data(), info);
+  assert_internal(info == 0);
+  return true;
+#else
+  (void)a, (void)n, (void)k, (void)r_diag;
+  return false;
+#endif  // LAZYTEN_HAVE_LAPACK
+}
+
+template <typename Scalar>
+bool householder_lapack(std::vector<Scalar>&, const size_t, const size_t,
+                        std::vector<Scalar>&, std::false_type) {
+  return false;
+}
+
+/** Householder QR of the n x k column-major array a reflector by reflector.
+ *  Used if LAPACK is not available, same interface as householder_lapack. */
+template <typename Scalar>
+void householder_unblocked(std::vector<Scalar>& a, const size_t n, const size_t k,
+                           std::vector<Scalar>& r_diag) {
+  typedef decltype(std::abs(Scalar{})) real_type;
+  krims::ConjFctr conj{};
+
+  std::vector<real_type> beta(k, 0);  // 2 / |v_j|^2 or 0 if no reflection
+  for (size_t j = 0; j < k; ++j) {
+    Scalar* x = &a[j * n];
+    real_type norm_x = 0;
+    for (size_t i = j; i < n; ++i) norm_x += std::norm(x[i]);
+    norm_x = std::sqrt(norm_x);
+    r_diag[j] = Constants<Scalar>::zero;
+    if (norm_x == 0) continue;
+
+    // v = x - alpha e_j with alpha = -sign(x_j) |x|, which avoids cancellation
+    const real_type abs_xj = std::abs(x[j]);
+    const Scalar sign = abs_xj == 0 ? Constants<Scalar>::one : x[j] / abs_xj;
+    r_diag[j] = -sign * norm_x;
+    x[j] -= r_diag[j];
+
+    real_type norm_v = 0;
+    for (size_t i = j; i < n; ++i) norm_v += std::norm(x[i]);
+    beta[j] = 2 / norm_v;
+
+    // Apply the reflection to the remaining columns
+    for (size_t l = j + 1; l < k; ++l) {
+      Scalar* col = &a[l * n];
+      Scalar w = 0;
+      for (size_t i = j; i < n; ++i) w += conj(x[i]) * col[i];
+      w *= beta[j];
+      for (size_t i = j; i < n; ++i) col[i] -= w * x[i];
+    }
+  }
+
+  // Form Q = H_0 H_1 ... H_{k-1} I[:, :k] by backward accumulation
+  std::vector<Scalar> q(n * k, Constants<Scalar>::zero);
+  for (size_t l = 0; l < k; ++l) {
+    Scalar* col = &q[l * n];
+    col[l] = Constants<Scalar>::one;
+    for (size_t j = std::min(l + 1, k); j-- > 0;) {
+      if (beta[j] == 0) continue;
+      const Scalar* v = &a[j * n];
+      Scalar w = 0;
+      for (size_t i = j; i < n; ++i) w += conj(v[i]) * col[i];
+      w *= beta[j];
+      for (size_t i = j; i < n; ++i) col[i] -= w * v[i];
+    }
+  }
+  a.swap(q);
+}
+
+/** Orthonormalise with respect to the Euclidean inner product by
+ *  Householder QR. The resulting vectors are scaled such that the
+ *  diagonal of R is real and positive (as for the Gram-Schmidt-like
+ *  methods). */
+template <typename Vector>
+MultiVector<Vector> ortho_householder(const MultiVector<Vector>& vs) {
+  typedef typename Vector::scalar_type scalar_type;
+  const size_t n = vs.n_elem();
+  const size_t k = vs.n_vectors();
+  assert_greater_equal(k, n);
+
+  // Copy into a column-major array, which is overwritten by Q
+  std::vector<scalar_type> a(n * k);
+  for (size_t j = 0; j < k; ++j) std::copy(vs[j].begin(), vs[j].end(), &a[j * n]);
+
+  std::vector<scalar_type> r_diag(k);
+  if (!householder_lapack(a, n, k, r_diag, IsBlasScalar<scalar_type>{})) {
+    householder_unblocked(a, n, k, r_diag);
+  }
+
+  MultiVector<Vector> q;
+  q.reserve(k);
+  for (size_t l = 0; l < k; ++l) {
+    // Make the diagonal of R positive
+    scalar_type* col = &a[l * n];
+    if (r_diag[l] != Constants<scalar_type>::zero) {
+      const scalar_type phase = r_diag[l] / std::abs(r_diag[l]);
+      for (size_t i = 0; i < n; ++i) col[i] *= phase;
+    }
+
+    q.push_back(Vector(vs[l]));
+    std::copy(col, col + n, q[l].begin());
+  }
+  return q;
+}
+
+/** Orthonormalise a set of vectors by the method selected in params, where
+ *  gram is a functor returning the Gram matrix of two blocks of vectors
+ *  column-major (as detail::block_gram). */
+template <typename Vector, typename Gram>
+MultiVector<Vector> ortho_gram(const MultiVector<Vector>& vs, Gram&& gram,
+                               const krims::GenMap& params) {
+  if (vs.n_vectors() == 0) return vs;
+
+  const std::string method = params.at(OrthoKeys::method, std::string("cholqr2"));
+  if (method == "cgs2") {
+    const size_t block_size = params.at(OrthoKeys::block_size, size_t(16));
+    assert_throw(block_size > 0,
+                 ExcInvalidOrthoParameters("The block size needs to be positive."));
+    return ortho_bcgs2(vs, gram, block_size);
+  }
+
+  assert_throw(method == "cholqr2",
+               ExcInvalidOrthoParameters("The orthonormalisation method " + method +
+                                         " is unknown or not available with an inner "
+                                         "product function."));
+  MultiVector<Vector> ret;
+  ret.reserve(vs.n_vectors());
+  for (size_t i = 0; i < vs.n_vectors(); ++i) ret.push_back(Vector(vs[i]));
+  cholqr2(ret, gram);
+  return ret;
+}
+}  // namespace detail
+
+/** Orthonormalise a set of vectors with respect to an orthogonalisation function
+ *
+ * The inner product function is expected to take two arguments of the
+ * type MultiVector<Vector> and return a matrix of values which are the
+ * inner products of each vector with each other.
+ *
+ * All methods only evaluate the inner product function on whole blocks of
+ * vectors, such that a metric is applied once per block and not once per
+ * pair of vectors. The span of the first k vectors is kept for all k
+ * (i.e. the result is the Q of a QR factorisation).
+ *
+ * ## Parameters and their default values
+ *   - method: The method to use. Default: "cholqr2"; allowed values:
+ *       - "cholqr2"  Two passes of Cholesky QR on the full set, with a
+ *                    shifted first pass for ill-conditioned sets.
+ *                    Fastest, evaluates the inner product on the full set
+ *                    twice (four times for ill-conditioned sets).
+ *       - "cgs2"     Block classical Gram-Schmidt with reorthogonalisation
+ *                    and CholQR2 within each block.
+ *       - "householder" Householder QR (blocked by LAPACK if available).
+ *                    Most robust, but only available for the Euclidean
+ *                    inner product, i.e. the ortho function without metric.
+ *   - block_size: Block size for "cgs2". Default: 16
+ *
+ * \throws ExcLinearlyDependentVectors if the vectors are found to be
+ *          (numerically) linearly dependent.
+ **/
+template <typename Vector, typename InnerProduct,
+          typename = krims::enable_if_t<!IsMatrix<krims::decay_t<InnerProduct>>::value>>
+MultiVector<Vector> ortho(const MultiVector<Vector>& vs, InnerProduct&& prod,
+                          const krims::GenMap& params = krims::GenMap()) {
+  return detail::ortho_gram(
+        vs,
+        [&prod](const MultiVector<Vector>& u, const MultiVector<Vector>& v) {
+          return detail::ortho_product_gram(prod, u, v);
+        },
+        params);
+}
+
 /** Orthonormalise a set of vectors with respect to a metric matrix,
- *  i.e. the goal of the function is to make the set of vectors M-orthogonal. */
+ *  i.e. the goal of the function is to make the set of vectors M-orthogonal.
+ *
+ *  The Gram matrices are computed by detail::block_gram, i.e. by xgemm
+ *  if BLAS is available. */
 template <typename Vector, typename Matrix,
           typename = krims::enable_if_t<IsMatrix<krims::decay_t<Matrix>>::value>>
 MultiVector<Vector> ortho(const MultiVector<Vector>& vs, const Matrix& m,
                           const krims::GenMap& params = krims::GenMap()) {
-  return ortho(vs, [&m](const MultiVector<const Vector>& v1,
-                        const MultiVector<const Vector>& v2) { return dot(v1, m * v2); },
-               params);
+  return detail::ortho_gram(
+        vs,
+        [&m](const MultiVector<Vector>& u, const MultiVector<Vector>& v) {
+          return detail::block_gram(u, m * v);
+        },
+        params);
 }
 
-/** Orthonormalise a set of vectors with respect to the identity matrix */
+/** Orthonormalise a set of vectors with respect to the identity matrix
+ *
+ *  The Gram matrices are computed by detail::block_gram, i.e. by xsyrk or
+ *  xgemm if BLAS is available. */
 template <typename Vector>
 MultiVector<Vector> ortho(const MultiVector<Vector>& vs,
                           const krims::GenMap& params = krims::GenMap()) {
-  return ortho(vs, [](const MultiVector<const Vector>& v1,
-                      const MultiVector<const Vector>& v2) { return dot(v1, v2); },
-               params);
+  if (params.at(OrthoKeys::method, std::string("cholqr2")) == "householder") {
+    if (vs.n_vectors() == 0) return vs;
+    return detail::ortho_householder(vs);
+  }
+  return detail::ortho_gram(
+        vs,
+        [](const MultiVector<Vector>& u, const MultiVector<Vector>& v) {
+          return detail::block_gram(u, v);
+        },
+        params);
 }
 
 }  // namespace lazyten
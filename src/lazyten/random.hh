@@ -19,10 +19,18 @@
 
 #pragma once
 #include "Base/Interfaces.hh"
+#include "MultiVector.hh"
 #include "StoredMatrix_i.hh"
+#include "detail/balanced_parallel_for.hh"
+#include "detail/philox.hh"
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <krims/TypeUtils.hh>
+#include <limits>
 #include <random>
+#include <thread>
 
 namespace lazyten {
 
@@ -93,16 +101,212 @@ T random() {
 }
 //@}
 
+/** The distributions supported by CounterRandomScalar */
+enum class RandomDistribution {
+  /** Uniform in the range [min,max) */
+  Uniform,
+
+  /** Normal distribution of given mean and standard deviation */
+  Normal,
+};
+
+/** Counter-based generator of random scalar values
+ *
+ * In contrast to RandomScalar the generated values are not drawn from
+ * a sequential engine, but the value with index i is a pure function
+ * of the seed and i (using the Philox4x32-10 bijection). Hence the values
+ * can be generated in any order or in parallel and the result only
+ * depends on the seed.
+ *
+ * For complex scalars real and imaginary part are both drawn from
+ * the selected distribution.
+ *
+ * \note The values are only pseudorandom and *not* cryptographically
+ *       safe in any way.
+ */
+template <typename T>
+class CounterRandomScalar {
+ public:
+  typedef T scalar_type;
+  typedef typename krims::RealTypeOf<T>::type real_type;
+  static_assert(std::is_floating_point<real_type>::value,
+                "T needs to be a floating point or a complex value here.");
+
+  /** Construct a generator for values uniformly distributed in the
+   *  range [min,max), by default [-100,100) like RandomScalar. */
+  explicit CounterRandomScalar(uint64_t seed, real_type min = -100, real_type max = 100)
+        : CounterRandomScalar(seed, RandomDistribution::Uniform, min, max) {}
+
+  /** Construct a generator for normally distributed values */
+  static CounterRandomScalar normal(uint64_t seed, real_type mean = 0,
+                                    real_type stddev = 1) {
+    return CounterRandomScalar(seed, RandomDistribution::Normal, mean, stddev);
+  }
+
+  /** Return the random value with the given index */
+  T operator()(uint64_t index) const;
+
+  /** The seed of this generator */
+  uint64_t seed() const { return m_seed; }
+
+  /** The distribution the values are drawn from */
+  RandomDistribution distribution() const { return m_distribution; }
+
+ private:
+  CounterRandomScalar(uint64_t seed, RandomDistribution distribution, real_type a,
+                      real_type b)
+        : m_seed(seed), m_distribution(distribution), m_a(a), m_b(b) {
+    assert_dbg(distribution != RandomDistribution::Uniform || a < b,
+               krims::ExcInvalidState("Empty range for uniform distribution"));
+    assert_dbg(distribution != RandomDistribution::Normal || b >= 0,
+               krims::ExcInvalidState("Standard deviation may not be negative"));
+  }
+
+  /** Convert 64 random bits to a real value in [0,1) */
+  static real_type to_unit(uint32_t high, uint32_t low);
+
+  /** Make a real or a complex value out of the two values */
+  static T make_value(real_type x, real_type, std::false_type) { return x; }
+  static T make_value(real_type x, real_type y, std::true_type) { return T(x, y); }
+
+  uint64_t m_seed;
+  RandomDistribution m_distribution;
+
+  /** Min and max for uniform, mean and stddev for normal distributions */
+  real_type m_a;
+  real_type m_b;
+};
+
+namespace detail {
+/** Number of elements filled per task in fill_random */
+constexpr size_t random_fill_chunk_size = 16384;
+
+/** Return a new seed for random(), which is distinct on each call. */
+inline uint64_t next_random_seed() {
+  static std::atomic<uint64_t> seed{static_cast<uint64_t>(
+        std::chrono::system_clock::now().time_since_epoch().count())};
+  return seed++;
+}
+
+/** Fill the elements [0, n_elem) of each of the stored vectors or matrices
+ *  pointed to by ptrs, such that element i of object k is assigned
+ *  gen(offset + k * n_elem + i), using n_threads threads. */
+template <typename Stored, typename Scalar>
+void fill_random_chunked(const std::vector<Stored*>& ptrs, size_t n_elem,
+                         const CounterRandomScalar<Scalar>& gen, size_t n_threads,
+                         uint64_t offset) {
+  const size_t n_chunks = (n_elem + random_fill_chunk_size - 1) / random_fill_chunk_size;
+  std::vector<double> costs(ptrs.size() * n_chunks, 1.);
+  balanced_parallel_for(costs, n_threads, [&](size_t task) {
+    const size_t k = task / n_chunks;
+    const size_t begin = (task % n_chunks) * random_fill_chunk_size;
+    const size_t end = std::min(n_elem, begin + random_fill_chunk_size);
+    Stored& stored = *ptrs[k];
+    for (size_t i = begin; i < end; ++i) stored[i] = gen(offset + k * n_elem + i);
+  });
+}
+}  // namespace detail
+
+/** Fill a stored vector or matrix with random values from gen.
+ *
+ * Element i (in row-major order for matrices) is assigned the value
+ * gen(offset + i). The work is split into chunks processed by n_threads
+ * threads, but the result is the same for any number of threads.
+ */
+template <typename Stored, typename Scalar,
+          typename Enabled = krims::enable_if_t<IsStoredVector<Stored>::value ||
+                                                IsStoredMatrix<Stored>::value>>
+void fill_random(Stored& stored, const CounterRandomScalar<Scalar>& gen,
+                 size_t n_threads = std::thread::hardware_concurrency(),
+                 uint64_t offset = 0) {
+  detail::fill_random_chunked(std::vector<Stored*>{&stored}, stored.n_elem(), gen,
+                              n_threads, offset);
+}
+
+/** Fill all vectors of a MultiVector with random values from gen.
+ *
+ * Element i of vector k is assigned gen(offset + k * mv.n_elem() + i),
+ * which is again independent of the number of threads used.
+ */
+template <typename Stored, typename Scalar,
+          typename Enabled = krims::enable_if_t<IsStoredVector<Stored>::value>>
+void fill_random(MultiVector<Stored>& mv, const CounterRandomScalar<Scalar>& gen,
+                 size_t n_threads = std::thread::hardware_concurrency(),
+                 uint64_t offset = 0) {
+  std::vector<Stored*> ptrs;
+  ptrs.reserve(mv.n_vectors());
+  for (size_t k = 0; k < mv.n_vectors(); ++k) ptrs.push_back(&mv[k]);
+  detail::fill_random_chunked(ptrs, mv.n_elem(), gen, n_threads, offset);
+}
+
 /** Return a random indexable constructed from the passed argument
- *  and filled with random values generated using a RandomScalar functor
- *  in the default range */
+ *  and filled (in parallel) with random values uniformly distributed
+ *  in the default range [-100,100). A new seed is used on each call.*/
 template <typename Stored, typename... Args,
           typename Enabled = krims::enable_if_t<IsStoredVector<Stored>::value ||
                                                 IsStoredMatrix<Stored>::value>>
 Stored random(Args&&... args) {
   Stored stored(std::forward<Args>(args)...);
-  std::generate(stored.begin(), stored.end(),
-                RandomScalar<typename Stored::scalar_type>{});
+  fill_random(stored, CounterRandomScalar<typename Stored::scalar_type>{
+                            detail::next_random_seed()});
+  return stored;
+}
+
+/** Return a random indexable constructed from the passed argument
+ *  and filled (in parallel) with standard normally distributed values.
+ *  A new seed is used on each call.*/
+template <typename Stored, typename... Args,
+          typename Enabled = krims::enable_if_t<IsStoredVector<Stored>::value ||
+                                                IsStoredMatrix<Stored>::value>>
+Stored random_normal(Args&&... args) {
+  Stored stored(std::forward<Args>(args)...);
+  fill_random(stored, CounterRandomScalar<typename Stored::scalar_type>::normal(
+                            detail::next_random_seed()));
   return stored;
 }
+
+//
+// ---------------------------------------------------------------
+//
+
+template <typename T>
+typename CounterRandomScalar<T>::real_type CounterRandomScalar<T>::to_unit(
+      uint32_t high, uint32_t low) {
+  // Use as many of the bits as fit into the mantissa, such that
+  // the conversion is exact and 1 can never be reached.
+  constexpr int digits = std::numeric_limits<real_type>::digits < 64
+                               ? std::numeric_limits<real_type>::digits
+                               : 64;
+  const uint64_t bits = (static_cast<uint64_t>(high) << 32) | low;
+  return std::ldexp(static_cast<real_type>(bits >> (64 - digits)), -digits);
+}
+
+template <typename T>
+T CounterRandomScalar<T>::operator()(uint64_t index) const {
+  const std::array<uint32_t, 4> ctr{{static_cast<uint32_t>(index),
+                                     static_cast<uint32_t>(index >> 32), 0, 0}};
+  const std::array<uint32_t, 2> key{
+        {static_cast<uint32_t>(m_seed), static_cast<uint32_t>(m_seed >> 32)}};
+  const std::array<uint32_t, 4> bits = detail::philox4x32(ctr, key);
+  const real_type u1 = to_unit(bits[0], bits[1]);
+  const real_type u2 = to_unit(bits[2], bits[3]);
+  const std::integral_constant<bool, krims::IsComplexNumber<T>::value> is_complex{};
+
+  if (m_distribution == RandomDistribution::Normal) {
+    // Box-Muller transform (1 - u1 is in (0,1], such that the log is finite)
+    const real_type two_pi = 2 * std::acos(real_type(-1));
+    const real_type r = std::sqrt(-2 * std::log(1 - u1));
+    const real_type phi = two_pi * u2;
+    return make_value(m_a + m_b * r * std::cos(phi), m_a + m_b * r * std::sin(phi),
+                      is_complex);
+  }
+
+  // Guard against rounding up to the (excluded) upper bound
+  const auto in_range = [this](real_type u) {
+    const real_type x = m_a + (m_b - m_a) * u;
+    return x < m_b ? x : std::nextafter(m_b, m_a);
+  };
+  return make_value(in_range(u1), in_range(u2), is_complex);
+}
+
 }  // namespace lazyten
@@ -0,0 +1,186 @@
+//
+// Copyright (C) 2017 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+#pragma once
+#include "LazyMatrixExpression.hh"
+#include "LowRankMatrix.hh"
+#include "detail/small_eigensystem.hh"
+#include "ortho.hh"
+#include "random.hh"
+#include <krims/GenMap.hh>
+
+namespace lazyten {
+
+DefException1(ExcInvalidRandomisedSvdParameters, std::string, << arg1);
+DefExceptionMsg(ExcRandomisedSvdNeedsTranspose,
+                "The randomised SVD needs to apply the transpose of the matrix, "
+                "but the matrix does not support a transpose operation mode "
+                "(has_transpose_operation_mode() returned false).");
+
+/** Class which contains all GenMap keys which are understood by
+ *  randomised_range_finder and randomised_svd as static string members.
+ *  See their doc strings for the types required. */
+struct RandomisedSvdKeys {
+  /** The number of additional test vectors used to sample the range of
+   *  the matrix in randomised_svd, which improves the accuracy of the
+   *  trailing singular values. Type: size_t */
+  static const std::string oversampling;
+
+  /** The number of power iterations, i.e. the number of times the
+   *  subspace is improved by an application of $A A^T$. Required for
+   *  matrices, whose singular values decay slowly. Type: size_t */
+  static const std::string n_power_iterations;
+
+  /** The seed to generate the Gaussian test vectors from.
+   *  By default a new seed is used on each call. Type: size_t */
+  static const std::string seed;
+};
+
+namespace detail {
+/** Orthonormalise a set of vectors with respect to the Euclidean inner product
+ *  using Householder QR, which is stable also for numerically rank-deficient
+ *  samples of the range */
+template <typename Vector>
+MultiVector<Vector> range_ortho(const MultiVector<Vector>& vs) {
+  return ortho_householder(vs);
+}
+}  // namespace detail
+
+/** Find an orthonormal basis Q approximating the range of a matrix.
+ *
+ * The matrix is applied to a block of n_vectors Gaussian random vectors
+ * and the result is orthonormalised. Optionally the basis is improved by
+ * a number of power iterations, each applying the matrix and its transpose
+ * once to the whole block. After q power iterations the error
+ * $\| A - Q Q^T A \|$ decays like $(\sigma_{k+1} / \sigma_k)^{2q+1}$.
+ *
+ * See N. Halko, P. G. Martinsson, J. A. Tropp, SIAM Review 53, 217 (2011)
+ * for details.
+ *
+ * ## Parameters and their default values
+ *   - n_power_iterations: Number of power iterations. Default: 2
+ *   - seed:  Seed for the Gaussian test vectors. Default: New seed on each call.
+ */
+template <typename StoredMatrix>
+MultiVector<typename StoredMatrix::vector_type> randomised_range_finder(
+      const LazyMatrixExpression<StoredMatrix>& A, const size_t n_vectors,
+      const krims::GenMap& params = krims::GenMap()) {
+  typedef typename StoredMatrix::vector_type vector_type;
+  typedef typename StoredMatrix::scalar_type scalar_type;
+  static_assert(std::is_floating_point<scalar_type>::value,
+                "The randomised range finder is only implemented for real matrices");
+  assert_throw(n_vectors <= std::min(A.n_rows(), A.n_cols()),
+               ExcInvalidRandomisedSvdParameters(
+                     "The number of vectors cannot exceed the smaller dimension "
+                     "of the matrix."));
+
+  const size_t n_power_iterations =
+        params.at(RandomisedSvdKeys::n_power_iterations, size_t(2));
+  const size_t seed = params.at(RandomisedSvdKeys::seed,
+                                static_cast<size_t>(detail::next_random_seed()));
+  assert_throw(n_power_iterations == 0 || A.has_transpose_operation_mode(),
+               ExcRandomisedSvdNeedsTranspose());
+  if (n_vectors == 0) return MultiVector<vector_type>(A.n_rows(), 0);
+
+  // Sample the range with a block of Gaussian test vectors
+  MultiVector<vector_type> omega(A.n_cols(), n_vectors, false);
+  fill_random(omega, CounterRandomScalar<scalar_type>::normal(seed));
+  MultiVector<vector_type> y(A.n_rows(), n_vectors, false);
+  A.apply(omega, y);
+  MultiVector<vector_type> q = detail::range_ortho(y);
+
+  // Power iterations, orthonormalising after each application for stability
+  MultiVector<vector_type> z(A.n_cols(), n_vectors, false);
+  for (size_t it = 0; it < n_power_iterations; ++it) {
+    A.apply(q, z, Transposed::Trans);
+    z = detail::range_ortho(z);
+    A.apply(z, y);
+    q = detail::range_ortho(y);
+  }
+  return q;
+}
+
+/** Compute an approximate truncated singular value decomposition
+ *  $A \approx U \, \text{diag}(\sigma) \, V^T$ of the given rank
+ *  by randomised sampling.
+ *
+ * The range of A is approximated by randomised_range_finder using
+ * rank + oversampling vectors. The matrix is then projected onto this
+ * basis $Q$ and the small projected matrix $B = Q^T A$ is decomposed
+ * by a dense SVD (via a QR factorisation of $B^T$). The matrix A is only
+ * used via applications (in normal and transpose mode) to blocks of
+ * vectors, such that this is suitable for large lazy matrices.
+ *
+ * The returned LowRankMatrix has orthonormal left and right factors
+ * (the singular vectors) and the weights are the singular values
+ * in descending order.
+ *
+ * ## Parameters and their default values
+ *   - oversampling: Number of extra test vectors. Default: 10
+ *   - n_power_iterations: Number of power iterations. Default: 2
+ *   - seed:  Seed for the Gaussian test vectors. Default: New seed on each call.
+ */
+template <typename StoredMatrix>
+LowRankMatrix<StoredMatrix> randomised_svd(
+      const LazyMatrixExpression<StoredMatrix>& A, const size_t rank,
+      const krims::GenMap& params = krims::GenMap()) {
+  typedef typename StoredMatrix::vector_type vector_type;
+  typedef typename StoredMatrix::scalar_type scalar_type;
+  static_assert(std::is_floating_point<scalar_type>::value,
+                "The randomised SVD is only implemented for real matrices");
+  assert_throw(A.has_transpose_operation_mode(), ExcRandomisedSvdNeedsTranspose());
+
+  const size_t max_rank = std::min(A.n_rows(), A.n_cols());
+  assert_throw(rank <= max_rank,
+               ExcInvalidRandomisedSvdParameters(
+                     "The rank cannot exceed the smaller dimension of the matrix."));
+  const size_t oversampling = params.at(RandomisedSvdKeys::oversampling, size_t(10));
+  const size_t n_samples = std::min(rank + oversampling, max_rank);
+
+  if (rank == 0) {
+    return LowRankMatrix<StoredMatrix>(MultiVector<vector_type>(A.n_rows(), 0), {},
+                                       MultiVector<vector_type>(A.n_cols(), 0));
+  }
+
+  // Basis for the range and B^T = A^T Q
+  const MultiVector<vector_type> q = randomised_range_finder(A, n_samples, params);
+  MultiVector<vector_type> bt(A.n_cols(), n_samples, false);
+  A.apply(q, bt, Transposed::Trans);
+
+  // B^T = Q2 R  =>  A ~ Q B = Q R^T Q2^T
+  const MultiVector<vector_type> q2 = detail::range_ortho(bt);
+  const auto r = dot(q2, bt);
+
+  // SVD of the small matrix R^T = W diag(sigma) Z^T
+  std::vector<scalar_type> rt(n_samples * n_samples);
+  for (size_t j = 0; j < n_samples; ++j) {
+    for (size_t i = 0; i < n_samples; ++i) rt[j * n_samples + i] = r(j, i);
+  }
+  std::vector<scalar_type> sigma, w, z;
+  detail::small_svd(std::move(rt), n_samples, n_samples, sigma, w, z);
+
+  // A ~ (Q W) diag(sigma) (Q2 Z)^T, truncated to the requested rank
+  sigma.resize(rank);
+  MultiVector<vector_type> u(A.n_rows(), rank, false);
+  MultiVector<vector_type> v(A.n_cols(), rank, false);
+  detail::block_combine(q, w.data(), n_samples, u);
+  detail::block_combine(q2, z.data(), n_samples, v);
+  return LowRankMatrix<StoredMatrix>(std::move(u), std::move(sigma), std::move(v));
+}
+
+}  // namespace lazyten
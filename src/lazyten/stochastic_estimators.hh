@@ -0,0 +1,343 @@
+//
+// Copyright (C) 2017 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+#pragma once
+#include "LazyMatrixExpression.hh"
+#include "detail/balanced_parallel_for.hh"
+#include "detail/block_ops.hh"
+#include "random.hh"
+#include "randomised_svd.hh"
+#include <krims/GenMap.hh>
+#include <limits>
+
+namespace lazyten {
+
+DefException1(ExcInvalidStochasticEstimatorParameters, std::string, << arg1);
+
+/** Class which contains all GenMap keys which are understood by
+ *  estimate_trace and estimate_diagonal as static string members.
+ *  See their doc strings for the types required. */
+struct StochasticEstimatorKeys {
+  /** The method to use for the trace estimation, i.e. "hutchinson"
+   *  or "hutchpp". Type: std::string */
+  static const std::string method;
+
+  /** The total number of probe vectors, i.e. the number of times the matrix
+   *  is applied to a vector. Type: size_t */
+  static const std::string n_probes;
+
+  /** The number of probe vectors, which are applied to the matrix at once
+   *  in a single block apply. Type: size_t */
+  static const std::string block_size;
+
+  /** The maximal number of threads used to process probe blocks
+   *  in parallel. Type: size_t */
+  static const std::string n_threads;
+
+  /** The seed to generate the random probe vectors from.
+   *  By default a new seed is used on each call. Type: size_t */
+  static const std::string seed;
+};
+
+/** Result of a stochastic trace estimation */
+template <typename Scalar>
+struct TraceEstimate {
+  /** The estimated trace */
+  Scalar trace;
+
+  /** The standard error of the estimate, i.e. the estimated standard
+   *  deviation of trace from the exact trace. */
+  Scalar error;
+
+  /** The number of matrix applies (to a single vector) used */
+  size_t n_applies;
+};
+
+/** Result of a stochastic diagonal estimation */
+template <typename Vector>
+struct DiagonalEstimate {
+  /** The estimated diagonal */
+  Vector diagonal;
+
+  /** The standard error of each element of the estimated diagonal */
+  Vector error;
+
+  /** The number of matrix applies (to a single vector) used */
+  size_t n_applies;
+};
+
+namespace detail {
+/** The parameters shared by all stochastic estimators */
+struct StochasticEstimatorParameters {
+  size_t n_probes;
+  size_t block_size;
+  size_t n_threads;
+  uint64_t seed;
+
+  explicit StochasticEstimatorParameters(const krims::GenMap& params)
+        : n_probes(params.at(StochasticEstimatorKeys::n_probes, size_t(64))),
+          block_size(params.at(StochasticEstimatorKeys::block_size, size_t(8))),
+          n_threads(params.at(StochasticEstimatorKeys::n_threads,
+                              size_t(std::max(1u, std::thread::hardware_concurrency())))),
+          seed(params.at(StochasticEstimatorKeys::seed,
+                         static_cast<size_t>(next_random_seed()))) {
+    assert_throw(block_size > 0, ExcInvalidStochasticEstimatorParameters(
+                                       "The block size needs to be positive."));
+  }
+
+  /** The number of probe blocks needed for n probes */
+  size_t n_blocks(size_t n) const { return (n + block_size - 1) / block_size; }
+
+  /** The number of probes in block b out of n probes in total */
+  size_t n_in_block(size_t b, size_t n) const {
+    return std::min(block_size, n - b * block_size);
+  }
+};
+
+/** Fill the vectors of mv with Rademacher random vectors, i.e. with
+ *  elements of +1 or -1 with equal probability. Element i of vector k
+ *  only depends on the seed and on offset + k * mv.n_elem() + i. */
+template <typename Vector>
+void fill_rademacher(MultiVector<Vector>& mv, uint64_t seed, uint64_t offset) {
+  typedef typename Vector::scalar_type scalar_type;
+  fill_random(mv, CounterRandomScalar<scalar_type>(seed, -1, 1), 1, offset);
+  for (auto& vec : mv) {
+    for (auto& elem : vec) elem = elem < 0 ? scalar_type(-1) : scalar_type(1);
+  }
+}
+
+/** Return the mean of the samples and the standard error of the mean */
+template <typename Scalar>
+std::pair<Scalar, Scalar> mean_and_error(const std::vector<Scalar>& samples) {
+  const size_t n = samples.size();
+  Scalar mean = 0;
+  for (const Scalar& s : samples) mean += s;
+  mean /= static_cast<Scalar>(n);
+  if (n < 2) return {mean, std::numeric_limits<Scalar>::infinity()};
+
+  Scalar variance = 0;
+  for (const Scalar& s : samples) variance += (s - mean) * (s - mean);
+  variance /= static_cast<Scalar>(n - 1);
+  return {mean, std::sqrt(variance / static_cast<Scalar>(n))};
+}
+
+/** Compute the quadratic forms z^T A z for n_probes Rademacher probes z,
+ *  which are projected onto the orthogonal complement of the orthonormal
+ *  vectors q before applying A. The probe blocks are processed in parallel,
+ *  but the result is independent of the number of threads. */
+template <typename StoredMatrix>
+std::vector<typename StoredMatrix::scalar_type> hutchinson_samples(
+      const LazyMatrixExpression<StoredMatrix>& A,
+      const MultiVector<typename StoredMatrix::vector_type>& q, size_t n_probes,
+      const StochasticEstimatorParameters& par, uint64_t seed) {
+  typedef typename StoredMatrix::vector_type vector_type;
+  typedef typename StoredMatrix::scalar_type scalar_type;
+  const size_t n = A.n_cols();
+
+  std::vector<scalar_type> samples(n_probes);
+  const size_t n_blocks = par.n_blocks(n_probes);
+  balanced_parallel_for(std::vector<double>(n_blocks, 1.), par.n_threads, [&](size_t b) {
+    const size_t n_vectors = par.n_in_block(b, n_probes);
+    MultiVector<vector_type> z(n, n_vectors, false);
+    fill_rademacher(z, seed, b * par.block_size * n);
+
+    if (q.n_vectors() > 0) {
+      // z -= q q^T z
+      std::vector<scalar_type> c = block_gram(q, z);
+      for (auto& elem : c) elem = -elem;
+      block_combine(q, c.data(), q.n_vectors(), z, Constants<scalar_type>::one);
+    }
+
+    MultiVector<vector_type> az(n, n_vectors, false);
+    A.apply(z, az);
+    for (size_t j = 0; j < n_vectors; ++j) {
+      samples[b * par.block_size + j] = dot(z[j], az[j]);
+    }
+  });
+  return samples;
+}
+}  // namespace detail
+
+/** Estimate the trace of a square matrix stochastically using only
+ *  applies of the matrix to blocks of random probe vectors.
+ *
+ * Two methods are available:
+ *   - "hutchinson": The trace is the mean of the quadratic forms
+ *     $z^T A z$ for Rademacher random vectors z. The error decays like
+ *     $1 / \sqrt{n_probes}$.
+ *   - "hutchpp": Hutch++ (R. A. Meyer, C. Musco, C. Musco, D. P. Woodruff,
+ *     SOSA 2021, 142). A third of the probes is used to find an
+ *     orthonormal basis Q of the dominant range of A (see
+ *     randomised_range_finder), for which $\text{tr}(Q^T A Q)$ is computed
+ *     exactly. Another third is used for $A Q$ and the rest for a
+ *     Hutchinson estimate of the trace of the remainder
+ *     $(I - QQ^T) A (I - QQ^T)$.
+ *     For matrices with decaying eigenvalues (e.g. positive semi-definite
+ *     matrices) the error decays like $1 / n_probes$.
+ *
+ * The error bar is the standard error of the stochastic part of the
+ * estimate, computed from the sample variance of the probes. The probe
+ * blocks are processed in parallel, so the apply function of A needs
+ * to be safe to call from several threads at once. The result only
+ * depends on the seed, not on the number of threads.
+ *
+ * Only real matrices are supported at the moment.
+ *
+ * ## Parameters and their default values
+ *   - method:  "hutchinson" or "hutchpp". Default: "hutchpp"
+ *   - n_probes:  Number of matrix-vector applies to use. Default: 64
+ *   - block_size:  Number of probes applied at once. Default: 8
+ *   - n_threads:  Maximal number of threads. Default: Number of hardware threads
+ *   - seed:  Seed for the probe vectors. Default: New seed on each call.
+ */
+template <typename StoredMatrix>
+TraceEstimate<typename StoredMatrix::scalar_type> estimate_trace(
+      const LazyMatrixExpression<StoredMatrix>& A,
+      const krims::GenMap& params = krims::GenMap()) {
+  typedef typename StoredMatrix::vector_type vector_type;
+  typedef typename StoredMatrix::scalar_type scalar_type;
+  static_assert(std::is_floating_point<scalar_type>::value,
+                "Stochastic estimators are only implemented for real matrices");
+  assert_size(A.n_rows(), A.n_cols());
+
+  const detail::StochasticEstimatorParameters par(params);
+  const std::string method =
+        params.at(StochasticEstimatorKeys::method, std::string("hutchpp"));
+
+  if (method == "hutchinson") {
+    assert_throw(par.n_probes >= 2,
+                 ExcInvalidStochasticEstimatorParameters(
+                       "Hutchinson's method needs at least 2 probes."));
+    const MultiVector<vector_type> no_projection(A.n_rows(), 0);
+    const auto res = detail::mean_and_error(
+          detail::hutchinson_samples(A, no_projection, par.n_probes, par, par.seed));
+    return {res.first, res.second, par.n_probes};
+  }
+
+  assert_throw(method == "hutchpp",
+               ExcInvalidStochasticEstimatorParameters("Unknown method: " + method));
+  assert_throw(par.n_probes >= 6, ExcInvalidStochasticEstimatorParameters(
+                                        "Hutch++ needs at least 6 probes."));
+
+  // Exact trace on the sampled dominant range
+  const size_t n_range = std::min(par.n_probes / 3, A.n_rows());
+  const krims::GenMap range_params{{RandomisedSvdKeys::n_power_iterations, size_t(0)},
+                                   {RandomisedSvdKeys::seed, size_t(par.seed)}};
+  const auto q = randomised_range_finder(A, n_range, range_params);
+  MultiVector<vector_type> aq(A.n_rows(), n_range, false);
+  A.apply(q, aq);
+  scalar_type trace = 0;
+  for (size_t i = 0; i < n_range; ++i) trace += dot(q[i], aq[i]);
+  if (n_range == A.n_rows()) return {trace, scalar_type(0), 2 * n_range};
+
+  // Hutchinson on the remainder, with a seed distinct from the range finder
+  const size_t n_residual = par.n_probes - 2 * n_range;
+  const auto res = detail::mean_and_error(
+        detail::hutchinson_samples(A, q, n_residual, par, par.seed + 1));
+  return {trace + res.first, res.second, par.n_probes};
+}
+
+/** Estimate the diagonal of a square matrix stochastically using only
+ *  applies of the matrix to blocks of random probe vectors.
+ *
+ * Element i of the diagonal is estimated as the mean of $z_i (A z)_i$ over
+ * Rademacher random probe vectors z (C. Bekas, E. Kokiopoulou, Y. Saad,
+ * Appl. Numer. Math. 57, 1214 (2007)). Its error is controlled by the
+ * off-diagonal elements of row i and decays like $1 / \sqrt{n_probes}$.
+ * The returned error bars are the standard errors of these means. The
+ * sample variances are accumulated by Welford's method within each probe
+ * block and the blocks are merged by the pairwise update of Chan et al.,
+ * such that they stay accurate for strongly diagonally dominant matrices.
+ *
+ * The probe blocks are processed in parallel, so the apply function of A
+ * needs to be safe to call from several threads at once. The result
+ * only depends on the seed, not on the number of threads.
+ *
+ * Only real matrices are supported at the moment.
+ *
+ * ## Parameters and their default values
+ *   - n_probes:  Number of matrix-vector applies to use. Default: 64
+ *   - block_size:  Number of probes applied at once. Default: 8
+ *   - n_threads:  Maximal number of threads. Default: Number of hardware threads
+ *   - seed:  Seed for the probe vectors. Default: New seed on each call.
+ */
+template <typename StoredMatrix>
+DiagonalEstimate<typename StoredMatrix::vector_type> estimate_diagonal(
+      const LazyMatrixExpression<StoredMatrix>& A,
+      const krims::GenMap& params = krims::GenMap()) {
+  typedef typename StoredMatrix::vector_type vector_type;
+  typedef typename StoredMatrix::scalar_type scalar_type;
+  static_assert(std::is_floating_point<scalar_type>::value,
+                "Stochastic estimators are only implemented for real matrices");
+  assert_size(A.n_rows(), A.n_cols());
+
+  const detail::StochasticEstimatorParameters par(params);
+  assert_throw(par.n_probes >= 2,
+               ExcInvalidStochasticEstimatorParameters(
+                     "The diagonal estimator needs at least 2 probes."));
+  const size_t n = A.n_rows();
+
+  // Means and sums of squared deviations from the mean (M2) of the samples
+  // z_i (A z)_i per probe block, which are merged in order afterwards to be
+  // independent of the threads.
+  const size_t n_blocks = par.n_blocks(par.n_probes);
+  std::vector<vector_type> means(n_blocks, vector_type(n));
+  std::vector<vector_type> m2s(n_blocks, vector_type(n));
+  detail::balanced_parallel_for(
+        std::vector<double>(n_blocks, 1.), par.n_threads, [&](size_t b) {
+          const size_t n_vectors = par.n_in_block(b, par.n_probes);
+          MultiVector<vector_type> z(n, n_vectors, false);
+          detail::fill_rademacher(z, par.seed, b * par.block_size * n);
+          MultiVector<vector_type> az(n, n_vectors, false);
+          A.apply(z, az);
+
+          // Welford's update
+          for (size_t j = 0; j < n_vectors; ++j) {
+            const auto count = static_cast<scalar_type>(j + 1);
+            for (size_t i = 0; i < n; ++i) {
+              const scalar_type sample = z[j][i] * az[j][i];
+              const scalar_type delta = sample - means[b][i];
+              means[b][i] += delta / count;
+              m2s[b][i] += delta * (sample - means[b][i]);
+            }
+          }
+        });
+
+  // Merge the blocks using the pairwise formula of Chan, Golub and LeVeque
+  DiagonalEstimate<vector_type> ret{std::move(means[0]), std::move(m2s[0]),
+                                    par.n_probes};
+  auto count = static_cast<scalar_type>(par.n_in_block(0, par.n_probes));
+  for (size_t b = 1; b < n_blocks; ++b) {
+    const auto count_b = static_cast<scalar_type>(par.n_in_block(b, par.n_probes));
+    const scalar_type merged = count + count_b;
+    for (size_t i = 0; i < n; ++i) {
+      const scalar_type delta = means[b][i] - ret.diagonal[i];
+      ret.diagonal[i] += delta * count_b / merged;
+      ret.error[i] += m2s[b][i] + delta * delta * count * count_b / merged;
+    }
+    count = merged;
+  }
+
+  // Standard error of the mean from the sample variance M2 / (n_probes - 1)
+  for (size_t i = 0; i < n; ++i) {
+    ret.error[i] = std::sqrt(ret.error[i] / (count - 1) / count);
+  }
+  return ret;
+}
+
+}  // namespace lazyten
@@ -19,6 +19,8 @@
 
 #include "eigensolver_tests.hh"
 #include <lazyten/Arpack.hh>
+#include <lazyten/EigensystemSolver.hh>
+#include <lazyten/Lapack.hh>
 #include <lazyten/SmallMatrix.hh>
 
 #ifdef LAZYTEN_HAVE_ARPACK
@@ -67,9 +69,242 @@ TEST_CASE("ArpackEigensolver", "[ArpackEigensolver]") {
     tr.run_matching(filter);
   }  // real hermitian generalised problems
 
-  // TODO test real non-hermitian problems
+  SECTION("Real non-hermitian normal problems") {
+    // dnaupd needs at least two more Arnoldi vectors than eigenpairs
+    auto filter_nonhermitian = [&filter](
+          const EigensolverTestProblemBase<matrix_type>& problem) {
+      return problem.n_ep + 2 < problem.dim && filter(problem);
+    };
+
+    typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ false> tprob_type;
+    TestProblemRunner<tprob_type, DefaultSolveFunctor<ArpackEigensolverTraits>> tr;
+    tr.run_normal_matching(filter_nonhermitian);
+  }  // real non-hermitian normal problems
+
   // TODO test real non-hermitian generalised problems
 
+#ifdef LAZYTEN_HAVE_LAPACK
+  SECTION("Shift-invert mode with internal factorisation") {
+    typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ true> tprob_type;
+    auto allprobs = EigensolverTestProblemLibrary<tprob_type>::get_all();
+
+    for (const tprob_type& testproblem : allprobs) {
+      if (!filter(testproblem)) continue;
+      if (testproblem.params.at<std::string>(EigensolverBaseKeys::which, "SR") !=
+          std::string("SR")) {
+        continue;
+      }
+
+      INFO("#");
+      INFO("# " + testproblem.description);
+      INFO("#");
+
+      // Place the shift below the spectrum, such that the eigenvalues
+      // closest to sigma are the smallest ones.
+      const double sigma =
+            *std::min_element(testproblem.evalues.begin(), testproblem.evalues.end()) -
+            1.;
+      krims::GenMap params{testproblem.params};
+      params.update(ArpackEigensolverKeys::mode, 3);
+      params.update(ArpackEigensolverKeys::sigma, sigma);
+      params.update(EigensolverBaseKeys::which, std::string("LM"));
+
+      auto prob = testproblem.generalised_eigenproblem();
+      ArpackEigensolver<decltype(prob)> solver{params};
+      auto ret = solver.solve(prob);
+
+      typedef typename tprob_type::evalue_type evalue_type;
+      std::vector<evalue_type> evals_sorted(ret.eigensolution().evalues());
+      std::sort(evals_sorted.begin(), evals_sorted.end());
+      SmallVector<evalue_type> evals(evals_sorted);
+      SmallVector<evalue_type> evals_ref(testproblem.evalues);
+      CHECK(evals == numcomp(evals_ref).tolerance(testproblem.tolerance));
+    }
+  }  // Shift-invert mode
+
+  SECTION("Buckling and Cayley modes with internal factorisation") {
+    // Generalised problem with positive definite A and B. Its eigenvalues
+    // are all larger than sigma, such that the smallest ones are the
+    // largest in magnitude after both transformations.
+    const size_t dim = 30;
+    const size_t n_ep = 3;
+    const double sigma = 0.5;
+    matrix_type a(dim, dim);
+    matrix_type b(dim, dim);
+    for (size_t i = 0; i < dim; ++i) {
+      a(i, i) = static_cast<double>(i + 1);
+      b(i, i) = 1. + 0.1 * static_cast<double>(i % 3);
+      if (i + 1 < dim) {
+        a(i, i + 1) = a(i + 1, i) = 0.2;
+        b(i, i + 1) = b(i + 1, i) = 0.05;
+      }
+    }
+    Eigenproblem<true, matrix_type, matrix_type> prob(a, b, n_ep);
+
+    LapackEigensolver<decltype(prob)> reference{};
+    const auto ret_ref = reference.solve(prob);
+    SmallVector<double> evals_ref(ret_ref.eigensolution().evalues());
+
+    for (const int mode : {4, 5}) {
+      INFO("ARPACK mode " + std::to_string(mode));
+      krims::GenMap params{{ArpackEigensolverKeys::mode, mode},
+                           {ArpackEigensolverKeys::sigma, sigma},
+                           {EigensolverBaseKeys::which, std::string("LM")}};
+      ArpackEigensolver<decltype(prob)> solver{params};
+      const auto ret = solver.solve(prob);
+
+      std::vector<double> evals_sorted(ret.eigensolution().evalues());
+      std::sort(evals_sorted.begin(), evals_sorted.end());
+      SmallVector<double> evals(evals_sorted);
+      CHECK(evals == numcomp(evals_ref).tolerance(1e-10));
+
+      for (size_t i = 0; i < n_ep; ++i) {
+        const auto& evec = ret.eigensolution().evectors()[i];
+        SmallVector<double> av = a * evec;
+        SmallVector<double> lbv = ret.eigensolution().evalues()[i] * (b * evec);
+        CHECK(av == numcomp(lbv).tolerance(1e-9));
+      }
+    }
+  }  // Buckling and Cayley modes
+#endif  // LAZYTEN_HAVE_LAPACK
+
+  SECTION("Statistics of the reverse communication") {
+    const size_t dim = 30;
+    matrix_type a(dim, dim);
+    matrix_type b(dim, dim);
+    for (size_t i = 0; i < dim; ++i) {
+      a(i, i) = static_cast<double>(i + 1);
+      b(i, i) = 2.;
+      if (i + 1 < dim) a(i, i + 1) = a(i + 1, i) = 0.2;
+    }
+
+    // Each reverse communication step but the last one (which signals
+    // convergence) serves exactly one apply of OP or of B.
+    // Note: The states are solved in-place, since n_bmtx_applies
+    //       is a reference into the iparam array of the state.
+    Eigenproblem<true, matrix_type> prob(a, 3);
+    ArpackEigensolverState<decltype(prob)> ret{prob};
+    ArpackEigensolver<decltype(prob)>{}.solve_state(ret);
+    CHECK(ret.n_ido_steps > 0);
+    CHECK(ret.n_bmtx_applies == 0);
+    CHECK(ret.n_ido_steps == ret.n_mtx_applies() + 1);
+    CHECK(ret.time_in_arpack.count() > 0);
+    CHECK(ret.time_in_applies.count() > 0);
+
+#ifdef LAZYTEN_HAVE_LAPACK
+    Eigenproblem<true, matrix_type, matrix_type> gprob(a, b, 3);
+    krims::GenMap params{{ArpackEigensolverKeys::mode, 3},
+                         {ArpackEigensolverKeys::sigma, 0.},
+                         {EigensolverBaseKeys::which, std::string("LM")}};
+    ArpackEigensolverState<decltype(gprob)> gret{gprob};
+    ArpackEigensolver<decltype(gprob)>{params}.solve_state(gret);
+    CHECK(gret.n_bmtx_applies > 0);
+    CHECK(gret.n_ido_steps == gret.n_mtx_applies() +
+                                    static_cast<size_t>(gret.n_bmtx_applies) + 1);
+#endif  // LAZYTEN_HAVE_LAPACK
+  }  // Statistics
+
+  SECTION("Complex hermitian and non-hermitian problems") {
+    typedef std::complex<double> complex_type;
+    typedef SmallMatrix<complex_type> cmatrix_type;
+    const size_t dim = 30;
+    const size_t n_ep = 3;
+
+    // Maximal deviation of A v from lambda v for all eigenpairs
+    auto max_residual = [](const cmatrix_type& a, const std::vector<complex_type>& evals,
+                           const MultiVector<SmallVector<complex_type>>& evecs) {
+      double ret = 0;
+      for (size_t i = 0; i < evals.size(); ++i) {
+        const SmallVector<complex_type> av = a * evecs[i];
+        for (size_t j = 0; j < av.size(); ++j) {
+          ret = std::max(ret, std::abs(av[j] - evals[i] * evecs[i][j]));
+        }
+      }
+      return ret;
+    };
+
+    auto by_real_part = [](complex_type x, complex_type y) {
+      return x.real() < y.real();
+    };
+
+    // Hermitian tridiagonal matrix with complex off-diagonal elements
+    cmatrix_type a(dim, dim);
+    for (size_t i = 0; i < dim; ++i) {
+      a(i, i) = static_cast<double>(i + 1);
+      if (i + 1 < dim) {
+        a(i, i + 1) = complex_type(0.2, 0.3);
+        a(i + 1, i) = complex_type(0.2, -0.3);
+      }
+    }
+    Eigenproblem<true, cmatrix_type> prob(a, n_ep);
+    const auto ret = ArpackEigensolver<decltype(prob)>{}.solve(prob);
+    std::vector<complex_type> evals(ret.eigensolution().evalues());
+    REQUIRE(evals.size() == n_ep);
+    CHECK(max_residual(a, evals, ret.eigensolution().evectors()) < 1e-9);
+
+#ifdef LAZYTEN_HAVE_LAPACK
+    const auto ret_ref = LapackEigensolver<decltype(prob)>{}.solve(prob);
+    const std::vector<complex_type>& evals_ref = ret_ref.eigensolution().evalues();
+    std::sort(evals.begin(), evals.end(), by_real_part);
+    for (size_t i = 0; i < n_ep; ++i) {
+      CHECK(std::abs(evals[i] - evals_ref[i]) < 1e-10);
+    }
+#endif  // LAZYTEN_HAVE_LAPACK
+
+    // Method selection picks ARPACK for complex problems
+    // if no dense method may be used
+    krims::GenMap params{{EigensystemSolverKeys::method, std::string("auto")},
+                         {EigensolverCostModelKeys::max_dense_memory, size_t(1)}};
+    const auto ret_auto = EigensystemSolver<decltype(prob)>{params}.solve(prob);
+    CHECK(ret_auto.selected_method() == "arpack");
+    std::vector<complex_type> evals_auto(ret_auto.eigensolution().evalues());
+    CHECK(max_residual(a, evals_auto, ret_auto.eigensolution().evectors()) < 1e-9);
+
+    // Non-hermitian upper triangular matrix, whose eigenvalues are
+    // just its diagonal elements.
+    cmatrix_type t(dim, dim);
+    for (size_t i = 0; i < dim; ++i) {
+      const double re = static_cast<double>(i + 1);
+      t(i, i) = complex_type(re, 0.5 * static_cast<double>(i % 4));
+      if (i + 1 < dim) t(i, i + 1) = 0.1;
+      if (i + 2 < dim) t(i, i + 2) = complex_type(0., 0.05);
+    }
+    Eigenproblem<false, cmatrix_type> tprob(t, n_ep);
+    const auto tret = ArpackEigensolver<decltype(tprob)>{}.solve(tprob);
+    std::vector<complex_type> tevals(tret.eigensolution().evalues());
+    REQUIRE(tevals.size() == n_ep);
+    CHECK(max_residual(t, tevals, tret.eigensolution().evectors()) < 1e-9);
+    std::sort(tevals.begin(), tevals.end(), by_real_part);
+    for (size_t i = 0; i < n_ep; ++i) {
+      CHECK(std::abs(tevals[i] - t(i, i)) < 1e-10);
+    }
+
+    // Shift-invert mode with the shifted inverse provided in Diag.
+    // which refers to nu = 1 / (lambda - sigma), such that "LR" selects
+    // the eigenvalues 11 + i, 12 + 1.5i and 13 above the shift.
+    const double sigma = 10.2;
+    cmatrix_type tinv(dim, dim);
+    for (size_t j = 0; j < dim; ++j) {
+      for (size_t i = j + 1; i-- > 0;) {
+        complex_type sum = i == j ? complex_type(1.) : complex_type(0.);
+        for (size_t k = i + 1; k <= j; ++k) sum -= t(i, k) * tinv(k, j);
+        tinv(i, j) = sum / (t(i, i) - sigma);
+      }
+    }
+    Eigenproblem<false, cmatrix_type> siprob(t, n_ep, tinv);
+    const krims::GenMap siparams{{ArpackEigensolverKeys::mode, 3},
+                                 {ArpackEigensolverKeys::sigma, sigma},
+                                 {EigensolverBaseKeys::which, std::string("LR")}};
+    const auto siret = ArpackEigensolver<decltype(siprob)>{siparams}.solve(siprob);
+    std::vector<complex_type> sievals(siret.eigensolution().evalues());
+    REQUIRE(sievals.size() == n_ep);
+    CHECK(max_residual(t, sievals, siret.eigensolution().evectors()) < 1e-9);
+    std::sort(sievals.begin(), sievals.end(), by_real_part);
+    for (size_t i = 0; i < n_ep; ++i) {
+      CHECK(std::abs(sievals[i] - t(10 + i, 10 + i)) < 1e-10);
+    }
+  }  // Complex problems
+
   SECTION("Check that providing a guess reduces the number of steps needed") {
     // TODO Get this into the general testing library
 
@@ -18,7 +18,10 @@
 //
 
 #include "stored_vector_tests.hh"
+#include <cmath>
 #include <lazyten/Builtin/BuiltinVector.hh>
+#include <limits>
+#include <thread>
 
 namespace lazyten {
 namespace tests {
@@ -41,6 +44,66 @@ TEST_CASE("BuiltinVector class", "[BuiltinVector]") {
     stored_vector_tests::run_with_generator(genlib<std::complex<double>>::testgenerator(),
                                             "BuiltinVector<complex double>: ");
   }
+
+  SECTION("Reductions do not depend on the number of threads") {
+    // Large enough to be split across threads
+    const size_t size = 40 * detail::reduction_chunk_size *
+                        detail::reduction_min_chunks_per_thread / 7;
+    BuiltinVector<double> v(size, false);
+    BuiltinVector<double> w(size, false);
+    for (size_t i = 0; i < size; ++i) {
+      v[i] = 1. / (1. + i) - 0.01;
+      w[i] = std::sin(0.1 * i);
+    }
+
+    const size_t n_threads_orig = reduction_n_threads();
+    set_reduction_n_threads(1);
+    const std::vector<double> ref{accumulate(v), dot(v, w), norm_l1(v),
+                                  norm_l2(v),    min(w),    max(w)};
+    for (size_t n_threads : {2, 3, 8}) {
+      set_reduction_n_threads(n_threads);
+      const std::vector<double> res{accumulate(v), dot(v, w), norm_l1(v),
+                                    norm_l2(v),    min(w),    max(w)};
+      CHECK(res == ref);
+    }
+    set_reduction_n_threads(n_threads_orig);
+
+    // Pairwise summation keeps the error small
+    long double exact = 0;
+    for (size_t i = 0; i < size; ++i) exact += v[i];
+    CHECK(std::abs(accumulate(v) - static_cast<double>(exact)) <
+          10 * std::numeric_limits<double>::epsilon() * std::abs(exact));
+  }
+
+  SECTION("Reductions inside a parallel region run serially") {
+    const size_t size = 40 * detail::reduction_chunk_size *
+                        detail::reduction_min_chunks_per_thread / 7;
+    BuiltinVector<double> v(size, false);
+    for (size_t i = 0; i < size; ++i) v[i] = std::cos(0.3 * i);
+
+    const size_t n_threads_orig = reduction_n_threads();
+    set_reduction_n_threads(4);
+    const double ref = norm_l2(v);
+    CHECK_FALSE(detail::in_parallel_region());
+
+    std::vector<double> res(4, 0.);
+    std::vector<int> serial(4, 0);
+    detail::balanced_parallel_for(std::vector<double>(4, 1.), 2, [&](size_t i) {
+      // Nested loops do not spawn threads of their own
+      const auto outer_id = std::this_thread::get_id();
+      bool same_thread = detail::in_parallel_region();
+      detail::balanced_parallel_for(std::vector<double>(3, 1.), 3, [&](size_t) {
+        same_thread = same_thread && std::this_thread::get_id() == outer_id;
+      });
+      serial[i] = same_thread ? 1 : 0;
+      res[i] = norm_l2(v);
+    });
+    set_reduction_n_threads(n_threads_orig);
+
+    CHECK_FALSE(detail::in_parallel_region());
+    CHECK(serial == std::vector<int>(4, 1));
+    CHECK(res == std::vector<double>(4, ref));
+  }
 }
 
 }  // namespace builtin_vector_tests
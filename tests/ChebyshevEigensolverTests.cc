@@ -0,0 +1,124 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "eigensolver_tests.hh"
+#include <lazyten/Chebyshev.hh>
+#include <lazyten/SmallMatrix.hh>
+
+namespace lazyten {
+namespace tests {
+using namespace rc;
+
+/** Traits class needed for the tests */
+struct ChebyshevEigensolverTraits {
+  template <typename Eigenproblem>
+  using Solver = ChebyshevEigensolver<Eigenproblem>;
+};
+
+TEST_CASE("ChebyshevEigensolver", "[ChebyshevEigensolver]") {
+  using namespace eigensolver_tests;
+  typedef SmallMatrix<double> matrix_type;
+
+  /* The filter functor to filter out problems which make no sense
+   * for us here*/
+  auto filter = [](const EigensolverTestProblemBase<matrix_type>& problem) {
+    // The filter only targets the extremal ends of the spectrum
+    const std::string which =
+          problem.params.at<std::string>(EigensolverBaseKeys::which, "SR");
+    return which == std::string("SR") || which == std::string("LR");
+  };
+
+  SECTION("Real hermitian normal problems") {
+    typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ true> tprob_type;
+    TestProblemRunner<tprob_type, DefaultSolveFunctor<ChebyshevEigensolverTraits>> tr;
+    tr.run_normal_matching(filter);
+  }  // real hermitian normal problems
+
+  SECTION("Real hermitian generalised problems") {
+    typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ true> tprob_type;
+    TestProblemRunner<tprob_type, DefaultSolveFunctor<ChebyshevEigensolverTraits>> tr;
+
+    // Run all problems as generalised problems.
+    tr.solve_functor().force_generalised = true;
+    tr.run_matching(filter);
+  }  // real hermitian generalised problems
+
+  SECTION("Real hermitian problems with a low filter degree") {
+    typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ true> tprob_type;
+    TestProblemRunner<tprob_type, DefaultSolveFunctor<ChebyshevEigensolverTraits>> tr;
+    tr.solve_functor().extra_params = krims::GenMap{
+          {ChebyshevEigensolverKeys::degree, size_t(3)},
+          {ChebyshevEigensolverKeys::max_iter, size_t(1000)}};
+    tr.run_normal_matching(filter);
+  }  // low filter degree
+
+  SECTION("Check that providing a guess reduces the number of steps needed") {
+    typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ true> tprob_type;
+    auto allprobs = EigensolverTestProblemLibrary<tprob_type>::get_all();
+
+    for (const tprob_type& testproblem : allprobs) {
+      if (!filter(testproblem)) continue;
+
+      INFO("#");
+      INFO("# " + testproblem.description);
+      INFO("#");
+
+      auto prob = testproblem.generalised_eigenproblem();
+      ChebyshevEigensolverState<decltype(prob)> guess_state{prob};
+
+      // Set the results to expect:
+      guess_state.eigensolution().evalues() = testproblem.evalues;
+
+      auto& evecs = guess_state.eigensolution().evectors();
+      evecs.clear();
+      evecs.reserve(testproblem.evectors.size());
+      for (auto& vec : testproblem.evectors) {
+        evecs.push_back(typename tprob_type::evector_type{vec});
+      }
+
+      ChebyshevEigensolver<decltype(prob)> solver{testproblem.params};
+      auto ret = solver.solve_with_guess(prob, guess_state);
+      CHECK(ret.n_iter() < 3);
+
+      // Check eigenvalues
+      typedef typename tprob_type::evalue_type evalue_type;
+      SmallVector<evalue_type> evals(ret.eigensolution().evalues());
+      SmallVector<evalue_type> evals_ref(testproblem.evalues);
+      CHECK(evals == numcomp(evals_ref).tolerance(testproblem.tolerance));
+    }
+  }
+
+  SECTION("The tolerance actually used is recorded in the state") {
+    matrix_type m{{4, 1, 0, 0}, {1, 3, 1, 0}, {0, 1, 2, 1}, {0, 0, 1, 1}};
+    Eigenproblem<true, matrix_type> prob(m, 1);
+
+    ChebyshevEigensolver<decltype(prob)> solver{
+          krims::GenMap{{EigensolverBaseKeys::tolerance, 1e-8}}};
+    CHECK(solver.solve(prob).residual_tolerance == 1e-8);
+
+    // Tolerances below the floor are raised to it
+    solver.tolerance = 1e-20;
+    const double floor = 100 * Constants<double>::default_tolerance;
+    CHECK(solver.solve(prob).residual_tolerance == floor);
+  }
+
+}  // ChebyshevEigensolver
+
+}  // namespace tests
+}  // namespace lazyten
@@ -0,0 +1,69 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "eigensolver_tests.hh"
+#include <lazyten/Lanczos.hh>
+#include <lazyten/SmallMatrix.hh>
+
+namespace lazyten {
+namespace tests {
+using namespace rc;
+
+/** Traits class needed for the tests */
+struct LanczosEigensolverTraits {
+  template <typename Eigenproblem>
+  using Solver = LanczosEigensolver<Eigenproblem>;
+};
+
+TEST_CASE("LanczosEigensolver", "[LanczosEigensolver]") {
+  using namespace eigensolver_tests;
+  typedef SmallMatrix<double> matrix_type;
+
+  /* The filter functor to filter out problems which make no sense
+   * for us here*/
+  auto filter = [](const EigensolverTestProblemBase<matrix_type>& problem) {
+    // We need at least one vector beyond the eigenpairs for the Lanczos basis
+    if (problem.n_ep >= problem.dim) return false;
+
+    // Only the ends of the spectrum can be targeted
+    const std::string which =
+          problem.params.at<std::string>(EigensolverBaseKeys::which, "SR");
+    return which == std::string("SR") || which == std::string("LR") ||
+           which == std::string("LM");
+  };
+
+  SECTION("Real hermitian normal problems") {
+    typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ true> tprob_type;
+    TestProblemRunner<tprob_type, DefaultSolveFunctor<LanczosEigensolverTraits>> tr;
+    tr.run_normal_matching(filter);
+  }  // real hermitian normal problems
+
+  SECTION("Real hermitian generalised problems") {
+    typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ true> tprob_type;
+    TestProblemRunner<tprob_type, DefaultSolveFunctor<LanczosEigensolverTraits>> tr;
+
+    // Run all problems as generalised problems.
+    tr.solve_functor().force_generalised = true;
+    tr.run_matching(filter);
+  }  // real hermitian generalised problems
+
+}  // LanczosEigensolver
+
+}  // namespace tests
+}  // namespace lazyten
@@ -18,9 +18,12 @@
 //
 
 #include "eigensolver_tests.hh"
+#include <lazyten/Lapack/LapackBatchedEigensolver.hh>
 #include <lazyten/Lapack/LapackEigensolver.hh>
 #include <lazyten/LazyMatrixWrapper.hh>
 #include <lazyten/TestingUtils.hh>
+#include <lazyten/eigensystem.hh>
+#include <lazyten/random.hh>
 #include <rapidcheck.h>
 
 #ifdef LAZYTEN_HAVE_LAPACK
@@ -34,6 +37,93 @@ struct LapackEigensolverTraits {
   using Solver = LapackEigensolver<Eigenproblem>;
 };
 
+/** Phase factor exp(i angle) for complex scalars, 1 for real scalars */
+template <typename T>
+T phase(T, double) {
+  return T(1);
+}
+
+template <typename T>
+std::complex<T> phase(std::complex<T>, double angle) {
+  return std::polar(T(1), static_cast<T>(angle));
+}
+
+/** Build the tridiagonal Hermitian matrix D T D^H, where T is real symmetric
+ *  with the given diagonal and off-diagonal value and D = diag(exp(i j)).
+ *  The eigenvalues of the result are those of T. */
+template <typename Scalar>
+ArmadilloMatrix<Scalar> phased_tridiagonal(const std::vector<double>& diagonal,
+                                           double offdiag) {
+  const size_t dim = diagonal.size();
+  ArmadilloMatrix<Scalar> ret(dim, dim);
+  for (size_t i = 0; i < dim; ++i) {
+    ret(i, i) = static_cast<Scalar>(diagonal[i]);
+    if (i + 1 < dim) {
+      const Scalar off = static_cast<Scalar>(offdiag);
+      ret(i, i + 1) = off * phase(Scalar(), -1.);
+      ret(i + 1, i) = off * phase(Scalar(), 1.);
+    }
+  }
+  return ret;
+}
+
+/** Solve a normal and a generalised Hermitian problem with the scalar type
+ *  Scalar and compare against the corresponding real double precision
+ *  problem. Checks the eigenpairs by their residual as well. */
+template <typename Scalar>
+void check_lapack_scalar_type(double tolerance) {
+  typedef ArmadilloMatrix<Scalar> matrix_type;
+  typedef ArmadilloVector<Scalar> vector_type;
+  typedef ArmadilloMatrix<double> ref_matrix_type;
+  typedef typename Eigenproblem<true, matrix_type>::evalue_type evalue_type;
+  const size_t dim = 20;
+  const size_t n_ep = 5;
+
+  std::vector<double> diag_a(dim);
+  std::vector<double> diag_b(dim);
+  for (size_t i = 0; i < dim; ++i) {
+    diag_a[i] = static_cast<double>(i + 1);
+    diag_b[i] = 2. + 0.1 * static_cast<double>(i % 3);
+  }
+  const matrix_type a = phased_tridiagonal<Scalar>(diag_a, 0.3);
+  const matrix_type b = phased_tridiagonal<Scalar>(diag_b, 0.1);
+  const ref_matrix_type a_ref = phased_tridiagonal<double>(diag_a, 0.3);
+  const ref_matrix_type b_ref = phased_tridiagonal<double>(diag_b, 0.1);
+
+  // Compare the eigenvalues to the reference and check the residual
+  // of A x = lambda B x (or A x = lambda x if bptr is a nullptr)
+  auto check = [&](const std::vector<double>& evals_ref, const matrix_type* bptr,
+                   const std::vector<evalue_type>& evals,
+                   const MultiVector<vector_type>& evecs) {
+    REQUIRE(evals.size() == n_ep);
+    for (size_t i = 0; i < n_ep; ++i) {
+      CHECK(std::abs(std::complex<double>(evals[i]) - evals_ref[i]) < tolerance);
+
+      const vector_type ax = a * evecs[i];
+      const vector_type bx = bptr ? vector_type(*bptr * evecs[i]) : evecs[i];
+      double residual = 0;
+      for (size_t j = 0; j < dim; ++j) {
+        residual = std::max<double>(residual, std::abs(ax[j] - evals[i] * bx[j]));
+      }
+      CHECK(residual < tolerance);
+    }
+  };
+
+  Eigenproblem<true, matrix_type> prob(a, n_ep);
+  Eigenproblem<true, ref_matrix_type> prob_ref(a_ref, n_ep);
+  const auto res = LapackEigensolver<decltype(prob)>{}.solve(prob);
+  const auto res_ref = LapackEigensolver<decltype(prob_ref)>{}.solve(prob_ref);
+  check(res_ref.eigensolution().evalues(), nullptr, res.eigensolution().evalues(),
+        res.eigensolution().evectors());
+
+  Eigenproblem<true, matrix_type, matrix_type> gprob(a, b, n_ep);
+  Eigenproblem<true, ref_matrix_type, ref_matrix_type> gprob_ref(a_ref, b_ref, n_ep);
+  const auto gres = LapackEigensolver<decltype(gprob)>{}.solve(gprob);
+  const auto gres_ref = LapackEigensolver<decltype(gprob_ref)>{}.solve(gprob_ref);
+  check(gres_ref.eigensolution().evalues(), &b, gres.eigensolution().evalues(),
+        gres.eigensolution().evectors());
+}
+
 TEST_CASE("LapackEigensolver", "[LapackEigensolver]") {
   using namespace eigensolver_tests;
   typedef double scalar_type;
@@ -99,9 +189,41 @@ TEST_CASE("LapackEigensolver", "[LapackEigensolver]") {
     REQUIRE(rc::check("LapackPackedMatrix generation and unpacking", test));
   }  // LapackPackedMatrix
 
+  SECTION("Test LapackSymmetricMatrix") {
+    matrix_type mat{{1, 2, 3}, {2, 4, 5}, {3, 5, 6}};
+    LazyMatrixWrapper<matrix_type> mat_wrap(mat);
+
+    detail::LapackSymmetricMatrix<double> full(mat);
+    detail::LapackSymmetricMatrix<double> fullwrap(mat_wrap);
+
+    REQUIRE(full.n == 3);
+    REQUIRE(fullwrap.n == 3);
+    CHECK(full.elements == std::vector<double>(mat.begin(), mat.end()));
+    CHECK(fullwrap.elements == full.elements);
+  }  // LapackSymmetricMatrix
+
+  SECTION("Eigenvectors are views into the Lapack buffer") {
+    matrix_type mat{{4, 1, 0}, {1, 3, 1}, {0, 1, 2}};
+    Eigenproblem<true, matrix_type> prob(mat);
+    LapackEigensolver<decltype(prob)> solver{};
+    const auto state = solver.solve(prob);
+    const auto& evectors = state.eigensolution().evectors();
+
+    REQUIRE(evectors.n_vectors() == 3);
+    const auto memptrs = evectors.memptrs();
+    for (size_t i = 1; i < memptrs.size(); ++i) {
+      // Canonically ordered and contiguous
+      CHECK(memptrs[i] == memptrs[0] + 3 * i);
+    }
+  }  // Eigenvector views
+
   krims::GenMap params1{{LapackEigensolverKeys::prefer_packed_matrices, false}};
   krims::GenMap params2{{LapackEigensolverKeys::prefer_packed_matrices, true}};
 
+  // Use the subset drivers whenever possible
+  krims::GenMap params3{{LapackEigensolverKeys::prefer_packed_matrices, false},
+                        {LapackEigensolverKeys::max_subset_ratio, 1.}};
+
   SECTION("Real hermitian normal problems") {
     typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ true> tprob_type;
     TestProblemRunner<tprob_type, DefaultSolveFunctor<LapackEigensolverTraits>> tr;
@@ -115,6 +237,11 @@ TEST_CASE("LapackEigensolver", "[LapackEigensolver]") {
       tr.solve_functor().extra_params = params2;
       tr.run_normal();
     }
+
+    SECTION("Run with third parameter set") {
+      tr.solve_functor().extra_params = params3;
+      tr.run_normal();
+    }
   }  // real hermitian normal problems
 
   SECTION("Real hermitian generalised problems") {
@@ -133,8 +260,85 @@ TEST_CASE("LapackEigensolver", "[LapackEigensolver]") {
       tr.solve_functor().extra_params = params2;
       tr.run_all();
     }
+
+    SECTION("Run with third parameter set") {
+      tr.solve_functor().extra_params = params3;
+      tr.run_all();
+    }
   }  // real hermitian generalised problems
 
+  SECTION("Batched small eigenproblems") {
+    const std::vector<size_t> dims{5, 20, 1, 13, 40, 7, 0, 25};
+    std::vector<matrix_type> matrices;
+    HermitianMatrixBatch<scalar_type> batch;
+    for (const size_t n : dims) {
+      matrix_type mat = random<matrix_type>(n, n);
+      for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < i; ++j) mat(j, i) = mat(i, j);
+      }
+      batch.push_back(mat);
+      matrices.push_back(std::move(mat));
+    }
+
+    const krims::GenMap params{{LapackBatchedEigensolverKeys::n_threads, size_t(3)}};
+    const auto soln = eigensystem_hermitian_batched(std::move(batch), params);
+    REQUIRE(soln.size() == dims.size());
+
+    for (size_t b = 0; b < dims.size(); ++b) {
+      INFO("Problem " + std::to_string(b) + " of size " + std::to_string(dims[b]));
+      REQUIRE(soln.dim(b) == dims[b]);
+      if (dims[b] == 0) continue;
+
+      // Compare to the result of the standard interface
+      const auto ref = eigensystem_hermitian(matrices[b]);
+      SmallVector<scalar_type> evals(soln.evalues(b), soln.evalues(b) + dims[b]);
+      SmallVector<scalar_type> evals_ref(ref.evalues());
+      CHECK(evals == numcomp(evals_ref).tolerance(1e-10));
+
+      // Check the eigenpairs and that the eigenvectors are views into the arena
+      const auto esoln = soln.eigensolution<vector_type>(b);
+      for (size_t k = 0; k < dims[b]; ++k) {
+        const vector_type& v = esoln.evectors()[k];
+        CHECK(v.memptr() == soln.evectors(b) + k * dims[b]);
+
+        vector_type av = matrices[b] * v;
+        vector_type lv = esoln.evalues()[k] * v;
+        CHECK(av == numcomp(lv).tolerance(1e-10));
+      }
+    }
+  }  // Batched small eigenproblems
+
+  SECTION("Reuse the Cholesky factorisation of the metric") {
+    typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ true> tprob_type;
+    auto allprobs = EigensolverTestProblemLibrary<tprob_type>::get_all();
+
+    for (const tprob_type& testproblem : allprobs) {
+      INFO("#");
+      INFO("# " + testproblem.description);
+      INFO("#");
+
+      auto prob = testproblem.generalised_eigenproblem();
+      LapackEigensolver<decltype(prob)> solver{testproblem.params};
+      const auto first = solver.solve(prob);
+      const auto second = solver.solve(prob);
+      CHECK_FALSE(first.reused_metric_factorisation);
+      CHECK(second.reused_metric_factorisation);
+
+      typedef typename tprob_type::evalue_type evalue_type;
+      SmallVector<evalue_type> evals(second.eigensolution().evalues());
+      SmallVector<evalue_type> evals_ref(testproblem.evalues);
+      CHECK(evals == numcomp(evals_ref).tolerance(testproblem.tolerance));
+    }
+  }  // Reuse the Cholesky factorisation
+
+  SECTION("Single precision and complex hermitian problems") {
+    // The eigenvectors of complex problems need to be conjugated, which
+    // the residual check in check_lapack_scalar_type verifies.
+    SECTION("float") { check_lapack_scalar_type<float>(1e-4); }
+    SECTION("complex float") { check_lapack_scalar_type<std::complex<float>>(1e-4); }
+    SECTION("complex double") { check_lapack_scalar_type<std::complex<double>>(1e-10); }
+  }  // Single precision and complex hermitian problems
+
   //  TODO Not yet there
   //  SECTION("Real non-hermitian normal problems") {
   //    typedef EigensolverTestProblem<matrix_type, /* Hermitian= */ false> tprob_type;
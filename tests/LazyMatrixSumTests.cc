@@ -168,6 +168,43 @@ TEST_CASE("LazyMatrixSum", "[LazyMatrixSum]") {
 
     REQUIRE(rc::check("Random function test of LazyMatrixSum.", random_test));
   }  // Random function test
+
+  SECTION("Symmetry checks and their caching") {
+    // Large enough to span a few tiles of the symmetry check
+    const size_t n = 2 * detail::symmetry_check_tile_size + 7;
+    stored_matrix_type sym(n, n, false);
+    stored_matrix_type nonsym(n, n, false);
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        sym(i, j) = 1. / (1. + i + j);
+        nonsym(i, j) = 1. / (1. + i + 2. * j);
+      }
+    }
+
+    LazyMatrixSum<stored_matrix_type> sum;
+    sum.push_term(sym);
+    CHECK(sum.is_symmetric());
+    CHECK(sum.is_hermitian());
+    sum.push_term(sym, 2.);
+    CHECK(sum.is_symmetric());
+
+    // Pushing a non-symmetric term invalidates the cached result
+    sum.push_term(nonsym, 0.5);
+    CHECK_FALSE(sum.is_symmetric());
+    CHECK_FALSE(sum.is_hermitian());
+
+    // Violation of symmetry only in the last tile
+    stored_matrix_type almost(sym);
+    LazyMatrixSum<stored_matrix_type> sum_almost;
+    sum_almost.push_term(almost);
+    CHECK(sum_almost.is_symmetric());
+
+    // Sums with stored terms do not cache, so changes to the stored term
+    // are seen right away
+    CHECK_FALSE(sum_almost.owns_data());
+    almost(n - 1, n - 2) += 1.;
+    CHECK_FALSE(sum_almost.is_symmetric());
+  }  // Symmetry checks
 }
 
 }  // namespace tests
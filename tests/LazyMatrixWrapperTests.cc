@@ -61,6 +61,51 @@ TEST_CASE("LazyMatrixWrapper class", "[LazyMatrixWrapper]") {
     testlib{args_generator, model_generator, lazy_generator, "LazyMatrixWrapper: "}
           .run_checks();
   }
+
+  SECTION("Iterating over multiple row tiles") {
+    // Wide enough to have several tiles, the last of which is incomplete.
+    const size_type n_cols = 300;
+    const size_type n_rows =
+          3 * (detail::matrix_iterator_tile_size / n_cols) + 1;  // 3 full tiles + 1 row
+    stored_matrix_type m(n_rows, n_cols, false);
+    for (size_type i = 0; i < n_rows; ++i) {
+      for (size_type j = 0; j < n_cols; ++j) {
+        m(i, j) = static_cast<scalar_type>(i * n_cols + j);
+      }
+    }
+    lazy_matrix_type wrap{m};
+
+    size_type count = 0;
+    for (auto it = std::begin(wrap); it != std::end(wrap); ++it, ++count) {
+      REQUIRE(it.row() == count / n_cols);
+      REQUIRE(it.col() == count % n_cols);
+      REQUIRE(*it == m(it.row(), it.col()));
+    }
+    CHECK(count == n_rows * n_cols);
+
+    // Copies stay valid when the original moves on to a different tile
+    auto it = wrap.cbegin();
+    auto copy = it++;
+    it.seek_to({n_rows - 1, 5});
+    CHECK(*copy == m(0, 0));
+    CHECK(*it == m(n_rows - 1, 5));
+    CHECK(*++copy == m(0, 1));
+  }
+
+  SECTION("Symmetry checks see changes to the wrapped matrix") {
+    stored_matrix_type m{{1., 2., 3.}, {2., 4., 5.}, {3., 5., 6.}};
+    lazy_matrix_type wrap{m};
+    CHECK_FALSE(wrap.owns_data());
+    CHECK(wrap.is_symmetric());
+    CHECK(wrap.is_hermitian());
+
+    // No stale result is returned, even without update()
+    m(0, 1) = 5.;
+    CHECK_FALSE(wrap.is_symmetric());
+    CHECK_FALSE(wrap.is_hermitian());
+    m(0, 1) = 2.;
+    CHECK(wrap.is_symmetric());
+  }
 }
 
 }  // namespace tests
@@ -23,6 +23,7 @@
 #include <lazyten/MultiVector.hh>
 #include <lazyten/SmallVector.hh>
 #include <lazyten/TestingUtils.hh>
+#include <lazyten/detail/block_ops.hh>
 
 namespace lazyten {
 namespace tests {
@@ -347,6 +348,106 @@ TEST_CASE("MultiVector class", "[MultiVector]") {
     CHECK(rc::check("MultiVector: outer_prod_sum()", test));
   }  // outer_sum() on multivectors
 
+  SECTION("dot() of two multivectors") {
+    // Reference: One dot product per pair of vectors
+    auto check_gram = [](const MultiVector<vector_type>& u,
+                         const MultiVector<vector_type>& v) {
+      auto res = dot(u, v);
+      RC_ASSERT(res.n_rows() == u.n_vectors());
+      RC_ASSERT(res.n_cols() == v.n_vectors());
+      for (size_type i = 0; i < u.n_vectors(); ++i) {
+        for (size_type j = 0; j < v.n_vectors(); ++j) {
+          RC_ASSERT_NC(krims::numcomp(dot(u[i], v[j])).tolerance(1e-12) == res(i, j));
+        }  // j
+      }    // i
+    };
+
+    auto test = [&check_gram] {
+      auto vecs1 = gen_vectors<vector_type>();
+      auto mv1 = gen_multivector(vecs1);
+      check_gram(mv1, mv1);
+      if (vecs1.empty()) return;
+
+      const auto n_vecs2 = *gen::numeric_size<2>().as("Number of vectors in v");
+      auto vecs2 = *gen::container<std::vector<vector_type>>(
+            n_vecs2, gen::numeric_tensor<vector_type>(mv1.n_elem()));
+      auto mv2 = gen_multivector(vecs2);
+      check_gram(mv1, mv2);
+    };
+    CHECK(rc::check("MultiVector: dot() of scattered vectors", test));
+
+#ifdef LAZYTEN_HAVE_ARMADILLO
+    auto test_contiguous = [&check_gram] {
+      const auto n_elem = *gen::inRange<size_type>(1, 600).as("Number of elements");
+      const auto n_vecs = *gen::inRange<size_type>(1, 10).as("Number of vectors");
+      const auto stride = n_elem + *gen::inRange<size_type>(0, 3).as("Padding");
+      auto buffer = *gen::container<std::vector<scalar_type>>(
+                          2 * n_vecs * stride, gen::numeric<scalar_type>())
+                           .as("Buffer");
+
+      // Views into the buffer, which are equally spaced in memory
+      MultiVector<vector_type> mv1;
+      MultiVector<vector_type> mv2;
+      for (size_type i = 0; i < n_vecs; ++i) {
+        scalar_type* ptr1 = buffer.data() + i * stride;
+        scalar_type* ptr2 = buffer.data() + (n_vecs + i) * stride;
+        mv1.push_back(vector_type(arma::Col<scalar_type>(ptr1, n_elem, false, true)));
+        mv2.push_back(vector_type(arma::Col<scalar_type>(ptr2, n_elem, false, true)));
+      }
+
+      check_gram(mv1, mv1);
+      check_gram(mv1, mv2);
+    };
+    CHECK(rc::check("MultiVector: dot() of contiguous vectors", test_contiguous));
+#endif  // LAZYTEN_HAVE_ARMADILLO
+  }  // dot() of two multivectors
+
+  SECTION("Block operations of the iterative solvers") {
+    auto test = [] {
+      auto vecs1 = gen_vectors<vector_type>();
+      RC_PRE(vecs1.size() > size_type(0));
+      auto mv1 = gen_multivector(vecs1);
+      const size_type k = mv1.n_vectors();
+      const size_type l = *gen::inRange<size_type>(1, 6).as("Number of output vectors");
+      auto vecs2 = *gen::container<std::vector<vector_type>>(
+            l, gen::numeric_tensor<vector_type>(mv1.n_elem()));
+      auto mv2 = gen_multivector(vecs2);
+
+      // block_gram against one dot product per pair
+      const auto gram = detail::block_gram(mv1, mv2);
+      const auto gram_sym = detail::block_gram(mv1, mv1);
+      for (size_type j = 0; j < l; ++j) {
+        for (size_type i = 0; i < k; ++i) {
+          RC_ASSERT_NC(krims::numcomp(dot(mv1[i], mv2[j])).tolerance(1e-12) ==
+                       gram[j * k + i]);
+        }
+      }
+      for (size_type j = 0; j < k; ++j) {
+        for (size_type i = 0; i < k; ++i) {
+          RC_ASSERT_NC(krims::numcomp(dot(mv1[i], mv1[j])).tolerance(1e-12) ==
+                       gram_sym[j * k + i]);
+        }
+      }
+
+      // block_combine against the explicit linear combination
+      const size_type ldc = k + *gen::inRange<size_type>(0, 3).as("Padding of c");
+      const auto c = *gen::container<std::vector<scalar_type>>(
+                           ldc * l, gen::numeric<scalar_type>())
+                            .as("Coefficients");
+      const auto c_out = *gen::element<scalar_type>(0., 1., -2.5).as("c_out");
+      MultiVector<vector_type> out = mv2.copy_deep();
+      detail::block_combine(mv1, c.data(), ldc, out, c_out);
+      for (size_type j = 0; j < l; ++j) {
+        for (size_type e = 0; e < out.n_elem(); ++e) {
+          scalar_type ref = c_out * mv2[j][e];
+          for (size_type i = 0; i < k; ++i) ref += c[j * ldc + i] * mv1[i][e];
+          RC_ASSERT_NC(krims::numcomp(ref).tolerance(1e-12) == out[j][e]);
+        }
+      }
+    };
+    CHECK(rc::check("MultiVector: block_gram() and block_combine()", test));
+  }  // Block operations
+
   // TODO full stateful test
 
 }  // MultiVector class
@@ -21,6 +21,7 @@
 #include <lazyten/SmallMatrix.hh>
 #include <lazyten/SmallVector.hh>
 #include <lazyten/random.hh>
+#include <numeric>
 
 namespace lazyten {
 namespace tests {
@@ -126,6 +127,66 @@ TEST_CASE("Random number/vector/matrix generator", "[random]") {
     CHECK(testable());
   }
 
+  SECTION("Philox4x32-10 known-answer vectors") {
+    // Reference values from the kat_vectors file of Random123
+    typedef std::array<uint32_t, 4> ctr_type;
+    typedef std::array<uint32_t, 2> key_type;
+    CHECK(detail::philox4x32(ctr_type{{0, 0, 0, 0}}, key_type{{0, 0}}) ==
+          (ctr_type{{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}}));
+    CHECK(detail::philox4x32(ctr_type{{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+                             key_type{{0xffffffff, 0xffffffff}}) ==
+          (ctr_type{{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}}));
+    CHECK(detail::philox4x32(ctr_type{{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+                             key_type{{0xa4093822, 0x299f31d0}}) ==
+          (ctr_type{{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}));
+  }
+
+  SECTION("Counter-based generation is independent of the thread count") {
+    CounterRandomScalar<double> gen(42);
+    matrix_type m1(150, 130, false);
+    matrix_type m2(150, 130, false);
+    fill_random(m1, gen, 1);
+    fill_random(m2, gen, 7);
+    CHECK(m1 == m2);
+    CHECK(std::all_of(std::begin(m1), std::end(m1),
+                      [](double t) { return -100 <= t && t < 100; }));
+
+    // Row-major element i is the value with index i
+    CHECK(m1(3, 5) == gen(3 * 130 + 5));
+
+    // Vector k of a MultiVector continues the stream after vector k-1
+    MultiVector<vector_type> mv(20000, 3, false);
+    fill_random(mv, gen, 4, 10);
+    CHECK(mv[0][0] == gen(10));
+    CHECK(mv[2][17] == gen(10 + 2 * 20000 + 17));
+
+    // Different seeds give different values
+    CounterRandomScalar<double> other(43);
+    CHECK(other(0) != gen(0));
+  }
+
+  SECTION("Counter-based normal distribution") {
+    const auto gen = CounterRandomScalar<double>::normal(3, 1., 2.);
+    vector_type v(200000, false);
+    fill_random(v, gen);
+
+    const double mean = std::accumulate(std::begin(v), std::end(v), 0.) / v.n_elem();
+    double variance = 0;
+    for (const double x : v) variance += (x - mean) * (x - mean);
+    variance /= v.n_elem();
+    CHECK(std::abs(mean - 1.) < 0.05);
+    CHECK(std::abs(variance - 4.) < 0.1);
+  }
+
+  SECTION("Counter-based complex numbers in range [12,15)") {
+    CounterRandomScalar<std::complex<double>> gen(5, 12, 15);
+    bool ok = true;
+    for (uint64_t i = 0; i < 1000; ++i) {
+      const std::complex<double> z = gen(i);
+      ok = ok && 12 <= z.real() && z.real() < 15 && 12 <= z.imag() && z.imag() < 15;
+    }
+    CHECK(ok);
+  }
 }  // Random object generator
 
 }  // namespace tests
@@ -0,0 +1,174 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <catch.hpp>
+#include <lazyten/EigensystemSolver.hh>
+#include <lazyten/SmallMatrix.hh>
+#include <lazyten/SmallVector.hh>
+#include <lazyten/SpectrumSlicing.hh>
+#include <lazyten/TestingUtils.hh>
+#include <numeric>
+
+#ifdef LAZYTEN_HAVE_LAPACK
+namespace lazyten {
+namespace tests {
+
+TEST_CASE("SpectrumSlicingEigensolver", "[SpectrumSlicingEigensolver]") {
+  typedef SmallMatrix<double> matrix_type;
+  typedef SpectrumSlicingEigensolverKeys keys;
+
+  // Tridiagonal test matrix with a well-spread spectrum
+  const size_t dim = 80;
+  matrix_type mat(dim, dim);
+  for (size_t i = 0; i < dim; ++i) {
+    mat(i, i) = 0.25 * static_cast<double>(i) + std::sin(static_cast<double>(i));
+    if (i + 1 < dim) mat(i, i + 1) = mat(i + 1, i) = 0.3;
+  }
+
+  // Reference: All eigenvalues from Lapack
+  Eigenproblem<true, matrix_type> full_prob(mat, dim);
+  const auto reference = LapackEigensolver<decltype(full_prob)>{}.solve(full_prob);
+  const std::vector<double>& all_evals = reference.eigensolution().evalues();
+
+  auto in_interval = [&all_evals](double lower, double upper) {
+    std::vector<double> ret;
+    for (const double v : all_evals) {
+      if (v >= lower && v < upper) ret.push_back(v);
+    }
+    return ret;
+  };
+
+  SECTION("Interior eigenpairs on multiple threads") {
+    Eigenproblem<true, matrix_type> prob(mat, 1);
+    krims::GenMap params{{keys::lower, 4.},
+                         {keys::upper, 12.},
+                         {keys::n_windows, size_t(4)},
+                         {keys::n_threads, size_t(3)}};
+    SpectrumSlicingEigensolver<decltype(prob)> solver{params};
+    const auto state = solver.solve(prob);
+
+    const std::vector<double> expected = in_interval(4., 12.);
+    const auto& soln = state.eigensolution();
+    REQUIRE(soln.evalues().size() == expected.size());
+    REQUIRE(state.window_counts.size() == 4);
+    CHECK(std::accumulate(state.window_counts.begin(), state.window_counts.end(),
+                          size_t(0)) == expected.size());
+
+    SmallVector<double> evals(soln.evalues());
+    SmallVector<double> evals_ref(expected);
+    CHECK(evals == numcomp(evals_ref).tolerance(1e-9));
+
+    // Check the residuals
+    for (size_t i = 0; i < soln.n_ep(); ++i) {
+      SmallVector<double> res = mat * soln.evectors()[i];
+      res -= soln.evalues()[i] * soln.evectors()[i];
+      CHECK(norm_l2(res) < 1e-8);
+    }
+  }  // Interior eigenpairs
+
+  SECTION("Memory limit serialises the factorisations") {
+    // Too little memory for a single copy of the matrix: The windows are
+    // processed one after another with the same results.
+    Eigenproblem<true, matrix_type> prob(mat, 1);
+    krims::GenMap params{{keys::lower, 4.},
+                         {keys::upper, 12.},
+                         {keys::n_windows, size_t(4)},
+                         {keys::n_threads, size_t(3)}};
+    const auto state = SpectrumSlicingEigensolver<decltype(prob)>{params}.solve(prob);
+    params.update(EigensolverCostModelKeys::max_dense_memory, size_t(1));
+    const auto limited = SpectrumSlicingEigensolver<decltype(prob)>{params}.solve(prob);
+
+    CHECK(limited.n_factorisations == state.n_factorisations);
+    CHECK(limited.eigensolution().evalues() == state.eigensolution().evalues());
+  }  // Memory limit
+
+  SECTION("Generalised problem") {
+    // Positive definite tridiagonal metric, such that the shifted
+    // factorisations of A - t B and their inertia involve B.
+    matrix_type b(dim, dim);
+    for (size_t i = 0; i < dim; ++i) {
+      b(i, i) = 1. + 0.2 * static_cast<double>(i % 4);
+      if (i + 1 < dim) b(i, i + 1) = b(i + 1, i) = 0.1;
+    }
+
+    Eigenproblem<true, matrix_type, matrix_type> full_gprob(mat, b, dim);
+    const auto gref = LapackEigensolver<decltype(full_gprob)>{}.solve(full_gprob);
+    std::vector<double> expected;
+    for (const double v : gref.eigensolution().evalues()) {
+      if (v >= 2. && v < 8.) expected.push_back(v);
+    }
+
+    Eigenproblem<true, matrix_type, matrix_type> prob(mat, b, 1);
+    krims::GenMap params{{keys::lower, 2.},
+                         {keys::upper, 8.},
+                         {keys::n_windows, size_t(3)},
+                         {keys::n_threads, size_t(2)}};
+    const auto state = SpectrumSlicingEigensolver<decltype(prob)>{params}.solve(prob);
+    const auto& soln = state.eigensolution();
+
+    // The inertia counts of A - t B agree with the reference
+    REQUIRE(soln.evalues().size() == expected.size());
+    CHECK(std::accumulate(state.window_counts.begin(), state.window_counts.end(),
+                          size_t(0)) == expected.size());
+    CHECK(state.residual_tolerance == 100 * Constants<double>::default_tolerance);
+
+    SmallVector<double> evals(soln.evalues());
+    SmallVector<double> evals_ref(expected);
+    CHECK(evals == numcomp(evals_ref).tolerance(1e-9));
+
+    for (size_t i = 0; i < soln.n_ep(); ++i) {
+      SmallVector<double> res = mat * soln.evectors()[i];
+      SmallVector<double> bx = b * soln.evectors()[i];
+      res -= soln.evalues()[i] * bx;
+      CHECK(norm_l2(res) < 1e-8);
+    }
+  }  // Generalised problem
+
+  SECTION("Eigenvalues on the window boundaries") {
+    matrix_type diag(20, 20);
+    for (size_t i = 0; i < 20; ++i) diag(i, i) = static_cast<double>(i);
+    Eigenproblem<true, matrix_type> prob(diag, 1);
+
+    krims::GenMap params{{keys::lower, 4.},
+                         {keys::upper, 10.},
+                         {keys::n_windows, size_t(3)},
+                         {keys::n_threads, size_t(2)}};
+    const auto state = SpectrumSlicingEigensolver<decltype(prob)>{params}.solve(prob);
+    const auto& evals = state.eigensolution().evalues();
+
+    // [4, 10) contains 4, ..., 9 and the inertia puts boundary eigenvalues
+    // into the window to their right.
+    CHECK(state.window_counts == (std::vector<size_t>{2, 2, 2}));
+    REQUIRE(evals.size() == 6);
+    for (size_t i = 0; i < 6; ++i) CHECK(evals[i] == Approx(4. + static_cast<double>(i)));
+  }  // Boundary eigenvalues
+
+  SECTION("Use via EigensystemSolver") {
+    Eigenproblem<true, matrix_type> prob(mat, 1);
+    krims::GenMap params{{EigensystemSolverKeys::method, "slicing"},
+                         {keys::lower, -1.},
+                         {keys::upper, 3.}};
+    const auto state = EigensystemSolver<decltype(prob)>{params}.solve(prob);
+    CHECK(state.eigensolution().evalues().size() == in_interval(-1., 3.).size());
+  }  // EigensystemSolver
+}
+
+}  // namespace tests
+}  // namespace lazyten
+#endif  // LAZYTEN_HAVE_LAPACK
@@ -0,0 +1,112 @@
+//
+// Copyright (C) 2016-17 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "generators.hh"
+#include "rapidcheck_utils.hh"
+#include <catch.hpp>
+#include <lazyten/Builtin/BuiltinVector.hh>
+#include <lazyten/SmallVector.hh>
+#include <lazyten/TestingUtils.hh>
+#include <lazyten/VectorExpression.hh>
+
+namespace lazyten {
+namespace tests {
+using namespace rc;
+
+namespace vector_expression_tests {
+template <typename Vector>
+void run_expression_tests(const std::string& prefix) {
+  typedef typename Vector::scalar_type scalar_type;
+
+  auto test_assign = [] {
+    const auto n_elem = *gen::numeric_size<2>().as("Number of elements");
+    const auto x = *gen::numeric_tensor<Vector>(n_elem).as("x");
+    const auto y = *gen::numeric_tensor<Vector>(n_elem).as("y");
+    const auto z = *gen::numeric_tensor<Vector>(n_elem).as("z");
+    const auto a = *gen::numeric<scalar_type>().as("a");
+    const auto b = *gen::numeric<scalar_type>().as("b");
+
+    // Reference using the vector operators and temporaries
+    const Vector ref = a * x + b * y - z;
+
+    Vector res(n_elem, false);
+    assign(res, a * as_expression(x) + as_expression(y) * b - z);
+    RC_ASSERT_NC(res == numcomp(ref));
+
+    // Construction from an expression
+    Vector constructed(a * as_expression(x) + b * as_expression(y) - z);
+    RC_ASSERT_NC(constructed == numcomp(ref));
+
+    // The assigned vector may appear in the expression
+    Vector inplace(z);
+    assign(inplace,
+           -as_expression(inplace) + a * as_expression(x) + b * as_expression(y));
+    RC_ASSERT_NC(inplace == numcomp(ref));
+
+    const scalar_type two = 2;
+    RC_ASSERT_NC(as_expression(x) / two == numcomp(x / two));
+  };
+
+  auto test_reductions = [] {
+    const auto n_elem = *gen::numeric_size<2>().as("Number of elements");
+    const auto x = *gen::numeric_tensor<Vector>(n_elem).as("x");
+    const auto y = *gen::numeric_tensor<Vector>(n_elem).as("y");
+    const auto a = *gen::numeric<scalar_type>().as("a");
+
+    const Vector diff = x - a * y;
+    const auto expr = as_expression(x) - a * as_expression(y);
+    RC_ASSERT_NC(dot(expr, y) == numcomp(dot(diff, y)));
+    RC_ASSERT_NC(dot(expr, expr) == numcomp(dot(diff, diff)));
+    RC_ASSERT_NC(accumulate(expr) == numcomp(accumulate(diff)));
+    RC_ASSERT_NC(norm_l2(expr) == numcomp(norm_l2(diff)));
+  };
+
+  CHECK(rc::check(prefix + "Assignment of fused expressions", test_assign));
+  CHECK(rc::check(prefix + "Reductions of fused expressions", test_reductions));
+}
+}  // namespace vector_expression_tests
+
+TEST_CASE("Fused vector expressions", "[VectorExpression]") {
+  using namespace vector_expression_tests;
+
+  SECTION("Memory vectors") {
+    run_expression_tests<SmallVector<double>>("SmallVector<double>: ");
+    run_expression_tests<BuiltinVector<double>>("BuiltinVector<double>: ");
+    run_expression_tests<BuiltinVector<std::complex<double>>>(
+          "BuiltinVector<complex double>: ");
+  }
+
+  SECTION("Operations on expressions are fused") {
+    BuiltinVector<double> x{1, 2, 3, 4};
+    BuiltinVector<double> y{4, 3, 2, 1};
+    auto expr = 2. * as_expression(x) + as_expression(y);
+    static_assert(IsVectorExpression<decltype(expr)>::value,
+                  "Combination of vector expressions is not an expression");
+    static_assert(IsVector<decltype(expr)>::value,
+                  "Vector expressions are not vectors");
+
+    // Expressions are evaluated lazily, i.e. see changes to the vectors
+    CHECK(expr[0] == 6.);
+    x[0] = 2;
+    CHECK(expr[0] == 8.);
+  }
+}
+
+}  // namespace tests
+}  // namespace lazyten
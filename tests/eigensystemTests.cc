@@ -18,9 +18,11 @@
 //
 
 #include "eigensolver_tests.hh"
+#include <lazyten/EigensystemSolver.hh>
 #include <lazyten/LazyMatrixWrapper.hh>
 #include <lazyten/SmallMatrix.hh>
 #include <lazyten/SmallVector.hh>
+#include <lazyten/TestingUtils.hh>
 #include <lazyten/eigensystem.hh>
 
 namespace lazyten {
@@ -217,6 +219,237 @@ TEST_CASE("eigensystem", "[eigensystem]") {
 
     CHECK(rc::check("Test block-diagonal problems", testable));
   }  //
+
+  SECTION("Block-sparse solution of a block-diagonal problem") {
+    using lazyten::EigensystemSolverKeys;
+    typedef LazyMatrixWrapper<matrix_type> lazy_type;
+
+    matrix_type m1{{2, 1, 0}, {1, 2, 1}, {0, 1, 2}};
+    matrix_type m2{{5}};
+    matrix_type m3{{1, 0.5}, {0.5, 3}};
+    BlockDiagonalMatrix<lazy_type, 3> diag{
+          {{lazy_type(std::move(m1)), lazy_type(std::move(m2)),
+            lazy_type(std::move(m3))}}};
+
+    krims::GenMap params{{EigensystemSolverKeys::method, "lapack"},
+                         {EigensystemSolverKeys::which, "SR"},
+                         {EigensystemSolverKeys::n_block_threads, size_t(3)}};
+    krims::GenMap params_serial{{EigensystemSolverKeys::method, "lapack"},
+                                {EigensystemSolverKeys::which, "SR"},
+                                {EigensystemSolverKeys::n_block_threads, size_t(1)}};
+
+    const auto sol = eigensystem_hermitian_blocks(diag, 5, params);
+    const auto sol_serial = eigensystem_hermitian_blocks(diag, 5, params_serial);
+
+    REQUIRE(sol.n_ep() == 5);
+    CHECK(sol.dim == 6);
+    CHECK(sol.block_offsets == (std::array<size_t, 3>{{0, 3, 4}}));
+    CHECK(sol.blocks[0].n_ep() == 2);
+    CHECK(sol.blocks[1].n_ep() == 1);
+    CHECK(sol.blocks[2].n_ep() == 2);
+    CHECK(sol.blocks[0].evectors().n_elem() == 3);
+    CHECK(sol.blocks[2].evectors().n_elem() == 2);
+
+    // Parallel and serial solve agree and padding agrees
+    // with the direct zero-padded solution.
+    const auto padded = sol.padded();
+    const auto padded_serial = sol_serial.padded();
+    const auto direct = eigensystem_hermitian(diag, 5, params);
+    CHECK(padded.evalues() == padded_serial.evalues());
+    CHECK(padded.evalues() == direct.evalues());
+    for (size_t i = 0; i < padded.n_ep(); ++i) {
+      CHECK(padded.evectors()[i] == padded_serial.evectors()[i]);
+      CHECK(padded.evectors()[i] == direct.evectors()[i]);
+    }
+  }  // Block-sparse solution
+
+  SECTION("Number of threads used for the blocks") {
+    using lazyten::EigensystemSolverKeys;
+    const size_t n_hardware = std::max(1u, std::thread::hardware_concurrency());
+    CHECK(detail::n_block_threads(krims::GenMap{}) == n_hardware);
+    CHECK(detail::n_block_threads({{EigensystemSolverKeys::method, "auto"}}) ==
+          n_hardware);
+    CHECK(detail::n_block_threads({{EigensystemSolverKeys::method, "arpack"}}) ==
+          n_hardware);
+    CHECK(detail::n_block_threads({{EigensystemSolverKeys::method, "lapack"}}) ==
+          n_hardware);
+    CHECK(detail::n_block_threads({{EigensystemSolverKeys::method, "arpack"},
+                                   {EigensystemSolverKeys::n_block_threads,
+                                    size_t(4)}}) == 4);
+  }  // Number of threads
+
+#ifdef LAZYTEN_HAVE_ARPACK
+  SECTION("Blocks solved concurrently by ARPACK") {
+    using lazyten::EigensystemSolverKeys;
+    typedef LazyMatrixWrapper<matrix_type> lazy_type;
+    constexpr size_t n_blocks = 4;
+    const size_t dim = 30;
+
+    std::vector<matrix_type> mats;
+    for (size_t b = 0; b < n_blocks; ++b) {
+      matrix_type m(dim, dim);
+      for (size_t i = 0; i < dim; ++i) {
+        m(i, i) = static_cast<double>(i + 1 + b);
+        if (i + 1 < dim) m(i, i + 1) = m(i + 1, i) = 0.1 * static_cast<double>(b + 1);
+      }
+      mats.push_back(std::move(m));
+    }
+    BlockDiagonalMatrix<lazy_type, n_blocks> diag{
+          {{lazy_type(mats[0]), lazy_type(mats[1]), lazy_type(mats[2]),
+            lazy_type(mats[3])}}};
+
+    krims::GenMap params{{EigensystemSolverKeys::method, "arpack"},
+                         {EigensystemSolverKeys::which, "SR"},
+                         {EigensystemSolverKeys::n_block_threads, size_t(n_blocks)}};
+    krims::GenMap params_ref{{EigensystemSolverKeys::method, "arpack"},
+                             {EigensystemSolverKeys::which, "SR"},
+                             {EigensystemSolverKeys::n_block_threads, size_t(1)}};
+    const auto sol = eigensystem_hermitian_blocks(diag, 2 * n_blocks, params);
+    const auto sol_ref = eigensystem_hermitian_blocks(diag, 2 * n_blocks, params_ref);
+
+    REQUIRE(sol.n_ep() == 2 * n_blocks);
+    for (size_t b = 0; b < n_blocks; ++b) {
+      INFO("Block " + std::to_string(b));
+      REQUIRE(sol.blocks[b].n_ep() == 2);
+      SmallVector<double> evals(sol.blocks[b].evalues());
+      SmallVector<double> evals_ref(sol_ref.blocks[b].evalues());
+      CHECK(evals == numcomp(evals_ref).tolerance(1e-10));
+
+      for (size_t i = 0; i < 2; ++i) {
+        const auto& evec = sol.blocks[b].evectors()[i];
+        SmallVector<double> av = mats[b] * evec;
+        SmallVector<double> lv = sol.blocks[b].evalues()[i] * evec;
+        CHECK(av == numcomp(lv).tolerance(1e-9));
+      }
+    }
+  }  // Blocks solved concurrently by ARPACK
+#endif  // LAZYTEN_HAVE_ARPACK
+
+  SECTION("Automatic method selection records its reasoning") {
+    matrix_type m{{2, 1, 0}, {1, 2, 1}, {0, 1, 2}};
+    Eigenproblem<true, matrix_type> prob(m, 2);
+
+    EigensystemSolver<decltype(prob)> solver{{{EigensystemSolverKeys::method, "auto"}}};
+    const auto state = solver.solve(prob);
+    CHECK(state.selected_method() != "");
+    CHECK(state.selected_method() != "auto");
+    CHECK_FALSE(state.selection_reasons().empty());
+    CHECK(state.eigensolution().n_ep() == 2);
+
+    EigensystemSolver<decltype(prob)> explicit_solver{
+          {{EigensystemSolverKeys::method, state.selected_method()}}};
+    const auto explicit_state = explicit_solver.solve(prob);
+    CHECK(explicit_state.selected_method() == state.selected_method());
+    CHECK(explicit_state.selection_reasons().empty());
+  }  // Automatic method selection
+
+  SECTION("Cost model estimates") {
+    EigensolverCostModel model;
+    model.seconds_per_dense_flop = 1e-10;
+    model.seconds_per_apply_flop = 1e-9;
+    model.seconds_per_ortho_flop = 2e-9;
+    model.applies_per_eigenpair = 40.;
+
+    // Tridiagonalisation, back-transformation and Cholesky reduction
+    CHECK(EigensolverCostModel::dense_flops(10, 2, false) ==
+          numcomp(4. / 3. * 1000. + 400.));
+    CHECK(EigensolverCostModel::dense_flops(10, 2, true) ==
+          numcomp(4. / 3. * 1000. + 400. + 7. / 3. * 1000.));
+
+    // Copies of A, the eigenvectors, the workspace and B
+    CHECK(EigensolverCostModel::dense_memory(10, false, 8) == size_t(4 * 100 * 8));
+    CHECK(EigensolverCostModel::dense_memory(10, true, 8) == size_t(5 * 100 * 8));
+
+    // Extraction of lazy matrices costs dim applies
+    const double t_flops = 1e-10 * EigensolverCostModel::dense_flops(10, 2, false);
+    CHECK(model.dense_time(10, 2, false, true, 1e-3) == numcomp(t_flops));
+    CHECK(model.dense_time(10, 2, false, false, 1e-3) == numcomp(t_flops + 1e-2));
+
+    // 80 applies, each with an orthogonalisation against 5 vectors of size 100,
+    // which is charged at the orthogonalisation rate only.
+    const double t_iter = 80. * (1e-6 + 2e-9 * 4. * 100. * 5.);
+    CHECK(model.iterative_time(100, 2, 1e-6) == numcomp(t_iter));
+    model.seconds_per_dense_flop = 1.;
+    CHECK(model.iterative_time(100, 2, 1e-6) == numcomp(t_iter));
+
+    // Parameters can be set and read via a GenMap
+    krims::GenMap map;
+    model.get_parameters(map);
+    CHECK(map.at<double>(EigensolverCostModelKeys::seconds_per_ortho_flop) == 2e-9);
+    EigensolverCostModel from_map{
+          krims::GenMap{{EigensolverCostModelKeys::seconds_per_ortho_flop, 3e-9}}};
+    CHECK(from_map.seconds_per_ortho_flop == 3e-9);
+  }  // Cost model estimates
+
+  SECTION("Cost model switches between dense and iterative methods") {
+    auto tridiagonal = [](size_t dim) {
+      matrix_type m(dim, dim);
+      for (size_t i = 0; i < dim; ++i) {
+        m(i, i) = static_cast<double>(i + 1);
+        if (i + 1 < dim) m(i, i + 1) = m(i + 1, i) = 0.1;
+      }
+      return m;
+    };
+    auto is_dense = [](const std::string& method) {
+      return method == "lapack" || method == "armadillo";
+    };
+
+    // A tiny problem is solved densely
+    const matrix_type small = tridiagonal(6);
+    Eigenproblem<true, matrix_type> small_prob(small, 2);
+    EigensystemSolver<decltype(small_prob)> solver{
+          {{EigensystemSolverKeys::method, "auto"}}};
+    CHECK(is_dense(solver.solve(small_prob).selected_method()));
+
+    // Without memory for the dense method the iterative one is forced
+    const matrix_type large = tridiagonal(40);
+    Eigenproblem<true, matrix_type> large_prob(large, 2);
+    EigensystemSolver<decltype(large_prob)> no_memory{
+          {{EigensystemSolverKeys::method, "auto"},
+           {EigensolverCostModelKeys::max_dense_memory, size_t(1)}}};
+    const auto state = no_memory.solve(large_prob);
+    CHECK_FALSE(is_dense(state.selected_method()));
+    REQUIRE_FALSE(state.selection_reasons().empty());
+    CHECK(state.selection_reasons().back().find("memory") != std::string::npos);
+
+    // Expensive dense flops select the iterative method, too.
+    EigensystemSolver<decltype(large_prob)> slow_dense{
+          {{EigensystemSolverKeys::method, "auto"},
+           {EigensolverCostModelKeys::seconds_per_dense_flop, 1.}}};
+    CHECK_FALSE(is_dense(slow_dense.solve(large_prob).selected_method()));
+  }  // Cost model switches
+
+  SECTION("Warm-started sequence of eigenproblems") {
+    const size_t dim = 40;
+    matrix_type m(dim, dim);
+    for (size_t i = 0; i < dim; ++i) {
+      m(i, i) = static_cast<double>(i + 1);
+      if (i + 1 < dim) m(i, i + 1) = m(i + 1, i) = 0.1;
+    }
+    Eigenproblem<true, matrix_type> prob(m, 3);
+
+    EigensystemSolver<decltype(prob)> solver{{{EigensystemSolverKeys::method, "lanczos"},
+                                              {EigensystemSolverKeys::which, "SR"}}};
+    const auto cold = solver.solve_next(prob);
+    const auto warm = solver.solve_next(prob);
+
+    CHECK(cold.sequence_index == 0);
+    CHECK(warm.sequence_index == 1);
+    CHECK(warm.selected_method() == "lanczos");
+    CHECK(warm.n_mtx_applies_cold == cold.n_mtx_applies());
+    CHECK(warm.n_mtx_applies() <= cold.n_mtx_applies());
+    CHECK(warm.n_mtx_applies_saved() == cold.n_mtx_applies() - warm.n_mtx_applies());
+
+    SmallVector<double> evals_cold(cold.eigensolution().evalues());
+    SmallVector<double> evals_warm(warm.eigensolution().evalues());
+    CHECK(evals_warm == numcomp(evals_cold).tolerance(1e-8));
+
+    // A reset starts a new sequence
+    solver.reset_sequence();
+    const auto restart = solver.solve_next(prob);
+    CHECK(restart.sequence_index == 0);
+    CHECK(restart.n_mtx_applies_saved() == 0);
+  }  // Warm-started sequence
 }  // eigensystem
 
 }  // namespace tests
@@ -90,6 +90,7 @@ struct FunctionalityTests : public matrix_tests::ComparativeTests<CompMatrix, Su
     }
 
     test_convert_to_stored(model, sut);
+    test_extract_diagonal(model, sut, low);
 
     if (norm_frobenius_squared(model) < problematic_norm) {
 #ifdef LAZYTEN_TESTS_VERBOSE
@@ -113,6 +114,20 @@ struct FunctionalityTests : public matrix_tests::ComparativeTests<CompMatrix, Su
     // Check that it is equivalent to the model:
     RC_ASSERT_NC(sm == numcomp(model).tolerance(tolerance));
   }
+
+  /** Test extracting the diagonal of the sut matrix */
+  static void test_extract_diagonal(
+        const compmat_type& model, const sutmat_type& sut,
+        const NumCompAccuracyLevel tolerance = NumCompAccuracyLevel::Default) {
+    typedef typename stored_matrix_type::vector_type vector_type;
+    const size_type n = std::min(model.n_rows(), model.n_cols());
+    vector_type diag(n, false);
+    for (size_type i = 0; i < n; ++i) diag[i] = model(i, i);
+
+    const vector_type res = sut.extract_diagonal();
+    RC_ASSERT(res.size() == n);
+    RC_ASSERT_NC(res == numcomp(diag).tolerance(tolerance));
+  }
 };
 
 /** Testing library for lazy matrices.
@@ -168,6 +183,7 @@ class TestingLibrary {
  protected:
   // The testing library and caller type
   typedef matrix_tests::ComparativeTests<stored_matrix_type, matrix_type> comptests;
+  typedef FunctionalityTests<stored_matrix_type, matrix_type> lazytests;
   typedef RCTestableGenerator<stored_matrix_type, matrix_type, genarg_type> gen_type;
 
   std::string m_prefix;
@@ -230,6 +246,8 @@ void TestingLibrary<LazyMatrix, LazyGenArg>::run_checks() const {
 
   CHECK(rc::check(m_prefix + "trace calculation",
                   m_gen.generate(comptests::test_trace, low)));
+  CHECK(rc::check(m_prefix + "Extract the diagonal",
+                  m_gen.generate(lazytests::test_extract_diagonal, low)));
 
   // Basic Operations (+, -, scaling)
   typedef LazyMatrixWrapper<stored_matrix_type> lazy_matrix_type;
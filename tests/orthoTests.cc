@@ -56,7 +56,7 @@ TEST_CASE("Test ortho function", "[ortho]") {
     return id;
   };
 
-  auto testable_pre = [](matrix_type m, bool is_id) {
+  auto testable_pre = [](matrix_type m, bool is_id, const krims::GenMap& params) {
     const size_t n_vecs = *gen::inRange<size_t>(2, m.n_cols()).as("Number of vectors");
 
     auto gen_non_zero_vec =
@@ -70,7 +70,7 @@ TEST_CASE("Test ortho function", "[ortho]") {
                  .as("Vectors to orthogonalise.");
 
     // Orthogonalise
-    const auto res = is_id ? ortho(vecs) : ortho(vecs, m);
+    const auto res = is_id ? ortho(vecs, params) : ortho(vecs, m, params);
 
     // Build scalar products
     const matrix_type innprod = dot(res, m * res);
@@ -80,18 +80,43 @@ TEST_CASE("Test ortho function", "[ortho]") {
     for (size_t i = 0; i < n_vecs; ++i) id(i, i) = 1;
 
     RC_ASSERT(numcomp(id) == innprod);
+
+    // The span of the first k vectors is kept, i.e. the result is the
+    // Q of a QR factorisation with positive diagonal of R.
+    const matrix_type r = dot(res, m * vecs);
+    for (size_t j = 0; j < n_vecs; ++j) {
+      RC_ASSERT(r(j, j) > 0);
+      for (size_t i = j + 1; i < n_vecs; ++i) {
+        RC_ASSERT(std::abs(r(i, j)) < 1e-8 * std::abs(r(j, j)));
+      }
+    }
   };
 
+  const krims::GenMap cholqr2{{OrthoKeys::method, std::string("cholqr2")}};
+  const krims::GenMap cgs2{{OrthoKeys::method, std::string("cgs2")},
+                           {OrthoKeys::block_size, size_t(2)}};
+  const krims::GenMap householder{{OrthoKeys::method, std::string("householder")}};
+
   SECTION("Orthogonalise random real vectors") {
-    CHECK(rc::check("Orthogonalise random real vectors",
-                    [&testable_pre, &gen_id]() { testable_pre(gen_id(), true); }));
+    CHECK(rc::check("Orthogonalise random real vectors (CholQR2)",
+                    [&]() { testable_pre(gen_id(), true, cholqr2); }));
+    CHECK(rc::check("Orthogonalise random real vectors (block CGS2)",
+                    [&]() { testable_pre(gen_id(), true, cgs2); }));
+    CHECK(rc::check("Orthogonalise random real vectors (Householder)",
+                    [&]() { testable_pre(gen_id(), true, householder); }));
   }
 
   SECTION("M-orthogonalise random real vectors") {
-    CHECK(rc::check("M-orthogonalise random real vectors",
-                    [&testable_pre, &gen_pos_dev_mat]() {
-                      testable_pre(gen_pos_dev_mat(), false);
-                    }));
+    CHECK(rc::check("M-orthogonalise random real vectors (CholQR2)",
+                    [&]() { testable_pre(gen_pos_dev_mat(), false, cholqr2); }));
+    CHECK(rc::check("M-orthogonalise random real vectors (block CGS2)",
+                    [&]() { testable_pre(gen_pos_dev_mat(), false, cgs2); }));
+  }
+
+  SECTION("Householder needs the Euclidean inner product") {
+    MultiVector<vector_type> vecs{{1., 2., 3.}, {0., 1., 1.}};
+    matrix_type m{{2., 0., 0.}, {0., 1., 0.}, {0., 0., 1.}};
+    CHECK_THROWS_AS(ortho(vecs, m, householder), ExcInvalidOrthoParameters);
   }
 
 }  // Test ortho function
@@ -0,0 +1,165 @@
+//
+// Copyright (C) 2017 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <catch.hpp>
+#include <lazyten/LazyMatrixWrapper.hh>
+#include <lazyten/SmallMatrix.hh>
+#include <lazyten/SmallVector.hh>
+#include <lazyten/TestingUtils.hh>
+#include <lazyten/randomised_svd.hh>
+#include <numeric>
+
+namespace lazyten {
+namespace tests {
+
+TEST_CASE("Randomised SVD", "[randomised_svd]") {
+  typedef double scalar_type;
+  typedef SmallVector<scalar_type> vector_type;
+  typedef SmallMatrix<scalar_type> matrix_type;
+
+  // Build a matrix with known, geometrically decaying singular values
+  // from random orthonormal singular vectors
+  const size_t n_rows = 120;
+  const size_t n_cols = 80;
+  const auto gen = CounterRandomScalar<scalar_type>::normal(1);
+  MultiVector<vector_type> x(n_rows, n_cols, false);
+  MultiVector<vector_type> y(n_cols, n_cols, false);
+  fill_random(x, gen);
+  fill_random(y, gen, std::thread::hardware_concurrency(), n_rows * n_cols);
+  const krims::GenMap householder{{OrthoKeys::method, std::string("householder")}};
+  x = ortho(x, householder);
+  y = ortho(y, householder);
+
+  std::vector<scalar_type> sigma(n_cols);
+  for (size_t i = 0; i < n_cols; ++i) sigma[i] = std::pow(0.7, i);
+  const LowRankMatrix<matrix_type> exact(x, sigma, y);
+
+  matrix_type a(n_rows, n_cols, false);
+  exact.extract_block(a, 0, 0);
+  const LazyMatrixWrapper<matrix_type> lazy_a(a);
+
+  // Identity of size k
+  auto identity = [](size_t k) {
+    matrix_type id(k, k);
+    for (size_t i = 0; i < k; ++i) id(i, i) = 1;
+    return id;
+  };
+
+  SECTION("Singular values and singular vectors") {
+    const size_t rank = 10;
+    const krims::GenMap params{{RandomisedSvdKeys::seed, size_t(5)}};
+    const auto lr = randomised_svd(lazy_a, rank, params);
+    REQUIRE(lr.rank() == rank);
+    REQUIRE(lr.n_rows() == n_rows);
+    REQUIRE(lr.n_cols() == n_cols);
+
+    for (size_t i = 0; i < rank; ++i) {
+      CHECK(lr.weights()[i] == Approx(sigma[i]).epsilon(1e-10));
+    }
+    CHECK(dot(lr.left_factors(), lr.left_factors()) ==
+          numcomp(identity(rank)).tolerance(1e-12));
+    CHECK(dot(lr.right_factors(), lr.right_factors()) ==
+          numcomp(identity(rank)).tolerance(1e-12));
+
+    // The approximation error is the optimal one, i.e. the norm of
+    // the truncated singular values.
+    matrix_type approx(n_rows, n_cols, false);
+    lr.extract_block(approx, 0, 0);
+    scalar_type error = 0;
+    for (size_t i = 0; i < n_rows; ++i) {
+      for (size_t j = 0; j < n_cols; ++j) {
+        error += (approx(i, j) - a(i, j)) * (approx(i, j) - a(i, j));
+      }
+    }
+    scalar_type optimal = 0;
+    for (size_t i = rank; i < n_cols; ++i) optimal += sigma[i] * sigma[i];
+    CHECK(std::sqrt(error) == Approx(std::sqrt(optimal)).epsilon(1e-6));
+  }
+
+  SECTION("Same seed gives the same result") {
+    const krims::GenMap params{{RandomisedSvdKeys::seed, size_t(3)},
+                               {RandomisedSvdKeys::n_power_iterations, size_t(0)}};
+    const auto lr1 = randomised_svd(lazy_a, 5, params);
+    const auto lr2 = randomised_svd(lazy_a, 5, params);
+    CHECK(lr1.weights() == lr2.weights());
+  }
+
+  SECTION("Range finder") {
+    const krims::GenMap params{{RandomisedSvdKeys::seed, size_t(7)}};
+    const auto q = randomised_range_finder(lazy_a, 15, params);
+    REQUIRE(q.n_vectors() == 15);
+    REQUIRE(q.n_elem() == n_rows);
+    CHECK(dot(q, q) == numcomp(identity(15)).tolerance(1e-12));
+
+    // The dominant left singular vector lies in the span of q
+    scalar_type norm2 = 0;
+    for (const auto& qi : q) {
+      const scalar_type proj =
+            std::inner_product(std::begin(qi), std::end(qi), std::begin(x[0]), 0.);
+      norm2 += proj * proj;
+    }
+    CHECK(norm2 == Approx(1.).epsilon(1e-10));
+  }
+
+  SECTION("LowRankMatrix operations agree with the stored matrix") {
+    const auto lr = randomised_svd(lazy_a, 7);
+    matrix_type full(n_rows, n_cols, false);
+    lr.extract_block(full, 0, 0);
+
+    MultiVector<vector_type> in(n_cols, 2, false);
+    MultiVector<vector_type> in_t(n_rows, 2, false);
+    fill_random(in, CounterRandomScalar<scalar_type>(11));
+    fill_random(in_t, CounterRandomScalar<scalar_type>(12));
+
+    MultiVector<vector_type> out(n_rows, 2, false);
+    MultiVector<vector_type> out_t(n_cols, 2, false);
+    lr.apply(in, out);
+    lr.apply(in_t, out_t, Transposed::Trans);
+    for (size_t v = 0; v < 2; ++v) {
+      vector_type ref(n_rows);
+      vector_type ref_t(n_cols);
+      for (size_t i = 0; i < n_rows; ++i) {
+        for (size_t j = 0; j < n_cols; ++j) {
+          ref[i] += full(i, j) * in[v][j];
+          ref_t[j] += full(i, j) * in_t[v][i];
+        }
+      }
+      CHECK(out[v] == numcomp(ref).tolerance(1e-10));
+      CHECK(out_t[v] == numcomp(ref_t).tolerance(1e-10));
+    }
+
+    matrix_type block(5, 4, false);
+    lr.extract_block(block, 3, 2, Transposed::Trans);
+    for (size_t i = 0; i < 5; ++i) {
+      for (size_t j = 0; j < 4; ++j) {
+        CHECK(block(i, j) == Approx(full(2 + j, 3 + i)));
+      }
+    }
+    CHECK(lr(4, 9) == Approx(full(4, 9)));
+  }
+
+  SECTION("Invalid parameters") {
+    CHECK_THROWS_AS(randomised_svd(lazy_a, n_cols + 1),
+                    ExcInvalidRandomisedSvdParameters);
+    CHECK(randomised_svd(lazy_a, 0).rank() == 0);
+  }
+}  // Randomised SVD
+
+}  // namespace tests
+}  // namespace lazyten
@@ -0,0 +1,177 @@
+//
+// Copyright (C) 2017 by the lazyten authors
+//
+// This file is part of lazyten.
+//
+// lazyten is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// lazyten is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with lazyten. If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <catch.hpp>
+#include <lazyten/LazyMatrixWrapper.hh>
+#include <lazyten/SmallMatrix.hh>
+#include <lazyten/SmallVector.hh>
+#include <lazyten/TestingUtils.hh>
+#include <lazyten/stochastic_estimators.hh>
+
+namespace lazyten {
+namespace tests {
+
+TEST_CASE("Stochastic trace and diagonal estimation", "[stochastic_estimators]") {
+  typedef double scalar_type;
+  typedef SmallVector<scalar_type> vector_type;
+  typedef SmallMatrix<scalar_type> matrix_type;
+
+  // Symmetric positive semi-definite matrix with decaying eigenvalues
+  // and a dominant diagonal: B B^T + D with a random n x 5 matrix B.
+  const size_t n = 200;
+  matrix_type b(n, 5, false);
+  fill_random(b, CounterRandomScalar<scalar_type>(1, -1, 1));
+  matrix_type a(n, n, false);
+  scalar_type exact_trace = 0;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      a(i, j) = 0;
+      for (size_t k = 0; k < 5; ++k) a(i, j) += b(i, k) * b(j, k) / n;
+    }
+    a(i, i) += 1. + static_cast<scalar_type>(i % 7);
+    exact_trace += a(i, i);
+  }
+  const LazyMatrixWrapper<matrix_type> lazy_a(a);
+
+  // Gaussian kernel matrix, which is positive semi-definite and has
+  // rapidly decaying eigenvalues. Its trace is n.
+  matrix_type kernel(n, n, false);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      const scalar_type dx =
+            (static_cast<scalar_type>(i) - static_cast<scalar_type>(j)) / n;
+      kernel(i, j) = std::exp(-dx * dx / 0.02);
+    }
+  }
+  const LazyMatrixWrapper<matrix_type> lazy_kernel(kernel);
+
+  SECTION("Hutchinson trace estimate") {
+    const std::string hutchinson("hutchinson");
+    const krims::GenMap params{{StochasticEstimatorKeys::method, hutchinson},
+                               {StochasticEstimatorKeys::n_probes, size_t(200)},
+                               {StochasticEstimatorKeys::seed, size_t(3)}};
+    const auto est = estimate_trace(lazy_a, params);
+    CHECK(est.n_applies == 200);
+    CHECK(est.error > 0);
+    CHECK(std::abs(est.trace - exact_trace) < 4 * est.error);
+  }
+
+  SECTION("Hutch++ trace estimate") {
+    const krims::GenMap params{{StochasticEstimatorKeys::n_probes, size_t(60)},
+                               {StochasticEstimatorKeys::seed, size_t(3)}};
+    const auto est = estimate_trace(lazy_kernel, params);
+    CHECK(est.n_applies == 60);
+    CHECK(std::abs(est.trace - n) < 4 * est.error);
+
+    // Much more accurate than Hutchinson's method with the same effort
+    const std::string hutchinson("hutchinson");
+    const krims::GenMap params_hutchinson{{StochasticEstimatorKeys::method, hutchinson},
+                                          {StochasticEstimatorKeys::n_probes, size_t(60)},
+                                          {StochasticEstimatorKeys::seed, size_t(3)}};
+    const auto est_hutchinson = estimate_trace(lazy_kernel, params_hutchinson);
+    CHECK(std::abs(est_hutchinson.trace - n) < 4 * est_hutchinson.error);
+    CHECK(est.error < 0.1 * est_hutchinson.error);
+  }
+
+  SECTION("Hutch++ is exact for small matrices") {
+    matrix_type small{{1., 2., 0.}, {2., 5., 1.}, {0., 1., 3.}};
+    const krims::GenMap params{{StochasticEstimatorKeys::n_probes, size_t(9)}};
+    const auto est = estimate_trace(LazyMatrixWrapper<matrix_type>(small), params);
+    CHECK(est.trace == Approx(9.));
+    CHECK(est.error == 0);
+  }
+
+  SECTION("Results are independent of the number of threads") {
+    krims::GenMap params{{StochasticEstimatorKeys::n_probes, size_t(40)},
+                         {StochasticEstimatorKeys::block_size, size_t(3)},
+                         {StochasticEstimatorKeys::seed, size_t(8)},
+                         {StochasticEstimatorKeys::n_threads, size_t(1)}};
+    const auto trace_serial = estimate_trace(lazy_a, params);
+    const auto diag_serial = estimate_diagonal(lazy_a, params);
+    params.update(StochasticEstimatorKeys::n_threads, size_t(4));
+    const auto trace_parallel = estimate_trace(lazy_a, params);
+    const auto diag_parallel = estimate_diagonal(lazy_a, params);
+
+    CHECK(trace_serial.trace == trace_parallel.trace);
+    CHECK(trace_serial.error == trace_parallel.error);
+    CHECK(diag_serial.diagonal == diag_parallel.diagonal);
+    CHECK(diag_serial.error == diag_parallel.error);
+  }
+
+  SECTION("Diagonal estimate") {
+    const krims::GenMap params{{StochasticEstimatorKeys::n_probes, size_t(100)},
+                               {StochasticEstimatorKeys::seed, size_t(5)}};
+    const auto est = estimate_diagonal(lazy_a, params);
+    REQUIRE(est.diagonal.size() == n);
+    REQUIRE(est.error.size() == n);
+    CHECK(est.n_applies == 100);
+
+    size_t n_outside = 0;
+    for (size_t i = 0; i < n; ++i) {
+      if (std::abs(est.diagonal[i] - a(i, i)) > 4 * est.error[i]) ++n_outside;
+    }
+    CHECK(n_outside <= 2);
+  }
+
+  SECTION("Diagonal estimate of a diagonal matrix is exact") {
+    matrix_type diag(10, 10);
+    for (size_t i = 0; i < 10; ++i) diag(i, i) = static_cast<scalar_type>(i);
+    const krims::GenMap params{{StochasticEstimatorKeys::n_probes, size_t(4)}};
+    const auto est = estimate_diagonal(LazyMatrixWrapper<matrix_type>(diag), params);
+    for (size_t i = 0; i < 10; ++i) {
+      CHECK(est.diagonal[i] == Approx(static_cast<scalar_type>(i)));
+      CHECK(est.error[i] == 0);
+    }
+  }
+
+  SECTION("Diagonal estimate of a strongly diagonally dominant matrix") {
+    // The samples for element i have mean 1e6 and variance
+    // sum_{j != i} a_ij^2 = 0.01 * (m - 1), which is lost to cancellation
+    // if the variance is computed from the mean of the squares.
+    const size_t m = 50;
+    const size_t n_probes = 100;
+    matrix_type dominant(m, m, false);
+    for (size_t i = 0; i < m; ++i) {
+      for (size_t j = 0; j < m; ++j) dominant(i, j) = (i + j) % 2 == 0 ? 0.1 : -0.1;
+      dominant(i, i) = 1e6 + static_cast<scalar_type>(i);
+    }
+    const krims::GenMap params{{StochasticEstimatorKeys::n_probes, n_probes},
+                               {StochasticEstimatorKeys::block_size, size_t(7)},
+                               {StochasticEstimatorKeys::seed, size_t(2)}};
+    const auto est = estimate_diagonal(LazyMatrixWrapper<matrix_type>(dominant), params);
+
+    const scalar_type exact_error = std::sqrt(0.01 * (m - 1) / n_probes);
+    size_t n_outside = 0;
+    for (size_t i = 0; i < m; ++i) {
+      CHECK(est.error[i] > 0.5 * exact_error);
+      CHECK(est.error[i] < 2. * exact_error);
+      if (std::abs(est.diagonal[i] - dominant(i, i)) > 4 * est.error[i]) ++n_outside;
+    }
+    CHECK(n_outside <= 1);
+  }
+
+  SECTION("Invalid parameters") {
+    const krims::GenMap params{{StochasticEstimatorKeys::method, std::string("none")}};
+    CHECK_THROWS_AS(estimate_trace(lazy_a, params),
+                    ExcInvalidStochasticEstimatorParameters);
+  }
+}  // Stochastic trace and diagonal estimation
+
+}  // namespace tests
+}  // namespace lazyten